@@ -11,13 +11,15 @@ attribute vec2 vVertex;
 
 uniform mat4 ModelViewProjectionMatrix;
 uniform vec2 CropArea;
+uniform vec4 TileArea; //The area of the note that's covered by the tile, xy is the offset, zw is the size
 
 varying vec2 TexCoord;
 
 
 void main(void)
 {
-    gl_Position = ModelViewProjectionMatrix * vec4(vVertex, -0.1, 1.0);
+    vec2 notePosition = TileArea.xy + vVertex * TileArea.zw;
+    gl_Position = ModelViewProjectionMatrix * vec4(notePosition, -0.1, 1.0);
     TexCoord = vec2(vVertex.xy * CropArea);
 }
 
@@ -11,18 +11,16 @@
 #include "cwImageData.h"
 #include "cwImageProvider.h"
 #include "cwDebug.h"
+#include "cwSQLManager.h"
 //#include "cwImageDatabase.h"
 
-//For creating compressed DXT texture maps
-#include <squish.h>
-
 //Std includes
 #include "cwMath.h"
 
 //Qt includes
 #include <QString>
 #include <QImage>
-#include <QGLWidget>
+#include <QPainter>
 #include <QDebug>
 #include <QSqlDatabase>
 #include <QSqlQuery>
@@ -32,7 +30,7 @@
 #include <QImageWriter>
 #include <QBuffer>
 #include <QtConcurrentMap>
-#include <QOpenGLContext>
+#include <QVector>
 
 //TODO: REMOVE for testing only
 #include <QFile>
@@ -46,13 +44,9 @@
 
 cwAddImageTask::cwAddImageTask(QObject* parent) : cwProjectIOTask(parent)
 {
-    CompressionContext = new QOpenGLContext(this);
-    Window = new QWindow();
-    Window->setSurfaceType(QSurface::OpenGLSurface);
-    Window->create();
-    Texture = 0;
-
     MipmapOnly = false;
+    CompressionQuality = cwDxt1Encoder::HighQuality;
+    MipmapCodec = cwBlobCodec::FastLZ;
 }
 
 /**
@@ -71,26 +65,6 @@ void cwAddImageTask::runTask() {
     //Set the number of steps for this task
     calculateNumberOfSteps();
 
-    bool couldCreate = CompressionContext->create();
-    if(!couldCreate) {
-        qDebug() << "Could create context:" << couldCreate << LOCATION;
-        done();
-        return;
-    }
-
-    bool couldMakeCurrent = CompressionContext->makeCurrent(Window);
-    if(!couldMakeCurrent) {
-        qDebug() << "Could make curernt: " << couldMakeCurrent << LOCATION;
-        done();
-        return;
-    }
-
-    
-
-    if(Texture == 0) {
-        glGenTextures(1, &Texture);
-    }
-
     //Connect to the database
     bool connected = connectToDatabase("AddImagesTask");
 
@@ -108,8 +82,6 @@ void cwAddImageTask::runTask() {
         qDebug() << "Couldn't connect to the database!" << LOCATION;
     }
 
-    CompressionContext->doneCurrent();
-
     //Finished
     done();
 }
@@ -359,303 +331,194 @@ void cwAddImageTask::createIcon(QImage originalImage, QString imageFilename, cwI
 }
 
 /**
-  \brief This creates compressed mipmaps for the originalImage
+  \brief Halves one row of an image with a box filter
 
-  The return stringList is a list of all the mipmaps, starting with level 0 going to level
-  size-1 of the list.
+  Each destination pixel is the average of the 2x2 source pixels that it covers. The
+  destination's size is rounded down, so the last row or column of an odd sized source is
+  skipped, except when the source is a single row or column, which is repeated.
   */
-void cwAddImageTask::createMipmaps(QImage originalImage,
-                                   QString imageFilename,
-                                   cwImage* imageIds) {
-
-    QSizeF clipArea;
-    QImage scaledImage = ensureImageDivisibleBy4(originalImage, &clipArea);
-    QList<int> mipmapIds;
-
-    int numberOfLevels = numberOfMipmapLevels(scaledImage.size());
-
-    QSize scaledImageSize = scaledImage.size();
-
-    bool regeneratingMipmaps = numberOfLevels == imageIds->mipmaps().size();
-
-    for(int i = 0; i < numberOfLevels && isRunning(); i++) {
-        emit statusMessage(QString("Compressing %1 of %2 bold flavors of %3").arg(i + 1).arg(numberOfLevels).arg(QFileInfo(imageFilename).fileName()));
-
-        //Rescaled the image
-        scaledImage = scaledImage.scaled(scaledImageSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
-        int mipmapId = -1;
-        if(regeneratingMipmaps) {
-            mipmapId = imageIds->mipmaps().at(i);
-        }
-
-        //Export the image to DXT1 format
-        mipmapId = saveToDXT1Format(scaledImage, mipmapId);
-
-        //Add the path to the mipmapPath
-        if(!regeneratingMipmaps) {
-            mipmapIds.append(mipmapId);
+class HalfImageKernal {
+public:
+    HalfImageKernal(const QImage* source, uchar* destination, QSize destinationSize) :
+        Source(source),
+        Destination(destination),
+        DestinationSize(destinationSize)
+    {}
+
+    const QImage* Source;
+    uchar* Destination; //Tightly packed RGBA pixels
+    QSize DestinationSize;
+
+    void operator()(int row) {
+        int lastSourceRow = Source->height() - 1;
+        int lastSourceColumn = Source->width() - 1;
+        const uchar* top = Source->constScanLine(qMin(2 * row, lastSourceRow));
+        const uchar* bottom = Source->constScanLine(qMin(2 * row + 1, lastSourceRow));
+        uchar* destination = Destination + row * DestinationSize.width() * 4;
+
+        for(int x = 0; x < DestinationSize.width(); x++) {
+            int left = 4 * qMin(2 * x, lastSourceColumn);
+            int right = 4 * qMin(2 * x + 1, lastSourceColumn);
+            for(int c = 0; c < 4; c++) {
+                destination[4 * x + c] = (top[left + c] + top[right + c] + bottom[left + c] + bottom[right + c] + 2) / 4;
+            }
         }
-
-        //Create the new width and height, by halfing them
-        scaledImageSize = halfSize(scaledImageSize);
     }
-
-    imageIds->setMipmaps(mipmapIds);
-}
+};
 
 /**
-  \brief This calculates the number of mipmap levels that the originalImage will
-  make up.
-
-  This takes the largest dimension and takes the log2 of it.
+  \brief Compresses one mipmap level
   */
-int cwAddImageTask::numberOfMipmapLevels(QSize imageSize) const {
-    double largestDimension = (double)qMax(imageSize.width(), imageSize.height());
-    return (int)log2(largestDimension) + 1;
-}
+class CompressMipmapKernal {
+public:
+    CompressMipmapKernal(cwAddImageTask* task, const QList<QImage>* levels, cwImageData* compressedLevels) :
+        Task(task),
+        Levels(levels),
+        CompressedLevels(compressedLevels)
+    {}
 
+    cwAddImageTask* Task;
+    const QList<QImage>* Levels;
+    cwImageData* CompressedLevels;
 
-/**
-  \brief Saves the image to the path using the dxt1 format from squish
+    void operator()(int level) {
+        if(!Task->isRunning()) { return; }
+        CompressedLevels[level] = Task->compressToDXT1Format(Levels->at(level));
+    }
+};
 
-  The image will be firsted compress using dxt1 compression 1:6.  Then it'll
-  be compressed with zlib to gunzip.  This will compress the image by another
-  35% by default.
+/**
+  \brief This creates compressed mipmaps for the originalImage
 
-  \param image - The image that'll be converted
-  \param id - The id that'll be overwritten by the task
+  All the levels are created up front, with a box filter, and then compressed
+  concurrently. The compressed levels are written to the database in one transaction.
   */
-int cwAddImageTask::saveToDXT1Format(QImage image, int id) {
-    //Convert and compress using dxt1
-    //20 times slower on my computer
-#ifdef Q_OS_WIN
-    //FIXME: Need to have settings to use opengl dxt1 compression!
-    //FIXME: This should be used on gl es 2 implementations only. We should check to see if we have glGetCompressTexture
-    QByteArray outputData = squishCompressImageThreaded(image, squish::kDxt1 | squish::kColourIterativeClusterFit);
-#else
-    //FIXME: This is commented out because this breaks hard on old intel graphics cards
-    QByteArray outputData = openglDxt1Compression(image);
-#endif
-
-    if(outputData.isEmpty()) {
-        return -1;
-    }
-
-    //Compress the dxt1FileData using zlib
-    outputData = qCompress(outputData, 9);
+void cwAddImageTask::createMipmaps(QImage originalImage,
+                                   QString imageFilename,
+                                   cwImage* imageIds) {
 
-    //Add the image to the database
-    cwImageData iconImageData(image.size(), 0, cwImageProvider::Dxt1_GZ_Extension, outputData);
+    QSizeF clipArea;
+    QImage paddedImage = ensureImageDivisibleBy4(originalImage, &clipArea);
 
-    int imageId;
-    if(id == -1) {
-        //Add the image
-        imageId = cwProject::addImage(Database, iconImageData);
-    } else {
-        imageId = id;
-        cwProject::updateImage(Database, iconImageData, id);
-    }
+    int numberOfLevels = numberOfMipmapLevels(paddedImage.size());
+    emit statusMessage(QString("Compressing %1 bold flavors of %2").arg(numberOfLevels).arg(QFileInfo(imageFilename).fileName()));
 
-    return imageId;
-}
+    //Textures are uploaded bottom row first
+    QImage firstLevel = paddedImage.mirrored().convertToFormat(QImage::Format_RGBA8888);
 
-using namespace squish;
+    //All the levels after the first share one buffer
+    QByteArray levelBuffer;
+    QList<QImage> levels = createMipmapLevels(firstLevel, numberOfLevels, &levelBuffer);
 
-/**
-  This block is create to be compressed by squish in a thread way.
+    QVector<int> levelIndexes;
+    levelIndexes.reserve(levels.size());
+    for(int i = 0; i < levels.size(); i++) {
+        levelIndexes.append(i);
+    }
 
-  See sqiush::CompressMask for details
-  */
-class Block {
-public:
+    QVector<cwImageData> compressedLevels(levels.size());
+    QtConcurrent::blockingMap(levelIndexes, CompressMipmapKernal(this, &levels, compressedLevels.data()));
 
-    /**
-      \param x - The x parameter
-      \param y - The y parameter
-      \param rgba - The source rgba
-      \param blockData - The output blockdata
-      */
-    Block(int x, int y, u8 const* rgba, void* blockData) {
-        Position = QPoint(x, y);
-        RGBA = rgba;
-        BlockData = blockData;
+    if(!isRunning()) {
+        return;
     }
 
-    QPoint Position;
-    u8 const* RGBA;
-    void* BlockData;
-};
+    bool regeneratingMipmaps = numberOfLevels == imageIds->mipmaps().size();
 
-/**
-  \brief This class compresses a signle block.  This allow squish library to be
-  threaded.
-  */
-class CompressImageKernal {
-public:
-    CompressImageKernal(cwAddImageTask* task, QSize imageSize, int flags, float* metric) {
-        Task = task;
-        ImageSize = imageSize;
-        Flags = flags;
-        Metric = metric;
+    //Each level is stored as tiles, so cwTileLoadTask can read the tiles that are in view
+    QList<int> mipmapIds;
+    cwSQLManager::Transaction transaction(&Database);
+    for(int i = 0; i < compressedLevels.size(); i++) {
+        if(regeneratingMipmaps) {
+            cwProject::updateTiledImage(Database, compressedLevels.at(i), MipmapCodec, imageIds->mipmaps().at(i), false);
+        } else {
+            mipmapIds.append(cwProject::addTiledImage(Database, compressedLevels.at(i), MipmapCodec, false));
+        }
     }
 
-    cwAddImageTask* Task;
-    QSize ImageSize;
-    int Flags;
-    float* Metric;
-
+    if(!regeneratingMipmaps) {
+        imageIds->setMipmaps(mipmapIds);
+    }
+}
 
-    void operator()(Block block) {
+/**
+  \brief Creates all the mipmap levels of firstLevel
 
-        if(!Task->isRunning()) { return; }
+  Each level is half the size of the previous level, created with a box filter. The first
+  level is firstLevel, and the other levels are stored in levelBuffer, which must outlive
+  the returned images.
+  */
+QList<QImage> cwAddImageTask::createMipmapLevels(const QImage &firstLevel, int numberOfLevels, QByteArray *levelBuffer) const
+{
+    Q_ASSERT(firstLevel.format() == QImage::Format_RGBA8888);
 
-        // build the 4x4 block of pixels
-        u8 sourceRgba[16*4];
-        u8* targetPixel = sourceRgba;
-        int mask = 0;
-        for( int py = 0; py < 4; ++py )
-        {
-            for( int px = 0; px < 4; ++px )
-            {
-                // get the source pixel in the image
-                int sx = block.Position.x() + px;
-                int sy = block.Position.y() + py;
-
-                // enable if we're in the image
-                if( sx < ImageSize.width() && sy < ImageSize.height() )
-                {
-                    // copy the rgba value
-                    u8 const* sourcePixel = block.RGBA + 4*( ImageSize.width() * sy + sx );
-                    for( int i = 0; i < 4; ++i ) {
-                        *targetPixel++ = *sourcePixel++;
-                    }
-
-                    // enable this pixel
-                    mask |= ( 1 << ( 4*py + px ) );
-                }
-                else
-                {
-                    // skip this pixel as its outside the image
-                    targetPixel += 4;
-                }
-            }
+    QList<QSize> sizes;
+    int bufferSize = 0;
+    QSize size = firstLevel.size();
+    for(int i = 1; i < numberOfLevels; i++) {
+        size = halfSize(size);
+        sizes.append(size);
+        bufferSize += size.width() * size.height() * 4;
+    }
+
+    levelBuffer->resize(bufferSize);
+    uchar* levelData = reinterpret_cast<uchar*>(levelBuffer->data());
+
+    QList<QImage> levels;
+    levels.reserve(numberOfLevels);
+    levels.append(firstLevel);
+
+    foreach(QSize levelSize, sizes) {
+        QVector<int> rows;
+        rows.reserve(levelSize.height());
+        for(int row = 0; row < levelSize.height(); row++) {
+            rows.append(row);
         }
 
-        CompressMasked(sourceRgba, mask, block.BlockData, Flags);
+        const QImage& previousLevel = levels.last();
+        QtConcurrent::blockingMap(rows, HalfImageKernal(&previousLevel, levelData, levelSize));
 
-        emit Task->IncreaseProgress();
+        //Wraps levelData without copying it
+        const uchar* constLevelData = levelData;
+        levels.append(QImage(constLevelData, levelSize.width(), levelSize.height(), levelSize.width() * 4, QImage::Format_RGBA8888));
+        levelData += levelSize.width() * levelSize.height() * 4;
     }
 
-};
-
-
-
-/**
-  Copied directly from squish library
-  */
-
-static int FixFlags( int flags )
-{
-    // grab the flag bits
-    int method = flags & ( kDxt1 | kDxt3 | kDxt5 );
-    int fit = flags & ( kColourIterativeClusterFit | kColourClusterFit | kColourRangeFit );
-    int extra = flags & kWeightColourByAlpha;
-
-    // set defaults
-    if( method != kDxt3 && method != kDxt5 )
-        method = kDxt1;
-    if( fit != kColourRangeFit && fit != kColourIterativeClusterFit )
-        fit = kColourClusterFit;
-
-    // done
-    return method | fit | extra;
+    return levels;
 }
 
 /**
-  \brief This is a drop in replacement for sqiush::CompressImage
+  \brief This calculates the number of mipmap levels that the originalImage will
+  make up.
 
-  The only differance is this is threaded.
+  This takes the largest dimension and takes the log2 of it.
   */
-QByteArray cwAddImageTask::squishCompressImageThreaded( QImage image, int flags, float* metric ) {
-    int outputFileSize = squish::GetStorageRequirements(image.width(), image.height(), squish::kDxt1);
-
-    //Allocate the compress data
-    QByteArray outputData;
-    outputData.resize(outputFileSize);
-
-    //Convert the image to a real format
-    QImage convertedFormat = QGLWidget::convertToGLFormat(image);
-
-    // fix any bad flags
-    flags = FixFlags( flags );
+int cwAddImageTask::numberOfMipmapLevels(QSize imageSize) const {
+    double largestDimension = (double)qMax(imageSize.width(), imageSize.height());
+    return (int)log2(largestDimension) + 1;
+}
 
-    // initialise the block output
-    u8* targetBlock = reinterpret_cast< u8* >( outputData.data() );
-    int bytesPerBlock = ( ( flags & kDxt1 ) != 0 ) ? 8 : 16;
 
-    // loop over pixels and create blocks
-    QList<Block> computeBlocks;
-    for( int y = 0; y < image.height(); y += 4 )
-    {
-        for( int x = 0; x < image.width(); x += 4 )
-        {
-            computeBlocks.append(Block(x, y, convertedFormat.bits(), targetBlock));
+/**
+  \brief Compresses the image using the dxt1 format from cwDxt1Encoder
 
-            // advance
-            targetBlock += bytesPerBlock;
-        }
-    }
+  The image is compressed using dxt1 compression 1:6. Each of its tiles is compressed
+  with the MipmapCodec when it's stored, see cwProject::addTiledImage().
 
-    //This takes all the compute blocks and compresses them using squish
-    QtConcurrent::blockingMap(computeBlocks, CompressImageKernal(this, image.size(), flags, metric));
+  This is thread safe, levels are compressed concurrently.
 
-    return outputData;
-}
+  \param image - The image that'll be converted, the first scan line is the bottom of the texture
+  */
+cwImageData cwAddImageTask::compressToDXT1Format(const QImage& image) {
+    cwDxt1Encoder encoder;
+    encoder.setQuality(CompressionQuality);
+    encoder.setTask(this);
+    encoder.setProgressFunction([this](int numberOfBlocks) { IncreaseProgress(numberOfBlocks); });
 
-/**
- * @brief cwAddImageTask::graphicsDriverDx1Compression
- * @param image - The image to compress
- * @return Returns the compress image in DXT1 compression
- *
- * This assumes that the opengl context is bound
- */
-#ifndef Q_OS_WIN
-QByteArray cwAddImageTask::openglDxt1Compression(QImage image)
-{
-    glBindTexture(GL_TEXTURE_2D, Texture);
-
-    QImage convertedImage = QGLWidget::convertToGLFormat(image);
-
-    glTexImage2D(GL_TEXTURE_2D,
-                 0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
-                 image.width(), image.height(),
-                 0, GL_RGBA,
-                 GL_UNSIGNED_BYTE,
-                 convertedImage.bits());
-
-
-    GLint compressed;
-    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_ARB, &compressed);
-    // if the compression has been successful
-    if (compressed == GL_TRUE)
-    {
-        //        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT,
-        //                                 &internalformat);
-        GLint compressed_size;
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE_ARB,
-                                 &compressed_size);
-        QByteArray compressedByteArray(compressed_size, 0);
-        glGetCompressedTexImage(GL_TEXTURE_2D, 0, compressedByteArray.data());
-
-        return compressedByteArray;
-    }
+    QByteArray outputData = encoder.compress(image);
 
-    qDebug() << "Error: Couldn't compress image" << LOCATION;
-    return QByteArray();
+    return cwImageData(image.size(), 0, cwImageProvider::dxt1Format(cwBlobCodec::Stored), outputData);
 }
-#endif
-
 
 /**
   Gets the number of dots per meter of the image
@@ -788,8 +651,8 @@ QImage cwAddImageTask::ensureImageDivisibleBy4(QImage originalImage, QSizeF *cli
 
   This uses an atomic integer that's thread safe
   */
-void cwAddImageTask::IncreaseProgress() {
-    int originalValue = Progress.fetchAndAddRelaxed(1);
+void cwAddImageTask::IncreaseProgress(int steps) {
+    int originalValue = Progress.fetchAndAddRelaxed(steps);
 
     //Normalize to progress
     double percent = 100.0 * (originalValue / (double)numberOfSteps());
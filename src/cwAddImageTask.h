@@ -11,6 +11,9 @@
 //Our includes
 #include "cwProjectIOTask.h"
 #include "cwImage.h"
+#include "cwDxt1Encoder.h"
+#include "cwBlobCodec.h"
+class cwImageData;
 
 //Qt includes
 #include <QStringList>
@@ -19,18 +22,14 @@
 #include <QDir>
 #include <QSqlDatabase>
 #include <QAtomicInt>
-#include <QWindow>
 #include <QDebug>
-#include <QOpenGLContext>
 
-//Squish includes
-#include <squish.h>
-
-class CompressImageKernal;
+class CompressMipmapKernal;
 
 class cwAddImageTask : public cwProjectIOTask
 {
-    friend class CompressImageKernal;
+    friend class CompressMipmapKernal;
+    friend class AddImageTaskTester; //For testcases
 
     Q_OBJECT
 
@@ -48,6 +47,8 @@ public:
 
     //Options for adding
     void setMipmapsOnly(bool mipmapOnly);
+    void setCompressionQuality(cwDxt1Encoder::Quality quality);
+    void setMipmapCodec(cwBlobCodec::Codec codec);
 
     //Regenerate mipmaps
     void regenerateMipmapsOn(cwImage image);
@@ -86,13 +87,12 @@ private:
     QStringList Errors;
 
     bool MipmapOnly; //Doesn't save the original or create an icon
+    cwDxt1Encoder::Quality CompressionQuality;
+    cwBlobCodec::Codec MipmapCodec;
 
     cwImage RegenerateImage; //This updates the mipmaps for the image
 
     QAtomicInt Progress;
-    QOpenGLContext* CompressionContext;
-    QWindow* Window;
-    GLuint Texture;
 
     QImage copyOriginalImage(QString image, cwImage* imageIds);
     void copyOriginalImage(const QImage& image, cwImage* imageIds);
@@ -100,9 +100,8 @@ private:
 
     void createIcon(QImage originalImage, QString imageFilename, cwImage* imageIds);
     void createMipmaps(QImage originalImage, QString imageFilename, cwImage* imageIds);
-    int saveToDXT1Format(QImage image, int id = -1);
-    QByteArray squishCompressImageThreaded(QImage image, int flags, float* metric = 0);
-    QByteArray openglDxt1Compression(QImage image);
+    QList<QImage> createMipmapLevels(const QImage& firstLevel, int numberOfLevels, QByteArray* levelBuffer) const;
+    cwImageData compressToDXT1Format(const QImage& image);
     QImage ensureImageDivisibleBy4(QImage originalImage, QSizeF* clipArea);
 
     void calculateNumberOfSteps();
@@ -112,7 +111,7 @@ private:
 
     void regenerateMipmaps();
 
-    void IncreaseProgress();
+    void IncreaseProgress(int steps = 1);
 
 private slots:
     void tryAddingImagesToDatabase();
@@ -157,6 +156,25 @@ inline void cwAddImageTask::setMipmapsOnly(bool mipmapOnly)
     MipmapOnly = mipmapOnly;
 }
 
+/**
+ * @brief cwAddImageTask::setCompressionQuality
+ * @param quality - The DXT1 compression quality of the mipmaps, by default this is HighQuality
+ */
+inline void cwAddImageTask::setCompressionQuality(cwDxt1Encoder::Quality quality)
+{
+    CompressionQuality = quality;
+}
+
+/**
+ * @brief cwAddImageTask::setMipmapCodec
+ * @param codec - How the DXT1 mipmaps are compressed in the project file, by default this is
+ * FastLZ. Stored makes the largest files, but imports and loads textures the fastest.
+ */
+inline void cwAddImageTask::setMipmapCodec(cwBlobCodec::Codec codec)
+{
+    MipmapCodec = codec;
+}
+
 /**
  * @brief cwAddImageTask::regenerateMipmapsOn
  * @param image
@@ -0,0 +1,348 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwBlobCodec.h"
+#include "cwDebug.h"
+
+//Qt includes
+#include <QtEndian>
+#include <QDebug>
+
+//Std includes
+#include <cstring>
+#include <vector>
+#include <limits>
+
+namespace {
+
+//The smallest match that's encoded, a match is a 4 bit length in the token
+const int MinMatch = 4;
+
+//The last bytes of the input are always literals, so the decoder can copy without checking
+//every byte
+const int LastLiterals = 5;
+
+//A match can't start in the last bytes of the input
+const int MatchSafeDistance = LastLiterals + 7;
+
+//Matches are found with a hash table of the previous position of every four bytes
+const int HashBits = 13;
+
+//The offset of a match is stored in 16 bits
+const int MaxOffset = 65535;
+
+//Bytes in the uncompressed size header
+const int HeaderSize = 4;
+
+inline quint32 read32(const uchar* data) {
+    quint32 value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline int hash(quint32 sequence) {
+    return static_cast<int>((sequence * 2654435761u) >> (32 - HashBits));
+}
+
+//Writes the extra bytes of a length that doesn't fit in the token's 4 bits
+inline uchar* writeLength(uchar* output, int length) {
+    for(; length >= 255; length -= 255) {
+        *output++ = 255;
+    }
+    *output++ = static_cast<uchar>(length);
+    return output;
+}
+
+//Writes a token, the literals, and the match. If matchLength is 0, this is the last sequence
+//and doesn't have a match
+uchar* writeSequence(uchar* output, const uchar* literals, int literalLength, int offset, int matchLength) {
+    uchar* token = output++;
+    *token = static_cast<uchar>(qMin(literalLength, 15) << 4);
+    if(literalLength >= 15) {
+        output = writeLength(output, literalLength - 15);
+    }
+
+    memcpy(output, literals, literalLength);
+    output += literalLength;
+
+    if(matchLength == 0) {
+        return output;
+    }
+
+    *output++ = static_cast<uchar>(offset & 0xFF);
+    *output++ = static_cast<uchar>(offset >> 8);
+
+    int extraLength = matchLength - MinMatch;
+    *token |= static_cast<uchar>(qMin(extraLength, 15));
+    if(extraLength >= 15) {
+        output = writeLength(output, extraLength - 15);
+    }
+
+    return output;
+}
+
+//Reads the extra bytes of a length, returns false if the input runs out
+inline bool readLength(const uchar*& input, const uchar* inputEnd, int& length) {
+    uchar value;
+    do {
+        if(input >= inputEnd || length > std::numeric_limits<int>::max() - 255) {
+            return false;
+        }
+        value = *input++;
+        length += value;
+    } while(value == 255);
+    return true;
+}
+
+}
+
+/**
+ * @brief cwBlobCodec::compress
+ * @param data - The uncompressed blob
+ * @param codec - How the blob is compressed
+ * @return The compressed blob
+ */
+QByteArray cwBlobCodec::compress(const QByteArray &data, cwBlobCodec::Codec codec)
+{
+    switch(codec) {
+    case Stored:
+        return data;
+    case FastLZ:
+        return compressLZ(data);
+    case Zlib:
+        return qCompress(data, 9);
+    }
+    return data;
+}
+
+/**
+ * @brief cwBlobCodec::uncompress
+ * @param data - The blob from compress()
+ * @param codec - The codec that was passed to compress()
+ * @return The uncompressed blob, or an empty QByteArray, if the blob is corrupt
+ */
+QByteArray cwBlobCodec::uncompress(const QByteArray &data, cwBlobCodec::Codec codec)
+{
+    switch(codec) {
+    case Stored:
+        return data;
+    case FastLZ:
+        return uncompressLZ(data);
+    case Zlib:
+        return qUncompress(data);
+    }
+    return data;
+}
+
+/**
+ * @brief cwBlobCodec::extension
+ * @return The extension that's appended to the image's type, for example ".lz". Stored
+ * doesn't have an extension.
+ */
+QByteArray cwBlobCodec::extension(cwBlobCodec::Codec codec)
+{
+    switch(codec) {
+    case Stored:
+        return QByteArray();
+    case FastLZ:
+        return QByteArrayLiteral(".lz");
+    case Zlib:
+        return QByteArrayLiteral(".gz");
+    }
+    return QByteArray();
+}
+
+/**
+ * @brief cwBlobCodec::codec
+ * @param type - The image's type, like "dxt1.gz"
+ * @return The codec from the type's extension, if the type doesn't have a codec extension, this
+ * returns Stored
+ */
+cwBlobCodec::Codec cwBlobCodec::codec(const QByteArray &type)
+{
+    if(type.endsWith(extension(FastLZ))) {
+        return FastLZ;
+    } else if(type.endsWith(extension(Zlib))) {
+        return Zlib;
+    }
+    return Stored;
+}
+
+/**
+ * @brief cwBlobCodec::baseType
+ * @param type - The image's type, like "dxt1.gz"
+ * @return The type without the codec's extension, like "dxt1"
+ */
+QByteArray cwBlobCodec::baseType(const QByteArray &type)
+{
+    return type.left(type.size() - extension(codec(type)).size());
+}
+
+/**
+ * @brief cwBlobCodec::compressLZ
+ *
+ * The output starts with the uncompressed size, as a big endian 32 bit int, like qCompress(). It's
+ * followed by LZ4 style sequences. Each sequence is a token, with 4 bits for the number of
+ * literals and 4 bits for the match length, the literals, and then the match's 16 bit little
+ * endian offset. Lengths that don't fit in the token are continued with bytes of 255.
+ */
+QByteArray cwBlobCodec::compressLZ(const QByteArray &data)
+{
+    const int inputSize = data.size();
+    const uchar* input = reinterpret_cast<const uchar*>(data.constData());
+
+    //Worst case, every byte is a literal
+    QByteArray output;
+    output.resize(HeaderSize + inputSize + inputSize / 255 + 16);
+    uchar* outputBegin = reinterpret_cast<uchar*>(output.data());
+    qToBigEndian(static_cast<quint32>(inputSize), outputBegin);
+    uchar* op = outputBegin + HeaderSize;
+
+    int anchor = 0;
+
+    if(inputSize > MatchSafeDistance) {
+        std::vector<int> hashTable(1 << HashBits, -1);
+        const int matchStartLimit = inputSize - MatchSafeDistance;
+        const int matchEndLimit = inputSize - LastLiterals;
+
+        int position = 0;
+        while(position < matchStartLimit) {
+            quint32 sequence = read32(input + position);
+            int& entry = hashTable[hash(sequence)];
+            int reference = entry;
+            entry = position;
+
+            if(reference < 0 ||
+                    position - reference > MaxOffset ||
+                    read32(input + reference) != sequence)
+            {
+                //Skip ahead faster through data that doesn't compress
+                position += 1 + ((position - anchor) >> 6);
+                continue;
+            }
+
+            //Extend the match backwards into the pending literals
+            while(position > anchor && reference > 0 && input[position - 1] == input[reference - 1]) {
+                position--;
+                reference--;
+            }
+
+            int matchLength = MinMatch;
+            while(position + matchLength < matchEndLimit &&
+                  input[position + matchLength] == input[reference + matchLength])
+            {
+                matchLength++;
+            }
+
+            op = writeSequence(op, input + anchor, position - anchor, position - reference, matchLength);
+
+            position += matchLength;
+            anchor = position;
+
+            //Make the end of the match findable
+            if(position - 2 < matchStartLimit) {
+                hashTable[hash(read32(input + position - 2))] = position - 2;
+            }
+        }
+    }
+
+    op = writeSequence(op, input + anchor, inputSize - anchor, 0, 0);
+
+    output.resize(static_cast<int>(op - outputBegin));
+    return output;
+}
+
+/**
+ * @brief cwBlobCodec::uncompressLZ
+ * @return The data from compressLZ(), or an empty QByteArray if the data is corrupt
+ */
+QByteArray cwBlobCodec::uncompressLZ(const QByteArray &data)
+{
+    if(data.size() < HeaderSize + 1) {
+        qDebug() << "LZ blob is too small:" << data.size() << LOCATION;
+        return QByteArray();
+    }
+
+    const uchar* ip = reinterpret_cast<const uchar*>(data.constData());
+    const uchar* inputEnd = ip + data.size();
+    const quint32 outputSize = qFromBigEndian<quint32>(ip);
+    ip += HeaderSize;
+
+    //A byte of input can't expand to more than 255 bytes of output. The limit is in 64 bits, because
+    //it doesn't fit in 32 bits for blobs larger than 16MB
+    if(static_cast<quint64>(outputSize) > static_cast<quint64>(data.size()) * 255u ||
+            outputSize > static_cast<quint32>(std::numeric_limits<int>::max()))
+    {
+        qDebug() << "LZ blob has a bad size:" << outputSize << LOCATION;
+        return QByteArray();
+    }
+
+    QByteArray output;
+    output.resize(static_cast<int>(outputSize));
+    uchar* outputBegin = reinterpret_cast<uchar*>(output.data());
+    uchar* op = outputBegin;
+    uchar* outputEnd = outputBegin + outputSize;
+
+    forever {
+        if(ip >= inputEnd) {
+            break;
+        }
+
+        const uchar token = *ip++;
+
+        int literalLength = token >> 4;
+        if(literalLength == 15 && !readLength(ip, inputEnd, literalLength)) {
+            break;
+        }
+
+        if(literalLength > inputEnd - ip || literalLength > outputEnd - op) {
+            break;
+        }
+        memcpy(op, ip, literalLength);
+        op += literalLength;
+        ip += literalLength;
+
+        //The last sequence doesn't have a match
+        if(ip == inputEnd) {
+            if(op == outputEnd) {
+                return output;
+            }
+            break;
+        }
+
+        if(inputEnd - ip < 2) {
+            break;
+        }
+        const int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        int matchLength = token & 0xF;
+        if(matchLength == 15 && !readLength(ip, inputEnd, matchLength)) {
+            break;
+        }
+        matchLength += MinMatch;
+
+        if(offset == 0 || offset > op - outputBegin || matchLength > outputEnd - op) {
+            break;
+        }
+
+        const uchar* match = op - offset;
+        if(offset >= matchLength) {
+            memcpy(op, match, matchLength);
+        } else {
+            //The match overlaps the output, so it's copied a byte at a time
+            for(int i = 0; i < matchLength; i++) {
+                op[i] = match[i];
+            }
+        }
+        op += matchLength;
+    }
+
+    qDebug() << "LZ blob is corrupt" << LOCATION;
+    return QByteArray();
+}
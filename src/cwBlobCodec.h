@@ -0,0 +1,52 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWBLOBCODEC_H
+#define CWBLOBCODEC_H
+
+//Our includes
+#include "cwGlobals.h"
+
+//Qt includes
+#include <QByteArray>
+
+/**
+ * @brief The cwBlobCodec class
+ *
+ * Compresses and decompresses the image blobs that are stored in the project file. Each codec
+ * has an extension that's appended to the image's type, for example "dxt1.lz", so the blob can
+ * be decoded without knowing how it was written.
+ *
+ * Stored doesn't compress the blob at all. FastLZ is a byte oriented LZ77 codec, in the style of
+ * LZ4's block format, that decompresses at memory speed. Zlib is qCompress(), and is only kept
+ * for older project files. Level 9 zlib is very slow to write and only saves a little more
+ * space than FastLZ on DXT1 data.
+ *
+ * All the functions are thread safe.
+ */
+class CAVEWHERE_LIB_EXPORT cwBlobCodec
+{
+public:
+    enum Codec {
+        Stored,
+        FastLZ,
+        Zlib
+    };
+
+    static QByteArray compress(const QByteArray& data, Codec codec);
+    static QByteArray uncompress(const QByteArray& data, Codec codec);
+
+    static QByteArray extension(Codec codec);
+    static Codec codec(const QByteArray& type);
+    static QByteArray baseType(const QByteArray& type);
+
+private:
+    static QByteArray compressLZ(const QByteArray& data);
+    static QByteArray uncompressLZ(const QByteArray& data);
+};
+
+#endif // CWBLOBCODEC_H
@@ -8,6 +8,12 @@
 #include "cwCamera.h"
 #include "cwDebug.h"
 
+//Qt includes
+#include <QVector4D>
+
+//Std includes
+#include <limits>
+
 cwCamera::cwCamera(QObject *parent) :
     QObject(parent),
     ZoomScale(1.0)
@@ -165,6 +171,43 @@ QVector3D cwCamera::mapNormalizeScreenToGLViewport(const QVector3D& point) const
      return pixelVector.x();
  }
 
+ /**
+  * @brief cwCamera::pixelsPerMeter
+  * @param box - A box in world coordinates
+  * @return The most pixels per meter, of any point in box
+  *
+  * This works for ortho and perspective projections, and is used to pick levels of detail.
+  * The clip w is linear, so its smallest value in the box is at a corner, and that corner is
+  * where the box is the largest on the screen. If the box is behind the camera, or the camera is
+  * in the box, this returns infinity.
+  */
+ double cwCamera::pixelsPerMeter(const QBox3D& box) const {
+     if(box.isNull()) {
+         return 0.0;
+     }
+
+     QMatrix4x4 viewProjection = projectionMatrix() * viewMatrix();
+     QVector3D minimum = box.minimum();
+     QVector3D maximum = box.maximum();
+
+     double minimumW = std::numeric_limits<double>::infinity();
+     for(int i = 0; i < 8; i++) {
+         QVector3D corner(i & 1 ? maximum.x() : minimum.x(),
+                          i & 2 ? maximum.y() : minimum.y(),
+                          i & 4 ? maximum.z() : minimum.z());
+         QVector4D clip = viewProjection * QVector4D(corner, 1.0);
+         minimumW = qMin(minimumW, (double)clip.w());
+     }
+
+     if(minimumW <= 0.0) {
+         return std::numeric_limits<double>::infinity();
+     }
+
+     //A meter along the view's x axis, in normalized device coordinates, is the projection's
+     //x scale over w, and normalized device coordinates are 2 units across the viewport
+     return projectionMatrix()(0, 0) * viewport().width() / (2.0 * minimumW);
+ }
+
  /**
 * @brief cwCamera::setZoomScale
 * @param zoomScale
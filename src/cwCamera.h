@@ -15,6 +15,7 @@
 #include <QObject>
 #include <QRect>
 #include <QMatrix4x4>
+#include <QBox3D>
 
 class cwCamera : public QObject
 {
@@ -59,6 +60,7 @@ public:
 
     //Utility functions
     double pixelsPerMeter() const; //Only valid with ortho projection
+    double pixelsPerMeter(const QBox3D& box) const;
     cwProjection orthoProjectionDefault() const;
     cwProjection perspectiveProjectionDefault() const;
 
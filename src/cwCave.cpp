@@ -11,13 +11,18 @@
 #include "cwStation.h"
 #include "cwLength.h"
 #include "cwErrorModel.h"
+#include "cwStationOccurrenceIndex.h"
+#include "cwRegionObjectId.h"
 
 cwCave::cwCave(QObject* parent) :
     QAbstractListModel(parent),
     Length(new cwLength(this)),
     Depth(new cwLength(this)),
     ErrorModel(new cwErrorModel(this)),
-    StationPositionModelStale(false)
+    StationOccurrenceIndex(new cwStationOccurrenceIndex(this)),
+    StationPositionModelStale(false),
+    BulkEditDepth(0),
+    Id(cwRegionObjectId::next())
 {
     Length->setUnit(cwUnits::Meters);
     Depth->setUnit(cwUnits::Meters);
@@ -37,7 +42,10 @@ cwCave::cwCave(const cwCave& object) :
     Length(new cwLength(this)),
     Depth(new cwLength(this)),
     ErrorModel(new cwErrorModel(this)),
-    StationPositionModelStale(false)
+    StationOccurrenceIndex(new cwStationOccurrenceIndex(this)),
+    StationPositionModelStale(false),
+    BulkEditDepth(0),
+    Id(cwRegionObjectId::next())
 {
     Copy(object);
 }
@@ -67,6 +75,12 @@ cwCave& cwCave::Copy(const cwCave& object) {
     setStationPositionLookup(object.stationPositionLookup());
 
     //Remove all the old trips
+    if(isBulkEditing()) {
+        foreach(cwTrip* trip, Trips) {
+            trip->endBulkEdit();
+        }
+    }
+
     int lastTripIndex = Trips.size() - 1;
     Trips.clear();
     if(lastTripIndex > 0) {
@@ -81,6 +95,9 @@ cwCave& cwCave::Copy(const cwCave& object) {
         newTrip->setParent(this);
         newTrip->setParentCave(this);
         newTrip->errorModel()->setParentModel(ErrorModel);
+        if(isBulkEditing()) {
+            newTrip->beginBulkEdit();
+        }
         Trips.append(newTrip);
     }
 
@@ -88,6 +105,9 @@ cwCave& cwCave::Copy(const cwCave& object) {
         emit insertedTrips(0, object.tripCount() - 1);
     }
 
+    //The signals above aren't emitted for a single trip
+    StationOccurrenceIndex->invalidate();
+
     *Length = *(object.Length);
     *Depth = *(object.Depth);
 
@@ -96,6 +116,77 @@ cwCave& cwCave::Copy(const cwCave& object) {
     return *this;
 }
 
+/**
+ * @brief cwCave::data
+ * @return A value snapshot of the cave and all its trips
+ */
+cwCaveData cwCave::data() const
+{
+    cwCaveData data;
+    data.Id = Id;
+    data.Name = Name;
+    data.LengthUnit = (cwUnits::LengthUnit)Length->unit();
+    data.DepthUnit = (cwUnits::LengthUnit)Depth->unit();
+    data.StationPositions = StationPositionModel;
+    data.StationPositionsStale = StationPositionModelStale;
+
+    data.Trips.reserve(Trips.size());
+    foreach(cwTrip* trip, Trips) {
+        data.Trips.append(trip->data());
+    }
+
+    return data;
+}
+
+/**
+ * @brief cwCave::setData
+ * @param data - Replaces all the data in the cave
+ *
+ * The trips are replaced with addTrip() and removeTrip(), so this is undoable if the cave has
+ * an undo stack.
+ */
+void cwCave::setData(const cwCaveData &data)
+{
+    if(data.Id != 0) {
+        setId(data.Id);
+    }
+    setName(data.Name);
+    Length->setUnit(data.LengthUnit);
+    Depth->setUnit(data.DepthUnit);
+
+    while(tripCount() > 0) {
+        removeTrip(tripCount() - 1);
+    }
+
+    foreach(const cwTripData& tripData, data.Trips) {
+        cwTrip* trip = new cwTrip();
+        trip->setData(tripData);
+        addTrip(trip);
+    }
+
+    setStationPositionLookup(data.StationPositions);
+    setStationPositionLookupStale(data.StationPositionsStale);
+}
+
+/**
+ * @brief cwCave::id
+ * @return The cave's id, see cwRegionObjectId. Copies of the cave get a new id
+ */
+qint64 cwCave::id() const
+{
+    return Id;
+}
+
+/**
+ * @brief cwCave::setId
+ * @param id - The id that was loaded with the cave
+ */
+void cwCave::setId(qint64 id)
+{
+    cwRegionObjectId::reserve(id);
+    Id = id;
+}
+
 /**
   \brief Sets the name of the cwCave
   */
@@ -124,6 +215,46 @@ void cwCave::addTripNullHelper() {
     endUndoMacro();
 }
 
+/**
+ * @brief cwCave::beginBulkEdit
+ *
+ * Starts a bulk edit on all the trips in the cave, see cwTrip::beginBulkEdit(). Trips that are
+ * added during the bulk edit are also bulk edited. Calls can be nested.
+ *
+ * The cave's own signals aren't batched, because they're also the model's row signals.
+ */
+void cwCave::beginBulkEdit()
+{
+    BulkEditDepth++;
+    if(BulkEditDepth == 1) {
+        foreach(cwTrip* trip, Trips) {
+            trip->beginBulkEdit();
+        }
+    }
+}
+
+/**
+ * @brief cwCave::endBulkEdit
+ *
+ * Ends a bulk edit started with beginBulkEdit(). When the outer most bulk edit ends, all the trips
+ * end their bulk edits and then bulkEditFinished() is emitted.
+ */
+void cwCave::endBulkEdit()
+{
+    Q_ASSERT(BulkEditDepth > 0);
+    if(BulkEditDepth > 1) {
+        BulkEditDepth--;
+        return;
+    }
+
+    foreach(cwTrip* trip, Trips) {
+        trip->endBulkEdit();
+    }
+
+    BulkEditDepth = 0;
+    emit bulkEditFinished();
+}
+
 /**
   \brief Adds a trip to the cave
 
@@ -275,6 +406,9 @@ void cwCave::InsertRemoveTrip::insertTrips() {
         cave->Trips.insert(index, Trips[i]);
         Trips[i]->setParentCave(cave);
         Trips[i]->errorModel()->setParentModel(cave->errorModel());
+        if(cave->isBulkEditing()) {
+            Trips[i]->beginBulkEdit();
+        }
 //        cave->errorModel()->addParent(Trips[i]);
     }
 
@@ -286,6 +420,12 @@ void cwCave::InsertRemoveTrip::insertTrips() {
 
 void cwCave::InsertRemoveTrip::removeTrips() {
     cwCave* cave = CavePtr; //.data();
+    if(cave->isBulkEditing()) {
+        foreach(cwTrip* trip, Trips) {
+            trip->endBulkEdit();
+        }
+    }
+
     emit cave->beginRemoveTrips(BeginIndex, EndIndex);
     emit cave->beginRemoveRows(QModelIndex(), BeginIndex, EndIndex);
 
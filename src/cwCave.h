@@ -12,11 +12,13 @@
 class cwTrip;
 class cwLength;
 class cwErrorModel;
+class cwStationOccurrenceIndex;
 #include "cwStation.h"
 #include "cwUndoer.h"
 #include "cwStationPositionLookup.h"
 #include "cwGlobals.h"
 #include "cwSurveyNetwork.h"
+#include "cwCaveData.h"
 
 //Qt includes
 #include <QObject>
@@ -48,6 +50,12 @@ public:
     cwCave& operator=(const cwCave& object);
     ~cwCave();
 
+    cwCaveData data() const;
+    void setData(const cwCaveData& data);
+
+    qint64 id() const;
+    void setId(qint64 id);
+
     QString name() const;
     void setName(QString name);
 
@@ -55,6 +63,7 @@ public:
     cwLength* depth() const;
 
     cwErrorModel* errorModel() const;
+    cwStationOccurrenceIndex* stationOccurrenceIndex() const;
 
     int tripCount() const;
     cwTrip* trip(int index) const;
@@ -82,6 +91,10 @@ public:
 
     QList< cwStation > stations() const;
 
+    void beginBulkEdit();
+    void endBulkEdit();
+    bool isBulkEditing() const;
+
 signals:
     void beginInsertTrips(int begin, int end);
     void insertedTrips(int begin, int end);
@@ -94,6 +107,8 @@ signals:
     void stationPositionPositionChanged();
     void surveyNetworkChanged();
 
+    void bulkEditFinished();
+
 private:
     QList<cwTrip*> Trips;
     QString Name;
@@ -102,12 +117,17 @@ private:
     cwLength* Depth;
 
     cwErrorModel* ErrorModel; //!<
+    cwStationOccurrenceIndex* StationOccurrenceIndex; //!< Where each station is in the trips and scraps
 
     cwStationPositionLookup StationPositionModel;
     bool StationPositionModelStale;
 
     cwSurveyNetwork Network;
 
+    int BulkEditDepth; //!< Number of nested beginBulkEdit() calls
+
+    qint64 Id; //!< The cave's row in the project file, see cwRegionObjectId
+
     cwCave& Copy(const cwCave& object);
     void addTripNullHelper();
 
@@ -247,6 +267,23 @@ inline cwErrorModel* cwCave::errorModel() const {
     return ErrorModel;
 }
 
+/**
+* @brief cwCave::stationOccurrenceIndex
+* @return The index of where each station is in the cave's trips, shots, and scraps. This
+* should be used instead of searching through all the trips for a station.
+*/
+inline cwStationOccurrenceIndex* cwCave::stationOccurrenceIndex() const {
+    return StationOccurrenceIndex;
+}
+
+/**
+* @brief cwCave::isBulkEditing
+* @return True if beginBulkEdit() has been called without a matching endBulkEdit()
+*/
+inline bool cwCave::isBulkEditing() const {
+    return BulkEditDepth > 0;
+}
+
 
 
 #endif // CWCAVE_H
@@ -0,0 +1,43 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWCAVEDATA_H
+#define CWCAVEDATA_H
+
+//Our includes
+#include "cwTripData.h"
+#include "cwStationPositionLookup.h"
+#include "cwUnits.h"
+
+//Qt includes
+#include <QString>
+#include <QList>
+
+/**
+ * @brief The cwCaveData class
+ *
+ * A value copy of cwCave and its trips. This is part of a cwCavingRegionData snapshot.
+ */
+class cwCaveData {
+public:
+    cwCaveData() :
+        Id(0),
+        LengthUnit(cwUnits::Meters),
+        DepthUnit(cwUnits::Meters),
+        StationPositionsStale(false)
+    {}
+
+    qint64 Id; //!< See cwRegionObjectId, 0 if the cave doesn't have an id
+    QString Name;
+    cwUnits::LengthUnit LengthUnit;
+    cwUnits::LengthUnit DepthUnit;
+    QList<cwTripData> Trips;
+    cwStationPositionLookup StationPositions;
+    bool StationPositionsStale;
+};
+
+#endif // CWCAVEDATA_H
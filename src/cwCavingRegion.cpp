@@ -15,7 +15,8 @@
 #include <QDebug>
 
 cwCavingRegion::cwCavingRegion(QObject *parent) :
-    QAbstractListModel(parent)
+    QAbstractListModel(parent),
+    BulkEditDepth(0)
 {
 }
 
@@ -24,7 +25,8 @@ cwCavingRegion::cwCavingRegion(QObject *parent) :
   */
 cwCavingRegion::cwCavingRegion(const cwCavingRegion& object) :
     QAbstractListModel(nullptr),
-    cwUndoer(object.undoStack())
+    cwUndoer(object.undoStack()),
+    BulkEditDepth(0)
 {
     copy(object);
 }
@@ -101,25 +103,83 @@ cwCavingRegion& cwCavingRegion::copy(const cwCavingRegion& object) {
         return *this;
     }
 
+    QList<cwCave*> caves;
+    caves.reserve(object.Caves.size());
+    foreach(cwCave* cave, object.Caves) {
+        //Strange copying to make sure the newCaves are
+        //On the correct thread
+        caves.append(new cwCave(*cave));
+    }
+
+    replaceCaves(caves);
+
+    return *this;
+}
+
+/**
+ * @brief cwCavingRegion::data
+ * @return An implicitly shared snapshot of all the survey data in the region
+ *
+ * Creating the snapshot doesn't copy any stations, shots, or note data, so this is cheap to
+ * call on the GUI thread. The snapshot can be passed to tasks on other threads, and used after
+ * the region has been edited.
+ */
+cwCavingRegionData cwCavingRegion::data() const
+{
+    cwCavingRegionData data;
+    data.Caves.reserve(Caves.size());
+    foreach(cwCave* cave, Caves) {
+        data.Caves.append(cave->data());
+    }
+    return data;
+}
+
+/**
+ * @brief cwCavingRegion::setData
+ * @param data - Replaces all the caves in the region with the caves in data
+ *
+ * The new caves are created on the current thread, so this must be called on the region's
+ * thread. Unlike removeCaves() and addCaves(), this isn't undoable.
+ */
+void cwCavingRegion::setData(const cwCavingRegionData &data)
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+
+    QList<cwCave*> caves;
+    caves.reserve(data.Caves.size());
+    foreach(const cwCaveData& caveData, data.Caves) {
+        cwCave* cave = new cwCave();
+        cave->setData(caveData);
+        caves.append(cave);
+    }
+
+    replaceCaves(caves);
+}
+
+/**
+ * @brief cwCavingRegion::replaceCaves
+ * @param caves - The new caves, the region takes ownership of them
+ *
+ * Removes all the old caves and adds caves, without using the undo stack
+ */
+void cwCavingRegion::replaceCaves(QList<cwCave *> caves)
+{
     //Clear old caves
     int lastIndex = Caves.size() - 1;
     removeCaves(0, lastIndex);
 
-    if(!object.Caves.isEmpty()) {
-        emit beginInsertCaves(0, object.Caves.size() - 1);
-        emit beginInsertRows(QModelIndex(), 0, object.Caves.size() - 1);
+    if(!caves.isEmpty()) {
+        emit beginInsertCaves(0, caves.size() - 1);
+        emit beginInsertRows(QModelIndex(), 0, caves.size() - 1);
     }
 
     //Add new caves
-    Caves.reserve(object.Caves.size());
-    foreach(cwCave* cave, object.Caves) {
-
-        //Strange copying to make sure the newCaves are
-        //On the correct thread
-        cwCave* newCave = new cwCave(*cave);
-
+    Caves.reserve(caves.size());
+    foreach(cwCave* newCave, caves) {
         newCave->setParent(this);  //Uncomment because this cause problems with QML
-
+        if(isBulkEditing()) {
+            newCave->beginBulkEdit();
+        }
         Caves.append(newCave);
     }
 
@@ -128,10 +188,50 @@ cwCavingRegion& cwCavingRegion::copy(const cwCavingRegion& object) {
         emit endInsertRows();
         emit caveCountChanged();
     }
+}
 
-    return *this;
+
+/**
+ * @brief cwCavingRegion::beginBulkEdit
+ *
+ * Starts a bulk edit on all the caves in the region, see cwCave::beginBulkEdit(). Caves that are
+ * added during the bulk edit are also bulk edited. Calls can be nested.
+ *
+ * Listeners that recompute the whole region, like cwLinePlotManager, wait for
+ * bulkEditFinished() instead of recomputing for each change. Use this when importing or
+ * when an undo command changes many shots.
+ */
+void cwCavingRegion::beginBulkEdit()
+{
+    BulkEditDepth++;
+    if(BulkEditDepth == 1) {
+        foreach(cwCave* cave, Caves) {
+            cave->beginBulkEdit();
+        }
+    }
 }
 
+/**
+ * @brief cwCavingRegion::endBulkEdit
+ *
+ * Ends a bulk edit started with beginBulkEdit(). When the outer most bulk edit ends, all the caves
+ * end their bulk edits and then bulkEditFinished() is emitted.
+ */
+void cwCavingRegion::endBulkEdit()
+{
+    Q_ASSERT(BulkEditDepth > 0);
+    if(BulkEditDepth > 1) {
+        BulkEditDepth--;
+        return;
+    }
+
+    foreach(cwCave* cave, Caves) {
+        cave->endBulkEdit();
+    }
+
+    BulkEditDepth = 0;
+    emit bulkEditFinished();
+}
 
 /**
   \brief Creates a new cave and adds it to the caving region
@@ -282,6 +382,9 @@ void cwCavingRegion::InsertRemoveCave::insertCaves() {
         int index = BeginIndex + i;
         regionPtr->Caves.insert(index, Caves[i]);
         Caves[i]->setParent(regionPtr);
+        if(regionPtr->isBulkEditing()) {
+            Caves[i]->beginBulkEdit();
+        }
     }
 
     OwnsCaves = false;
@@ -298,6 +401,12 @@ void cwCavingRegion::InsertRemoveCave::removeCaves() {
 //    if(Region.isNull()) { return; }
     cwCavingRegion* regionPtr = Region; //.data();
 
+    if(regionPtr->isBulkEditing()) {
+        foreach(cwCave* cave, Caves) {
+            cave->endBulkEdit();
+        }
+    }
+
     emit regionPtr->beginRemoveCaves(BeginIndex, EndIndex);
     emit regionPtr->beginRemoveRows(QModelIndex(), BeginIndex, EndIndex);
 
@@ -20,6 +20,7 @@
 class cwCave;
 #include "cwUndoer.h"
 #include "cwGlobals.h"
+#include "cwCavingRegionData.h"
 
 class CAVEWHERE_LIB_EXPORT cwCavingRegion : public QAbstractListModel, public cwUndoer
 {
@@ -36,6 +37,9 @@ public:
     explicit cwCavingRegion(QObject *parent = nullptr);
     cwCavingRegion(const cwCavingRegion& object);
     cwCavingRegion& operator=(const cwCavingRegion& object);
+
+    cwCavingRegionData data() const;
+    void setData(const cwCavingRegionData& data);
 //    ~cwCavingRegion() { qDebug() << "Deleted: " << this; }
 
     bool hasCaves() const;
@@ -57,6 +61,9 @@ public:
 
     int indexOf(cwCave* cave);
 
+    void beginBulkEdit();
+    void endBulkEdit();
+    bool isBulkEditing() const;
 
 signals:
     void beginInsertCaves(int begin, int end);
@@ -67,6 +74,8 @@ signals:
 
     void caveCountChanged();
 
+    void bulkEditFinished();
+
 public slots:
 
 protected:
@@ -75,7 +84,10 @@ protected:
     virtual void setUndoStackForChildren();
 
 private:
+    int BulkEditDepth; //!< Number of nested beginBulkEdit() calls
+
     cwCavingRegion& copy(const cwCavingRegion& object);
+    void replaceCaves(QList<cwCave*> caves);
 
     void unparentCave(cwCave* cave);
     void addCaveHelper();
@@ -147,4 +159,12 @@ inline QList<cwCave*> cwCavingRegion::caves() const {
     return Caves;
 }
 
+/**
+ * @brief cwCavingRegion::isBulkEditing
+ * @return True if beginBulkEdit() has been called without a matching endBulkEdit()
+ */
+inline bool cwCavingRegion::isBulkEditing() const {
+    return BulkEditDepth > 0;
+}
+
 #endif // CWCAVINGREGION_H
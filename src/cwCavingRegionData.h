@@ -0,0 +1,32 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWCAVINGREGIONDATA_H
+#define CWCAVINGREGIONDATA_H
+
+//Our includes
+#include "cwCaveData.h"
+
+//Qt includes
+#include <QList>
+
+/**
+ * @brief The cwCavingRegionData class
+ *
+ * An immutable snapshot of all the survey data in a cwCavingRegion, see cwCavingRegion::data().
+ *
+ * The snapshot is made of implicitly shared Qt containers, so it can be copied in constant
+ * time, and passed to tasks on other threads without moving QObjects between threads. The
+ * stations, shots, note stations, leads, and triangulated data are shared with the region's
+ * objects, so only the parts that are edited after the snapshot is taken are ever copied.
+ */
+class cwCavingRegionData {
+public:
+    QList<cwCaveData> Caves;
+};
+
+#endif // CWCAVINGREGIONDATA_H
@@ -126,7 +126,11 @@ void cwCompassImporter::parseSurvey(QFile *file)
     parseTripDate(file);
     parseSurveyTeam(file);
     parseSurveyFormatAndCalibration(file);
+
+    //Errors are checked once for each chunk, instead of once for each shot
+    CurrentTrip->beginBulkEdit();
     parseSurveyData(file);
+    CurrentTrip->endBulkEdit();
 
     qint64 position = file->pos();
     QByteArray lastLine = file->readLine();
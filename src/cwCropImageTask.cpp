@@ -109,7 +109,7 @@ void cwCropImageTask::runTask() {
   This size is the size of the original image.  This is useful for converting normalize rectangle
   into a rectangle.
   */
-QRect cwCropImageTask::mapNormalizedToIndex(QRectF normalized, QSize size) const {
+QRect cwCropImageTask::mapNormalizedToIndex(QRectF normalized, QSize size) {
     int left = qRound(normalized.left() * size.width());
     int right = qRound(normalized.right() * size.width());
     int top = qRound((1.0 - normalized.bottom()) * size.height());
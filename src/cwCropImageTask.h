@@ -37,6 +37,8 @@ public:
     //Output
     cwImage croppedImage() const;
 
+    static QRect mapNormalizedToIndex(QRectF normalized, QSize size);
+
 protected:
     virtual void runTask();
 
@@ -54,8 +56,6 @@ private:
     //For writting the cropped image
     cwAddImageTask* AddImageTask;
 
-    QRect mapNormalizedToIndex(QRectF normalized, QSize size) const;
-
 };
 
 #endif // CWCROPIMAGETASK_H
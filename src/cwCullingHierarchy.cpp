@@ -0,0 +1,173 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwCullingHierarchy.h"
+
+//Std includes
+#include <algorithm>
+
+namespace {
+
+//The most parts in a leaf, before it's split
+const int MaxLeafSize = 4;
+
+}
+
+cwCullingHierarchy::cwCullingHierarchy() :
+    CacheValid(false)
+{
+}
+
+/**
+ * @brief cwCullingHierarchy::setBounds
+ * @param bounds - The bounds of each part, a part's index is its index in bounds. Null boxes are
+ * never visible.
+ *
+ * Rebuilds the hierarchy. Parts are split at the median of their centers, along the longest axis.
+ */
+void cwCullingHierarchy::setBounds(const QVector<QBox3D>& bounds)
+{
+    Bounds = bounds;
+    Order.clear();
+    Nodes.clear();
+    Visible.clear();
+    CacheValid = false;
+
+    Order.reserve(Bounds.size());
+    for(int i = 0; i < Bounds.size(); i++) {
+        if(!Bounds.at(i).isNull()) {
+            Order.append(i);
+        }
+    }
+
+    if(!Order.isEmpty()) {
+        Nodes.reserve(Order.size() * 2 / MaxLeafSize + 1);
+        build(0, Order.size());
+    }
+}
+
+/**
+ * @brief cwCullingHierarchy::cull
+ * @param viewProjection - The camera's view projection matrix
+ * @return True if visible() was updated, and false if it's the same as the last cull()
+ */
+bool cwCullingHierarchy::cull(const QMatrix4x4& viewProjection)
+{
+    if(CacheValid && CachedViewProjection == viewProjection) {
+        return false;
+    }
+
+    CachedViewProjection = viewProjection;
+    CacheValid = true;
+
+    Visible.clear();
+    if(!Nodes.isEmpty()) {
+        collect(0, cwFrustum(viewProjection));
+        std::sort(Visible.begin(), Visible.end());
+    }
+
+    return true;
+}
+
+/**
+ * @brief cwCullingHierarchy::build
+ * @return The index of the node that holds Order[first, first + count)
+ */
+int cwCullingHierarchy::build(int first, int count)
+{
+    int nodeIndex = Nodes.size();
+    Nodes.append(Node());
+
+    QBox3D box;
+    QBox3D centers;
+    for(int i = first; i < first + count; i++) {
+        const QBox3D& bounds = Bounds.at(Order.at(i));
+        box.unite(bounds);
+        centers.unite(bounds.center());
+    }
+
+    Nodes[nodeIndex].Box = box;
+
+    QVector3D size = centers.size();
+    if(count <= MaxLeafSize || size == QVector3D()) {
+        Nodes[nodeIndex].First = first;
+        Nodes[nodeIndex].Count = count;
+        return nodeIndex;
+    }
+
+    int axis = 0;
+    if(size.y() > size[axis]) { axis = 1; }
+    if(size.z() > size[axis]) { axis = 2; }
+
+    int half = count / 2;
+    const QVector<QBox3D>& allBounds = Bounds;
+    std::nth_element(Order.begin() + first,
+                     Order.begin() + first + half,
+                     Order.begin() + first + count,
+                     [&allBounds, axis](int a, int b) {
+        return allBounds.at(a).center()[axis] < allBounds.at(b).center()[axis];
+    });
+
+    //The left child is always the next node
+    build(first, half);
+    int right = build(first + half, count - half);
+
+    Nodes[nodeIndex].First = right;
+    Nodes[nodeIndex].Count = 0;
+    return nodeIndex;
+}
+
+/**
+ * @brief cwCullingHierarchy::collect
+ *
+ * Adds the parts under nodeIndex that intersect the frustum to Visible
+ */
+void cwCullingHierarchy::collect(int nodeIndex, const cwFrustum& frustum)
+{
+    const Node& node = Nodes.at(nodeIndex);
+
+    switch(frustum.contains(node.Box)) {
+    case cwFrustum::Outside:
+        return;
+    case cwFrustum::Inside:
+        collectAll(nodeIndex);
+        return;
+    case cwFrustum::Intersecting:
+        break;
+    }
+
+    if(node.Count > 0) {
+        for(int i = node.First; i < node.First + node.Count; i++) {
+            int part = Order.at(i);
+            if(frustum.contains(Bounds.at(part)) != cwFrustum::Outside) {
+                Visible.append(part);
+            }
+        }
+    } else {
+        collect(nodeIndex + 1, frustum);
+        collect(node.First, frustum);
+    }
+}
+
+/**
+ * @brief cwCullingHierarchy::collectAll
+ *
+ * Adds all the parts under nodeIndex to Visible
+ */
+void cwCullingHierarchy::collectAll(int nodeIndex)
+{
+    const Node& node = Nodes.at(nodeIndex);
+    if(node.Count > 0) {
+        for(int i = node.First; i < node.First + node.Count; i++) {
+            Visible.append(Order.at(i));
+        }
+    } else {
+        collectAll(nodeIndex + 1);
+        collectAll(node.First);
+    }
+}
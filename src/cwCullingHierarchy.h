@@ -0,0 +1,81 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWCULLINGHIERARCHY_H
+#define CWCULLINGHIERARCHY_H
+
+//Our includes
+#include "cwGlobals.h"
+#include "cwFrustum.h"
+
+//Qt includes
+#include <QVector>
+#include <QBox3D>
+#include <QMatrix4x4>
+
+/**
+ * @brief The cwCullingHierarchy class
+ *
+ * A bounding box hierarchy over the parts of a cwGLObject, like its scraps, that's used to find
+ * the parts that are in the camera's view. Subtrees that are completely outside of the frustum
+ * are skipped, and subtrees that are completely inside are added without testing their children.
+ *
+ * The visible parts are cached until the view projection matrix or the bounds change, so nothing
+ * is tested while the camera is still.
+ */
+class CAVEWHERE_LIB_EXPORT cwCullingHierarchy
+{
+public:
+    cwCullingHierarchy();
+
+    void setBounds(const QVector<QBox3D>& bounds);
+    QVector<QBox3D> bounds() const;
+
+    bool cull(const QMatrix4x4& viewProjection);
+    const QVector<int>& visible() const;
+
+private:
+    class Node {
+    public:
+        QBox3D Box;
+        int First; //!< Leaf: the first index in Order, otherwise the left child
+        int Count; //!< The number of parts in a leaf, 0 for interior nodes
+    };
+
+    QVector<QBox3D> Bounds;
+    QVector<int> Order; //!< Indexes into Bounds, in tree order
+    QVector<Node> Nodes; //!< The first node is the root
+
+    bool CacheValid;
+    QMatrix4x4 CachedViewProjection;
+    QVector<int> Visible;
+
+    int build(int first, int count);
+    void collect(int nodeIndex, const cwFrustum& frustum);
+    void collectAll(int nodeIndex);
+};
+
+/**
+ * @brief cwCullingHierarchy::bounds
+ * @return The bounds of each part
+ */
+inline QVector<QBox3D> cwCullingHierarchy::bounds() const
+{
+    return Bounds;
+}
+
+/**
+ * @brief cwCullingHierarchy::visible
+ * @return The indexes of the parts that were visible in the last cull(), sorted from smallest to
+ * largest
+ */
+inline const QVector<int>& cwCullingHierarchy::visible() const
+{
+    return Visible;
+}
+
+#endif // CWCULLINGHIERARCHY_H
@@ -0,0 +1,572 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwDxt1Encoder.h"
+#include "cwTask.h"
+
+//Qt includes
+#include <QtConcurrentMap>
+#include <QVector>
+
+//Std includes
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CW_DXT1_SSE2
+#include <emmintrin.h>
+#endif
+
+/**
+  The four colors that a block's indices select from. Colors are r, g, b.
+  */
+class Dxt1Palette {
+public:
+    int Colors[4][3];
+};
+
+static inline int clampToByte(int value) {
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static inline quint16 packRgb565(int r, int g, int b) {
+    return (quint16)(((r * 31 + 127) / 255) << 11 |
+                     ((g * 63 + 127) / 255) << 5 |
+                     ((b * 31 + 127) / 255));
+}
+
+static inline void unpackRgb565(quint16 color, int* rgb) {
+    int r = (color >> 11) & 0x1F;
+    int g = (color >> 5) & 0x3F;
+    int b = color & 0x1F;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+/**
+  The four color mode palette, color0 must be greater than color1
+  */
+static inline Dxt1Palette createPalette(quint16 color0, quint16 color1) {
+    Dxt1Palette palette;
+    unpackRgb565(color0, palette.Colors[0]);
+    unpackRgb565(color1, palette.Colors[1]);
+    for(int i = 0; i < 3; i++) {
+        palette.Colors[2][i] = (2 * palette.Colors[0][i] + palette.Colors[1][i]) / 3;
+        palette.Colors[3][i] = (palette.Colors[0][i] + 2 * palette.Colors[1][i]) / 3;
+    }
+    return palette;
+}
+
+/**
+  Finds the closest palette color for the 16 pixels, and returns the sum of the squared errors
+  */
+static int selectIndices(const quint8* rgba, const Dxt1Palette& palette, quint8* indices) {
+    int error = 0;
+
+#ifdef CW_DXT1_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgbMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+
+    __m128i colors[4];
+    for(int k = 0; k < 4; k++) {
+        const int* color = palette.Colors[k];
+        colors[k] = _mm_set_epi16(0, color[2], color[1], color[0], 0, color[2], color[1], color[0]);
+    }
+
+    for(int i = 0; i < 4; i++) {
+        //Four pixels, widened to two pixels per register
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + 16 * i));
+        __m128i low = _mm_and_si128(_mm_unpacklo_epi8(pixels, zero), rgbMask);
+        __m128i high = _mm_and_si128(_mm_unpackhi_epi8(pixels, zero), rgbMask);
+
+        __m128i bestDistance = _mm_set1_epi32(INT_MAX);
+        __m128i bestIndex = zero;
+
+        for(int k = 0; k < 4; k++) {
+            __m128i lowDiff = _mm_sub_epi16(low, colors[k]);
+            __m128i highDiff = _mm_sub_epi16(high, colors[k]);
+
+            //r*r + g*g and b*b for each pixel
+            lowDiff = _mm_madd_epi16(lowDiff, lowDiff);
+            highDiff = _mm_madd_epi16(highDiff, highDiff);
+            lowDiff = _mm_add_epi32(lowDiff, _mm_srli_epi64(lowDiff, 32));
+            highDiff = _mm_add_epi32(highDiff, _mm_srli_epi64(highDiff, 32));
+
+            __m128i distance = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lowDiff),
+                                                               _mm_castsi128_ps(highDiff),
+                                                               _MM_SHUFFLE(2, 0, 2, 0)));
+
+            __m128i closer = _mm_cmplt_epi32(distance, bestDistance);
+            bestDistance = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, bestDistance));
+            bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, bestIndex));
+        }
+
+        int distances[4];
+        int pixelIndices[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(distances), bestDistance);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixelIndices), bestIndex);
+        for(int j = 0; j < 4; j++) {
+            indices[4 * i + j] = (quint8)pixelIndices[j];
+            error += distances[j];
+        }
+    }
+#else
+    for(int i = 0; i < 16; i++) {
+        const quint8* pixel = rgba + 4 * i;
+        int bestDistance = INT_MAX;
+        for(int k = 0; k < 4; k++) {
+            const int* color = palette.Colors[k];
+            int dr = pixel[0] - color[0];
+            int dg = pixel[1] - color[1];
+            int db = pixel[2] - color[2];
+            int distance = dr * dr + dg * dg + db * db;
+            if(distance < bestDistance) {
+                bestDistance = distance;
+                indices[i] = (quint8)k;
+            }
+        }
+        error += bestDistance;
+    }
+#endif
+
+    return error;
+}
+
+/**
+  Finds the per channel minimum and maximum of the 16 pixels
+  */
+static void colorBounds(const quint8* rgba, int* minColor, int* maxColor) {
+#ifdef CW_DXT1_SSE2
+    const __m128i* pixels = reinterpret_cast<const __m128i*>(rgba);
+    __m128i p0 = _mm_loadu_si128(pixels);
+    __m128i p1 = _mm_loadu_si128(pixels + 1);
+    __m128i p2 = _mm_loadu_si128(pixels + 2);
+    __m128i p3 = _mm_loadu_si128(pixels + 3);
+
+    __m128i minimum = _mm_min_epu8(_mm_min_epu8(p0, p1), _mm_min_epu8(p2, p3));
+    __m128i maximum = _mm_max_epu8(_mm_max_epu8(p0, p1), _mm_max_epu8(p2, p3));
+    minimum = _mm_min_epu8(minimum, _mm_shuffle_epi32(minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+    maximum = _mm_max_epu8(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(1, 0, 3, 2)));
+    minimum = _mm_min_epu8(minimum, _mm_shuffle_epi32(minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+    maximum = _mm_max_epu8(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    quint32 minPixel = (quint32)_mm_cvtsi128_si32(minimum);
+    quint32 maxPixel = (quint32)_mm_cvtsi128_si32(maximum);
+    for(int i = 0; i < 3; i++) {
+        minColor[i] = (minPixel >> (8 * i)) & 0xFF;
+        maxColor[i] = (maxPixel >> (8 * i)) & 0xFF;
+    }
+#else
+    for(int i = 0; i < 3; i++) {
+        minColor[i] = 255;
+        maxColor[i] = 0;
+    }
+    for(int p = 0; p < 16; p++) {
+        for(int i = 0; i < 3; i++) {
+            minColor[i] = std::min(minColor[i], (int)rgba[4 * p + i]);
+            maxColor[i] = std::max(maxColor[i], (int)rgba[4 * p + i]);
+        }
+    }
+#endif
+}
+
+/**
+  A block's end points, indices, and the squared error of the block
+  */
+class Dxt1Candidate {
+public:
+    Dxt1Candidate() :
+        Color0(0),
+        Color1(0),
+        Error(INT_MAX)
+    {}
+
+    quint16 Color0;
+    quint16 Color1;
+    quint8 Indices[16];
+    int Error;
+};
+
+/**
+  Quantizes the end points, picks the indices, and keeps the result in best, if it's better
+  */
+static void tryEndPoints(const quint8* rgba, const int* end0, const int* end1, Dxt1Candidate* best) {
+    quint16 color0 = packRgb565(end0[0], end0[1], end0[2]);
+    quint16 color1 = packRgb565(end1[0], end1[1], end1[2]);
+
+    //The four color mode needs color0 > color1
+    if(color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    Dxt1Candidate candidate;
+    candidate.Color0 = color0;
+    candidate.Color1 = color1;
+
+    if(color0 == color1) {
+        //Solid block, every index is color0
+        int color[3];
+        unpackRgb565(color0, color);
+        candidate.Error = 0;
+        for(int i = 0; i < 16; i++) {
+            candidate.Indices[i] = 0;
+            for(int c = 0; c < 3; c++) {
+                int diff = rgba[4 * i + c] - color[c];
+                candidate.Error += diff * diff;
+            }
+        }
+    } else {
+        candidate.Error = selectIndices(rgba, createPalette(color0, color1), candidate.Indices);
+    }
+
+    if(candidate.Error < best->Error) {
+        *best = candidate;
+    }
+}
+
+/**
+  End points from the block's bounding box. The box is inset a little, because the extreme
+  colors are usually outliers. The diagonal of the box follows the block's color correlation.
+  */
+static void boundingBoxEndPoints(const quint8* rgba, int* end0, int* end1) {
+    int minColor[3];
+    int maxColor[3];
+    colorBounds(rgba, minColor, maxColor);
+
+    for(int i = 0; i < 3; i++) {
+        int inset = (maxColor[i] - minColor[i]) >> 4;
+        end0[i] = maxColor[i] - inset;
+        end1[i] = minColor[i] + inset;
+    }
+
+    //Flip the red and blue ranges, if they're anti correlated with green
+    int mean[3] = {0, 0, 0};
+    for(int p = 0; p < 16; p++) {
+        for(int i = 0; i < 3; i++) {
+            mean[i] += rgba[4 * p + i];
+        }
+    }
+
+    int covarianceRG = 0;
+    int covarianceBG = 0;
+    for(int p = 0; p < 16; p++) {
+        const quint8* pixel = rgba + 4 * p;
+        int g = 16 * pixel[1] - mean[1];
+        covarianceRG += (16 * pixel[0] - mean[0]) * g;
+        covarianceBG += (16 * pixel[2] - mean[2]) * g;
+    }
+
+    if(covarianceRG < 0) {
+        std::swap(end0[0], end1[0]);
+    }
+
+    if(covarianceBG < 0) {
+        std::swap(end0[2], end1[2]);
+    }
+}
+
+/**
+  End points from the block's principal axis. Returns false if the block is a solid color.
+  */
+static bool principalAxisEndPoints(const quint8* rgba, int* end0, int* end1) {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for(int p = 0; p < 16; p++) {
+        for(int i = 0; i < 3; i++) {
+            mean[i] += rgba[4 * p + i];
+        }
+    }
+    for(int i = 0; i < 3; i++) {
+        mean[i] /= 16.0f;
+    }
+
+    //The covariance matrix, rr, rg, rb, gg, gb, bb
+    float covariance[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    for(int p = 0; p < 16; p++) {
+        float r = rgba[4 * p] - mean[0];
+        float g = rgba[4 * p + 1] - mean[1];
+        float b = rgba[4 * p + 2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    //Power iteration for the largest eigenvector
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for(int iteration = 0; iteration < 8; iteration++) {
+        float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+        float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+        float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+        float length = std::max(std::fabs(x), std::max(std::fabs(y), std::fabs(z)));
+        if(length == 0.0f) {
+            return false;
+        }
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    float minProjection = std::numeric_limits<float>::max();
+    float maxProjection = -std::numeric_limits<float>::max();
+    for(int p = 0; p < 16; p++) {
+        float projection = (rgba[4 * p] - mean[0]) * axis[0] +
+                (rgba[4 * p + 1] - mean[1]) * axis[1] +
+                (rgba[4 * p + 2] - mean[2]) * axis[2];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    float axisLengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    minProjection /= axisLengthSquared;
+    maxProjection /= axisLengthSquared;
+
+    for(int i = 0; i < 3; i++) {
+        end0[i] = clampToByte((int)std::floor(mean[i] + axis[i] * maxProjection + 0.5f));
+        end1[i] = clampToByte((int)std::floor(mean[i] + axis[i] * minProjection + 0.5f));
+    }
+    return true;
+}
+
+/**
+  Least squares fit of the end points for the candidate's indices. Returns false if the indices
+  don't constrain the end points.
+  */
+static bool refineEndPoints(const quint8* rgba, const Dxt1Candidate& candidate, int* end0, int* end1) {
+    //How much of color0 and color1 each index blends, in thirds
+    static const int weight0[4] = {3, 0, 2, 1};
+    static const int weight1[4] = {0, 3, 1, 2};
+
+    int aa = 0;
+    int ab = 0;
+    int bb = 0;
+    int ax[3] = {0, 0, 0};
+    int bx[3] = {0, 0, 0};
+
+    for(int p = 0; p < 16; p++) {
+        int index = candidate.Indices[p];
+        int a = weight0[index];
+        int b = weight1[index];
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for(int i = 0; i < 3; i++) {
+            ax[i] += a * rgba[4 * p + i];
+            bx[i] += b * rgba[4 * p + i];
+        }
+    }
+
+    int determinant = aa * bb - ab * ab;
+    if(determinant == 0) {
+        return false;
+    }
+
+    //The weights are in thirds, so the solution is scaled by 3
+    float scale = 3.0f / determinant;
+    for(int i = 0; i < 3; i++) {
+        end0[i] = clampToByte((int)std::floor((bb * ax[i] - ab * bx[i]) * scale + 0.5f));
+        end1[i] = clampToByte((int)std::floor((aa * bx[i] - ab * ax[i]) * scale + 0.5f));
+    }
+    return true;
+}
+
+static void writeBlock(const Dxt1Candidate& candidate, quint8* block) {
+    quint32 indices = 0;
+    for(int i = 15; i >= 0; i--) {
+        indices = (indices << 2) | candidate.Indices[i];
+    }
+
+    block[0] = candidate.Color0 & 0xFF;
+    block[1] = candidate.Color0 >> 8;
+    block[2] = candidate.Color1 & 0xFF;
+    block[3] = candidate.Color1 >> 8;
+    block[4] = indices & 0xFF;
+    block[5] = (indices >> 8) & 0xFF;
+    block[6] = (indices >> 16) & 0xFF;
+    block[7] = indices >> 24;
+}
+
+/**
+  \brief Compresses one row of blocks
+  */
+class cwDxt1Encoder::CompressRowKernal {
+public:
+    CompressRowKernal(const cwDxt1Encoder* encoder, const QImage* image, quint8* output) :
+        Encoder(encoder),
+        Image(image),
+        Output(output)
+    {}
+
+    const cwDxt1Encoder* Encoder;
+    const QImage* Image;
+    quint8* Output;
+
+    void operator()(int blockRow) {
+        if(Encoder->Task != nullptr && !Encoder->Task->isRunning()) { return; }
+
+        int width = Image->width();
+        int height = Image->height();
+        int blocksPerRow = (width + 3) / 4;
+
+        //Pixels past the edge of the image repeat the edge
+        const uchar* lines[4];
+        for(int y = 0; y < 4; y++) {
+            lines[y] = Image->constScanLine(std::min(blockRow * 4 + y, height - 1));
+        }
+
+        quint8* block = Output + blockRow * blocksPerRow * 8;
+        quint8 rgba[16 * 4];
+        for(int blockColumn = 0; blockColumn < blocksPerRow; blockColumn++) {
+            for(int y = 0; y < 4; y++) {
+                for(int x = 0; x < 4; x++) {
+                    int column = std::min(blockColumn * 4 + x, width - 1);
+                    memcpy(rgba + 4 * (4 * y + x), lines[y] + 4 * column, 4);
+                }
+            }
+
+            compressBlock(rgba, block, Encoder->CompressionQuality);
+            block += 8;
+        }
+
+        if(Encoder->Progress) {
+            Encoder->Progress(blocksPerRow);
+        }
+    }
+};
+
+cwDxt1Encoder::cwDxt1Encoder() :
+    CompressionQuality(HighQuality),
+    Task(nullptr)
+{
+}
+
+/**
+ * @brief cwDxt1Encoder::compress
+ * @param image - The image that'll be compressed, the image's first scan line is the first row
+ * of blocks.
+ * @return The image's DXT1 blocks, row by row
+ */
+QByteArray cwDxt1Encoder::compress(const QImage &image) const
+{
+    if(image.isNull()) {
+        return QByteArray();
+    }
+
+    QImage rgbaImage = image.convertToFormat(QImage::Format_RGBA8888);
+
+    QByteArray output;
+    output.resize(storageSize(image.size()));
+
+    int blockRows = (image.height() + 3) / 4;
+    QVector<int> rows;
+    rows.reserve(blockRows);
+    for(int i = 0; i < blockRows; i++) {
+        rows.append(i);
+    }
+
+    QtConcurrent::blockingMap(rows, CompressRowKernal(this,
+                                                      &rgbaImage,
+                                                      reinterpret_cast<quint8*>(output.data())));
+
+    return output;
+}
+
+/**
+ * @brief cwDxt1Encoder::storageSize
+ * @return The number of bytes of the DXT1 blocks for an image of imageSize
+ */
+int cwDxt1Encoder::storageSize(QSize imageSize)
+{
+    return ((imageSize.width() + 3) / 4) * ((imageSize.height() + 3) / 4) * 8;
+}
+
+/**
+ * @brief cwDxt1Encoder::compressBlock
+ * @param rgba - 16 pixels, row by row, 4 bytes per pixel. The alpha is ignored.
+ * @param block - The 8 bytes of the compressed block
+ */
+void cwDxt1Encoder::compressBlock(const quint8 *rgba, quint8 *block, Quality quality)
+{
+    Dxt1Candidate best;
+
+    int end0[3];
+    int end1[3];
+    boundingBoxEndPoints(rgba, end0, end1);
+    tryEndPoints(rgba, end0, end1, &best);
+
+    if(best.Error > 0 && refineEndPoints(rgba, best, end0, end1)) {
+        tryEndPoints(rgba, end0, end1, &best);
+    }
+
+    if(quality == HighQuality && best.Error > 0) {
+        if(principalAxisEndPoints(rgba, end0, end1)) {
+            tryEndPoints(rgba, end0, end1, &best);
+        }
+
+        for(int iteration = 0; iteration < 2 && best.Error > 0; iteration++) {
+            int previousError = best.Error;
+            if(!refineEndPoints(rgba, best, end0, end1)) {
+                break;
+            }
+            tryEndPoints(rgba, end0, end1, &best);
+            if(best.Error == previousError) {
+                break;
+            }
+        }
+    }
+
+    writeBlock(best, block);
+}
+
+/**
+ * @brief cwDxt1Encoder::decompressBlock
+ * @param block - The 8 bytes of a DXT1 block
+ * @param rgba - The block's 16 pixels, row by row, 4 bytes per pixel
+ *
+ * Transparent pixels, in the three color mode, are black with zero alpha
+ */
+void cwDxt1Encoder::decompressBlock(const quint8 *block, quint8 *rgba)
+{
+    quint16 color0 = block[0] | (block[1] << 8);
+    quint16 color1 = block[2] | (block[3] << 8);
+    quint32 indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((quint32)block[7] << 24);
+
+    int colors[4][4];
+    unpackRgb565(color0, colors[0]);
+    unpackRgb565(color1, colors[1]);
+    colors[0][3] = 255;
+    colors[1][3] = 255;
+    colors[2][3] = 255;
+    colors[3][3] = 255;
+
+    if(color0 > color1) {
+        Dxt1Palette palette = createPalette(color0, color1);
+        for(int i = 0; i < 3; i++) {
+            colors[2][i] = palette.Colors[2][i];
+            colors[3][i] = palette.Colors[3][i];
+        }
+    } else {
+        for(int i = 0; i < 3; i++) {
+            colors[2][i] = (colors[0][i] + colors[1][i]) / 2;
+            colors[3][i] = 0;
+        }
+        colors[3][3] = 0;
+    }
+
+    for(int p = 0; p < 16; p++) {
+        int index = (indices >> (2 * p)) & 0x3;
+        for(int i = 0; i < 4; i++) {
+            rgba[4 * p + i] = (quint8)colors[index][i];
+        }
+    }
+}
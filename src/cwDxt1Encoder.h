@@ -0,0 +1,105 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWDXT1ENCODER_H
+#define CWDXT1ENCODER_H
+
+//Our includes
+#include "cwGlobals.h"
+class cwTask;
+
+//Qt includes
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+
+//Std includes
+#include <functional>
+
+/**
+ * @brief The cwDxt1Encoder class
+ *
+ * Compresses images into DXT1 (BC1) blocks in software, without an OpenGL context. The
+ * blocks have no alpha, all the blocks use the four color mode.
+ *
+ * Fast finds the block's end points with the bounding box of the block's colors, and refines
+ * them once with least squares. HighQuality also tries the block's principal axis, and refines
+ * the best end points up to two more times, so it's never worse than Fast. HighQuality is meant
+ * to be close to squish's cluster fit on scanned notes. Dxt1EncoderTest compares the two, its
+ * bounds are provisional until they've been measured. Fast is about twice as fast as HighQuality.
+ *
+ * Rows of blocks are compressed in parallel on the global thread pool. The block math uses
+ * SSE2 when it's available.
+ */
+class CAVEWHERE_LIB_EXPORT cwDxt1Encoder
+{
+public:
+    enum Quality {
+        Fast,
+        HighQuality
+    };
+
+    cwDxt1Encoder();
+
+    void setQuality(Quality quality);
+    Quality quality() const;
+
+    void setTask(cwTask* task);
+    void setProgressFunction(std::function<void (int numberOfBlocks)> progress);
+
+    QByteArray compress(const QImage& image) const;
+
+    static int storageSize(QSize imageSize);
+    static void compressBlock(const quint8* rgba, quint8* block, Quality quality);
+    static void decompressBlock(const quint8* block, quint8* rgba);
+
+private:
+    class CompressRowKernal;
+
+    Quality CompressionQuality;
+    cwTask* Task; //!< Stops compressing if the task stops, can be null
+    std::function<void (int)> Progress; //!< Called after each row of blocks has been compressed
+};
+
+/**
+ * @brief cwDxt1Encoder::setQuality
+ * @param quality - Trades the compression's speed for quality, by default this is HighQuality
+ */
+inline void cwDxt1Encoder::setQuality(cwDxt1Encoder::Quality quality)
+{
+    CompressionQuality = quality;
+}
+
+/**
+ * @brief cwDxt1Encoder::quality
+ * @return The compression's quality
+ */
+inline cwDxt1Encoder::Quality cwDxt1Encoder::quality() const
+{
+    return CompressionQuality;
+}
+
+/**
+ * @brief cwDxt1Encoder::setTask
+ * @param task - If the task stops running, compress() will stop early and the output is incomplete
+ */
+inline void cwDxt1Encoder::setTask(cwTask *task)
+{
+    Task = task;
+}
+
+/**
+ * @brief cwDxt1Encoder::setProgressFunction
+ * @param progress - Called with the number of blocks that have been compressed. This is called
+ * from the thread pool's threads.
+ */
+inline void cwDxt1Encoder::setProgressFunction(std::function<void (int)> progress)
+{
+    Progress = progress;
+}
+
+#endif // CWDXT1ENCODER_H
@@ -14,6 +14,8 @@ cwErrorModel::cwErrorModel(QObject *parent) :
     FatalCount(0),
     WarningCount(0),
     FatalWaringCountUptoDate(false),
+    UnlistedFatalCount(0),
+    UnlistedWarningCount(0),
     Errors(new cwErrorListModel(this)),
     Parent(nullptr)
 {
@@ -123,8 +125,8 @@ void cwErrorModel::checkForCountChanged(QModelIndex topLeft, QModelIndex bottomR
  */
 void cwErrorModel::updateFatalAndWarningCount() const
 {
-    FatalCount = 0;
-    WarningCount = 0;
+    FatalCount = UnlistedFatalCount;
+    WarningCount = UnlistedWarningCount;
 
     for(int i = 0; i < Errors->count(); i++) {
         cwError error = Errors->at(i);
@@ -189,3 +191,25 @@ QList<cwErrorModel *> cwErrorModel::childModels() const
 {
     return ChildModels;
 }
+
+/**
+ * @brief cwErrorModel::setUnlistedCount
+ * @param fatalCount - The number of fatal errors
+ * @param warningCount - The number of unsuppressed warnings
+ *
+ * Adds errors to fatalCount() and warningCount() that aren't stored in errors() or in a child
+ * model. cwSurveyChunk uses this for its cell errors, which are only put in a cwErrorModel when
+ * the cell is viewed.
+ */
+void cwErrorModel::setUnlistedCount(int fatalCount, int warningCount)
+{
+    if(UnlistedFatalCount != fatalCount) {
+        UnlistedFatalCount = fatalCount;
+        makeFatalDirty();
+    }
+
+    if(UnlistedWarningCount != warningCount) {
+        UnlistedWarningCount = warningCount;
+        makeWarningDirty();
+    }
+}
@@ -40,6 +40,8 @@ public:
 
     QList<cwErrorModel*> childModels() const;
 
+    void setUnlistedCount(int fatalCount, int warningCount);
+
 signals:
     void fatalCountChanged();
     void warningCountChanged();
@@ -50,6 +52,9 @@ private:
 
     mutable bool FatalWaringCountUptoDate;
 
+    int UnlistedFatalCount; //!< Errors counted by this model, that aren't in Errors or ChildModels
+    int UnlistedWarningCount; //!< Warnings counted by this model, that aren't in Errors or ChildModels
+
     cwErrorListModel* Errors;
     QList<cwErrorModel*> ChildModels;
 
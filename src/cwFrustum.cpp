@@ -0,0 +1,81 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwFrustum.h"
+
+/**
+ * @brief cwFrustum::cwFrustum
+ *
+ * An empty frustum, that has everything inside of it
+ */
+cwFrustum::cwFrustum()
+{
+}
+
+/**
+ * @brief cwFrustum::cwFrustum
+ * @param viewProjection - The camera's projection matrix times its view matrix
+ *
+ * A point is in the frustum if all of its clip coordinates are between -w and w. Each of those
+ * six inequalities is a plane, that's a sum or difference of the matrix's rows.
+ */
+cwFrustum::cwFrustum(const QMatrix4x4& viewProjection)
+{
+    QVector4D x = viewProjection.row(0);
+    QVector4D y = viewProjection.row(1);
+    QVector4D z = viewProjection.row(2);
+    QVector4D w = viewProjection.row(3);
+
+    Planes[0] = w + x;
+    Planes[1] = w - x;
+    Planes[2] = w + y;
+    Planes[3] = w - y;
+    Planes[4] = w + z;
+    Planes[5] = w - z;
+}
+
+/**
+ * @brief cwFrustum::contains
+ * @param box - An axis aligned box in world coordinates
+ * @return Outside if the box is completely outside, Inside if it's completely inside, otherwise
+ * Intersecting
+ *
+ * For each plane only two corners are tested, the one that's farthest along the plane's normal,
+ * and the one that's farthest against it. This can return Intersecting for boxes that are just
+ * outside a corner of the frustum, which is fine for culling.
+ */
+cwFrustum::Containment cwFrustum::contains(const QBox3D& box) const
+{
+    if(box.isNull()) {
+        return Outside;
+    }
+
+    QVector3D minimum = box.minimum();
+    QVector3D maximum = box.maximum();
+
+    Containment containment = Inside;
+    for(int i = 0; i < 6; i++) {
+        const QVector4D& plane = Planes[i];
+
+        QVector3D farthest(plane.x() >= 0.0f ? maximum.x() : minimum.x(),
+                           plane.y() >= 0.0f ? maximum.y() : minimum.y(),
+                           plane.z() >= 0.0f ? maximum.z() : minimum.z());
+        if(QVector3D::dotProduct(plane.toVector3D(), farthest) + plane.w() < 0.0f) {
+            return Outside;
+        }
+
+        QVector3D nearest(plane.x() >= 0.0f ? minimum.x() : maximum.x(),
+                          plane.y() >= 0.0f ? minimum.y() : maximum.y(),
+                          plane.z() >= 0.0f ? minimum.z() : maximum.z());
+        if(QVector3D::dotProduct(plane.toVector3D(), nearest) + plane.w() < 0.0f) {
+            containment = Intersecting;
+        }
+    }
+
+    return containment;
+}
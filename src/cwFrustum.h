@@ -0,0 +1,44 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWFRUSTUM_H
+#define CWFRUSTUM_H
+
+//Our includes
+#include "cwGlobals.h"
+
+//Qt includes
+#include <QMatrix4x4>
+#include <QVector4D>
+#include <QBox3D>
+
+/**
+ * @brief The cwFrustum class
+ *
+ * The six planes of a camera's view volume, found from its view projection matrix. This works for
+ * both perspective and orthographic projections.
+ */
+class CAVEWHERE_LIB_EXPORT cwFrustum
+{
+public:
+    enum Containment {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    cwFrustum();
+    cwFrustum(const QMatrix4x4& viewProjection);
+
+    Containment contains(const QBox3D& box) const;
+
+private:
+    //Left, right, bottom, top, near and far. The normals point into the frustum
+    QVector4D Planes[6];
+};
+
+#endif // CWFRUSTUM_H
@@ -10,7 +10,7 @@
 
 //Our includes
 #include "cwGLResources.h"
-#include "cwImageTexture.h"
+#include "cwTiledImageTexture.h"
 
 //Qt includes
 class QOpenGLBuffer;
@@ -28,7 +28,7 @@ public:
     explicit cwGLImageItemResources();
     virtual ~cwGLImageItemResources();
 
-    cwImageTexture* NoteTexture;
+    cwTiledImageTexture* NoteTexture;
     QOpenGLBuffer GeometryVertexBuffer;
 
 signals:
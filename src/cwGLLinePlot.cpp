@@ -7,6 +7,7 @@
 
 //Std includes
 #include <limits>
+#include <algorithm>
 
 //Our includes
 #include "cwGLLinePlot.h"
@@ -15,6 +16,73 @@
 #include "cwCamera.h"
 #include "cwGlobalDirectory.h"
 
+namespace {
+
+//The number of line segments of the full line plot in a cell
+const int ChunkSize = 256;
+
+//The tolerance of the full line plot, and each coarser level of detail, in meters
+const double Tolerances[] = {0.0, 1.0, 4.0, 16.0};
+const int NumberOfTolerances = sizeof(Tolerances) / sizeof(Tolerances[0]);
+
+//A level of detail is only kept if it has this fraction of the lines of the finer level
+const double MinimumReduction = 0.75;
+
+//The farthest that the simplified lines can be from the stations, in pixels on the screen
+const double MaxErrorPixels = 1.0;
+
+//How far past MaxErrorPixels the error must be, before the level of detail changes
+const double Hysteresis = 1.5;
+
+/**
+ * Spreads the lower 10 bits of value, so there's two zero bits between each bit
+ */
+inline quint32 spreadBits(quint32 value) {
+    value &= 0x3ff;
+    value = (value | (value << 16)) & 0x030000ff;
+    value = (value | (value << 8)) & 0x0300f00f;
+    value = (value | (value << 4)) & 0x030c30c3;
+    value = (value | (value << 2)) & 0x09249249;
+    return value;
+}
+
+/**
+ * The z-order curve code of point in box, points that are close have close codes
+ */
+inline quint32 mortonCode(const QVector3D& point, const QBox3D& box) {
+    QVector3D size = box.size();
+    quint32 code = 0;
+    for(int i = 0; i < 3; i++) {
+        float normalized = size[i] > 0.0f ? (point[i] - box.minimum()[i]) / size[i] : 0.0f;
+        quint32 cell = static_cast<quint32>(qBound(0.0f, normalized, 1.0f) * 1023.0f);
+        code |= spreadBits(cell) << i;
+    }
+    return code;
+}
+
+/**
+ * The z-order curve code of the midpoint of the segment from first to second
+ */
+inline quint32 segmentCode(const QVector<QVector3D>& points, unsigned int first, unsigned int second, const QBox3D& box) {
+    return mortonCode((points.at(first) + points.at(second)) * 0.5f, box);
+}
+
+/**
+ * The distance between point and the line segment from first to last
+ */
+inline float distanceToSegment(const QVector3D& point, const QVector3D& first, const QVector3D& last) {
+    QVector3D direction = last - first;
+    float lengthSquared = direction.lengthSquared();
+    if(lengthSquared == 0.0f) {
+        return (point - first).length();
+    }
+
+    float t = qBound(0.0f, QVector3D::dotProduct(point - first, direction) / lengthSquared, 1.0f);
+    return (point - (first + direction * t)).length();
+}
+
+}
+
 
 cwGLLinePlot::cwGLLinePlot(QObject *parent) :
     cwGLObject(parent),
@@ -22,7 +90,6 @@ cwGLLinePlot::cwGLLinePlot(QObject *parent) :
 {
     MaxZValue = 0.0;
     MinZValue = 0.0;
-    IndexBufferSize = 0;
 }
 
 void cwGLLinePlot::initialize() {
@@ -93,7 +160,18 @@ void cwGLLinePlot::draw() {
 
     ShaderProgram->setAttributeBuffer(vVertex, GL_FLOAT, 0, 3);
 
-    glDrawElements(GL_LINES, IndexBufferSize, GL_UNSIGNED_INT, nullptr);
+    //The draw ranges are cached while the camera is still
+    if(updateVisibleCells(camera())) {
+        updateDrawRanges();
+    }
+
+    typedef QPair<int, int> DrawRange;
+    foreach(const DrawRange& range, DrawRanges) {
+        glDrawElements(GL_LINES,
+                       range.second,
+                       GL_UNSIGNED_INT,
+                       reinterpret_cast<const void*>(range.first * sizeof(unsigned int)));
+    }
 
     LinePlotVertexBuffer.release();
     LinePlotIndexBuffer.release();
@@ -148,12 +226,12 @@ void cwGLLinePlot::updateData() {
     ShaderProgram->setUniformValue(UniformMinZValue, MinZValue);
     ShaderProgram->release();
 
+    QVector<unsigned int> allIndexes = updateLevels();
+
     LinePlotIndexBuffer.bind();
-    LinePlotIndexBuffer.allocate(Indexes.data(), Indexes.size() * sizeof(unsigned int));
+    LinePlotIndexBuffer.allocate(allIndexes.constData(), allIndexes.size() * sizeof(unsigned int));
     LinePlotIndexBuffer.release();
 
-    IndexBufferSize = Indexes.size();
-
     if(geometryItersecter() != nullptr) {
         geometryItersecter()->clear(this);
 
@@ -169,3 +247,305 @@ void cwGLLinePlot::updateData() {
         geometryItersecter()->addObject(geometryObject);
     }
 }
+
+/**
+ * @brief cwGLLinePlot::simplifyLines
+ * @param tolerance - The farthest a station can be from the simplified lines, in meters
+ * @return The line segments of Indexes, simplified
+ *
+ * The line plot is split into chains of shots between junctions and ends, and each chain is
+ * simplified with Douglas-Peucker. Junctions and ends are always kept, so the simplified line
+ * plot is connected the same way.
+ */
+QVector<unsigned int> cwGLLinePlot::simplifyLines(double tolerance) const
+{
+    int numberOfSegments = Indexes.size() / 2;
+
+    //The segments that touch each point
+    QVector<QVector<int> > pointSegments(Points.size());
+    for(int i = 0; i < numberOfSegments; i++) {
+        unsigned int first = Indexes.at(i * 2);
+        unsigned int second = Indexes.at(i * 2 + 1);
+        if((int)first >= Points.size() || (int)second >= Points.size()) {
+            continue;
+        }
+        pointSegments[first].append(i);
+        pointSegments[second].append(i);
+    }
+
+    QVector<bool> used(numberOfSegments, false);
+    QVector<unsigned int> simplified;
+
+    //Walks the chain from start, through segment, until a junction or end
+    auto simplifyChain = [&](unsigned int start, int segment) {
+        QVector<unsigned int> chain;
+        chain.append(start);
+
+        unsigned int current = start;
+        while(true) {
+            used[segment] = true;
+            unsigned int first = Indexes.at(segment * 2);
+            unsigned int next = first == current ? Indexes.at(segment * 2 + 1) : first;
+            chain.append(next);
+
+            const QVector<int>& nextSegments = pointSegments.at(next);
+            if(nextSegments.size() != 2) { break; }
+
+            segment = nextSegments.at(0) == segment ? nextSegments.at(1) : nextSegments.at(0);
+            if(used.at(segment)) { break; }
+            current = next;
+        }
+
+        //Douglas-Peucker
+        QVector<bool> keep(chain.size(), false);
+        keep.first() = true;
+        keep.last() = true;
+
+        QVector<QPair<int, int> > stack;
+        stack.append(QPair<int, int>(0, chain.size() - 1));
+        while(!stack.isEmpty()) {
+            QPair<int, int> range = stack.takeLast();
+            const QVector3D& firstPoint = Points.at(chain.at(range.first));
+            const QVector3D& lastPoint = Points.at(chain.at(range.second));
+
+            int farthest = -1;
+            float farthestDistance = tolerance;
+            for(int i = range.first + 1; i < range.second; i++) {
+                float distance = distanceToSegment(Points.at(chain.at(i)), firstPoint, lastPoint);
+                if(distance > farthestDistance) {
+                    farthest = i;
+                    farthestDistance = distance;
+                }
+            }
+
+            if(farthest >= 0) {
+                keep[farthest] = true;
+                stack.append(QPair<int, int>(range.first, farthest));
+                stack.append(QPair<int, int>(farthest, range.second));
+            }
+        }
+
+        int previous = 0;
+        for(int i = 1; i < chain.size(); i++) {
+            if(keep.at(i)) {
+                simplified.append(chain.at(previous));
+                simplified.append(chain.at(i));
+                previous = i;
+            }
+        }
+    };
+
+    //Chains that start at junctions and ends
+    for(int i = 0; i < pointSegments.size(); i++) {
+        if(pointSegments.at(i).size() == 2) { continue; }
+        foreach(int segment, pointSegments.at(i)) {
+            if(!used.at(segment)) {
+                simplifyChain(i, segment);
+            }
+        }
+    }
+
+    //Loops without any junctions
+    for(int i = 0; i < numberOfSegments; i++) {
+        if(!used.at(i) && (int)Indexes.at(i * 2) < Points.size() && (int)Indexes.at(i * 2 + 1) < Points.size()) {
+            simplifyChain(Indexes.at(i * 2), i);
+        }
+    }
+
+    return simplified;
+}
+
+/**
+ * @brief cwGLLinePlot::updateLevels
+ * @return The indexes of all the levels, one after another, for LinePlotIndexBuffer
+ *
+ * Finds the bounds of the line plot, splits it into cells, and creates the simplified levels of
+ * detail. Levels that don't remove enough lines aren't kept.
+ */
+QVector<unsigned int> cwGLLinePlot::updateLevels()
+{
+    Bounds = QBox3D();
+    foreach(const QVector3D& point, Points) {
+        Bounds.unite(point);
+    }
+
+    //The cells are runs of ChunkSize segments of the full line plot, along a z-order curve. A cell
+    //is defined by its first code, so the segments of every level can be sorted into the same cells
+    QVector<quint32> codes;
+    codes.reserve(Indexes.size() / 2);
+    for(int i = 0; i + 1 < Indexes.size(); i += 2) {
+        if((int)Indexes.at(i) < Points.size() && (int)Indexes.at(i + 1) < Points.size()) {
+            codes.append(segmentCode(Points, Indexes.at(i), Indexes.at(i + 1), Bounds));
+        }
+    }
+    std::sort(codes.begin(), codes.end());
+
+    CellCodes.clear();
+    for(int i = 0; i < codes.size(); i += ChunkSize) {
+        if(CellCodes.isEmpty() || CellCodes.last() != codes.at(i)) {
+            CellCodes.append(codes.at(i));
+        }
+    }
+    CellBounds = QVector<QBox3D>(CellCodes.size());
+    CellLevels = QVector<int>(CellCodes.size(), 0);
+
+    //The full line plot, and the simplified levels, one after another in the index buffer
+    Levels.clear();
+    QVector<unsigned int> allIndexes;
+    for(int i = 0; i < NumberOfTolerances; i++) {
+        QVector<unsigned int> indexes = i == 0 ? Indexes : simplifyLines(Tolerances[i]);
+        if(i > 0 && (indexes.isEmpty() || indexes.size() > Levels.last().NumberOfIndexes * MinimumReduction)) {
+            continue;
+        }
+
+        Level level;
+        level.Tolerance = Tolerances[i];
+        level.IndexOffset = allIndexes.size();
+        allIndexes += sortIntoCells(indexes, &level);
+        level.NumberOfIndexes = allIndexes.size() - level.IndexOffset;
+        Levels.append(level);
+    }
+
+    Culling.setBounds(CellBounds);
+    DrawRanges.clear();
+
+    return allIndexes;
+}
+
+/**
+ * @brief cwGLLinePlot::sortIntoCells
+ * @param indexes - Line segments
+ * @param level - Gets the offset of each cell's segments
+ * @return The line segments, sorted into the cells
+ *
+ * Each segment goes into the cell that has its midpoint's z-order code, so a cell is a small part
+ * of the cave in every level. The cells' bounds grow to hold the segments.
+ */
+QVector<unsigned int> cwGLLinePlot::sortIntoCells(const QVector<unsigned int>& indexes, Level* level)
+{
+    level->CellOffsets.fill(0, CellCodes.size() + 1);
+    if(CellCodes.isEmpty()) {
+        return QVector<unsigned int>();
+    }
+
+    //Sort the segments by their midpoint's code
+    int numberOfSegments = indexes.size() / 2;
+    QVector<QPair<quint32, int> > codes;
+    codes.reserve(numberOfSegments);
+    for(int i = 0; i < numberOfSegments; i++) {
+        unsigned int first = indexes.at(i * 2);
+        unsigned int second = indexes.at(i * 2 + 1);
+        if((int)first >= Points.size() || (int)second >= Points.size()) {
+            continue;
+        }
+
+        codes.append(QPair<quint32, int>(segmentCode(Points, first, second, Bounds), i));
+    }
+    std::sort(codes.begin(), codes.end());
+
+    QVector<unsigned int> sortedIndexes;
+    sortedIndexes.reserve(codes.size() * 2);
+
+    for(int i = 0; i < codes.size(); i++) {
+        //The codes are sorted, so the segments of a cell are next to each other
+        int cell = static_cast<int>(std::upper_bound(CellCodes.constBegin(), CellCodes.constEnd(), codes.at(i).first) - CellCodes.constBegin()) - 1;
+        cell = qMax(cell, 0);
+
+        int segment = codes.at(i).second;
+        unsigned int first = indexes.at(segment * 2);
+        unsigned int second = indexes.at(segment * 2 + 1);
+        sortedIndexes.append(first);
+        sortedIndexes.append(second);
+        CellBounds[cell].unite(Points.at(first));
+        CellBounds[cell].unite(Points.at(second));
+        level->CellOffsets[cell + 1] += 2;
+    }
+
+    //From each cell's number of indexes, to where the cell starts
+    for(int i = 1; i < level->CellOffsets.size(); i++) {
+        level->CellOffsets[i] += level->CellOffsets.at(i - 1);
+    }
+
+    return sortedIndexes;
+}
+
+/**
+ * @brief cwGLLinePlot::levelOfDetail
+ * @param pixelsPerMeter - A cell's size on the screen, at its nearest point
+ * @param currentLevel - The level that the cell is drawn with
+ * @return The coarsest level whose error is less than MaxErrorPixels on the screen
+ *
+ * The level only changes once the error is past the limit by Hysteresis, so the cell doesn't
+ * flicker between levels while zooming.
+ */
+int cwGLLinePlot::levelOfDetail(double pixelsPerMeter, int currentLevel) const
+{
+    if(Levels.isEmpty()) { return 0; }
+
+    int level = qBound(0, currentLevel, Levels.size() - 1);
+
+    //Coarser, once the coarser level's error is well under the limit
+    while(level + 1 < Levels.size() &&
+          Levels.at(level + 1).Tolerance * pixelsPerMeter < MaxErrorPixels / Hysteresis)
+    {
+        level++;
+    }
+
+    //Finer, once this level's error is well over the limit
+    while(level > 0 &&
+          Levels.at(level).Tolerance * pixelsPerMeter > MaxErrorPixels * Hysteresis)
+    {
+        level--;
+    }
+
+    return level;
+}
+
+/**
+ * @brief cwGLLinePlot::updateVisibleCells
+ * @param camera - The camera that the line plot is drawn with
+ * @return True if the visible cells, or their levels, have changed
+ *
+ * Culls the cells, and picks the level of each visible cell from its own nearest point. A cell
+ * that the camera is in is drawn with the full line plot, without forcing the rest of the cells
+ * to be detailed too.
+ */
+bool cwGLLinePlot::updateVisibleCells(cwCamera* camera)
+{
+    bool changed = Culling.cull(camera->viewProjectionMatrix());
+    foreach(int cell, Culling.visible()) {
+        int level = levelOfDetail(camera->pixelsPerMeter(CellBounds.at(cell)), CellLevels.at(cell));
+        if(level != CellLevels.at(cell)) {
+            CellLevels[cell] = level;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief cwGLLinePlot::updateDrawRanges
+ *
+ * Finds the draw calls for the visible cells, each in its own level. Cells that are next to each
+ * other in the index buffer are merged into one draw.
+ */
+void cwGLLinePlot::updateDrawRanges()
+{
+    DrawRanges.clear();
+
+    foreach(int cell, Culling.visible()) {
+        int levelIndex = CellLevels.at(cell);
+        if(levelIndex >= Levels.size()) { continue; }
+
+        const Level& level = Levels.at(levelIndex);
+        int first = level.IndexOffset + level.CellOffsets.at(cell);
+        int count = level.CellOffsets.at(cell + 1) - level.CellOffsets.at(cell);
+        if(count == 0) { continue; }
+
+        if(!DrawRanges.isEmpty() && DrawRanges.last().first + DrawRanges.last().second == first) {
+            DrawRanges.last().second += count;
+        } else {
+            DrawRanges.append(QPair<int, int>(first, count));
+        }
+    }
+}
@@ -10,16 +10,21 @@
 
 //Our includes
 #include "cwGLObject.h"
+#include "cwCullingHierarchy.h"
 
 //Qt includes
 #include <QVector3D>
 #include <QVector>
 #include <QOpenGLBuffer>
 #include <QOpenGLShaderProgram>
+#include <QPair>
 
 class cwGLLinePlot : public cwGLObject
 {
     Q_OBJECT
+
+    friend class GLLinePlotTester; //For testcases
+
 public:
     explicit cwGLLinePlot(QObject *parent = 0);
 
@@ -40,12 +45,35 @@ private:
     void initializeShaders();
     void initializeBuffers();
 
+    /**
+     * The line plot, simplified to Tolerance, and sorted into the cells
+     */
+    class Level {
+    public:
+        Level() :
+            Tolerance(0.0),
+            IndexOffset(0),
+            NumberOfIndexes(0)
+        {}
+
+        double Tolerance; //!< The farthest a station can be from the simplified lines, in meters
+        int IndexOffset; //!< The level's range in LinePlotIndexBuffer
+        int NumberOfIndexes;
+        QVector<int> CellOffsets; //!< Where each cell's indexes start in the level, and then the level's end
+    };
+
+    QVector<unsigned int> simplifyLines(double tolerance) const;
+    QVector<unsigned int> updateLevels();
+    QVector<unsigned int> sortIntoCells(const QVector<unsigned int>& indexes, Level* level);
+    int levelOfDetail(double pixelsPerMeter, int currentLevel) const;
+    bool updateVisibleCells(cwCamera* camera);
+    void updateDrawRanges();
+
     float MaxZValue;
     float MinZValue;
 
     QOpenGLBuffer LinePlotVertexBuffer;
     QOpenGLBuffer LinePlotIndexBuffer;
-    int IndexBufferSize;
 
     int vVertex; //attribute location
     int UniformModelViewProjectionMatrix; //in shader uniform location
@@ -55,6 +83,16 @@ private:
     QVector<QVector3D> Points;
     QVector<unsigned int> Indexes;
 
+    //The line plot is split into cells of nearby segments. Each cell is culled, and picks its level
+    //of detail, on its own, so the cells near the camera can be detailed while far cells are coarse
+    QVector<Level> Levels; //!< The full line plot, then coarser levels of detail
+    QBox3D Bounds;
+    QVector<quint32> CellCodes; //!< The first z-order code of each cell, see mortonCode()
+    QVector<QBox3D> CellBounds; //!< The bounds of each cell, in all the levels
+    QVector<int> CellLevels; //!< The level that each cell is drawn with
+    cwCullingHierarchy Culling; //!< Parts are the cells
+    QVector<QPair<int, int> > DrawRanges; //!< The first index and the number of indexes of the visible cells
+
     QOpenGLShaderProgram* ShaderProgram;
 };
 
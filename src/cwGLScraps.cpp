@@ -20,10 +20,26 @@
 #include "cwGlobalDirectory.h"
 #include "cwProject.h"
 
+//Std includes
+#include <cstddef>
+#include <algorithm>
+
+namespace {
+
+//The largest that a grid cell of a scrap's level of detail can be, in pixels on the screen
+const double MaxGridPixels = 32.0;
+
+//How far past MaxGridPixels a scrap's grid must be, before its level of detail changes
+const double Hysteresis = 1.25;
+
+}
+
 
 cwGLScraps::cwGLScraps(QObject *parent) :
     cwGLObject(parent),
     Project(nullptr),
+    Vertices(QOpenGLBuffer::VertexBuffer, sizeof(Vertex)),
+    Indices(QOpenGLBuffer::IndexBuffer, sizeof(uint)),
     MaxScrapId(0),
     Visible(true)
 {
@@ -31,6 +47,8 @@ cwGLScraps::cwGLScraps(QObject *parent) :
 
 void cwGLScraps::initialize() {
     initializeShaders();
+    Vertices.create();
+    Indices.create();
 }
 
 void cwGLScraps::draw() {
@@ -44,30 +62,36 @@ void cwGLScraps::draw() {
 
     glEnable(GL_DEPTH_TEST);
 
-    foreach(GLScrap scrap, Scraps) {
-        Program->setUniformValue(UniformScaleTexCoords, scrap.Texture->scaleTexCoords());
-
-        scrap.Texture->updateData();
+    Vertices.bind();
+    Program->setAttributeBuffer(vVertex, GL_FLOAT, offsetof(Vertex, Point), 3, sizeof(Vertex));
+    Program->setAttributeBuffer(vScrapTexCoords, GL_FLOAT, offsetof(Vertex, TexCoord), 2, sizeof(Vertex));
+    Indices.bind();
 
-        scrap.Texture->bind();
-
-        scrap.IndexBuffer.bind();
-
-        scrap.PointBuffer.bind();
-        Program->setAttributeBuffer(vVertex, GL_FLOAT, 0, 3);
-
-        scrap.TexCoords.bind();
-        Program->setAttributeBuffer(vScrapTexCoords, GL_FLOAT, 0, 2);
-
-        glDrawElements(GL_TRIANGLES, scrap.NumberOfIndices, GL_UNSIGNED_INT, nullptr);
+    //Only the scraps that are in view, this is cached while the camera is still
+    if(Culling.cull(camera()->viewProjectionMatrix())) {
+        updateDrawRanges();
+    }
 
-        scrap.IndexBuffer.release();
-        scrap.PointBuffer.release();
-        scrap.TexCoords.release();
+    //One draw per note texture, unless scraps in the middle of a batch are culled
+    cwImageTexture* boundTexture = nullptr;
+    foreach(const DrawRange& range, DrawRanges) {
+        cwImageTexture* texture = Batches.value(range.TextureKey).Texture;
+        if(texture != boundTexture) {
+            texture->updateData();
+            Program->setUniformValue(UniformScaleTexCoords, texture->scaleTexCoords());
+            texture->bind();
+            boundTexture = texture;
+        }
 
-        scrap.Texture->release();
+        glDrawElements(GL_TRIANGLES,
+                       range.NumberOfIndices,
+                       GL_UNSIGNED_INT,
+                       reinterpret_cast<const void*>(range.IndexOffset * sizeof(uint)));
     }
 
+    Indices.release();
+    Vertices.release();
+
     glBindTexture(GL_TEXTURE_2D, 0);
 
     Program->disableAttributeArray(vVertex);
@@ -86,6 +110,8 @@ void cwGLScraps::updateData()
 
     if(geometryItersecter() == nullptr) { return; }
 
+    bool changed = !PendingChanges.isEmpty();
+
     foreach(PendingScrapCommand command, PendingChanges.values()) {
         switch(command.type()) {
         case PendingScrapCommand::AddScrap:
@@ -93,13 +119,23 @@ void cwGLScraps::updateData()
             //For geometry intersection, mouse z depth
             int scrapId = -1;
 
+            cwImage image = command.triangulatedData().croppedImage();
+
             if(Scraps.contains(command.scrap())) {
                 GLScrap& glScrap = Scraps[command.scrap()];
-                glScrap.update(command.triangulatedData());
+                writeVertices(&glScrap, command.triangulatedData());
+                if(glScrap.TextureKey != textureKey(image)) {
+                    removeFromBatch(command.scrap(), glScrap);
+                    addToBatch(command.scrap(), &glScrap, image);
+                } else {
+                    Batches[glScrap.TextureKey].Dirty = true;
+                }
                 scrapId = glScrap.ScrapId;
             } else {
-                GLScrap glScrap(command.triangulatedData(), project());
+                GLScrap glScrap;
                 glScrap.ScrapId = MaxScrapId++;
+                writeVertices(&glScrap, command.triangulatedData());
+                addToBatch(command.scrap(), &glScrap, image);
                 scrapId = glScrap.ScrapId;
                 Scraps.insert(command.scrap(), glScrap);
             }
@@ -120,7 +156,8 @@ void cwGLScraps::updateData()
             if(Scraps.contains(command.scrap())) {
                  GLScrap& glScrap = Scraps[command.scrap()];
                  geometryItersecter()->removeObject(this, glScrap.ScrapId);
-                 glScrap.releaseResources();
+                 freeMeshes(glScrap);
+                 removeFromBatch(command.scrap(), glScrap);
                  Scraps.remove(command.scrap());
             }
             break;
@@ -131,6 +168,11 @@ void cwGLScraps::updateData()
     }
 
     PendingChanges.clear();
+
+    if(changed) {
+        updateBatches();
+        updateCulling();
+    }
 }
 
 /**
@@ -225,65 +267,309 @@ void cwGLScraps::initializeShaders() {
 }
 
 cwGLScraps::GLScrap::GLScrap() :
-    NumberOfIndices(0),
+    LevelOfDetail(0),
     ScrapId(-1),
-    Texture(nullptr)
+    TextureKey(-1)
+{
+
+}
 
+/**
+ * @brief cwGLScraps::writeVertices
+ * @param glScrap - The scrap that's updated
+ * @param data - The scrap's triangulated data
+ *
+ * Writes the full detail mesh and each level of detail into Vertices. The scrap's indices and
+ * bounding box are kept, so its batch can be rebuilt with updateBatches(), and it can be culled.
+ */
+void cwGLScraps::writeVertices(GLScrap* glScrap, const cwTriangulatedData& data)
 {
+    QList<cwTriangulatedData::LevelOfDetail> levels = data.levelsOfDetail();
+
+    //Free the levels that the scrap doesn't have anymore
+    for(int i = levels.size() + 1; i < glScrap->Meshes.size(); i++) {
+        Vertices.free(glScrap->Meshes.at(i).VertexOffset);
+    }
+    glScrap->Meshes.resize(levels.size() + 1);
+
+    Mesh& full = glScrap->Meshes[0];
+    full.GridSpacing = 0.0;
+    full.Indices = data.indices();
+    writeMesh(&full, data.points(), data.texCoords());
+
+    for(int i = 0; i < levels.size(); i++) {
+        const cwTriangulatedData::LevelOfDetail& level = levels.at(i);
+        Mesh& mesh = glScrap->Meshes[i + 1];
+        mesh.GridSpacing = level.GridSpacing;
+        mesh.Indices = level.Indices;
+        writeMesh(&mesh, level.Points, level.TexCoords);
+    }
+
+    glScrap->LevelOfDetail = qMin(glScrap->LevelOfDetail, glScrap->Meshes.size() - 1);
 
+    QBox3D box;
+    foreach(const QVector3D& point, data.points()) {
+        box.unite(point);
+    }
+    glScrap->Box = box;
 }
 
-cwGLScraps::GLScrap::GLScrap(const cwTriangulatedData& data, cwProject *project) :
-    ScrapId(-1),
-    Texture(new cwImageTexture())
+/**
+ * @brief cwGLScraps::writeMesh
+ * @param mesh - The mesh that's written
+ * @param points - The mesh's points
+ * @param texCoords - The mesh's texture coordinates
+ *
+ * Interleaves the points and texture coordinates into the mesh's range of Vertices. The range is
+ * rewritten in place if the number of vertices hasn't changed.
+ */
+void cwGLScraps::writeMesh(Mesh* mesh, const QVector<QVector3D>& points, const QVector<QVector2D>& texCoords)
 {
-    PointBuffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-    PointBuffer.create();
+    QVector<Vertex> vertices(points.size());
+    for(int i = 0; i < points.size(); i++) {
+        vertices[i].Point = points.at(i);
+        vertices[i].TexCoord = i < texCoords.size() ? texCoords.at(i) : QVector2D();
+    }
 
-    IndexBuffer = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
-    IndexBuffer.create();
+    if(mesh->VertexOffset >= 0 && mesh->NumberOfVertices == vertices.size()) {
+        Vertices.write(mesh->VertexOffset, vertices.constData(), vertices.size());
+    } else {
+        Vertices.free(mesh->VertexOffset);
+        mesh->VertexOffset = Vertices.allocate(vertices.constData(), vertices.size());
+        mesh->NumberOfVertices = vertices.size();
+    }
+}
 
-    TexCoords = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-    TexCoords.create();
+/**
+ * @brief cwGLScraps::freeMeshes
+ * @param glScrap - The scrap that's being removed
+ *
+ * Frees the vertices of all the scrap's meshes
+ */
+void cwGLScraps::freeMeshes(const GLScrap& glScrap)
+{
+    foreach(const Mesh& mesh, glScrap.Meshes) {
+        Vertices.free(mesh.VertexOffset);
+    }
+}
 
-    //Upload the texture to the graphics card
-    Texture->initialize();
-    Texture->setProject(project->filename());
+/**
+ * @brief cwGLScraps::addToBatch
+ * @param scrap - The scrap
+ * @param glScrap - The scrap's gl data, its TextureKey is set to the batch
+ * @param image - The scrap's image, for crop references this is the note's image
+ *
+ * Every scrap that's a crop reference of the same note shares one batch, so the note's
+ * mipmaps are only uploaded once, and all the scraps are drawn at once. Each call must be
+ * matched by a removeFromBatch().
+ */
+void cwGLScraps::addToBatch(cwScrap* scrap, GLScrap* glScrap, const cwImage& image)
+{
+    glScrap->TextureKey = textureKey(image);
+
+    Batch& batch = Batches[glScrap->TextureKey];
+    if(batch.Texture == nullptr) {
+        //Upload the texture to the graphics card
+        batch.Texture = new cwImageTexture();
+        batch.Texture->initialize();
+        batch.Texture->setProject(project()->filename());
+        batch.Texture->setImage(image);
+    }
+    batch.Scraps.insert(scrap);
+    batch.Dirty = true;
+}
 
-    update(data);
+/**
+ * @brief cwGLScraps::removeFromBatch
+ * @param scrap - The scrap
+ * @param glScrap - The scrap's gl data
+ *
+ * Deletes the batch and its texture when the last scrap is removed
+ */
+void cwGLScraps::removeFromBatch(cwScrap* scrap, const GLScrap& glScrap)
+{
+    Q_ASSERT(Batches.contains(glScrap.TextureKey));
+
+    Batch& batch = Batches[glScrap.TextureKey];
+    batch.Scraps.remove(scrap);
+    batch.Dirty = true;
+    if(batch.Scraps.isEmpty()) {
+        delete batch.Texture;
+        Indices.free(batch.IndexOffset);
+        Batches.remove(glScrap.TextureKey);
+    }
 }
 
 /**
- * @brief cwGLScraps::GLScrap::update
- * @param data.  This update the data in the glSCrap
+ * @brief cwGLScraps::updateBatches
+ *
+ * Rebuilds the indices of the batches that have changed. The scraps' indices are offset to
+ * where their vertices are in Vertices, so each batch is one range of Indices, and each of the
+ * scraps' meshes is a range inside of it.
  */
-void cwGLScraps::GLScrap::update(const cwTriangulatedData &data)
+void cwGLScraps::updateBatches()
 {
-    PointBuffer.bind();
-    int pointBufferSize = data.points().size() * sizeof(QVector3D);
-    PointBuffer.allocate(data.points().constData(), pointBufferSize);
-    PointBuffer.release();
-
-    IndexBuffer.bind();
-    int indexBufferSize = data.indices().size() * sizeof(uint);
-    IndexBuffer.allocate(data.indices().constData(), indexBufferSize);
-    IndexBuffer.release();
-    NumberOfIndices = data.indices().size();
-
-    TexCoords.bind();
-    int texCoordSize = data.texCoords().size() * sizeof(QVector2D);
-    TexCoords.allocate(data.texCoords().constData(), texCoordSize);
-    TexCoords.release();
-
-    Texture->setImage(data.croppedImage());
+    for(auto iter = Batches.begin(); iter != Batches.end(); ++iter) {
+        Batch& batch = iter.value();
+        if(!batch.Dirty) { continue; }
+
+        int numberOfLevels = 0;
+        foreach(cwScrap* scrap, batch.Scraps) {
+            Q_ASSERT(Scraps.contains(scrap));
+            numberOfLevels = qMax(numberOfLevels, Scraps.value(scrap).Meshes.size());
+        }
+
+        //Grouped by level of detail, so scraps at the same level are next to each other
+        QVector<uint> indices;
+        for(int level = 0; level < numberOfLevels; level++) {
+            foreach(cwScrap* scrap, batch.Scraps) {
+                GLScrap& glScrap = Scraps[scrap];
+                if(level >= glScrap.Meshes.size()) { continue; }
+
+                Mesh& mesh = glScrap.Meshes[level];
+                mesh.IndexOffset = indices.size();
+                mesh.NumberOfIndices = mesh.VertexOffset >= 0 ? mesh.Indices.size() : 0;
+
+                for(int i = 0; i < mesh.NumberOfIndices; i++) {
+                    indices.append(mesh.Indices.at(i) + mesh.VertexOffset);
+                }
+            }
+        }
+
+        if(batch.IndexOffset >= 0 && batch.NumberOfIndices == indices.size()) {
+            Indices.write(batch.IndexOffset, indices.constData(), indices.size());
+        } else {
+            Indices.free(batch.IndexOffset);
+            batch.IndexOffset = Indices.allocate(indices.constData(), indices.size());
+            batch.NumberOfIndices = indices.size();
+        }
+
+        foreach(cwScrap* scrap, batch.Scraps) {
+            GLScrap& glScrap = Scraps[scrap];
+            for(int level = 0; level < glScrap.Meshes.size(); level++) {
+                glScrap.Meshes[level].IndexOffset += batch.IndexOffset;
+            }
+        }
+
+        batch.Dirty = false;
+    }
+}
+
+/**
+ * @brief cwGLScraps::updateCulling
+ *
+ * Rebuilds the culling hierarchy from the scraps' bounding boxes. The visible scraps are found
+ * again on the next draw().
+ */
+void cwGLScraps::updateCulling()
+{
+    CullingScraps.clear();
+    CullingScraps.reserve(Scraps.size());
+
+    QVector<QBox3D> bounds;
+    bounds.reserve(Scraps.size());
+
+    for(auto iter = Scraps.constBegin(); iter != Scraps.constEnd(); ++iter) {
+        CullingScraps.append(iter.key());
+        bounds.append(iter.value().Box);
+    }
+
+    Culling.setBounds(bounds);
+}
+
+/**
+ * @brief cwGLScraps::updateDrawRanges
+ *
+ * Picks the level of detail of the visible scraps, and finds their draw calls. The scraps are
+ * sorted by texture and by where they are in Indices, and neighbouring scraps of the same batch
+ * are merged into one draw.
+ */
+void cwGLScraps::updateDrawRanges()
+{
+    DrawRanges.clear();
+
+    foreach(int part, Culling.visible()) {
+        GLScrap& glScrap = Scraps[CullingScraps.at(part)];
+        if(glScrap.Meshes.isEmpty()) { continue; }
+
+        glScrap.LevelOfDetail = levelOfDetail(glScrap, camera()->pixelsPerMeter(glScrap.Box));
+
+        const Mesh& mesh = glScrap.Meshes.at(glScrap.LevelOfDetail);
+        if(mesh.NumberOfIndices == 0) { continue; }
+
+        DrawRange range;
+        range.TextureKey = glScrap.TextureKey;
+        range.IndexOffset = mesh.IndexOffset;
+        range.NumberOfIndices = mesh.NumberOfIndices;
+        DrawRanges.append(range);
+    }
+
+    std::sort(DrawRanges.begin(), DrawRanges.end(), [](const DrawRange& a, const DrawRange& b) {
+        if(a.TextureKey != b.TextureKey) {
+            return a.TextureKey < b.TextureKey;
+        }
+        return a.IndexOffset < b.IndexOffset;
+    });
+
+    QVector<DrawRange> merged;
+    foreach(const DrawRange& range, DrawRanges) {
+        if(!merged.isEmpty()) {
+            DrawRange& last = merged.last();
+            if(last.TextureKey == range.TextureKey &&
+                    last.IndexOffset + last.NumberOfIndices == range.IndexOffset)
+            {
+                last.NumberOfIndices += range.NumberOfIndices;
+                continue;
+            }
+        }
+        merged.append(range);
+    }
+
+    DrawRanges = merged;
 }
 
-void cwGLScraps::GLScrap::releaseResources()
+/**
+ * @brief cwGLScraps::levelOfDetail
+ * @param glScrap - The scrap
+ * @param pixelsPerMeter - The scrap's size on the screen, at its nearest point
+ * @return The mesh that should be drawn
+ *
+ * This is the coarsest mesh whose grid cells are smaller than MaxGridPixels on the screen. The
+ * level only changes once the grid is past the limit by Hysteresis, so scraps don't flicker
+ * between levels while zooming.
+ */
+int cwGLScraps::levelOfDetail(const GLScrap& glScrap, double pixelsPerMeter)
+{
+    int level = qBound(0, glScrap.LevelOfDetail, glScrap.Meshes.size() - 1);
+
+    //Coarser, once the coarser grid is well under the limit
+    while(level + 1 < glScrap.Meshes.size() &&
+          glScrap.Meshes.at(level + 1).GridSpacing * pixelsPerMeter < MaxGridPixels / Hysteresis)
+    {
+        level++;
+    }
+
+    //Finer, once this grid is well over the limit
+    while(level > 0 &&
+          glScrap.Meshes.at(level).GridSpacing * pixelsPerMeter > MaxGridPixels * Hysteresis)
+    {
+        level--;
+    }
+
+    return level;
+}
+
+/**
+ * @brief cwGLScraps::textureKey
+ * @return The id that's used to share textures between scraps.
+ *
+ * Standalone cropped images only have mipmaps, so the first mipmap is used instead of
+ * the original image's id.
+ */
+int cwGLScraps::textureKey(const cwImage& image)
 {
-    PointBuffer.release();
-    IndexBuffer.release();
-    TexCoords.release();
-    delete Texture;
+    QList<int> mipmaps = image.mipmaps();
+    return mipmaps.isEmpty() ? image.original() : mipmaps.first();
 }
 
 
@@ -13,6 +13,8 @@
 #include "cwTriangulatedData.h"
 #include "cwImageTexture.h"
 #include "cwGeometryItersecter.h"
+#include "cwGLSharedBuffer.h"
+#include "cwCullingHierarchy.h"
 class cwCavingRegion;
 class cwProject;
 class cwScrap;
@@ -21,6 +23,10 @@ class cwScrap;
 #include <QOpenGLShaderProgram>
 #include <QOpenGLBuffer>
 #include <QSharedPointer>
+#include <QSet>
+#include <QVector2D>
+#include <QVector3D>
+#include <QBox3D>
 
 class cwGLScraps : public cwGLObject
 {
@@ -84,25 +90,76 @@ private:
 
     };
 
+    /**
+     * One level of detail of a scrap
+     */
+    class Mesh {
+    public:
+        Mesh() :
+            GridSpacing(0.0),
+            VertexOffset(-1),
+            NumberOfVertices(0),
+            IndexOffset(0),
+            NumberOfIndices(0)
+        {}
+
+        double GridSpacing; //!< In meters, 0 for the full detail mesh
+        int VertexOffset; //!< The mesh's range in cwGLScraps::Vertices
+        int NumberOfVertices;
+        QVector<uint> Indices; //!< Relative to VertexOffset
+        int IndexOffset; //!< The mesh's range in cwGLScraps::Indices, inside of its batch's range
+        int NumberOfIndices;
+    };
+
     class GLScrap {
 
     public:
         GLScrap();
-        GLScrap(const cwTriangulatedData& data, cwProject* project);
-
-        QOpenGLBuffer PointBuffer;
-        QOpenGLBuffer IndexBuffer;
-        QOpenGLBuffer TexCoords;
 
-        int NumberOfIndices;
+        QVector<Mesh> Meshes; //!< The full detail mesh, then coarser levels of detail
+        int LevelOfDetail; //!< The mesh that's drawn
+        QBox3D Box; //!< For culling
         int ScrapId; //For intersection
+        int TextureKey; //!< The scrap's batch in cwGLScraps::Batches
+    };
 
-        cwImageTexture* Texture;
+    /**
+     * Scraps that are crop references of the same note, share the note's texture, and are drawn
+     * together with one draw call
+     */
+    class Batch {
+    public:
+        Batch() :
+            Texture(nullptr),
+            IndexOffset(-1),
+            NumberOfIndices(0),
+            Dirty(false)
+        {}
 
-        void update(const cwTriangulatedData& data);
+        cwImageTexture* Texture;
+        QSet<cwScrap*> Scraps;
+        int IndexOffset; //!< The batch's range in cwGLScraps::Indices
+        int NumberOfIndices;
+        bool Dirty; //!< True if the batch's indices need to be rebuilt
+    };
 
-        void releaseResources();
+    /**
+     * Visible scraps that are next to each other in Indices, and are drawn together
+     */
+    class DrawRange {
+    public:
+        int TextureKey;
+        int IndexOffset;
+        int NumberOfIndices;
+    };
 
+    /**
+     * The interleaved vertex in cwGLScraps::Vertices
+     */
+    class Vertex {
+    public:
+        QVector3D Point;
+        QVector2D TexCoord;
     };
 
     cwProject* Project; //!< The project file for loading textures
@@ -116,13 +173,30 @@ private:
     int UniformScaleTexCoords;
     int vVertex;
     int vScrapTexCoords;
+    cwGLSharedBuffer Vertices; //!< Every scrap's vertices
+    cwGLSharedBuffer Indices; //!< Every batch's indices
     QHash<cwScrap*, GLScrap> Scraps;
+    QHash<int, Batch> Batches; //Keyed by textureKey()
+    cwCullingHierarchy Culling; //!< Parts are indexes into CullingScraps
+    QVector<cwScrap*> CullingScraps;
+    QVector<DrawRange> DrawRanges; //!< The visible scraps, sorted by texture
     int MaxScrapId;
 
     bool Visible; //!< True if the scraps are visible and false if they're not
 
     void initializeShaders();
 
+    void writeVertices(GLScrap* glScrap, const cwTriangulatedData& data);
+    void writeMesh(Mesh* mesh, const QVector<QVector3D>& points, const QVector<QVector2D>& texCoords);
+    void freeMeshes(const GLScrap& glScrap);
+    void addToBatch(cwScrap* scrap, GLScrap* glScrap, const cwImage& image);
+    void removeFromBatch(cwScrap* scrap, const GLScrap& glScrap);
+    void updateBatches();
+    void updateCulling();
+    void updateDrawRanges();
+    static int textureKey(const cwImage& image);
+    static int levelOfDetail(const GLScrap& glScrap, double pixelsPerMeter);
+
 };
 
 /**
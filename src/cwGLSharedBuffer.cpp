@@ -0,0 +1,129 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwGLSharedBuffer.h"
+
+//Std includes
+#include <cstring>
+
+/**
+ * @brief cwGLSharedBuffer::cwGLSharedBuffer
+ * @param type - The buffer type, usually a vertex or index buffer
+ * @param elementSize - The size of an element, like a vertex, in bytes
+ */
+cwGLSharedBuffer::cwGLSharedBuffer(QOpenGLBuffer::Type type, int elementSize) :
+    Buffer(type),
+    ElementSize(elementSize),
+    BufferCapacity(0)
+{
+}
+
+/**
+ * @brief cwGLSharedBuffer::create
+ *
+ * Creates the opengl buffer, this needs a current opengl context
+ */
+void cwGLSharedBuffer::create()
+{
+    Buffer.create();
+}
+
+/**
+ * @brief cwGLSharedBuffer::destroy
+ *
+ * Deletes the opengl buffer and frees every range
+ */
+void cwGLSharedBuffer::destroy()
+{
+    Buffer.destroy();
+    Allocator.clear();
+    Data.clear();
+    BufferCapacity = 0;
+}
+
+/**
+ * @brief cwGLSharedBuffer::allocate
+ * @param data - The elements that are copied into the range
+ * @param count - The number of elements
+ * @return The offset of the range in elements, or -1 if count is 0
+ */
+int cwGLSharedBuffer::allocate(const void* data, int count)
+{
+    if(count <= 0) {
+        return -1;
+    }
+
+    int offset = Allocator.allocate(count);
+
+    if(Allocator.capacity() != BufferCapacity) {
+        //Grow, this uploads everything
+        BufferCapacity = Allocator.capacity();
+        Data.resize(BufferCapacity * ElementSize);
+        memcpy(Data.data() + offset * ElementSize, data, count * ElementSize);
+
+        Buffer.bind();
+        Buffer.allocate(Data.constData(), Data.size());
+        Buffer.release();
+    } else {
+        write(offset, data, count);
+    }
+
+    return offset;
+}
+
+/**
+ * @brief cwGLSharedBuffer::write
+ * @param offset - The offset of a range from allocate()
+ * @param data - The new elements
+ * @param count - The number of elements, this must fit in the range
+ *
+ * Rewrites the range in place
+ */
+void cwGLSharedBuffer::write(int offset, const void* data, int count)
+{
+    Q_ASSERT(count <= Allocator.size(offset));
+    if(count <= 0) {
+        return;
+    }
+
+    memcpy(Data.data() + offset * ElementSize, data, count * ElementSize);
+
+    Buffer.bind();
+    Buffer.write(offset * ElementSize, data, count * ElementSize);
+    Buffer.release();
+}
+
+/**
+ * @brief cwGLSharedBuffer::free
+ * @param offset - The offset of a range from allocate()
+ *
+ * The range's elements stay in the buffer until the range is reused
+ */
+void cwGLSharedBuffer::free(int offset)
+{
+    if(offset >= 0) {
+        Allocator.free(offset);
+    }
+}
+
+/**
+ * @brief cwGLSharedBuffer::bind
+ * @return True if the buffer was bound
+ */
+bool cwGLSharedBuffer::bind()
+{
+    return Buffer.bind();
+}
+
+/**
+ * @brief cwGLSharedBuffer::release
+ */
+void cwGLSharedBuffer::release()
+{
+    Buffer.release();
+}
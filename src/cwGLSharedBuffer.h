@@ -0,0 +1,64 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWGLSHAREDBUFFER_H
+#define CWGLSHAREDBUFFER_H
+
+//Our includes
+#include "cwRangeAllocator.h"
+
+//Qt includes
+#include <QOpenGLBuffer>
+#include <QByteArray>
+
+/**
+ * @brief The cwGLSharedBuffer class
+ *
+ * One opengl buffer that's shared by many objects. Each object gets a range of the buffer, that
+ * can be rewritten in place with glBufferSubData, so adding, updating or removing an object
+ * doesn't reallocate the whole buffer.
+ *
+ * The buffer is only reallocated when it grows. OpenGL ES 2 can't copy between buffers, so a copy
+ * of the buffer is kept in memory, and is uploaded when the buffer grows.
+ *
+ * This should only be used in the rendering thread.
+ */
+class cwGLSharedBuffer
+{
+public:
+    cwGLSharedBuffer(QOpenGLBuffer::Type type, int elementSize);
+
+    void create();
+    void destroy();
+
+    int allocate(const void* data, int count);
+    void write(int offset, const void* data, int count);
+    void free(int offset);
+
+    int count(int offset) const;
+
+    bool bind();
+    void release();
+
+private:
+    QOpenGLBuffer Buffer;
+    int ElementSize; //!< In bytes
+    int BufferCapacity; //!< The number of elements that have been allocated in Buffer
+    cwRangeAllocator Allocator;
+    QByteArray Data; //!< A copy of Buffer
+};
+
+/**
+ * @brief cwGLSharedBuffer::count
+ * @return The number of elements in the range at offset
+ */
+inline int cwGLSharedBuffer::count(int offset) const
+{
+    return Allocator.size(offset);
+}
+
+#endif // CWGLSHAREDBUFFER_H
@@ -12,12 +12,142 @@
 //Std limits
 #include <limits>
 #include <math.h>
+#include <algorithm>
 
 //Qt includes
 #include <QtNumeric>
 #include <QPlane3D>
 
-cwGeometryItersecter::cwGeometryItersecter()
+namespace {
+
+//The most primitives in a leaf, before it's split
+const int MaxLeafSize = 4;
+
+//The number of buckets that are tried for each split
+const int BinCount = 12;
+
+inline float minComponent(const QVector3D& v) {
+    return qMin(v.x(), qMin(v.y(), v.z()));
+}
+
+inline float maxComponent(const QVector3D& v) {
+    return qMax(v.x(), qMax(v.y(), v.z()));
+}
+
+inline QVector3D minimum(const QVector3D& a, const QVector3D& b) {
+    return QVector3D(qMin(a.x(), b.x()), qMin(a.y(), b.y()), qMin(a.z(), b.z()));
+}
+
+inline QVector3D maximum(const QVector3D& a, const QVector3D& b) {
+    return QVector3D(qMax(a.x(), b.x()), qMax(a.y(), b.y()), qMax(a.z(), b.z()));
+}
+
+}
+
+/**
+ * A ray with its inverse direction, for fast box tests
+ */
+class cwGeometryItersecter::Ray {
+public:
+    Ray(const QRay3D& ray) :
+        Origin(ray.origin()),
+        Direction(ray.direction()),
+        InverseDirection(1.0f / Direction.x(), 1.0f / Direction.y(), 1.0f / Direction.z()),
+        DirectionLengthSquared(QVector3D::dotProduct(Direction, Direction))
+    {}
+
+    /**
+     * Returns true if the ray hits box before maxT, and sets tNear to where it enters the box
+     */
+    bool intersects(const Bounds& box, float maxT, float* tNear) const {
+        QVector3D t1 = (box.Minimum - Origin) * InverseDirection;
+        QVector3D t2 = (box.Maximum - Origin) * InverseDirection;
+        float tEnter = qMax(maxComponent(minimum(t1, t2)), 0.0f);
+        float tExit = qMin(minComponent(maximum(t1, t2)), maxT);
+        *tNear = tEnter;
+        return tEnter <= tExit;
+    }
+
+    /**
+     * Returns where the ray hits the triangle, Möller-Trumbore, or NaN if it misses. Both sides of
+     * the triangle are hit.
+     */
+    float intersects(const QVector3D& p1, const QVector3D& p2, const QVector3D& p3) const {
+        QVector3D edge1 = p2 - p1;
+        QVector3D edge2 = p3 - p1;
+        QVector3D p = QVector3D::crossProduct(Direction, edge2);
+        float determinant = QVector3D::dotProduct(edge1, p);
+        if(determinant == 0.0f) {
+            return qQNaN(); //Parallel to the triangle, or the triangle is degenerate
+        }
+
+        float inverseDeterminant = 1.0f / determinant;
+        QVector3D s = Origin - p1;
+        float u = QVector3D::dotProduct(s, p) * inverseDeterminant;
+        if(u < 0.0f || u > 1.0f) { return qQNaN(); }
+
+        QVector3D q = QVector3D::crossProduct(s, edge1);
+        float v = QVector3D::dotProduct(Direction, q) * inverseDeterminant;
+        if(v < 0.0f || u + v > 1.0f) { return qQNaN(); }
+
+        float t = QVector3D::dotProduct(edge2, q) * inverseDeterminant;
+        return t > 0.0f ? t : qQNaN();
+    }
+
+    /**
+     * Returns the distance between the ray and the line segment p1 to p2, and sets t to the closest
+     * point on the ray
+     */
+    float distance(const QVector3D& p1, const QVector3D& p2, float* t) const {
+        QVector3D segment = p2 - p1;
+        QVector3D r = Origin - p1;
+        float a = DirectionLengthSquared;
+        float b = QVector3D::dotProduct(Direction, segment);
+        float c = QVector3D::dotProduct(Direction, r);
+        float e = QVector3D::dotProduct(segment, segment);
+        float f = QVector3D::dotProduct(segment, r);
+
+        float s; //Along the ray
+        float u; //Along the segment
+        if(e <= std::numeric_limits<float>::min()) {
+            u = 0.0f;
+            s = qMax(-c / a, 0.0f);
+        } else {
+            float denominator = a * e - b * b;
+            s = denominator > 0.0f ? qMax((b * f - c * e) / denominator, 0.0f) : 0.0f;
+            u = (b * s + f) / e;
+            if(u < 0.0f) {
+                u = 0.0f;
+                s = qMax(-c / a, 0.0f);
+            } else if(u > 1.0f) {
+                u = 1.0f;
+                s = qMax((b - c) / a, 0.0f);
+            }
+        }
+
+        *t = s;
+        return ((Origin + s * Direction) - (p1 + u * segment)).length();
+    }
+
+    /**
+     * Returns a lower bound of the distance between the ray and anything in box
+     */
+    float distance(const Bounds& box) const {
+        QVector3D center = box.center();
+        float s = qMax(QVector3D::dotProduct(center - Origin, Direction) / DirectionLengthSquared, 0.0f);
+        float centerDistance = ((Origin + s * Direction) - center).length();
+        return centerDistance - box.radius();
+    }
+
+    QVector3D Origin;
+    QVector3D Direction;
+    QVector3D InverseDirection;
+    float DirectionLengthSquared;
+};
+
+
+cwGeometryItersecter::cwGeometryItersecter() :
+    ObjectTreeDirty(false)
 {
 }
 
@@ -25,20 +155,52 @@ cwGeometryItersecter::cwGeometryItersecter()
  * @brief cwGeometryItersecter::addTriangles
  * @param object
  *
- * Add the object to the itersector
+ * Add the object to the itersector. If the object already exists in the intersecter, it's
+ * replaced. Only the object's BVH is built, the BVH over all the objects is rebuilt on the next
+ * query.
  */
 void cwGeometryItersecter::addObject(const cwGeometryItersecter::Object &object)
 {
-    switch(object.type()) {
-    case Triangles:
-        addTriangles(object);
-        break;
-    case Lines:
-        addLines(object);
-        break;
-    default:
-        break;
+    if(object.type() == None) {
+        return;
     }
+
+    Geometry geometry;
+    geometry.Object = object;
+
+    //Make sure the object has the right number of indices
+    int verticesPerPrimitive = geometry.verticesPerPrimitive();
+    if(object.indexes().size() % verticesPerPrimitive != 0) {
+        qDebug() << "Can't add object" << object.parent() << object.id() << "because it has an invalid indexes" << LOCATION;
+        return;
+    }
+
+    const QVector<QVector3D>& points = object.points();
+    const QVector<uint>& indexes = object.indexes();
+    for(int i = 0; i < indexes.size(); i++) {
+        if(indexes.at(i) >= static_cast<uint>(points.size())) {
+            qDebug() << "Can't add object" << object.parent() << object.id() << "because index" << indexes.at(i) << "is out of range" << LOCATION;
+            return;
+        }
+    }
+
+    QVector<Bounds> primitiveBounds(indexes.size() / verticesPerPrimitive);
+    for(int i = 0; i < primitiveBounds.size(); i++) {
+        for(int v = 0; v < verticesPerPrimitive; v++) {
+            primitiveBounds[i].expand(points.at(indexes.at(i * verticesPerPrimitive + v)));
+        }
+    }
+    geometry.Tree.build(primitiveBounds);
+
+    Key key(object.parent(), object.id());
+    if(GeometryIndexes.contains(key)) {
+        Geometries[GeometryIndexes.value(key)] = geometry;
+    } else {
+        GeometryIndexes.insert(key, Geometries.size());
+        Geometries.append(geometry);
+    }
+
+    ObjectTreeDirty = true;
 }
 
 /**
@@ -52,17 +214,15 @@ void cwGeometryItersecter::addObject(const cwGeometryItersecter::Object &object)
 void cwGeometryItersecter::clear(cwGLObject *parentObject)
 {
     if(parentObject == nullptr) {
-        Nodes.clear();
+        Geometries.clear();
+        GeometryIndexes.clear();
+        ObjectTreeDirty = true;
         return;
     }
 
-    QList<Node>::iterator iter = Nodes.begin();
-    while(iter != Nodes.end()) {
-        Node& currentNode = *iter;
-        if(currentNode.Object.parent() == parentObject) {
-            iter = Nodes.erase(iter);
-        } else {
-            iter++;
+    for(int i = Geometries.size() - 1; i >= 0; i--) {
+        if(Geometries.at(i).Object.parent() == parentObject) {
+            removeGeometry(i);
         }
     }
 }
@@ -76,206 +236,403 @@ void cwGeometryItersecter::clear(cwGLObject *parentObject)
  */
 void cwGeometryItersecter::removeObject(cwGLObject *parentObject, uint id)
 {
-    QList<Node>::iterator iter = Nodes.begin();
-    while(iter != Nodes.end()) {
-        Node& currentNode = *iter;
-        if(currentNode.Object.parent() == parentObject &&
-                currentNode.Object.id() == id)
-        {
-            iter = Nodes.erase(iter);
-        } else {
-            ++iter;
-        }
+    Key key(parentObject, id);
+    if(GeometryIndexes.contains(key)) {
+        removeGeometry(GeometryIndexes.value(key));
     }
 }
 
 /**
  * @brief cwGeometryItersecter::intersects
  * @param ray
- * @return Closes intersection to on the ray, or if no match, use nearest neighbor search
+ * @return Closest triangle that the ray hits, or if nothing is hit, the nearest neighbor search
  */
 double cwGeometryItersecter::intersects(const QRay3D &ray) const
 {
-    QList<double> intersections;
+    updateObjectTree();
+    if(ObjectTree.isEmpty()) {
+        return qSNaN();
+    }
+
+    Ray fastRay(ray);
+    float bestT = std::numeric_limits<float>::max();
 
-    foreach(Node node, Nodes) {
+    QVector<int> stack;
+    stack.append(0);
+    while(!stack.isEmpty()) {
+        const BVH::Node& node = ObjectTree.Nodes.at(stack.takeLast());
 
-        double t = node.BoundingBox.intersection(ray);
-        if(!qIsNaN(t)) {
-            intersections.append(t);
+        float tNear;
+        if(!fastRay.intersects(node.Box, bestT, &tNear)) { continue; }
+
+        if(node.Count > 0) {
+            for(int i = node.First; i < node.First + node.Count; i++) {
+                const Geometry& geometry = Geometries.at(ObjectTree.Primitives.at(i));
+                if(geometry.Object.type() == Triangles) {
+                    intersectTriangles(geometry, fastRay, &bestT);
+                }
+            }
+        } else {
+            stack.append(node.First);
+            stack.append(node.First + 1);
         }
     }
 
     //See if we've intersected anything
-    if(intersections.size() == 0) {
+    if(bestT == std::numeric_limits<float>::max()) {
         return nearestNeighbor(ray); //Do a nearest neighbor search
     }
 
-    //Find the max value int intersections
-    double maxValue = -std::numeric_limits<double>::max();
-    foreach(double t, intersections) {
-        maxValue = qMax(t, maxValue);
-    }
-
-    return maxValue;
+    return bestT;
 }
 
 /**
- * @brief cwGeometryItersecter::addTriangles
- * @param object
- *
- * Adds the object as a triangle, if the object already exist is the
- * interecter, the object will be replaced.
+ * @brief cwGeometryItersecter::nearestNeighbor
+ * @param ray
+ * @return Finds the point on the ray that's the nearest neigbor of the lines, and the triangle's
+ * edges. If there's no geometry in front of the ray, this returns NaN
  */
-void cwGeometryItersecter::addTriangles(const cwGeometryItersecter::Object &object)
+double cwGeometryItersecter::nearestNeighbor(const QRay3D &ray) const
 {
-    //Make sure the object has the right number of indices
-    if(object.indexes().size() % 3 != 0) {
-        qDebug() << "Can't add object" << object.parent() << object.id() << "because it has an invalid indexes" << LOCATION;
-        return;
+    updateObjectTree();
+    if(ObjectTree.isEmpty()) {
+        return qSNaN();
     }
 
-    removeObject(object.parent(), object.id());
+    Ray fastRay(ray);
+    float bestDistance = std::numeric_limits<float>::max();
+    float bestT = 0.0f;
+
+    QVector<int> stack;
+    stack.append(0);
+    while(!stack.isEmpty()) {
+        const BVH::Node& node = ObjectTree.Nodes.at(stack.takeLast());
+        if(fastRay.distance(node.Box) >= bestDistance) { continue; }
+
+        if(node.Count > 0) {
+            for(int i = node.First; i < node.First + node.Count; i++) {
+                nearestSegments(Geometries.at(ObjectTree.Primitives.at(i)), fastRay, &bestDistance, &bestT);
+            }
+        } else {
+            stack.append(node.First);
+            stack.append(node.First + 1);
+        }
+    }
 
-    for(int i = 0; i < object.indexes().size(); i+=3) {
-        Nodes.append(Node(object, i));
+    if(bestT == 0.0f) {
+        return qSNaN();
     }
+
+    return bestT;
 }
 
 /**
- * @brief cwGeometryItersecter::addLines
- * @param object
- *
- * Adds the object as a lines.
+ * @brief cwGeometryItersecter::removeGeometry
+ * @param index - The index in Geometries that's removed
  *
- * If the object already exists in the intersecter the object will be replace with
- * the new data.
+ * The last geometry is moved into index, so this doesn't shift all the geometry
  */
-void cwGeometryItersecter::addLines(const cwGeometryItersecter::Object &object)
+void cwGeometryItersecter::removeGeometry(int index)
 {
-    //Make sure the object has the right number of indices
-    if(object.indexes().size() % 2 != 0) {
-        qDebug() << "Can't add object" << object.parent() << object.id() << "because it has an invalid indexes" << LOCATION;
-        return;
+    const Geometry& geometry = Geometries.at(index);
+    GeometryIndexes.remove(Key(geometry.Object.parent(), geometry.Object.id()));
+
+    int lastIndex = Geometries.size() - 1;
+    if(index != lastIndex) {
+        Geometries[index] = Geometries.at(lastIndex);
+        const cwGeometryItersecter::Object& moved = Geometries.at(index).Object;
+        GeometryIndexes.insert(Key(moved.parent(), moved.id()), index);
     }
+    Geometries.removeLast();
 
-    removeObject(object.parent(), object.id());
+    ObjectTreeDirty = true;
+}
 
-    for(int i = 0; i < object.indexes().size(); i+=2) {
-        Node node = Node(object, i);
+/**
+ * @brief cwGeometryItersecter::updateObjectTree
+ *
+ * Rebuilds the BVH over all the objects, if objects have been added or removed
+ */
+void cwGeometryItersecter::updateObjectTree() const
+{
+    if(!ObjectTreeDirty) { return; }
 
-        //Make sure the node is valid
-        if(!node.BoundingBox.isNull()) {
-            Nodes.append(node);
-        }
+    QVector<Bounds> objectBounds;
+    objectBounds.reserve(Geometries.size());
+    foreach(const Geometry& geometry, Geometries) {
+        objectBounds.append(geometry.Tree.isEmpty() ? Bounds() : geometry.Tree.Nodes.first().Box);
     }
-}
 
+    ObjectTree.build(objectBounds);
+    ObjectTreeDirty = false;
+}
 
 /**
- * @brief cwGeometryItersecter::nearestNeighbor
- * @param ray
- * @return Finds the point on the ray that's the nearest neigbor of the ray
+ * @brief cwGeometryItersecter::intersectTriangles
+ *
+ * Finds the closest triangle in geometry that the ray hits before bestT, and updates bestT
  */
-double cwGeometryItersecter::nearestNeighbor(const QRay3D &ray) const
+void cwGeometryItersecter::intersectTriangles(const Geometry &geometry, const Ray &ray, float *bestT) const
 {
-
-    QVector<QVector3D> points;
-    points.resize(8);
-
-    double bestT = 0.0;
-    double bestDistance = std::numeric_limits<double>::max();
-
-    foreach(Node node, Nodes) {
-
-        QVector3D min = node.BoundingBox.minimum();
-        QVector3D max = node.BoundingBox.maximum();
-
-        points[0] = min;
-        points[1] = QVector3D(max.x(), min.y(), min.z());
-        points[2] = QVector3D(max.x(), max.y(), min.z());
-        points[3] = QVector3D(min.x(), max.y(), min.z());
-        points[4] = QVector3D(min.x(), min.y(), max.z());
-        points[5] = QVector3D(max.x(), min.y(), max.z());
-        points[6] = QVector3D(min.x(), max.y(), max.z());
-        points[7] = max;
-
-        for(int i = 0; i < 8; i++) {
-            const QVector3D& point = points.at(i);
-            double distance = ray.distance(point);
-            if(distance < bestDistance) {
-                double t = ray.projectedDistance(point);
-                if(t > 0.0) {
-                    bestDistance = distance;
-                    bestT = t;
+    if(geometry.Tree.isEmpty()) { return; }
+
+    const QVector<QVector3D>& points = geometry.Object.points();
+    const QVector<uint>& indexes = geometry.Object.indexes();
+    const BVH& tree = geometry.Tree;
+
+    QVector<int> stack;
+    stack.append(0);
+    while(!stack.isEmpty()) {
+        const BVH::Node& node = tree.Nodes.at(stack.takeLast());
+
+        float tNear;
+        if(!ray.intersects(node.Box, *bestT, &tNear)) { continue; }
+
+        if(node.Count > 0) {
+            for(int i = node.First; i < node.First + node.Count; i++) {
+                int first = tree.Primitives.at(i) * 3;
+                float t = ray.intersects(points.at(indexes.at(first)),
+                                         points.at(indexes.at(first + 1)),
+                                         points.at(indexes.at(first + 2)));
+                if(t < *bestT) {
+                    *bestT = t;
                 }
             }
+        } else {
+            stack.append(node.First);
+            stack.append(node.First + 1);
         }
     }
+}
 
-    if(bestT == 0.0) {
-        return qSNaN();
+/**
+ * @brief cwGeometryItersecter::nearestSegments
+ *
+ * Finds the line segment, or triangle edge, in geometry that's closest to the ray, in front of
+ * the ray. If it's closer than bestDistance, this updates bestDistance and bestT.
+ */
+void cwGeometryItersecter::nearestSegments(const Geometry &geometry, const Ray &ray, float *bestDistance, float *bestT) const
+{
+    if(geometry.Tree.isEmpty()) { return; }
+
+    const QVector<QVector3D>& points = geometry.Object.points();
+    const QVector<uint>& indexes = geometry.Object.indexes();
+    const BVH& tree = geometry.Tree;
+    const int verticesPerPrimitive = geometry.verticesPerPrimitive();
+
+    QVector<int> stack;
+    stack.append(0);
+    while(!stack.isEmpty()) {
+        const BVH::Node& node = tree.Nodes.at(stack.takeLast());
+        if(ray.distance(node.Box) >= *bestDistance) { continue; }
+
+        if(node.Count > 0) {
+            for(int i = node.First; i < node.First + node.Count; i++) {
+                int first = tree.Primitives.at(i) * verticesPerPrimitive;
+
+                //Lines are one segment, triangles are three
+                int segments = verticesPerPrimitive == 2 ? 1 : 3;
+                for(int s = 0; s < segments; s++) {
+                    const QVector3D& p1 = points.at(indexes.at(first + s));
+                    const QVector3D& p2 = points.at(indexes.at(first + (s + 1) % verticesPerPrimitive));
+
+                    float t;
+                    float distance = ray.distance(p1, p2, &t);
+                    if(distance < *bestDistance && t > 0.0f) {
+                        *bestDistance = distance;
+                        *bestT = t;
+                    }
+                }
+            }
+        } else {
+            stack.append(node.First);
+            stack.append(node.First + 1);
+        }
     }
+}
 
-    return bestT;
+cwGeometryItersecter::Bounds::Bounds() :
+    Minimum(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()),
+    Maximum(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max())
+{
 }
 
+void cwGeometryItersecter::Bounds::expand(const QVector3D &point)
+{
+    Minimum = minimum(Minimum, point);
+    Maximum = maximum(Maximum, point);
+}
 
-cwGeometryItersecter::Node::Node(const cwGeometryItersecter::Object &object, int indexInIndexes) :
-    Object(object),
-    IndexInIndexes(indexInIndexes)
+void cwGeometryItersecter::Bounds::expand(const cwGeometryItersecter::Bounds &bounds)
 {
+    Minimum = minimum(Minimum, bounds.Minimum);
+    Maximum = maximum(Maximum, bounds.Maximum);
+}
 
-    switch(object.type()) {
-    case Triangles:
-        BoundingBox = triangleToBoundingBox();
-        break;
-    case Lines:
-        BoundingBox = lineToBoundingBox();
-        break;
-    default:
-        break;
-    }
+bool cwGeometryItersecter::Bounds::isEmpty() const
+{
+    return Minimum.x() > Maximum.x();
+}
+
+QVector3D cwGeometryItersecter::Bounds::center() const
+{
+    return (Minimum + Maximum) * 0.5f;
+}
 
+float cwGeometryItersecter::Bounds::surfaceArea() const
+{
+    if(isEmpty()) { return 0.0f; }
+    QVector3D size = Maximum - Minimum;
+    return 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
 }
 
 /**
- * @brief cwGeometryItersecter::Node::triangleToBoundingBox
- * @return Creates a bounding box around a triangle
+ * Half of the box's diagonal, the radius of the sphere around the box
  */
-QBox3D cwGeometryItersecter::Node::triangleToBoundingBox() const
+float cwGeometryItersecter::Bounds::radius() const
 {
-    QVector3D p1 = Object.points().at(Object.indexes().at(IndexInIndexes));
-    QVector3D p2 = Object.points().at(Object.indexes().at(IndexInIndexes + 1));
-    QVector3D p3 = Object.points().at(Object.indexes().at(IndexInIndexes + 2));
+    return (Maximum - Minimum).length() * 0.5f;
+}
 
-    QVector3D maxPoint(qMax(p1.x(), qMax(p2.x(), p3.x())),
-                       qMax(p1.y(), qMax(p2.y(), p3.y())),
-                       qMax(p1.z(), qMax(p2.z(), p3.z())));
+/**
+ * @brief cwGeometryItersecter::BVH::build
+ * @param primitiveBounds - The bounds of each primitive
+ *
+ * Builds the BVH top down, with binned surface area heuristic splits. Primitives with empty bounds
+ * are left out.
+ */
+void cwGeometryItersecter::BVH::build(const QVector<Bounds> &primitiveBounds)
+{
+    Nodes.clear();
+    Primitives.clear();
+
+    QVector<QVector3D> centroids(primitiveBounds.size());
+    Primitives.reserve(primitiveBounds.size());
+    for(int i = 0; i < primitiveBounds.size(); i++) {
+        if(!primitiveBounds.at(i).isEmpty()) {
+            centroids[i] = primitiveBounds.at(i).center();
+            Primitives.append(i);
+        }
+    }
 
-    QVector3D minPoint(qMin(p1.x(), qMin(p2.x(), p3.x())),
-                       qMin(p1.y(), qMin(p2.y(), p3.y())),
-                       qMin(p1.z(), qMin(p2.z(), p3.z())));
+    if(Primitives.isEmpty()) {
+        return;
+    }
 
-    return QBox3D(minPoint, maxPoint);
+    Nodes.reserve(2 * Primitives.size() / MaxLeafSize + 1);
+
+    Node root;
+    root.First = 0;
+    root.Count = Primitives.size();
+    Nodes.append(root);
+
+    split(0, primitiveBounds, centroids);
 }
 
 /**
- * @brief cwGeometryItersecter::Node::lineToBoundingBox
- * @return Creates a bounding box around a line
+ * @brief cwGeometryItersecter::BVH::split
+ *
+ * Computes the bounds of the node at nodeIndex, and splits it, if that's cheaper than testing all of
+ * its primitives
  */
-QBox3D cwGeometryItersecter::Node::lineToBoundingBox() const
+void cwGeometryItersecter::BVH::split(int nodeIndex, const QVector<Bounds> &primitiveBounds, const QVector<QVector3D> &centroids)
 {
-    QVector3D p1 = Object.points().at(Object.indexes().at(IndexInIndexes));
-    QVector3D p2 = Object.points().at(Object.indexes().at(IndexInIndexes + 1));
+    const int first = Nodes.at(nodeIndex).First;
+    const int count = Nodes.at(nodeIndex).Count;
+    int* primitives = Primitives.data() + first;
+
+    Bounds box;
+    Bounds centroidBox;
+    for(int i = 0; i < count; i++) {
+        box.expand(primitiveBounds.at(primitives[i]));
+        centroidBox.expand(centroids.at(primitives[i]));
+    }
+    Nodes[nodeIndex].Box = box;
+
+    if(count <= MaxLeafSize) {
+        return;
+    }
+
+    //Split along the longest axis of the centroids
+    QVector3D extent = centroidBox.Maximum - centroidBox.Minimum;
+    int axis = 0;
+    if(extent[1] > extent[axis]) { axis = 1; }
+    if(extent[2] > extent[axis]) { axis = 2; }
+
+    if(extent[axis] <= 0.0f) {
+        return; //All the centroids are at the same point, they can't be split
+    }
+
+    const float axisMinimum = centroidBox.Minimum[axis];
+    const float binScale = BinCount / extent[axis];
+    auto binOf = [&](int primitive) {
+        return qMin(static_cast<int>((centroids.at(primitive)[axis] - axisMinimum) * binScale), BinCount - 1);
+    };
+
+    Bounds binBounds[BinCount];
+    int binCounts[BinCount] = {};
+    for(int i = 0; i < count; i++) {
+        int bin = binOf(primitives[i]);
+        binCounts[bin]++;
+        binBounds[bin].expand(primitiveBounds.at(primitives[i]));
+    }
+
+    //Sweep from the right, to find the cost of every split
+    float rightCosts[BinCount];
+    Bounds rightBox;
+    int rightCount = 0;
+    for(int i = BinCount - 1; i > 0; i--) {
+        rightBox.expand(binBounds[i]);
+        rightCount += binCounts[i];
+        rightCosts[i] = rightCount * rightBox.surfaceArea();
+    }
+
+    float bestCost = std::numeric_limits<float>::max();
+    int bestSplit = -1;
+    Bounds leftBox;
+    int leftCount = 0;
+    for(int i = 0; i < BinCount - 1; i++) {
+        leftBox.expand(binBounds[i]);
+        leftCount += binCounts[i];
+        float cost = leftCount * leftBox.surfaceArea() + rightCosts[i + 1];
+        if(leftCount > 0 && leftCount < count && cost < bestCost) {
+            bestCost = cost;
+            bestSplit = i;
+        }
+    }
+
+    int middle;
+    if(bestSplit >= 0) {
+        //A leaf is tested against every primitive
+        if(count <= 4 * MaxLeafSize && bestCost >= count * box.surfaceArea()) {
+            return;
+        }
+
+        int* middlePrimitive = std::partition(primitives, primitives + count,
+                                              [&](int primitive) { return binOf(primitive) <= bestSplit; });
+        middle = static_cast<int>(middlePrimitive - primitives);
+    } else {
+        //The bins couldn't separate the primitives, split them in half
+        middle = count / 2;
+        std::nth_element(primitives, primitives + middle, primitives + count,
+                         [&](int left, int right) { return centroids.at(left)[axis] < centroids.at(right)[axis]; });
+    }
+
+    Node left;
+    left.First = first;
+    left.Count = middle;
+
+    Node right;
+    right.First = first + middle;
+    right.Count = count - middle;
 
-    QVector3D maxPoint(qMax(p1.x(), p2.x()),
-                       qMax(p1.y(), p2.y()),
-                       qMax(p1.z(), p2.z()));
+    int leftIndex = Nodes.size();
+    Nodes.append(left);
+    Nodes.append(right);
 
-    QVector3D minPoint(qMin(p1.x(), p2.x()),
-                       qMin(p1.y(), p2.y()),
-                       qMin(p1.z(), p2.z()));
+    Nodes[nodeIndex].First = leftIndex;
+    Nodes[nodeIndex].Count = 0;
 
-    return QBox3D(minPoint, maxPoint);
+    split(leftIndex, primitiveBounds, centroids);
+    split(leftIndex + 1, primitiveBounds, centroids);
 }
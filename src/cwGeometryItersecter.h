@@ -13,11 +13,22 @@
 #include <QVector3D>
 #include <QRay3D>
 #include <QBox3D>
+#include <QHash>
+#include <QPair>
 
 //Our includes
+#include "cwGlobals.h"
 class cwGLObject;
 
-class cwGeometryItersecter
+/**
+ * @brief The cwGeometryItersecter class
+ *
+ * Finds where a ray hits the scene's geometry, for picking with the mouse. Every object has its own
+ * bounding volume hierarchy of its triangles or lines, that's rebuilt when the object is added or
+ * replaced. A second hierarchy over the objects is rebuilt lazily, on the next query after objects
+ * are added or removed. The objects' points and indexes are implicitly shared, and aren't copied.
+ */
+class CAVEWHERE_LIB_EXPORT cwGeometryItersecter
 {
 public:
 
@@ -60,32 +71,71 @@ public:
     void removeObject(cwGLObject* parentObject, uint id);
 
     double intersects(const QRay3D& ray) const;
-
+    double nearestNeighbor(const QRay3D& ray) const;
 
 private:
+    class Ray;
 
-    class Node {
+    class Bounds {
     public:
-        Node();
-        Node(const cwGeometryItersecter::Object& object, int indexInIndexes);
+        Bounds();
 
-        QBox3D BoundingBox;
-        cwGeometryItersecter::Object Object;
-        int IndexInIndexes; //Where in Object this Node point's to
+        void expand(const QVector3D& point);
+        void expand(const Bounds& bounds);
+
+        bool isEmpty() const;
+        QVector3D center() const;
+        float surfaceArea() const;
+        float radius() const;
+
+        QVector3D Minimum;
+        QVector3D Maximum;
+    };
+
+    /**
+     * A bounding volume hierarchy over primitives, like the triangles of an object, or the
+     * objects themselves. The first node is the root, and siblings are next to each other.
+     */
+    class BVH {
+    public:
+        class Node {
+        public:
+            Bounds Box;
+            int First; //Leaf: the first primitive in Primitives, otherwise the left child
+            int Count; //Leaf: the number of primitives, otherwise 0 and the right child is First + 1
+        };
+
+        void build(const QVector<Bounds>& primitiveBounds);
+        bool isEmpty() const { return Nodes.isEmpty(); }
+
+        QVector<Node> Nodes;
+        QVector<int> Primitives; //Primitive indexes, ordered so each leaf is a contiguous range
 
     private:
-        QBox3D triangleToBoundingBox() const;
-        QBox3D lineToBoundingBox() const;
+        void split(int nodeIndex, const QVector<Bounds>& primitiveBounds, const QVector<QVector3D>& centroids);
+    };
 
+    //An object and the BVH of its triangles or lines
+    class Geometry {
+    public:
+        cwGeometryItersecter::Object Object;
+        BVH Tree;
+        int verticesPerPrimitive() const { return Object.type() == Triangles ? 3 : 2; }
     };
 
-    QList<Node> Nodes;
+    typedef QPair<cwGLObject*, uint> Key;
 
-    void addTriangles(const cwGeometryItersecter::Object& object);
-    void addLines(const cwGeometryItersecter::Object& object);
+    QVector<Geometry> Geometries;
+    QHash<Key, int> GeometryIndexes; //Where each object is in Geometries
 
-    double nearestNeighbor(const QRay3D& ray) const;
-//    double LineLineIntersect(QVector3D p1, QVector3D p2, QVector3D p3, QVector3D p4) const;
+    mutable BVH ObjectTree; //Over all of the Geometries
+    mutable bool ObjectTreeDirty;
+
+    void removeGeometry(int index);
+    void updateObjectTree() const;
+
+    void intersectTriangles(const Geometry& geometry, const Ray& ray, float* bestT) const;
+    void nearestSegments(const Geometry& geometry, const Ray& ray, float* bestDistance, float* bestT) const;
 };
 
 inline uint qHash(const cwGeometryItersecter::Object& object) {
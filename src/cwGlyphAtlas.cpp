@@ -0,0 +1,142 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwGlyphAtlas.h"
+
+//Qt includes
+#include <QPainter>
+#include <QPainterPath>
+#include <QFontMetricsF>
+#include <QPen>
+
+namespace {
+
+//The width of the atlas in pixels
+const int AtlasWidth = 512;
+
+//The width of the black outline around each glyph
+const qreal OutlineWidth = 1.0;
+
+//Empty pixels between glyphs, so they don't bleed into each other
+const int Padding = 1;
+
+}
+
+cwGlyphAtlas::cwGlyphAtlas() :
+    Image(AtlasWidth, 64, QImage::Format_ARGB32_Premultiplied),
+    Cursor(Padding, Padding),
+    RowHeight(0)
+{
+    Image.fill(Qt::transparent);
+}
+
+/**
+ * @brief cwGlyphAtlas::addText
+ * @param text - The text that's going to be drawn
+ * @param font - The text's font
+ * @return True if glyphs were added to image()
+ */
+bool cwGlyphAtlas::addText(const QString& text, const QFont& font)
+{
+    bool added = false;
+    foreach(QChar character, text) {
+        if(!Glyphs.contains(glyphKey(character, font))) {
+            addGlyph(character, font);
+            added = true;
+        }
+    }
+    return added;
+}
+
+/**
+ * @brief cwGlyphAtlas::glyph
+ * @return The glyph for character, this is empty if it hasn't been added with addText()
+ */
+cwGlyphAtlas::Glyph cwGlyphAtlas::glyph(QChar character, const QFont& font) const
+{
+    return Glyphs.value(glyphKey(character, font));
+}
+
+/**
+ * @brief cwGlyphAtlas::addGlyph
+ *
+ * Draws the outlined glyph at the cursor. Glyphs are packed into rows, left to right.
+ */
+void cwGlyphAtlas::addGlyph(QChar character, const QFont& font)
+{
+    QFontMetricsF metrics(font);
+
+    Glyph glyph;
+    glyph.Advance = metrics.width(character);
+
+    QPainterPath path;
+    path.addText(QPointF(0.0, 0.0), font, QString(character));
+
+    QRectF bounds = path.boundingRect();
+    if(!bounds.isEmpty()) {
+        bounds.adjust(-OutlineWidth, -OutlineWidth, OutlineWidth, OutlineWidth);
+        QRect pixelBounds = bounds.toAlignedRect();
+
+        if(Cursor.x() + pixelBounds.width() + Padding > Image.width()) {
+            //Next row
+            Cursor = QPoint(Padding, Cursor.y() + RowHeight + Padding);
+            RowHeight = 0;
+        }
+
+        if(Cursor.y() + pixelBounds.height() + Padding > Image.height()) {
+            grow(Cursor.y() + pixelBounds.height() + Padding);
+        }
+
+        glyph.Rect = QRect(Cursor, pixelBounds.size());
+        glyph.Offset = pixelBounds.topLeft();
+
+        QPainter painter(&Image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.translate(Cursor - pixelBounds.topLeft());
+        painter.strokePath(path, QPen(Qt::black, OutlineWidth * 2.0, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        painter.fillPath(path, Qt::white);
+
+        Cursor.rx() += pixelBounds.width() + Padding;
+        RowHeight = qMax(RowHeight, pixelBounds.height());
+    }
+
+    Glyphs.insert(glyphKey(character, font), glyph);
+}
+
+/**
+ * @brief cwGlyphAtlas::grow
+ * @param height - The smallest height that image() needs
+ *
+ * Doubles the height of image() until it's at least height. The glyphs stay where they are.
+ */
+void cwGlyphAtlas::grow(int height)
+{
+    int newHeight = Image.height();
+    while(newHeight < height) {
+        newHeight *= 2;
+    }
+
+    QImage newImage(Image.width(), newHeight, QImage::Format_ARGB32_Premultiplied);
+    newImage.fill(Qt::transparent);
+
+    QPainter painter(&newImage);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(0, 0, Image);
+    painter.end();
+
+    Image = newImage;
+}
+
+/**
+ * @brief cwGlyphAtlas::glyphKey
+ * @return The key for character in font
+ */
+QString cwGlyphAtlas::glyphKey(QChar character, const QFont& font)
+{
+    return font.key() + character;
+}
@@ -0,0 +1,69 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWGLYPHATLAS_H
+#define CWGLYPHATLAS_H
+
+//Our includes
+#include "cwGlobals.h"
+
+//Qt includes
+#include <QImage>
+#include <QHash>
+#include <QFont>
+#include <QRect>
+#include <QPointF>
+
+/**
+ * @brief The cwGlyphAtlas class
+ *
+ * Packs outlined glyphs into one image, so all of the labels can be drawn from one texture.
+ * Glyphs are white with a black outline, like an outlined QML Text, and are added the first
+ * time they're used. The atlas is a fixed width, and grows taller as glyphs are added. Growing
+ * doesn't move the glyphs that are already in the atlas.
+ */
+class CAVEWHERE_LIB_EXPORT cwGlyphAtlas
+{
+public:
+    class Glyph {
+    public:
+        Glyph() : Advance(0.0) {}
+
+        QRect Rect; //!< Where the glyph is in image(), empty for whitespace
+        QPointF Offset; //!< From the pen position on the baseline, to the top left of Rect
+        qreal Advance; //!< How far the pen moves after the glyph
+    };
+
+    cwGlyphAtlas();
+
+    bool addText(const QString& text, const QFont& font);
+    Glyph glyph(QChar character, const QFont& font) const;
+
+    QImage image() const;
+
+private:
+    QImage Image;
+    QHash<QString, Glyph> Glyphs; //Keyed by glyphKey()
+    QPoint Cursor; //!< Where the next glyph goes
+    int RowHeight; //!< The height of the tallest glyph in Cursor's row
+
+    void addGlyph(QChar character, const QFont& font);
+    void grow(int height);
+
+    static QString glyphKey(QChar character, const QFont& font);
+};
+
+/**
+ * @brief cwGlyphAtlas::image
+ * @return All the glyphs, premultiplied
+ */
+inline QImage cwGlyphAtlas::image() const
+{
+    return Image;
+}
+
+#endif // CWGLYPHATLAS_H
@@ -62,6 +62,16 @@ void cwImageCleanupTask::runTask()
             removeImageIdQuery.exec();
         }
 
+        //Remove the tiles of the unused mipmaps, see cwProject::addTiledImage()
+        if(Database.tables().contains("ImageTiles")) {
+            QSqlQuery removeTilesQuery(Database);
+            removeTilesQuery.prepare("DELETE FROM ImageTiles WHERE imageId == ?");
+            foreach(int id, unusedIds) {
+                removeTilesQuery.bindValue(0, id);
+                removeTilesQuery.exec();
+            }
+        }
+
         endTransation();
 
         //Close the database
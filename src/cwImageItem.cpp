@@ -12,18 +12,22 @@
 #include "cwImageProvider.h"
 #include "cwImageProperties.h"
 #include "cwGlobalDirectory.h"
-#include "cwImageTexture.h"
+#include "cwTiledImageTexture.h"
 #include "cwProjection.h"
 #include "cwGLImageItemResources.h"
 
 //QT includes
 #include <QtConcurrentRun>
 #include <QtConcurrentMap>
+#include <QPolygonF>
+#include <QLineF>
+#include <QVector4D>
 
 QOpenGLShaderProgram* cwImageItem::ImageProgram = nullptr;
 int cwImageItem::vVertex = -1;
 int cwImageItem::ModelViewProjectionMatrix = -1;
 int cwImageItem::CropAreaUniform = -1;
+int cwImageItem::TileAreaUniform = -1;
 
 cwImageItem::cwImageItem(QQuickItem *parent) :
     cwGLViewer(parent),
@@ -140,13 +144,14 @@ void cwImageItem::initializeGL() {
     GLResources = new cwGLImageItemResources();
     GLResources->setContext(QOpenGLContext::currentContext());
 
-    GLResources->NoteTexture = new cwImageTexture();
+    GLResources->NoteTexture = new cwTiledImageTexture();
     GLResources->NoteTexture->setProject(ProjectFilename);
     GLResources->NoteTexture->setImage(Image);
 
     //Called when the image is finished loading
     connect(GLResources->NoteTexture, SIGNAL(textureUploaded()), SLOT(imageFinishedLoading()));
     connect(GLResources->NoteTexture, SIGNAL(projectChanged()), SIGNAL(projectFilenameChanged()));
+    connect(GLResources->NoteTexture, SIGNAL(tilesLoaded()), SLOT(update()));
 
     initializeShaders();
     initializeVertexBuffers();
@@ -176,6 +181,7 @@ void cwImageItem::initializeShaders() {
         vVertex = ImageProgram->attributeLocation("vVertex");
         ModelViewProjectionMatrix = ImageProgram->uniformLocation("ModelViewProjectionMatrix");
         CropAreaUniform = ImageProgram->uniformLocation("CropArea");
+        TileAreaUniform = ImageProgram->uniformLocation("TileArea");
 
         ImageProgram->setUniformValue("Texture", 0); //set the texture unit to 0
     }
@@ -268,27 +274,75 @@ void cwImageItem::paint(QPainter* painter) {
     if(!Image.isValid()) { return; }
     if(GLResources == nullptr) { initializeGL(); }
 
+    //Only the tiles that are in view are drawn
+    QList<cwTiledImageTexture::DrawTile> tiles = GLResources->NoteTexture->visibleTiles(visibleNoteArea(), noteScreenSize());
+
     painter->beginNativePainting();
 
-    GLResources->NoteTexture->bind();
+    //Tiles overlap coarser tiles, at the same depth
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+
     GLResources->GeometryVertexBuffer.bind();
 
     ImageProgram->bind();
     ImageProgram->setAttributeBuffer(vVertex, GL_FLOAT, 0, 2);
     ImageProgram->enableAttributeArray(vVertex);
     ImageProgram->setUniformValue(ModelViewProjectionMatrix, Camera->viewProjectionMatrix() * RotationModelMatrix);
-    ImageProgram->setUniformValue(CropAreaUniform, GLResources->NoteTexture->scaleTexCoords());
 
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4); //Draw the quad
+    glActiveTexture(GL_TEXTURE0);
+    foreach(const cwTiledImageTexture::DrawTile& tile, tiles) {
+        QRectF area = tile.Area;
+        glBindTexture(GL_TEXTURE_2D, tile.TextureId);
+        ImageProgram->setUniformValue(TileAreaUniform, QVector4D(area.x(), area.y(), area.width(), area.height()));
+        ImageProgram->setUniformValue(CropAreaUniform, tile.TexCoordScale);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4); //Draw the tile's quad
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
 
     ImageProgram->disableAttributeArray(vVertex);
     ImageProgram->release();
-    GLResources->NoteTexture->release();
     GLResources->GeometryVertexBuffer.release();
 
+    if(depthTest) {
+        glEnable(GL_DEPTH_TEST);
+    }
+
     painter->endNativePainting();
 }
 
+/**
+ * @brief cwImageItem::visibleNoteArea
+ * @return The bounding box of the note that's in the viewport, in normalized note coordinates
+ */
+QRectF cwImageItem::visibleNoteArea() const
+{
+    QRect viewport = Camera->viewport();
+    QList<QPoint> corners = {viewport.topLeft(),
+                             viewport.topRight(),
+                             viewport.bottomLeft(),
+                             viewport.bottomRight()};
+
+    QPolygonF area;
+    foreach(QPoint corner, corners) {
+        area.append(Camera->unProject(corner, 0.0, RotationModelMatrix).toPointF());
+    }
+
+    return area.boundingRect().intersected(QRectF(0.0, 0.0, 1.0, 1.0));
+}
+
+/**
+ * @brief cwImageItem::noteScreenSize
+ * @return The size of the whole note on the screen, in pixels
+ */
+QSizeF cwImageItem::noteScreenSize() const
+{
+    QPointF origin = Camera->project(QVector3D(0.0, 0.0, 0.0), RotationModelMatrix);
+    QPointF right = Camera->project(QVector3D(1.0, 0.0, 0.0), RotationModelMatrix);
+    QPointF top = Camera->project(QVector3D(0.0, 1.0, 0.0), RotationModelMatrix);
+    return QSizeF(QLineF(origin, right).length(), QLineF(origin, top).length());
+}
+
 /**
  * @brief cwImageItem::releaseResources
  */
@@ -17,7 +17,7 @@
 #include "cwImage.h"
 #include "cwImageData.h"
 class cwGLImageItemResources;
-class cwImageTexture;
+class cwTiledImageTexture;
 class cwImageProperties;
 
 class cwImageItem : public cwGLViewer
@@ -85,6 +85,7 @@ private:
     static int vVertex; //!< The attribute location of the vVertex
     static int ModelViewProjectionMatrix; //!< The uniform location for modelViewProjection matrix
     static int CropAreaUniform; //!< The uniform location of CropArea this is for trimming padding of the images
+    static int TileAreaUniform; //!< The uniform location of TileArea, the area of the note that's covered by a tile
 //    cwImageTexture* NoteTexture;
     static QOpenGLShaderProgram* ImageProgram; //!< The image shader program that's used to render the image
 //    QOpenGLBuffer GeometryVertexBuffer; //!< The vertex buffer
@@ -93,6 +94,9 @@ private:
     void initializeVertexBuffers();
     void initializeTexture();
 
+    QRectF visibleNoteArea() const;
+    QSizeF noteScreenSize() const;
+
 private slots:
      void imageFinishedLoading();
 
@@ -9,6 +9,8 @@
 #include "cwImageProvider.h"
 #include "cwDebug.h"
 #include "cwSQLManager.h"
+#include "cwTileLoadTask.h"
+#include "cwDxt1Encoder.h"
 
 //Qt includes
 #include <QSqlDatabase>
@@ -20,13 +22,165 @@
 #include <QMutexLocker>
 #include <QDebug>
 #include <QSqlError>
+#include <QCoreApplication>
+#include <QThread>
 
 const QString cwImageProvider::Name = "sqlimagequery";
 const QString cwImageProvider::RequestImageSQL = "SELECT type,width,height,dotsPerMeter,imageData from Images where id=?";
 const QString cwImageProvider::RequestMetadataSQL = "SELECT type,width,height,dotsPerMeter from Images where id=?";
+const QString cwImageProvider::RequestTileSQL = "SELECT type,tileData from ImageTiles where imageId=? and tileColumn=? and tileRow=?";
+const QString cwImageProvider::RequestTilesSQL = "SELECT tileColumn,tileRow,type,tileData from ImageTiles where imageId=?";
+const QByteArray cwImageProvider::Dxt1_Extension = "dxt1";
+const QByteArray cwImageProvider::Dxt1_LZ_Extension = "dxt1.lz";
 const QByteArray cwImageProvider::Dxt1_GZ_Extension = "dxt1.gz";
 
 QAtomicInt cwImageProvider::ConnectionCounter;
+QThreadStorage<cwImageProvider::ConnectionPool*> cwImageProvider::Connections;
+QMutex cwImageProvider::ConnectionStateMutex;
+QWaitCondition cwImageProvider::ConnectionsClosed;
+QHash<QString, int> cwImageProvider::Generations;
+QHash<QString, int> cwImageProvider::OpenWorkerConnections;
+
+/**
+  A read only connection to a project file with its queries already prepared.
+
+  Qt only supports using a database connection from the thread that created it, so a
+  connection is only opened, used and closed by the thread that owns it.
+  */
+class cwImageProvider::Connection {
+public:
+    Connection(const QString& projectPath);
+    ~Connection();
+
+    bool open();
+    void close();
+    bool isOpen() const { return Open; }
+    bool prepareTileQueries();
+
+    QString ProjectPath;
+    QString Name;
+    bool Open;
+    bool TileQueriesPrepared;
+    int Generation; //!< The project's generation when this was opened, see closeConnections()
+    QSqlDatabase Database;
+    QSqlQuery ImageQuery;
+    QSqlQuery MetadataQuery;
+    QSqlQuery TileQuery;
+    QSqlQuery TilesQuery;
+};
+
+/**
+  All the connections of a thread. This is deleted by QThreadStorage, in the thread, when the
+  thread exits, which closes and removes the connections.
+  */
+class cwImageProvider::ConnectionPool {
+public:
+    ~ConnectionPool() { qDeleteAll(Connections); }
+
+    QHash<QString, Connection*> Connections; //Project path to connection
+};
+
+cwImageProvider::Connection::Connection(const QString &projectPath) :
+    ProjectPath(projectPath),
+    Name(QString("imageProvider/%1").arg(ConnectionCounter.fetchAndAddAcquire(1))),
+    Open(false),
+    TileQueriesPrepared(false),
+    Generation(0)
+{
+    //Define the database
+    Database = QSqlDatabase::addDatabase("QSQLITE", Name);
+    Database.setDatabaseName(projectPath);
+}
+
+cwImageProvider::Connection::~Connection()
+{
+    close();
+    Database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(Name);
+}
+
+/**
+  Opens the database and prepares the queries. Returns true if the connection is open.
+  */
+bool cwImageProvider::Connection::open()
+{
+    if(Open) {
+        return true;
+    }
+
+    //Create an sql connection
+    if(!Database.open()) {
+        qDebug() << "cwProjectImageProvider:: Couldn't connect to database:" << ProjectPath << Database.lastError().text() << LOCATION;
+        return false;
+    }
+
+    //Setup the queries
+    ImageQuery = QSqlQuery(Database);
+    MetadataQuery = QSqlQuery(Database);
+
+    if(!ImageQuery.prepare(RequestImageSQL)) {
+        qDebug() << "cwProjectImageProvider:: Couldn't prepare query " << RequestImageSQL << ImageQuery.lastError().text();
+        close();
+        return false;
+    }
+
+    if(!MetadataQuery.prepare(RequestMetadataSQL)) {
+        qDebug() << "cwProjectImageProvider:: Couldn't prepare query " << RequestMetadataSQL << MetadataQuery.lastError().text();
+        close();
+        return false;
+    }
+
+    Open = true;
+    return true;
+}
+
+/**
+  Closes the database, this releases the file handle to the project file
+  */
+void cwImageProvider::Connection::close()
+{
+    //All the queries need to be gone before the database can be closed
+    ImageQuery = QSqlQuery();
+    MetadataQuery = QSqlQuery();
+    TileQuery = QSqlQuery();
+    TilesQuery = QSqlQuery();
+    TileQueriesPrepared = false;
+    Database.close();
+    Open = false;
+}
+
+/**
+  Prepares the queries for tiled images. Returns false if the project doesn't have tiled images.
+
+  Older projects don't have the ImageTiles table until an image is added to them, so this is
+  checked on every request until the table exists.
+  */
+bool cwImageProvider::Connection::prepareTileQueries()
+{
+    if(TileQueriesPrepared) {
+        return true;
+    }
+
+    if(!Database.tables().contains("ImageTiles")) {
+        return false;
+    }
+
+    TileQuery = QSqlQuery(Database);
+    TilesQuery = QSqlQuery(Database);
+
+    if(!TileQuery.prepare(RequestTileSQL)) {
+        qDebug() << "cwProjectImageProvider:: Couldn't prepare query " << RequestTileSQL << TileQuery.lastError().text();
+        return false;
+    }
+
+    if(!TilesQuery.prepare(RequestTilesSQL)) {
+        qDebug() << "cwProjectImageProvider:: Couldn't prepare query " << RequestTilesSQL << TilesQuery.lastError().text();
+        return false;
+    }
+
+    TileQueriesPrepared = true;
+    return true;
+}
 
 cwImageProvider::cwImageProvider() :
     QQuickImageProvider(QQuickImageProvider::Image)
@@ -84,7 +238,7 @@ QImage cwImageProvider::requestImage(const QString &id, QSize *size, const QSize
   This will also return the size and the data.  If the image couldn't be loaded then
   this returns a empty QByteArray.
 
-  If the format is dxt1.gz then this will unzip the data
+  If the format is dxt1.lz or dxt1.gz then this will uncompress the data
   */
 QByteArray cwImageProvider::requestImageData(int id, QSize* size, QByteArray* type) {
     //Set the default size
@@ -113,8 +267,18 @@ QByteArray cwImageProvider::requestImageData(int id, QSize* size, QByteArray* ty
  *Sets the project path so we can connect and extract data from it
  */
 void cwImageProvider::setProjectPath(QString projectPath) {
-    QMutexLocker locker(&ProjectPathMutex);
-    ProjectPath = projectPath;
+    QString oldProjectPath;
+    {
+        QMutexLocker locker(&ProjectPathMutex);
+        oldProjectPath = ProjectPath;
+        ProjectPath = projectPath;
+    }
+
+    //Release this thread's connection to the old project, other threads only keep connections
+    //open while they're reading
+    if(!oldProjectPath.isEmpty() && oldProjectPath != projectPath) {
+        closeLocalConnection(oldProjectPath);
+    }
 }
 
 /**
@@ -137,50 +301,24 @@ cwImageData cwImageProvider::originalMetadata(const cwImage &image) const {
   */
 cwImageData cwImageProvider::data(int id, bool metaDataOnly) const {
 
-    //Needed to get around const correctness
-    cwImageProvider* castedConstThis = const_cast<cwImageProvider*>(this);
-    int connectionName = castedConstThis->ConnectionCounter.fetchAndAddAcquire(1);
-
-//    QString databaseName = QString("resquestImage/%1").arg(counter);
-    QString request = metaDataOnly ? "requestMetadata/%1" : "resquestImage/%1";
-
-    //Define the database
-    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", request.arg(connectionName));
-    database.setDatabaseName(projectPath());
-
-    //Create an sql connection
-    bool connected = database.open();
-    if(!connected) {
-        qDebug() << "cwProjectImageProvider:: Couldn't connect to database:" << ProjectPath << database.lastError().text() << LOCATION;
+    Connection* projectConnection = connection(projectPath());
+    if(projectConnection == nullptr) {
         return cwImageData();
     }
 
-    cwSQLManager::instance()->beginTransaction(database, cwSQLManager::ReadOnly);
+    const QSqlDatabase& database = projectConnection->Database;
+    QSqlQuery& query = metaDataOnly ? projectConnection->MetadataQuery : projectConnection->ImageQuery;
 
-    //Setup the query
-    QSqlQuery query(database);
-    bool successful;
-    if(metaDataOnly) {
-        successful = query.prepare(RequestMetadataSQL);
-    } else {
-        successful = query.prepare(RequestImageSQL);
-    }
-
-    if(!successful) {
-        qDebug() << "cwProjectImageProvider:: Couldn't prepare query " << RequestImageSQL;
-        cwSQLManager::instance()->endTransaction(database);
-        database.close();
-        return cwImageData();
-    }
+    cwSQLManager::instance()->beginTransaction(database, cwSQLManager::ReadOnly);
 
     //Set the id that we're searching for
     query.bindValue(0, id);
-    successful = query.exec();
+    bool successful = query.exec();
 
     if(!successful) {
         qDebug() << "Couldn't exec query image id:" << id << LOCATION;
         cwSQLManager::instance()->endTransaction(database);
-        database.close();
+        releaseConnection(projectConnection);
         return cwImageData();
     }
 
@@ -194,24 +332,263 @@ cwImageData cwImageProvider::data(int id, bool metaDataOnly) const {
         QByteArray imageData;
         if(!metaDataOnly) {
             imageData = query.value(4).toByteArray();
-            //Remove the zlib compression from the image
-            if(QString(type) == QString(cwImageProvider::Dxt1_GZ_Extension)) {
-                //Decompress the QByteArray
-                imageData = qUncompress(imageData);
-            }
+        }
+
+        //Release the statement, so it's ready for the next request
+        query.finish();
+
+        //Tiled mipmaps don't have a blob, they're put back together from their tiles
+        bool tiled = !metaDataOnly && isDxt1Format(type) && imageData.isEmpty();
+        if(tiled) {
+            imageData = levelFromTiles(projectConnection, id, size);
         }
 
         cwSQLManager::instance()->endTransaction(database);
-        database.close();
+        releaseConnection(projectConnection);
+
+        //Remove the blob compression from the image
+        if(!metaDataOnly && isDxt1Format(type) && !tiled) {
+            imageData = cwBlobCodec::uncompress(imageData, cwBlobCodec::codec(type));
+        }
+
         return cwImageData(size, dotsPerMeter, type, imageData);
     }
 
+    query.finish();
     cwSQLManager::instance()->endTransaction(database);
-    database.close();
+    releaseConnection(projectConnection);
     qDebug() << "Query has no data for id:" << id << LOCATION;
     return cwImageData();
 }
 
+/**
+  \brief Gets the DXT1 blocks of a tile of a tiled mipmap
+
+  \param id - The mipmap's id
+  \param index - The tile's column and row, see cwTileLoadTask::tileRect()
+
+  Only the tile's row is read from the project. This returns an empty QByteArray if the mipmap
+  isn't tiled, see cwProject::addTiledImage(), or if the tile doesn't exist.
+  */
+QByteArray cwImageProvider::tile(int id, QPoint index) const
+{
+    Connection* projectConnection = connection(projectPath());
+    if(projectConnection == nullptr) {
+        return QByteArray();
+    }
+
+    if(!projectConnection->prepareTileQueries()) {
+        releaseConnection(projectConnection);
+        return QByteArray();
+    }
+
+    const QSqlDatabase& database = projectConnection->Database;
+    QSqlQuery& query = projectConnection->TileQuery;
+
+    cwSQLManager::instance()->beginTransaction(database, cwSQLManager::ReadOnly);
+
+    query.bindValue(0, id);
+    query.bindValue(1, index.x());
+    query.bindValue(2, index.y());
+
+    QByteArray type;
+    QByteArray tileData;
+    if(!query.exec()) {
+        qDebug() << "Couldn't exec query tile:" << id << index << query.lastError().text() << LOCATION;
+    } else if(query.next()) {
+        type = query.value(0).toByteArray();
+        tileData = query.value(1).toByteArray();
+    }
+
+    query.finish();
+    cwSQLManager::instance()->endTransaction(database);
+    releaseConnection(projectConnection);
+
+    return cwBlobCodec::uncompress(tileData, cwBlobCodec::codec(type));
+}
+
+/**
+  \brief Puts a tiled mipmap back together from its tiles
+
+  This must be called inside of a transaction. Returns an empty QByteArray if the mipmap doesn't
+  have any tiles, or if a tile is corrupt.
+  */
+QByteArray cwImageProvider::levelFromTiles(Connection *connection, int id, QSize size) const
+{
+    if(!connection->prepareTileQueries()) {
+        return QByteArray();
+    }
+
+    QSqlQuery& query = connection->TilesQuery;
+    query.bindValue(0, id);
+    if(!query.exec()) {
+        qDebug() << "Couldn't exec query tiles:" << id << query.lastError().text() << LOCATION;
+        return QByteArray();
+    }
+
+    QByteArray levelData(cwDxt1Encoder::storageSize(size), '\0');
+    int numberOfTiles = 0;
+    while(query.next()) {
+        QPoint index(query.value(0).toInt(), query.value(1).toInt());
+        QByteArray type = query.value(2).toByteArray();
+        QByteArray tileData = cwBlobCodec::uncompress(query.value(3).toByteArray(), cwBlobCodec::codec(type));
+
+        QRect rect = cwTileLoadTask::tileRect(size, index);
+        if(rect.isEmpty() || tileData.size() != cwDxt1Encoder::storageSize(rect.size())) {
+            qDebug() << "Tile" << index << "of mipmap" << id << "is corrupt" << LOCATION;
+            query.finish();
+            return QByteArray();
+        }
+
+        cwTileLoadTask::pasteTile(&levelData, size, rect, tileData);
+        numberOfTiles++;
+    }
+    query.finish();
+
+    QSize gridSize = cwTileLoadTask::tileGridSize(size);
+    if(numberOfTiles != gridSize.width() * gridSize.height()) {
+        if(numberOfTiles > 0) {
+            qDebug() << "Mipmap" << id << "is missing tiles" << numberOfTiles << gridSize << LOCATION;
+        }
+        return QByteArray();
+    }
+
+    return levelData;
+}
+
+/**
+  \brief Gets the current thread's open connection to projectPath
+
+  The connection is created the first time a thread requests data from projectPath. The GUI
+  thread keeps it open until closeConnections() or until the thread exits. Other threads, like
+  the thread pool and the QML image reader, can't be stopped before a project file is removed,
+  so they close it again in releaseConnection(), and keep only its prepared definition.
+
+  A connection that was opened before the last closeConnections() is reopened. Connections to
+  other projects are deleted here, so threads don't keep a connection for every project they've
+  read from.
+
+  Returns nullptr if the connection couldn't be opened. Otherwise, the caller must call
+  releaseConnection() when it's done.
+  */
+cwImageProvider::Connection* cwImageProvider::connection(const QString &projectPath) const
+{
+    if(!Connections.hasLocalData()) {
+        Connections.setLocalData(new ConnectionPool());
+    }
+
+    ConnectionPool* pool = Connections.localData();
+
+    //Delete this thread's connections to other projects
+    QMutableHashIterator<QString, Connection*> iter(pool->Connections);
+    while(iter.hasNext()) {
+        iter.next();
+        if(iter.key() != projectPath) {
+            delete iter.value();
+            iter.remove();
+        }
+    }
+
+    Connection* projectConnection = pool->Connections.value(projectPath, nullptr);
+    if(projectConnection == nullptr) {
+        projectConnection = new Connection(projectPath);
+        pool->Connections.insert(projectPath, projectConnection);
+    }
+
+    bool pooling = isPoolingThread();
+    {
+        QMutexLocker locker(&ConnectionStateMutex);
+        int generation = Generations.value(projectPath, 0);
+        if(projectConnection->isOpen() && projectConnection->Generation != generation) {
+            projectConnection->close();
+        }
+        projectConnection->Generation = generation;
+
+        if(!pooling) {
+            OpenWorkerConnections[projectPath]++;
+        }
+    }
+
+    if(!projectConnection->open()) {
+        releaseConnection(projectConnection);
+        return nullptr;
+    }
+
+    return projectConnection;
+}
+
+/**
+  \brief Ends a request that got its connection from connection()
+
+  Threads that don't pool their connections close it here, see connection()
+  */
+void cwImageProvider::releaseConnection(Connection *connection) const
+{
+    if(isPoolingThread()) {
+        return;
+    }
+
+    connection->close();
+
+    QMutexLocker locker(&ConnectionStateMutex);
+    int& count = OpenWorkerConnections[connection->ProjectPath];
+    count--;
+    if(count <= 0) {
+        OpenWorkerConnections.remove(connection->ProjectPath);
+        ConnectionsClosed.wakeAll();
+    }
+}
+
+/**
+  \brief True if the current thread keeps its connections open between requests
+
+  Only the GUI thread does, because that's the thread that removes project files.
+  */
+bool cwImageProvider::isPoolingThread()
+{
+    return QCoreApplication::instance() != nullptr &&
+            QThread::currentThread() == QCoreApplication::instance()->thread();
+}
+
+/**
+  \brief Releases the file handles to projectPath
+
+  This must be called, from the GUI thread, before the file at projectPath is removed or
+  replaced, because open connections keep the file in use. This closes the GUI thread's
+  connection, and waits for the requests that other threads are running on projectPath to
+  finish, those threads close their connections when they finish. The connections of every
+  thread are reopened, with the new file, on their next request.
+  */
+void cwImageProvider::closeConnections(const QString &projectPath)
+{
+    Q_ASSERT(isPoolingThread());
+
+    {
+        QMutexLocker locker(&ConnectionStateMutex);
+        Generations[projectPath]++;
+    }
+
+    closeLocalConnection(projectPath);
+
+    QMutexLocker locker(&ConnectionStateMutex);
+    while(OpenWorkerConnections.value(projectPath, 0) > 0) {
+        ConnectionsClosed.wait(&ConnectionStateMutex);
+    }
+}
+
+/**
+  \brief Closes the current thread's connection to projectPath, if it has one
+  */
+void cwImageProvider::closeLocalConnection(const QString &projectPath)
+{
+    if(Connections.hasLocalData()) {
+        Connection* connection = Connections.localData()->Connections.value(projectPath, nullptr);
+        if(connection != nullptr) {
+            connection->close();
+        }
+    }
+}
+
 /**
   \brief Gets a QImage from the image provider.  If the image at id is null, then
   this will return a empty image
@@ -219,7 +596,7 @@ cwImageData cwImageProvider::data(int id, bool metaDataOnly) const {
 QImage cwImageProvider::image(int id) const
 {
     cwImageData imageData = data(id);
-    if(imageData.format() != cwImageProvider::Dxt1_GZ_Extension) {
+    if(!isDxt1Format(imageData.format())) {
         return QImage::fromData(imageData.data(), imageData.format());
     }
     return QImage();
@@ -241,3 +618,25 @@ QVector2D cwImageProvider::scaleTexCoords(const cwImage& image) const
     return QVector2D(originalSize.width() / (double)firstMipmapSize.width(),
                      originalSize.height() / (double)firstMipmapSize.height());
 }
+
+/**
+ * @brief cwImageProvider::isDxt1Format
+ * @param format - The image's type from the database
+ * @return True if the image is DXT1 compressed, with any of the cwBlobCodec codecs
+ */
+bool cwImageProvider::isDxt1Format(const QByteArray &format)
+{
+    return format == Dxt1_Extension ||
+            format == Dxt1_LZ_Extension ||
+            format == Dxt1_GZ_Extension;
+}
+
+/**
+ * @brief cwImageProvider::dxt1Format
+ * @param codec - How the DXT1 blob is compressed
+ * @return The type that's stored in the database for a DXT1 image compressed with codec
+ */
+QByteArray cwImageProvider::dxt1Format(cwBlobCodec::Codec codec)
+{
+    return Dxt1_Extension + cwBlobCodec::extension(codec);
+}
@@ -12,13 +12,17 @@
 #include <QObject>
 #include <QQuickImageProvider>
 #include <QMutex>
+#include <QWaitCondition>
 #include <QDebug>
 #include <QVector2D>
+#include <QThreadStorage>
+#include <QHash>
 
 //Our includes
 #include "cwImage.h"
 #include "cwImageData.h"
 #include "cwGlobals.h"
+#include "cwBlobCodec.h"
 
 class CAVEWHERE_LIB_EXPORT cwImageProvider : public QObject, public QQuickImageProvider
 {
@@ -26,6 +30,8 @@ class CAVEWHERE_LIB_EXPORT cwImageProvider : public QObject, public QQuickImageP
 
 public:
     static const QString Name;
+    static const QByteArray Dxt1_Extension;
+    static const QByteArray Dxt1_LZ_Extension;
     static const QByteArray Dxt1_GZ_Extension;
 
     cwImageProvider();
@@ -34,9 +40,15 @@ public:
 
     cwImageData originalMetadata(const cwImage& image) const;
     cwImageData data(int id, bool metaDataOnly = false) const;
+    QByteArray tile(int id, QPoint index) const;
     QImage image(int id) const;
     QVector2D scaleTexCoords(const cwImage &image) const;
 
+    static void closeConnections(const QString& projectPath);
+
+    static bool isDxt1Format(const QByteArray& format);
+    static QByteArray dxt1Format(cwBlobCodec::Codec codec);
+
 public slots:
     void setProjectPath(QString projectPath);
 
@@ -44,12 +56,34 @@ public slots:
 private:
     static const QString RequestImageSQL;
     static const QString RequestMetadataSQL;
+    static const QString RequestTileSQL;
+    static const QString RequestTilesSQL;
     QString ProjectPath;
     QMutex ProjectPathMutex;
 
+    class Connection;
+    class ConnectionPool;
+
     static QAtomicInt ConnectionCounter;
 
+    //Each thread keeps its connections, one for each project file. Only the thread that created
+    //a connection uses or closes it
+    static QThreadStorage<ConnectionPool*> Connections;
+
+    //The generation of each project file, closeConnections() increments it, and the number of
+    //connections that worker threads have open to it
+    static QMutex ConnectionStateMutex;
+    static QWaitCondition ConnectionsClosed;
+    static QHash<QString, int> Generations;
+    static QHash<QString, int> OpenWorkerConnections;
+
     QString projectPath() const;
+    Connection* connection(const QString& projectPath) const;
+    void releaseConnection(Connection* connection) const;
+    QByteArray levelFromTiles(Connection* connection, int id, QSize size) const;
+
+    static bool isPoolingThread();
+    static void closeLocalConnection(const QString& projectPath);
 };
 
 #endif // CWPROJECTIMAGEPROVIDER_H
@@ -18,11 +18,6 @@ cwLabel3dGroup::cwLabel3dGroup(cwLabel3dView *parent) :
 
 cwLabel3dGroup::~cwLabel3dGroup()
 {
-
-    foreach(QQuickItem* item, LabelItems) {
-        item->deleteLater();
-    }
-
     setParentView(nullptr);
 }
 
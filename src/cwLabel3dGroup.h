@@ -10,7 +10,11 @@
 
 //Qt includes
 #include <QObject>
-class QQuickItem;
+#include <QVector>
+#include <QVector3D>
+#include <QSizeF>
+#include <QRectF>
+#include <QPointF>
 
 //Our includes
 #include "cwLabel3dItem.h"
@@ -37,9 +41,29 @@ signals:
 public slots:
 
 private:
+    /**
+     * @brief The GlyphQuad class
+     *
+     * One glyph of a label, built by cwLabel3dView::updateGroup()
+     */
+    class GlyphQuad {
+    public:
+        QRectF Rect; //!< Relative to the top left of the label
+        QRect AtlasRect; //!< Where the glyph is in the view's glyph atlas, in pixels
+    };
+
     cwLabel3dView* ParentView;
     QList<cwLabel3dItem> Labels;
-    QList<QQuickItem*> LabelItems;
+
+    //Packed per label data, so the positions can be transformed without copying the labels
+    QVector<QVector3D> Positions;
+    QVector<QSizeF> Sizes;
+    QVector<int> FirstQuads; //!< Index into Quads for each label, the last is Quads.size()
+    QVector<GlyphQuad> Quads;
+
+    //The labels that were placed by the last cwLabel3dView::updateGroupPositions()
+    QVector<int> VisibleLabels;
+    QVector<QPointF> ScreenPositions; //!< The top left of each visible label
     
 };
 
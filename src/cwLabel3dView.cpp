@@ -7,23 +7,24 @@
 
 //Our includes
 #include "cwLabel3dView.h"
-#include "cwGlobalDirectory.h"
 #include "cwLabel3dItem.h"
 #include "cwCamera.h"
 #include "cwDebug.h"
 #include "cwLabel3dGroup.h"
+#include "cwSGLabelsNode.h"
 
 //Qt includes
-#include <QQmlContext>
-#include <QQmlEngine>
 #include <QtConcurrent>
+#include <QQuickWindow>
+#include <QSGTexture>
+#include <QFontMetricsF>
 
 cwLabel3dView::cwLabel3dView(QQuickItem *parent) :
     QQuickItem(parent),
-    Component(nullptr),
-    Camera(nullptr)
+    Camera(nullptr),
+    GlyphAtlasChanged(false)
 {
-
+    setFlag(QQuickItem::ItemHasContents, true);
 }
 
 /**
@@ -55,6 +56,7 @@ void cwLabel3dView::removeGroup(cwLabel3dGroup *group) {
     if(LabelGroups.contains(group)) {
         LabelGroups.remove(group);
         group->setParentView(nullptr);
+        update();
     }
 }
 
@@ -62,52 +64,52 @@ void cwLabel3dView::removeGroup(cwLabel3dGroup *group) {
   * @brief updateGroup
   * @param group
   *
-  * Updates the group's QQuickItem's. This will remove old label, create new ones, as needed, and
-  * update the text and font properties.
+  * Lays out the group's labels. Each label's glyphs are added to the glyph atlas, as needed, and
+  * are placed along the label's baseline.
   */
 void cwLabel3dView::updateGroup(cwLabel3dGroup* group) {
-    if(Component == nullptr) {
-        //Create the component that will generate all the labels
-        QQmlEngine* engine = QQmlEngine::contextForObject(this)->engine();
-        Component = new QQmlComponent(engine, cwGlobalDirectory::baseDirectory() + "qml/Label3d.qml", this);
+    Q_ASSERT(LabelGroups.contains(group));
 
-        if(Component == nullptr) {
-            qDebug() << "Component is nullptr" << LOCATION;
-        }
+    group->Positions.clear();
+    group->Sizes.clear();
+    group->FirstQuads.clear();
+    group->Quads.clear();
 
-        if(!Component->errors().isEmpty()) {
-            qDebug() << Component->errorString();
-        }
-    }
+    group->Positions.reserve(group->Labels.size());
+    group->Sizes.reserve(group->Labels.size());
+    group->FirstQuads.reserve(group->Labels.size() + 1);
 
-    Q_ASSERT(LabelGroups.contains(group));
-
-    //Remove extra
-    int numberExtra = group->LabelItems.size() - group->Labels.size();
-    for(int i = 0; i < numberExtra; i++) {
-        group->LabelItems.last()->deleteLater();
-        group->LabelItems.removeLast();
-    }
+    foreach(const cwLabel3dItem& label, group->Labels) {
+        QString text = label.text();
+        QFont font = label.font();
+        QFontMetricsF metrics(font);
 
-    //Add extra
-    numberExtra = group->Labels.size() - group->LabelItems.size();
-    for(int i = 0; i < numberExtra; i++) {
-        QQuickItem* newItem = qobject_cast<QQuickItem*>(Component->create());
-        newItem->setParent(group);
-        newItem->setParentItem(this);
-        group->LabelItems.append(newItem);
-    }
+        if(GlyphAtlas.addText(text, font)) {
+            GlyphAtlasChanged = true;
+        }
 
-    //Update all the info for the label
-    Q_ASSERT(group->Labels.size() == group->LabelItems.size());
-    for(int i = 0; i < group->Labels.size(); i++) {
-        const cwLabel3dItem& label = group->Labels.at(i);
-        QQuickItem* item = group->LabelItems.at(i);
+        group->Positions.append(label.position());
+        group->FirstQuads.append(group->Quads.size());
+
+        //Whole pixels, so the glyphs aren't resampled
+        qreal baseline = qRound(metrics.ascent());
+        qreal penPosition = 0.0;
+        foreach(QChar character, text) {
+            cwGlyphAtlas::Glyph glyph = GlyphAtlas.glyph(character, font);
+            if(!glyph.Rect.isEmpty()) {
+                cwLabel3dGroup::GlyphQuad quad;
+                quad.Rect = QRectF(QPointF(qRound(penPosition), baseline) + glyph.Offset, glyph.Rect.size());
+                quad.AtlasRect = glyph.Rect;
+                group->Quads.append(quad);
+            }
+            penPosition += glyph.Advance;
+        }
 
-        item->setProperty("text", label.text());
-        item->setProperty("font", label.font());
+        group->Sizes.append(QSizeF(penPosition, metrics.height()));
     }
 
+    group->FirstQuads.append(group->Quads.size());
+
     //Update all the positions
     updateGroupPositions(group);
 }
@@ -126,56 +128,57 @@ void cwLabel3dView::setCamera(cwCamera* camera) {
 }
 
 /**
- * @brief cwLabel3dView::updatePositions
+ * @brief cwLabel3dView::updateGroupPositions
  *
- * Updates all the positions for the view.
+ * Projects the group's labels onto the screen and finds the labels that don't overlap labels
+ * that have already been placed.
  *
  * If camera is null, this does nothing
  */
 void cwLabel3dView::updateGroupPositions(cwLabel3dGroup* group)
 {
+    if(Camera == nullptr) { return; }
 
-    Q_ASSERT(group->Labels.size() == group->LabelItems.size());
+    Q_ASSERT(group->Positions.size() == group->Sizes.size());
 
-    //Copy all the labels
-    QList<cwLabel3dItem> labels = group->Labels;
+    //Copy all the positions
+    QVector<QVector3D> positions = group->Positions;
 
     //Transforms all the label's points
-    QtConcurrent::blockingMap(labels,
+    QtConcurrent::blockingMap(positions,
                               TransformPoint(Camera->viewProjectionMatrix(),
                                              Camera->viewport()));
 
-    //Go through all the station points and render the text
-    for(int i = 0; i < labels.size(); i++) {
-        const cwLabel3dItem& label = labels.at(i);
-        QQuickItem* item = group->LabelItems.at(i);
-
-        QVector3D projectedStationPosition = label.position();
-
+    group->VisibleLabels.clear();
+    group->ScreenPositions.clear();
 
+    //Go through all the station points and place the text
+    for(int i = 0; i < positions.size(); i++) {
+        const QVector3D& projectedStationPosition = positions.at(i);
 
         //Clip the stations to the rendering area
         if(projectedStationPosition.z() > 1.0 ||
                 projectedStationPosition.z() < 0.0 ||
                 !Camera->viewport().contains(projectedStationPosition.x(), projectedStationPosition.y())) {
-            item->setVisible(false);
             continue;
         }
 
         //See if stationName overlaps with other stations
+        const QSizeF& size = group->Sizes.at(i);
         QPoint topLeftPoint = projectedStationPosition.toPoint();
-        QSize stationNameTextSize(item->width() * 1.1, item->height() * 1.1);
+        QSize stationNameTextSize(size.width() * 1.1, size.height() * 1.1);
         QRect stationRect(topLeftPoint, stationNameTextSize);
         stationRect.moveTop(stationRect.top() - stationNameTextSize.height() / 1.1);
         bool couldAddText = LabelKdTree.addRect(stationRect);
 
         if(couldAddText) {
-            item->setVisible(true);
-            item->setPosition(projectedStationPosition.toPointF());
-        } else {
-            item->setVisible(false);
+            group->VisibleLabels.append(i);
+            group->ScreenPositions.append(QPointF(qRound(projectedStationPosition.x()),
+                                                  qRound(projectedStationPosition.y())));
         }
     }
+
+    update();
 }
 
 /**
@@ -202,10 +205,78 @@ void cwLabel3dView::updatePositions()
   This is the kernel for multi threaded algroithm to transform the points into
   screen coordinates.  This is a helper function to renderStationLabels
   */
-void cwLabel3dView::TransformPoint::operator()(cwLabel3dItem& label) {
-    QVector3D normalizeSceenCoordinate =  ModelViewProjection * label.position();
+void cwLabel3dView::TransformPoint::operator()(QVector3D& position) {
+    QVector3D normalizeSceenCoordinate =  ModelViewProjection * position;
     QVector3D viewportCoord = cwCamera::mapNormalizeScreenToGLViewport(normalizeSceenCoordinate, Viewport);
     float y = Viewport.y() + (Viewport.height() - viewportCoord.y());
     viewportCoord.setY(y);
-    label.setPosition(viewportCoord);
+    position = viewportCoord;
+}
+
+/**
+ * @brief cwLabel3dView::updatePaintNode
+ *
+ * Draws the glyphs of every visible label, in all the groups, with one node. The glyph atlas is
+ * only uploaded when glyphs have been added to it.
+ */
+QSGNode* cwLabel3dView::updatePaintNode(QSGNode* oldNode, QQuickItem::UpdatePaintNodeData* data)
+{
+    Q_UNUSED(data);
+
+    cwSGLabelsNode* node = static_cast<cwSGLabelsNode*>(oldNode);
+    if(node == nullptr) {
+        node = new cwSGLabelsNode();
+        GlyphAtlasChanged = true;
+    }
+
+    QImage atlas = GlyphAtlas.image();
+    if(GlyphAtlasChanged) {
+        node->setTexture(window()->createTextureFromImage(atlas));
+        GlyphAtlasChanged = false;
+    }
+
+    int numberOfQuads = 0;
+    foreach(cwLabel3dGroup* group, LabelGroups) {
+        foreach(int labelIndex, group->VisibleLabels) {
+            numberOfQuads += group->FirstQuads.at(labelIndex + 1) - group->FirstQuads.at(labelIndex);
+        }
+    }
+
+    QSGGeometry::TexturedPoint2D* vertices = node->allocateQuads(numberOfQuads);
+
+    float atlasWidth = atlas.width();
+    float atlasHeight = atlas.height();
+
+    foreach(cwLabel3dGroup* group, LabelGroups) {
+        for(int i = 0; i < group->VisibleLabels.size(); i++) {
+            int labelIndex = group->VisibleLabels.at(i);
+            QPointF topLeft = group->ScreenPositions.at(i);
+
+            for(int q = group->FirstQuads.at(labelIndex); q < group->FirstQuads.at(labelIndex + 1); q++) {
+                const cwLabel3dGroup::GlyphQuad& quad = group->Quads.at(q);
+                QRectF rect = quad.Rect.translated(topLeft);
+                const QRect& atlasRect = quad.AtlasRect;
+
+                float left = rect.left();
+                float top = rect.top();
+                float right = rect.right();
+                float bottom = rect.bottom();
+
+                float texLeft = atlasRect.x() / atlasWidth;
+                float texTop = atlasRect.y() / atlasHeight;
+                float texRight = (atlasRect.x() + atlasRect.width()) / atlasWidth;
+                float texBottom = (atlasRect.y() + atlasRect.height()) / atlasHeight;
+
+                vertices[0].set(left, top, texLeft, texTop);
+                vertices[1].set(right, top, texRight, texTop);
+                vertices[2].set(left, bottom, texLeft, texBottom);
+                vertices[3].set(right, top, texRight, texTop);
+                vertices[4].set(right, bottom, texRight, texBottom);
+                vertices[5].set(left, bottom, texLeft, texBottom);
+                vertices += 6;
+            }
+        }
+    }
+
+    return node;
 }
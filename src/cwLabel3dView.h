@@ -10,12 +10,12 @@
 
 //Qt includes
 #include <QQuickItem>
-#include <QQmlComponent>
 #include <QMatrix4x4>
 
 //Our includes
 #include "cwLabel3dItem.h"
 #include "cwCollisionRectKdTree.h"
+#include "cwGlyphAtlas.h"
 class cwCamera;
 class cwLabel3dGroup;
 
@@ -40,6 +40,9 @@ public:
 signals:
     void cameraChanged();
 
+protected:
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data);
+
 
 public slots:
     
@@ -61,7 +64,7 @@ private:
         /**
           \brief Transforms the point
           */
-        void operator()(cwLabel3dItem& label);
+        void operator()(QVector3D& position);
 
     private:
         QMatrix4x4 ModelViewProjection;
@@ -71,9 +74,10 @@ private:
     QSet<cwLabel3dGroup*> LabelGroups;
 
     //For rendering labels
-    QQmlComponent* Component;
     cwCamera* Camera; //!<
     cwCollisionRectKdTree LabelKdTree;
+    cwGlyphAtlas GlyphAtlas;
+    bool GlyphAtlasChanged; //!< True if GlyphAtlas needs to be uploaded in updatePaintNode()
 
     void updateGroup(cwLabel3dGroup* group);
     void updateGroupPositions(cwLabel3dGroup* group);
@@ -128,17 +128,17 @@ QList<cwLabel3dItem> cwLinePlotLabelView::labels(cwCave *cave) const
 {
     cwStationPositionLookup stations = cave->stationPositionLookup();
 
+    cwStationNameTable* nameTable = cwStationNameTable::instance();
+
     QList< cwLabel3dItem > uniqueStations;
-    uniqueStations.reserve(stations.positions().count());
+    uniqueStations.reserve(stations.count());
 
     QFont font;
     font.setPointSize(14);
 
     //Populate the vector of unique stations, this is so we can thread the transformation
-    QMapIterator<QString, QVector3D> mapIter(stations.positions());
-    while(mapIter.hasNext()) {
-        mapIter.next();
-        uniqueStations.append(cwLabel3dItem(mapIter.key(), mapIter.value(), font));
+    foreach(int stationId, stations.stationIds()) {
+        uniqueStations.append(cwLabel3dItem(nameTable->name(stationId), stations.position(stationId), font));
     }
 
     return uniqueStations;
@@ -23,29 +23,42 @@
 #include "cwErrorModel.h"
 #include "cwErrorListModel.h"
 
+//Qt includes
+#include <QTimer>
+
 
 cwLinePlotManager::cwLinePlotManager(QObject *parent) :
     QObject(parent)
 {
     Region = nullptr;
     GLLinePlot = nullptr;
+    RunAfterBulkEdit = false;
+    RequestedGeneration = 0;
+    RunningGeneration = 0;
+    CompletedGeneration = 0;
+    StructureChanged = false;
+
+    RunTimer = new QTimer(this);
+    RunTimer->setSingleShot(true);
+    connect(RunTimer, SIGNAL(timeout()), SLOT(runSurvex()));
+    LoopCloserBackend = cwLinePlotTask::NativeLoopCloser;
 
     SurveySignaler = new cwSurveyChunkSignaler(this);
 
-    SurveySignaler->addConnectionToCaves(SIGNAL(insertedTrips(int,int)), this, SLOT(runSurvex()));
-    SurveySignaler->addConnectionToCaves(SIGNAL(removedTrips(int,int)), this, SLOT(runSurvex()));
-    SurveySignaler->addConnectionToCaves(SIGNAL(nameChanged()), this, SLOT(runSurvex()));
+    SurveySignaler->addConnectionToCaves(SIGNAL(insertedTrips(int,int)), this, SLOT(surveyStructureChanged()));
+    SurveySignaler->addConnectionToCaves(SIGNAL(removedTrips(int,int)), this, SLOT(surveyStructureChanged()));
+    SurveySignaler->addConnectionToCaves(SIGNAL(nameChanged()), this, SLOT(surveyStructureChanged()));
 
-    SurveySignaler->addConnectionToTrips(SIGNAL(chunksInserted(int,int)), this, SLOT(runSurvex()));
-    SurveySignaler->addConnectionToTrips(SIGNAL(chunksRemoved(int,int)), this, SLOT(runSurvex()));
-    SurveySignaler->addConnectionToTrips(SIGNAL(nameChanged()), this, SLOT(runSurvex()));
-    SurveySignaler->addConnectionToTripCalibrations(SIGNAL(calibrationsChanged()), this, SLOT(runSurvex()));
+    SurveySignaler->addConnectionToTrips(SIGNAL(chunksInserted(int,int)), this, SLOT(surveyStructureChanged()));
+    SurveySignaler->addConnectionToTrips(SIGNAL(chunksRemoved(int,int)), this, SLOT(surveyStructureChanged()));
+    SurveySignaler->addConnectionToTrips(SIGNAL(nameChanged()), this, SLOT(surveyStructureChanged()));
+    SurveySignaler->addConnectionToTripCalibrations(SIGNAL(calibrationsChanged()), this, SLOT(surveyStructureChanged()));
 
-    SurveySignaler->addConnectionToChunks(SIGNAL(shotsAdded(int,int)), this, SLOT(runSurvex()));
-    SurveySignaler->addConnectionToChunks(SIGNAL(shotsRemoved(int,int)), this, SLOT(runSurvex()));
-    SurveySignaler->addConnectionToChunks(SIGNAL(stationsAdded(int,int)), this, SLOT(runSurvex()));
-    SurveySignaler->addConnectionToChunks(SIGNAL(stationsRemoved(int,int)), this, SLOT(runSurvex()));
-    SurveySignaler->addConnectionToChunks(SIGNAL(dataChanged(cwSurveyChunk::DataRole,int)), this, SLOT(runSurvex()));
+    SurveySignaler->addConnectionToChunks(SIGNAL(shotsAdded(int,int)), this, SLOT(surveyStructureChanged()));
+    SurveySignaler->addConnectionToChunks(SIGNAL(shotsRemoved(int,int)), this, SLOT(surveyStructureChanged()));
+    SurveySignaler->addConnectionToChunks(SIGNAL(stationsAdded(int,int)), this, SLOT(surveyStructureChanged()));
+    SurveySignaler->addConnectionToChunks(SIGNAL(stationsRemoved(int,int)), this, SLOT(surveyStructureChanged()));
+    SurveySignaler->addConnectionToChunks(SIGNAL(dataChanged(cwSurveyChunk::DataRole,int)), this, SLOT(surveyDataChanged()));
 
     LinePlotThread = new QThread(this);
     LinePlotThread->start();
@@ -73,14 +86,17 @@ void cwLinePlotManager::setRegion(cwCavingRegion* region) {
     if(Region == nullptr) { return; }
 
     //Connect all signal from the region
-    connect(Region, SIGNAL(insertedCaves(int,int)), SLOT(runSurvex()));
-    connect(Region, SIGNAL(removedCaves(int,int)), SLOT(runSurvex()));
+    connect(Region, SIGNAL(insertedCaves(int,int)), SLOT(surveyStructureChanged()));
+    connect(Region, SIGNAL(removedCaves(int,int)), SLOT(surveyStructureChanged()));
+    connect(Region, SIGNAL(bulkEditFinished()), SLOT(runSurvexAfterBulkEdit()));
 
     SurveySignaler->setRegion(Region);
 
     //Connect all sub data
     connectCaves(Region);
 
+    //Run now, without waiting for more changes
+    addGeneration(true);
     runSurvex();
 }
 
@@ -89,6 +105,21 @@ void cwLinePlotManager::setGLLinePlot(cwGLLinePlot* linePlot) {
     updateLinePlot();
 }
 
+/**
+ * @brief cwLinePlotManager::setLoopCloserBackend
+ * @param backend - The backend that generates station positions
+ *
+ * The native backend is the default. The cavern backend is kept so results can be cross
+ * checked with survex. Changing the backend reruns the line plot.
+ */
+void cwLinePlotManager::setLoopCloserBackend(cwLinePlotTask::LoopCloserBackend backend)
+{
+    if(LoopCloserBackend != backend) {
+        LoopCloserBackend = backend;
+        scheduleRun(true);
+    }
+}
+
 /**
  * @brief cwLinePlotManager::waitToFinish
  *
@@ -97,7 +128,20 @@ void cwLinePlotManager::setGLLinePlot(cwGLLinePlot* linePlot) {
  */
 void cwLinePlotManager::waitToFinish()
 {
-    LinePlotTask->waitToFinish();
+    forever {
+        //Don't wait for the debounce
+        if(RunTimer->isActive()) {
+            RunTimer->stop();
+            runSurvex();
+        }
+
+        LinePlotTask->waitToFinish();
+
+        //updateLinePlot() may have started a run, for changes made while the task was running
+        if(LinePlotTask->isReady() && !RunTimer->isActive()) {
+            break;
+        }
+    }
 }
 
 /**
@@ -115,7 +159,7 @@ void cwLinePlotManager::connectCaves(cwCavingRegion* region) {
     }
 
     if(caveIsStale) {
-        runSurvex();
+        scheduleRun(true);
     }
 }
 
@@ -211,24 +255,122 @@ void cwLinePlotManager::clearUnconnectedChunkErrors()
 }
 
 
+/**
+ * @brief cwLinePlotManager::surveyDataChanged
+ *
+ * Called when a reading or station name has changed. A run that's in flight is allowed to
+ * finish, because its results are still mostly right, and another run is started after it.
+ */
+void cwLinePlotManager::surveyDataChanged()
+{
+    scheduleRun(false);
+}
+
+/**
+ * @brief cwLinePlotManager::surveyStructureChanged
+ *
+ * Called when caves, trips, chunks, shots or calibrations have been added, removed, or renamed.
+ * The results of a run in flight are missing too much, so it's restarted when the scheduled run
+ * starts.
+ */
+void cwLinePlotManager::surveyStructureChanged()
+{
+    scheduleRun(true);
+}
+
+/**
+ * @brief cwLinePlotManager::addGeneration
+ * @param structureChanged - True if the change should restart a run that's in flight
+ *
+ * Each change to the region is a new generation. The results are stale until the generation of
+ * the last completed run catches up.
+ */
+void cwLinePlotManager::addGeneration(bool structureChanged)
+{
+    bool wasStale = isStale();
+    RequestedGeneration++;
+    StructureChanged |= structureChanged;
+
+    if(wasStale != isStale()) {
+        emit staleChanged();
+    }
+}
+
+/**
+ * @brief cwLinePlotManager::scheduleRun
+ * @param structureChanged - True if the change should restart a run that's in flight
+ *
+ * Debounces runs of the line plot task. Each change pushes the run back by DebounceInterval, so a
+ * burst of edits, like typing, only runs the task once. The run is never pushed back more than
+ * MaxRunDelay after the first change, so the line plot still updates during a long burst.
+ */
+void cwLinePlotManager::scheduleRun(bool structureChanged)
+{
+    if(Region == nullptr) { return; }
+
+    addGeneration(structureChanged);
+
+    if(Region->isBulkEditing()) {
+        //Run once, when the bulk edit is finished
+        RunAfterBulkEdit = true;
+        return;
+    }
+
+    if(!RunTimer->isActive()) {
+        FirstScheduledTime.start();
+        RunTimer->start(DebounceInterval);
+    } else if(FirstScheduledTime.elapsed() + DebounceInterval < MaxRunDelay) {
+        RunTimer->start(DebounceInterval);
+    }
+}
+
 /**
   \brief Run the line plot task
+
+  If the task is already running, it's only restarted if the structure of the region has
+  changed. Otherwise, updateLinePlot() runs the task again when it finishes.
   */
 void cwLinePlotManager::runSurvex() {
-    if(Region != nullptr) {
-        if(LinePlotTask->isReady()) {
-//            qDebug() << "Running the task";
-            setCaveStationLookupAsStale(true);
-            LinePlotTask->setData(*Region);
-            LinePlotTask->start();
-        } else {
-            //Restart the survex
-//            qDebug() << "Restart plot task";
-            LinePlotTask->restart();
-        }
+    if(Region == nullptr) { return; }
+
+    if(LinePlotTask->isReady()) {
+        RunTimer->stop();
+        StructureChanged = false;
+        RunningGeneration = RequestedGeneration;
+
+        setCaveStationLookupAsStale(true);
+        LinePlotTask->setLoopCloserBackend(LoopCloserBackend);
+        LinePlotTask->setData(*Region);
+        LinePlotTask->start();
+    } else if(StructureChanged) {
+        //Calls runSurvex() with shouldRerun(), once the task has stopped
+        LinePlotTask->restart();
+    }
+}
+
+/**
+ * @brief cwLinePlotManager::runSurvexAfterBulkEdit
+ *
+ * Runs the line plot task, if the region was changed during its bulk edit
+ */
+void cwLinePlotManager::runSurvexAfterBulkEdit()
+{
+    if(RunAfterBulkEdit) {
+        RunAfterBulkEdit = false;
+        runSurvex();
     }
 }
 
+/**
+ * @brief cwLinePlotManager::isStale
+ * @return True if the region has changed since the last completed run. The current results are
+ * still consistent, they're from completedGeneration().
+ */
+bool cwLinePlotManager::isStale() const
+{
+    return CompletedGeneration != RequestedGeneration;
+}
+
 /**
   \brief Updates the line plot, and all the station positions for the
   line region
@@ -282,5 +424,17 @@ void cwLinePlotManager::updateLinePlot() {
     emit stationPositionInCavesChanged(resultData.caveData().keys());
     emit stationPositionInTripsChanged(resultData.trips().toList());
     emit stationPositionInScrapsChanged(resultData.scraps().toList());
+
+    bool wasStale = isStale();
+    CompletedGeneration = RunningGeneration;
+    emit completedGenerationChanged();
+    if(wasStale != isStale()) {
+        emit staleChanged();
+    }
+
+    //Changes were made while the task was running
+    if(isStale() && !RunTimer->isActive() && !RunAfterBulkEdit) {
+        runSurvex();
+    }
 }
 
@@ -26,10 +26,26 @@ class cwErrorListModel;
 #include <QObject>
 #include <QThread>
 #include <QPointer>
-
+#include <QElapsedTimer>
+class QTimer;
+
+/**
+ * @brief The cwLinePlotManager class
+ *
+ * Runs cwLinePlotTask when the survey data in the region changes, and copies the station
+ * positions back into the caves.
+ *
+ * Changes are debounced, so a burst of edits only runs the task once. Each change increments the
+ * requested generation, and the results are from completedGeneration(). While the two differ,
+ * isStale() is true and the results are from older, but consistent, survey data.
+ */
 class CAVEWHERE_LIB_EXPORT cwLinePlotManager : public QObject
 {
     Q_OBJECT
+
+    Q_PROPERTY(int completedGeneration READ completedGeneration NOTIFY completedGenerationChanged)
+    Q_PROPERTY(bool stale READ isStale NOTIFY staleChanged)
+
 public:
     explicit cwLinePlotManager(QObject *parent = 0);
     ~cwLinePlotManager();
@@ -37,9 +53,18 @@ public:
     void setRegion(cwCavingRegion* region);
     Q_INVOKABLE void setGLLinePlot(cwGLLinePlot* linePlot);
 
+    void setLoopCloserBackend(cwLinePlotTask::LoopCloserBackend backend);
+    cwLinePlotTask::LoopCloserBackend loopCloserBackend() const;
+
     void waitToFinish();
 
+    int requestedGeneration() const;
+    int completedGeneration() const;
+    bool isStale() const;
+
 signals:
+    void completedGenerationChanged();
+    void staleChanged();
     void stationPositionInCavesChanged(QList<cwCave*>);
     void stationPositionInTripsChanged(QList<cwTrip*>);
     void stationPositionInScrapsChanged(QList<cwScrap*>);
@@ -52,10 +77,22 @@ private:
 
     cwLinePlotTask* LinePlotTask;
     QThread* LinePlotThread;
+    cwLinePlotTask::LoopCloserBackend LoopCloserBackend;
 
     cwGLLinePlot* GLLinePlot;
 
     cwSurveyChunkSignaler* SurveySignaler;
+    bool RunAfterBulkEdit; //!< True if the region changed while it was bulk edited
+
+    //Scheduling
+    static const int DebounceInterval = 150; //!< Milliseconds to wait for more changes
+    static const int MaxRunDelay = 1000; //!< Milliseconds after the first change, that a run is never delayed past
+    QTimer* RunTimer; //!< Fires when the debounced run should start
+    QElapsedTimer FirstScheduledTime; //!< Started by the first change that RunTimer is waiting on
+    int RequestedGeneration; //!< Incremented by each change to the region
+    int RunningGeneration; //!< The generation of the data the task is running on
+    int CompletedGeneration; //!< The generation of the current results
+    bool StructureChanged; //!< True if a change, since the task started, should restart it
 
     void connectCaves(cwCavingRegion* region);
 
@@ -65,10 +102,43 @@ private:
     void updateUnconnectedChunkErrors(cwCave *cave, const cwLinePlotTask::LinePlotCaveData& caveData);
     void clearUnconnectedChunkErrors();
 
+    void addGeneration(bool structureChanged);
+    void scheduleRun(bool structureChanged);
+
 private slots:
+    void surveyDataChanged();
+    void surveyStructureChanged();
     void runSurvex();
+    void runSurvexAfterBulkEdit();
 
     void updateLinePlot();
 };
 
+/**
+ * @brief cwLinePlotManager::loopCloserBackend
+ * @return The backend that's used to generate station positions
+ */
+inline cwLinePlotTask::LoopCloserBackend cwLinePlotManager::loopCloserBackend() const
+{
+    return LoopCloserBackend;
+}
+
+/**
+ * @brief cwLinePlotManager::requestedGeneration
+ * @return The generation of the region's current survey data
+ */
+inline int cwLinePlotManager::requestedGeneration() const
+{
+    return RequestedGeneration;
+}
+
+/**
+ * @brief cwLinePlotManager::completedGeneration
+ * @return The generation of the survey data that the current results were computed from
+ */
+inline int cwLinePlotManager::completedGeneration() const
+{
+    return CompletedGeneration;
+}
+
 #endif // CWLINEPLOTMANAGER_H
@@ -12,6 +12,7 @@
 #include "cwCavingRegion.h"
 #include "cwPlotSauceTask.h"
 #include "cwPlotSauceXMLTask.h"
+#include "cwLoopCloserTask.h"
 #include "cwLinePlotGeometryTask.h"
 #include "cwCave.h"
 #include "cwTrip.h"
@@ -23,11 +24,11 @@
 #include "cwLength.h"
 #include "cwStationValidator.h"
 #include "cwErrorModel.h"
+#include "cwStationOccurrenceIndex.h"
 
 //Qt includes
 #include <QDebug>
 #include <QTime>
-#include <QThread>
 
 //Std includes
 #include <math.h>
@@ -45,9 +46,16 @@ cwLinePlotTask::LinePlotCaveData::LinePlotCaveData() :
 }
 
 cwLinePlotTask::cwLinePlotTask(QObject *parent) :
-    cwTask(parent)
+    cwTask(parent),
+    Region(nullptr),
+    Backend(NativeLoopCloser)
 {
-    Region = new cwCavingRegion();
+
+    LoopCloserTask = new cwLoopCloserTask();
+    LoopCloserTask->setParentTask(this);
+
+    connect(LoopCloserTask, SIGNAL(finished()), SLOT(generateCenterlineGeometry()));
+    connect(LoopCloserTask, SIGNAL(stopped()), SLOT(done()));
 
     SurvexFile = new QTemporaryFile(this);
     SurvexFile->open();
@@ -105,26 +113,40 @@ void cwLinePlotTask::setData(const cwCavingRegion& region) {
         return;
     }
 
-    //Move region to the current thread
-    QMetaObject::invokeMethod(this,
-                              "moveCaveRegionToThread",
-                              Qt::BlockingQueuedConnection,
-                              Q_ARG(QThread*, QThread::currentThread()));
-
-    //Copy over all region data
-    *Region = region;  
-
-    //Move region back to task thread
-    moveCaveRegionToThread(thread());
+    //Snapshot the region's data, this shares the data with region, so it's cheap and
+    //doesn't block on the task's thread. runTask() rebuilds the local Region from it.
+    RegionData = region.data();
 
     //Populate the original pointers
     RegionOriginalPointers = RegionDataPtrs(region);
 
 }
 
+/**
+ * @brief cwLinePlotTask::setLoopCloserBackend
+ * @param backend - The backend that'll generate the station positions on the next run
+ *
+ * By default this is NativeLoopCloser. CavernLoopCloser is useful for cross checking the
+ * native results with survex.
+ */
+void cwLinePlotTask::setLoopCloserBackend(cwLinePlotTask::LoopCloserBackend backend)
+{
+    if(!isReady()) {
+        qWarning() << "Can't set the loop closer backend for LinePlotTask, while it's running";
+        return;
+    }
+
+    Backend = backend;
+}
+
 /**
   \brief Called when plot task starts running
 
+  With the native backend:
+  1. Loop close the region with cwLoopCloserTask
+  2. Update the survey data
+
+  With the cavern backend:
   1. Export the region or part of the region of interest into survex file
   2. Run the survex program
   3. Read the 3d file data
@@ -142,6 +164,12 @@ void cwLinePlotTask::runTask() {
     //Clear the previous results
     Result.clear();
 
+    //Update the local copy of the region, on the task's thread
+    if(Region == nullptr) {
+        Region = new cwCavingRegion();
+    }
+    updateRegion();
+
     try {
 
         //Check for errors
@@ -154,7 +182,11 @@ void cwLinePlotTask::runTask() {
         initializeCaveStationLookups();
 
         Time.start();
-        exportData();
+        if(Backend == NativeLoopCloser) {
+            closeLoops();
+        } else {
+            exportData();
+        }
 
     } catch(QString) {
         done();
@@ -162,6 +194,19 @@ void cwLinePlotTask::runTask() {
     }
 }
 
+/**
+  \brief Runs the native loop closer on the region
+  */
+void cwLinePlotTask::closeLoops() {
+    if(!isRunning()) {
+        done();
+        return;
+    }
+
+    LoopCloserTask->setRegion(Region);
+    LoopCloserTask->start();
+}
+
 /**
   \brief Exports the data to
   */
@@ -227,12 +272,17 @@ void cwLinePlotTask::generateCenterlineGeometry() {
         return;
     }
 
-    //Go through all the stations in the plot sauce parse and assign them
-    //to caves
-    updateStationPositionForCaves(PlotSauceParseTask->stationPositions());
+    if(Backend == NativeLoopCloser) {
+        //The loop closer has already split the stations by cave
+        updateStationPositionForCaves(LoopCloserTask->results());
+    } else {
+        //Go through all the stations in the plot sauce parse and assign them
+        //to caves
+        updateStationPositionForCaves(splitLookupByCave(PlotSauceParseTask->stationPositions()));
 
-    //Clear all the stations from the parser
-    PlotSauceParseTask->clearStationPositions();
+        //Clear all the stations from the parser
+        PlotSauceParseTask->clearStationPositions();
+    }
 
 //    qDebug() << "Generating centerline geometry" << status();
     CenterlineGeometryTask->setRegion(Region);
@@ -260,16 +310,13 @@ void cwLinePlotTask::linePlotTaskComplete() {
 
 /**
  * @brief cwLinePlotTask::updateStationPositionForCaves
- * @param stationPostions
+ * @param caveStationLookups - The new station positions for each cave
  */
-void cwLinePlotTask::updateStationPositionForCaves(const cwStationPositionLookup& stationPostions) {
+void cwLinePlotTask::updateStationPositionForCaves(const QVector<cwStationPositionLookup>& caveStationLookups) {
 
     //Index all the stations for quick lookup
     indexStations();
 
-    //Splite up stationPostions for each indiviual cave
-    QVector<cwStationPositionLookup> caveStationLookups = splitLookupByCave(stationPostions);
-
     //Update all the lookups that are part of this class
     updateInteralCaveStationLookups(caveStationLookups);
 
@@ -277,6 +324,34 @@ void cwLinePlotTask::updateStationPositionForCaves(const cwStationPositionLookup
     updateExteralCaveStationLookups();
 }
 
+/**
+ * @brief cwLinePlotTask::updateStationPositionForCaves
+ * @param loopCloserResults - The new station positions for each cave, from the loop closer
+ *
+ * If the loop closer knows which stations have moved, the stations aren't compared with their
+ * previous positions.
+ */
+void cwLinePlotTask::updateStationPositionForCaves(const QVector<cwLoopCloserTask::Result> &loopCloserResults)
+{
+    //Index all the stations for quick lookup
+    indexStations();
+
+    for(int i = 0; i < loopCloserResults.size(); i++) {
+        const cwLoopCloserTask::Result& result = loopCloserResults.at(i);
+        if(result.ChangedStationsValid) {
+            foreach(QString stationName, result.ChangedStations) {
+                setStationAsChanged(i, stationName);
+            }
+            CaveStationLookups[i] = result.StationPositions;
+        } else {
+            updateInteralCaveStationLookup(i, result.StationPositions);
+        }
+    }
+
+    //Update all cave station position models
+    updateExteralCaveStationLookups();
+}
+
 /**
  * @brief cwLinePlotTask::updateDepthLength
  */
@@ -296,6 +371,100 @@ void cwLinePlotTask::updateDepthLength()
     }
 }
 
+/**
+ * @brief cwLinePlotTask::updateRegion
+ *
+ * Updates the local Region with RegionData. Only the caves that have changed since they were
+ * last built are rebuilt. The other caves keep their trips, chunks, and station indexes from
+ * the previous run, so the whole region isn't copied every time the task runs.
+ */
+void cwLinePlotTask::updateRegion()
+{
+    //Remove the caves that are no longer in the region
+    if(Region->caveCount() > RegionData.Caves.size()) {
+        Region->removeCaves(RegionData.Caves.size(), Region->caveCount() - 1);
+    }
+
+    for(int i = 0; i < RegionData.Caves.size(); i++) {
+        const cwCaveData& caveData = RegionData.Caves.at(i);
+
+        if(i >= Region->caveCount()) {
+            cwCave* cave = new cwCave();
+            cave->setData(caveData);
+            Region->addCave(cave);
+        } else if(!isCaveSharedWith(RegionCaves.at(i), caveData)) {
+            Region->cave(i)->setData(caveData);
+        } else {
+            //The survey data hasn't changed, but the station positions might have been updated
+            //by a previous run, or reset by the user
+            cwCave* cave = Region->cave(i);
+            if(!cave->stationPositionLookup().isSharedWith(caveData.StationPositions)) {
+                cave->setStationPositionLookup(caveData.StationPositions);
+            }
+            cave->setStationPositionLookupStale(caveData.StationPositionsStale);
+        }
+    }
+
+    RegionCaves = RegionData.Caves;
+}
+
+/**
+ * @brief cwLinePlotTask::isCaveSharedWith
+ * @return True if all the data in caveData that the line plot uses is an implicitly shared copy
+ * of other's
+ *
+ * The survey chunks, team, and scrap stations are compared by their shared data, so this doesn't
+ * look at any stations or shots. The cave's name and station positions aren't compared, the task
+ * replaces both.
+ */
+bool cwLinePlotTask::isCaveSharedWith(const cwCaveData &caveData, const cwCaveData &other) const
+{
+    if(caveData.Trips.size() != other.Trips.size()) {
+        return false;
+    }
+
+    for(int i = 0; i < caveData.Trips.size(); i++) {
+        const cwTripData& trip = caveData.Trips.at(i);
+        const cwTripData& otherTrip = other.Trips.at(i);
+
+        //The survex exporter uses the name, date, and team
+        if(trip.Name != otherTrip.Name ||
+                trip.Date != otherTrip.Date ||
+                !trip.Team.isSharedWith(otherTrip.Team) ||
+                trip.Calibration != otherTrip.Calibration ||
+                trip.Chunks.size() != otherTrip.Chunks.size() ||
+                trip.Notes.size() != otherTrip.Notes.size()) {
+            return false;
+        }
+
+        for(int c = 0; c < trip.Chunks.size(); c++) {
+            const cwSurveyChunkData& chunk = trip.Chunks.at(c);
+            const cwSurveyChunkData& otherChunk = otherTrip.Chunks.at(c);
+            if(!chunk.Stations.isSharedWith(otherChunk.Stations) ||
+                    !chunk.Shots.isSharedWith(otherChunk.Shots)) {
+                return false;
+            }
+        }
+
+        //The scraps' stations are indexed, see StationTripScrapLookup
+        for(int n = 0; n < trip.Notes.size(); n++) {
+            const QList<cwScrapData>& scraps = trip.Notes.at(n).Scraps;
+            const QList<cwScrapData>& otherScraps = otherTrip.Notes.at(n).Scraps;
+            if(scraps.size() != otherScraps.size()) {
+                return false;
+            }
+
+            for(int s = 0; s < scraps.size(); s++) {
+                if(!scraps.at(s).Stations.isSharedWith(otherScraps.at(s).Stations)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
 /**
  * @brief cwLinePlotTask::checkForErrors
  */
@@ -451,12 +620,10 @@ QVector<cwStationPositionLookup> cwLinePlotTask::splitLookupByCave(const cwStati
     QVector<cwStationPositionLookup> caveStations;
     caveStations.resize(CaveStationLookups.size());
 
-    QMapIterator<QString, QVector3D> iter(stationPostions.positions());
-    while( iter.hasNext() ) {
-        iter.next();
-
-        QString name = iter.key();
-        QVector3D position = iter.value();
+    cwStationNameTable* nameTable = cwStationNameTable::instance();
+    foreach(int stationId, stationPostions.stationIds()) {
+        QString name = nameTable->name(stationId);
+        QVector3D position = stationPostions.position(stationId);
 
         //Cut off positions to 3 digits
         position.setX(qRound(position.x() * positionFactor) / positionFactor);
@@ -511,37 +678,49 @@ QVector<cwStationPositionLookup> cwLinePlotTask::splitLookupByCave(const cwStati
  */
 void cwLinePlotTask::updateInteralCaveStationLookups(QVector<cwStationPositionLookup> caveStations)
 {
-    //Go through all the stations and compare the to there previous positions
-    //If they have been updated then, this will add them to the station changed
     for(int i = 0; i < caveStations.size(); i++) {
-        cwStationPositionLookup& newLookup = caveStations[i];
-        cwStationPositionLookup& oldLookup = CaveStationLookups[i];
+        updateInteralCaveStationLookup(i, caveStations.at(i));
+    }
+}
 
-        if(newLookup.positions().size() != oldLookup.positions().size()) {
-            //This adds the station lookup as changed if the new looup has delete or added stations
-            addEmptyStationLookup(i);
-        }
+/**
+ * @brief cwLinePlotTask::updateInteralCaveStationLookup
+ * @param caveIndex - The index of the cave
+ * @param newLookup - The new station positions of the cave
+ *
+ * Compares the cave's stations with their previous positions, and replaces the
+ * cave's lookup with newLookup
+ */
+void cwLinePlotTask::updateInteralCaveStationLookup(int caveIndex, const cwStationPositionLookup &newLookup)
+{
+    const cwStationPositionLookup& oldLookup = CaveStationLookups.at(caveIndex);
 
-        QMap<QString, QVector3D> newPositions = newLookup.positions();
-        QMap<QString, QVector3D> oldPositions = oldLookup.positions();
+    QMap<QString, QVector3D> newPositions = newLookup.positions();
+    QMap<QString, QVector3D> oldPositions = oldLookup.positions();
 
-        foreach(QString stationName, newPositions.keys()) {
-            if(oldPositions.contains(stationName)) {
-                //Compare new point with old point
-                QVector3D newPoint = newPositions.value(stationName);
-                QVector3D oldPoint = oldPositions.value(stationName);
-                if(newPoint != oldPoint) {
-                    setStationAsChanged(i, stationName);
-                }
-            } else {
-                //New point
-                setStationAsChanged(i, stationName);
+    if(newPositions.size() != oldPositions.size()) {
+        //This adds the station lookup as changed if the new looup has delete or added stations
+        addEmptyStationLookup(caveIndex);
+    }
+
+    //Go through all the stations and compare the to there previous positions
+    //If they have been updated then, this will add them to the station changed
+    foreach(QString stationName, newPositions.keys()) {
+        if(oldPositions.contains(stationName)) {
+            //Compare new point with old point
+            QVector3D newPoint = newPositions.value(stationName);
+            QVector3D oldPoint = oldPositions.value(stationName);
+            if(newPoint != oldPoint) {
+                setStationAsChanged(caveIndex, stationName);
             }
+        } else {
+            //New point
+            setStationAsChanged(caveIndex, stationName);
         }
-
-        //Update the new station lookup with the new station lookup
-        CaveStationLookups[i] = caveStations[i];
     }
+
+    //Update the new station lookup with the new station lookup
+    CaveStationLookups[caveIndex] = newLookup;
 }
 
 /**
@@ -582,11 +761,9 @@ void cwLinePlotTask::updateCaveNetworks()
 
         foreach(cwTrip* trip, cave->trips()) {
             foreach(cwSurveyChunk* chunk, trip->chunks()) {
-                QList<cwStation> stations = chunk->stations();
+                const cwStationColumns& stations = chunk->stationColumns();
                 for(int i = 0; i < stations.size() - 1; i++) {
-                    cwStation from = stations.at(i);
-                    cwStation to = stations.at(i + 1);
-                    network.addShot(from.name(), to.name());
+                    network.addShot(stations.name(i), stations.name(i + 1));
                 }
             }
         }
@@ -603,11 +780,6 @@ void cwLinePlotTask::updateCaveNetworks()
     }
 }
 
-void cwLinePlotTask::moveCaveRegionToThread(QThread *thread)
-{
-    Region->moveToThread(thread);
-}
-
 /**
  * @brief cwLinePlotTask::addEmptyStationLookup
  * @param caveIndex
@@ -689,33 +861,54 @@ void cwLinePlotTask::LinePlotResultData::clear()
  * @brief cwLinePlotTask::StationTripScrapLookup::StationTripScrapLookup
  * @param cave
  *
- * This will go through the cave and index the scrap, and trip information by stationName
+ * This will go through the cave and index where each trip and scrap is. The stations are
+ * looked up with the cave's cwStationOccurrenceIndex.
  */
-cwLinePlotTask::StationTripScrapLookup::StationTripScrapLookup(cwCave *cave)
+cwLinePlotTask::StationTripScrapLookup::StationTripScrapLookup(cwCave *cave) :
+    Cave(cave)
 {
     for(int tripIndex = 0; tripIndex < cave->tripCount(); tripIndex++) {
         cwTrip* trip = cave->trip(tripIndex);
-        foreach(cwSurveyChunk* surveyChunk, trip->chunks()) {
-            foreach(cwStation station, surveyChunk->stations()) {
-                //Add trip to the multi hash
-                MapStationToTrip.insertMulti(station.name(), tripIndex);
-            }
-        }
+        TripIndexes.insert(trip, tripIndex);
 
         int scrapIndex = 0;
         foreach(cwNote* note, trip->notes()->notes()) {
-            for(int i = 0; i < note->scraps().size(); i++) {
-                cwScrap* scrap = note->scrap(i);
-
-                foreach(cwNoteStation noteStation, scrap->stations()) {
-                    MapStationToScrap.insertMulti(noteStation.name(), QPair<int, int>(tripIndex, scrapIndex));
-                }
-
+            foreach(cwScrap* scrap, note->scraps()) {
+                ScrapIndexes.insert(scrap, QPair<int, int>(tripIndex, scrapIndex));
                 scrapIndex++;
             }
         }
     }
 }
 
+/**
+ * @brief cwLinePlotTask::StationTripScrapLookup::trips
+ * @param stationName
+ * @return All the trips that contain stationName
+ */
+QList<int> cwLinePlotTask::StationTripScrapLookup::trips(QString stationName) const
+{
+    QList<int> tripIndexes;
+    if(Cave != nullptr) {
+        foreach(cwTrip* trip, Cave->stationOccurrenceIndex()->trips(stationName)) {
+            tripIndexes.append(TripIndexes.value(trip));
+        }
+    }
+    return tripIndexes;
+}
 
-
+/**
+ * @brief cwLinePlotTask::StationTripScrapLookup::scraps
+ * @param stationName
+ * @return All the scraps that contain stationName
+ */
+QList<QPair<int, int> > cwLinePlotTask::StationTripScrapLookup::scraps(QString stationName) const
+{
+    QList<QPair<int, int> > scrapIndexes;
+    if(Cave != nullptr) {
+        foreach(cwScrap* scrap, Cave->stationOccurrenceIndex()->scraps(stationName)) {
+            scrapIndexes.append(ScrapIndexes.value(scrap));
+        }
+    }
+    return scrapIndexes;
+}
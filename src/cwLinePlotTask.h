@@ -15,6 +15,8 @@ class cwLinePlotGeometryTask;
 #include "cwStationPositionLookup.h"
 #include "cwSurveyNetwork.h"
 #include "cwFindUnconnectedSurveyChunksTask.h"
+#include "cwLoopCloserTask.h"
+#include "cwCavingRegionData.h"
 class cwSurvexExporterRegionTask;
 class cwCavernTask;
 class cwPlotSauceTask;
@@ -34,8 +36,19 @@ class cwCave;
 class cwLinePlotTask : public cwTask
 {
     Q_OBJECT
+
+    friend class LinePlotTaskTester; //For testcases
+
 public:
 
+    /**
+     * The loop closure backend that generates the station positions
+     */
+    enum LoopCloserBackend {
+        NativeLoopCloser, //In process least squares adjustment, see cwLoopCloserTask
+        CavernLoopCloser //Exports to survex, runs cavern and plotsauce
+    };
+
     class LinePlotCaveData {
     public:
         LinePlotCaveData();
@@ -108,6 +121,9 @@ public:
 
     LinePlotResultData linePlotData() const;
 
+    void setLoopCloserBackend(LoopCloserBackend backend);
+    LoopCloserBackend loopCloserBackend() const;
+
 signals:
 
 protected:
@@ -117,6 +133,7 @@ public slots:
     void setData(const cwCavingRegion &region);
 
 private slots:
+    void closeLoops();
     void exportData();
     void runCavern();
     void convertToXML();
@@ -125,7 +142,8 @@ private slots:
     void linePlotTaskComplete();
 
     //For setting up all the station positions
-    void updateStationPositionForCaves(const cwStationPositionLookup& stationPostions);
+    void updateStationPositionForCaves(const QVector<cwStationPositionLookup>& caveStationLookups);
+    void updateStationPositionForCaves(const QVector<cwLoopCloserTask::Result>& loopCloserResults);
 
     //Update the depth and length data
     void updateDepthLength();
@@ -177,18 +195,21 @@ private:
     class StationTripScrapLookup {
     public:
         StationTripScrapLookup(cwCave* cave);
-        StationTripScrapLookup() { }
+        StationTripScrapLookup() : Cave(nullptr) { }
 
         QList<int> trips(QString stationName) const;
         QList<QPair<int, int> > scraps(QString stationName) const;
 
     private:
-        QHash<QString, int> MapStationToTrip; //Multi map of a station to multiple trips indexes
-        QHash<QString, QPair<int, int> > MapStationToScrap; //Multi map of a station to multiple scraps indexes (first index is cave, then scrap index)
+        cwCave* Cave; //Stations are looked up in the cave's cwStationOccurrenceIndex
+        QHash<cwTrip*, int> TripIndexes; //Trip to trip index
+        QHash<cwScrap*, QPair<int, int> > ScrapIndexes; //Scrap to trip index, then scrap index in the trip
     };
 
     //The region data
-    cwCavingRegion* Region; //Local copy of the region, we can modify this
+    cwCavingRegionData RegionData; //Snapshot of the region from setData()
+    cwCavingRegion* Region; //Local copy of the region, we can modify this, created on the task's thread
+    QList<cwCaveData> RegionCaves; //The snapshot of each cave in Region, when it was last built
     RegionDataPtrs RegionOriginalPointers; //Allows use to notify the which of the original data has changed
     QVector<cwStationPositionLookup> CaveStationLookups; //Copies of all the cave station lookups that are going to be modified
     QVector<StationTripScrapLookup> TripLookups; //Generated in indexStations()
@@ -198,6 +219,7 @@ private:
     cwSurvexExporterRegionTask* SurvexExporter;
 
     //Sub tasks
+    cwLoopCloserTask* LoopCloserTask;
     cwCavernTask* CavernTask;
     cwPlotSauceTask* PlotSauceTask;
     cwPlotSauceXMLTask* PlotSauceParseTask;
@@ -207,9 +229,14 @@ private:
     //What's returned
     LinePlotResultData Result;
 
+    LoopCloserBackend Backend;
+
     //For performance testing
     QTime Time;
 
+    void updateRegion();
+    bool isCaveSharedWith(const cwCaveData& caveData, const cwCaveData& other) const;
+
     void checkForErrors();
     void encodeCaveNames();
     void initializeCaveStationLookups();
@@ -219,12 +246,11 @@ private:
 
     QVector<cwStationPositionLookup> splitLookupByCave(const cwStationPositionLookup& stationPostions);
     void updateInteralCaveStationLookups(QVector<cwStationPositionLookup> caveStations);
+    void updateInteralCaveStationLookup(int caveIndex, const cwStationPositionLookup& newLookup);
     void updateExteralCaveStationLookups();
 
     void updateCaveNetworks();
 
-    Q_INVOKABLE void moveCaveRegionToThread(QThread* thread);
-
     void addEmptyStationLookup(int caveIndex);
 
 };
@@ -337,26 +363,14 @@ inline cwLinePlotTask::LinePlotResultData cwLinePlotTask::linePlotData() const
 }
 
 /**
- * @brief cwLinePlotTask::StationTripScrapLookup::trips
- * @param stationName
- * @return All the trips that contain stationName
- */
-inline QList<int> cwLinePlotTask::StationTripScrapLookup::trips(QString stationName) const
-{
-    return MapStationToTrip.values(stationName);
-}
-
-/**
- * @brief cwLinePlotTask::StationTripScrapLookup::scraps
- * @param stationName
- * @return All the scraps that contain stationName
+ * @brief cwLinePlotTask::loopCloserBackend
+ * @return The backend that's used to generate the station positions
  */
-inline QList<QPair<int, int> > cwLinePlotTask::StationTripScrapLookup::scraps(QString stationName) const
+inline cwLinePlotTask::LoopCloserBackend cwLinePlotTask::loopCloserBackend() const
 {
-    return MapStationToScrap.values(stationName);
+    return Backend;
 }
 
-
 inline void cwLinePlotTask::LinePlotCaveData::setDepth(double depth)
 {
     Depth = depth;
@@ -0,0 +1,1099 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwLoopCloser.h"
+
+//Qt includes
+#include <QtGlobal>
+#include <QSet>
+
+//Std includes
+#include <math.h>
+
+const double cwLoopCloser::MinimumVariance = 1.0e-6;
+const double cwLoopCloser::PositionPrecision = 0.01;
+const int cwLoopCloser::DenseSolverLimit = 1000;
+
+/**
+ * Finds the root of the union find set
+ */
+static int findRoot(QVector<int>& parents, int index) {
+    while(parents[index] != index) {
+        parents[index] = parents[parents[index]]; //Path halving
+        index = parents[index];
+    }
+    return index;
+}
+
+/**
+ * Converts a sparse, row mapped, matrix into a dense row major matrix
+ */
+static QVector<double> toDenseMatrix(const QVector<QHash<int, double> >& matrix) {
+    int size = matrix.size();
+    QVector<double> denseMatrix(size * size, 0.0);
+    for(int row = 0; row < size; row++) {
+        QHashIterator<int, double> columnIter(matrix.at(row));
+        while(columnIter.hasNext()) {
+            columnIter.next();
+            denseMatrix[row * size + columnIter.key()] = columnIter.value();
+        }
+    }
+    return denseMatrix;
+}
+
+cwLoopCloser::cwLoopCloser() :
+    HasBlocks(false),
+    HasSolution(false),
+    Incremental(false)
+{
+}
+
+/**
+ * @brief cwLoopCloser::clear
+ *
+ * Removes all the stations, shots, fixed stations and results from the loop closer
+ */
+void cwLoopCloser::clear()
+{
+    Names.clear();
+    NameIds.clear();
+    NameToId.clear();
+    Shots.clear();
+    FixedStations.clear();
+
+    SolvedShots.clear();
+    SolvedFixedStations.clear();
+    Active.clear();
+    Traverses.clear();
+    ShotTraverses.clear();
+    Blocks.clear();
+    JunctionLoops.clear();
+    HasBlocks = false;
+    HasSolution = false;
+    Incremental = false;
+
+    Positions.clear();
+    RoundedPositions.clear();
+    InLookup.clear();
+    ChangedStations.clear();
+    Lookup = cwStationPositionLookup();
+}
+
+/**
+ * @brief cwLoopCloser::clearShots
+ *
+ * Removes all the shots and fixed stations, but keeps the state of the last solve. Add the
+ * shots again and call solve() to update the positions.
+ */
+void cwLoopCloser::clearShots()
+{
+    Shots.clear();
+    FixedStations.clear();
+}
+
+/**
+ * @brief cwLoopCloser::addStation
+ * @param name - The name of the station, this is case insensitive
+ * @return The id of the station. If the station already exists, this returns the existing id
+ */
+int cwLoopCloser::addStation(const QString &name)
+{
+    int nameId = cwStationNameTable::instance()->intern(name);
+    QHash<int, int>::const_iterator iter = NameToId.constFind(nameId);
+    if(iter != NameToId.constEnd()) {
+        return iter.value();
+    }
+
+    int id = Names.size();
+    Names.append(name);
+    NameIds.append(nameId);
+    NameToId.insert(nameId, id);
+    return id;
+}
+
+/**
+ * @brief cwLoopCloser::addShot
+ * @param from - The from station name
+ * @param to - The to station name
+ * @param delta - The vector from the from station to the to station, in meters (east, north, up)
+ * @param variance - The variance of the shot. Shots with a larger variance absorb more of the
+ * loop's misclosure
+ *
+ * Shots where from and to are the same station are ignored.
+ */
+void cwLoopCloser::addShot(const QString &from, const QString &to, const Vector &delta, double variance)
+{
+    Shot shot;
+    shot.From = addStation(from);
+    shot.To = addStation(to);
+    shot.Delta = delta;
+    shot.Variance = qMax(variance, MinimumVariance);
+
+    if(shot.From == shot.To) {
+        return;
+    }
+
+    Shots.append(shot);
+}
+
+/**
+ * @brief cwLoopCloser::fixStation
+ * @param name - The station that'll be fixed
+ * @param position - The position of the fixed station
+ *
+ * Fixed stations don't move during the adjustment. Networks that don't have a fixed station
+ * have their first station fixed at the origin.
+ */
+void cwLoopCloser::fixStation(const QString &name, const Vector &position)
+{
+    int id = addStation(name);
+    FixedStations.insert(id, position);
+}
+
+/**
+ * @brief cwLoopCloser::solve
+ *
+ * Runs the least squares adjustment on all the shots. After this has been called, position()
+ * and positions() will return the adjusted positions.
+ *
+ * If the stations, shots and fixed stations are the same as the last solve, and only the shot
+ * vectors or variances have changed, only the changed parts of the network are solved.
+ */
+void cwLoopCloser::solve()
+{
+    ChangedStations.clear();
+
+    Incremental = HasSolution && HasBlocks && isSameNetwork();
+    if(Incremental) {
+        solveIncrementally();
+    } else {
+        solveFully();
+    }
+
+    SolvedShots = Shots;
+    SolvedFixedStations = FixedStations;
+    HasSolution = true;
+}
+
+/**
+ * @brief cwLoopCloser::hasPosition
+ * @return True if the station has been solved
+ */
+bool cwLoopCloser::hasPosition(const QString &name) const
+{
+    int id = stationId(name);
+    return id >= 0 && id < Active.size() && Active.at(id);
+}
+
+/**
+ * @brief cwLoopCloser::position
+ * @return The adjusted position of the station. If the station doesn't exist, this returns the
+ * origin
+ */
+cwLoopCloser::Vector cwLoopCloser::position(const QString &name) const
+{
+    int id = stationId(name);
+    if(id >= 0 && id < Positions.size()) {
+        return Positions.at(id);
+    }
+    return Vector();
+}
+
+/**
+ * @brief cwLoopCloser::stationId
+ * @return The id of the station or -1 if the station doesn't exist
+ */
+int cwLoopCloser::stationId(const QString &name) const
+{
+    return NameToId.value(cwStationNameTable::instance()->find(name), -1);
+}
+
+/**
+ * @brief cwLoopCloser::isSameNetwork
+ * @return True if the shots connect the same stations, and the fixed stations are the same as
+ * the last solve
+ */
+bool cwLoopCloser::isSameNetwork() const
+{
+    if(Shots.size() != SolvedShots.size()) {
+        return false;
+    }
+
+    if(FixedStations != SolvedFixedStations) {
+        return false;
+    }
+
+    for(int i = 0; i < Shots.size(); i++) {
+        const Shot& shot = Shots.at(i);
+        const Shot& solvedShot = SolvedShots.at(i);
+        if(shot.From != solvedShot.From || shot.To != solvedShot.To) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief cwLoopCloser::solveFully
+ *
+ * Rebuilds the traverses and blocks, and solves the whole network
+ */
+void cwLoopCloser::solveFully()
+{
+    int count = Names.size();
+
+    Positions.fill(Vector(), count);
+    Active.fill(false, count);
+    Traverses.clear();
+    Blocks.clear();
+    JunctionLoops.clear();
+
+    //Index all the shots for each station
+    QVector<QVector<int> > stationShots(count);
+    for(int i = 0; i < Shots.size(); i++) {
+        const Shot& shot = Shots.at(i);
+        stationShots[shot.From].append(i);
+        stationShots[shot.To].append(i);
+        Active[shot.From] = true;
+        Active[shot.To] = true;
+    }
+
+    //Find all the connected networks, the root is the network's first station
+    QVector<int> parents(count);
+    for(int i = 0; i < count; i++) {
+        parents[i] = i;
+    }
+
+    foreach(const Shot& shot, Shots) {
+        int fromRoot = findRoot(parents, shot.From);
+        int toRoot = findRoot(parents, shot.To);
+        if(fromRoot != toRoot) {
+            parents[qMax(fromRoot, toRoot)] = qMin(fromRoot, toRoot);
+        }
+    }
+
+    //Anchor each network with its first fixed station, otherwise its first station
+    QVector<int> anchors(count, -1); //Indexed by root
+    QVector<int> fixedCount(count, 0); //Indexed by root
+    for(int i = 0; i < count; i++) {
+        if(FixedStations.contains(i)) {
+            int root = findRoot(parents, i);
+            fixedCount[root]++;
+            if(anchors.at(root) == -1) {
+                anchors[root] = i;
+            }
+            Active[i] = true;
+            Positions[i] = FixedStations.value(i);
+        }
+    }
+
+    for(int i = 0; i < count; i++) {
+        if(Active.at(i) && parents.at(i) == i && anchors.at(i) == -1) {
+            anchors[i] = i;
+        }
+    }
+
+    //Junctions are all stations that don't have exactly two shots. Fixed stations and the
+    //anchor of each network are also junctions
+    QVector<bool> isJunction(count);
+    for(int i = 0; i < count; i++) {
+        isJunction[i] = Active.at(i) &&
+                (stationShots.at(i).size() != 2 ||
+                 FixedStations.contains(i) ||
+                 anchors.at(findRoot(parents, i)) == i);
+    }
+
+    findTraverses(stationShots, isJunction);
+
+    //Networks with a single fixed station are split into blocks. Networks with multiple fixed
+    //stations are solved all at once, and can't be solved incrementally
+    HasBlocks = true;
+    QVector<int> blockAnchors;
+    for(int i = 0; i < count; i++) {
+        if(anchors.at(i) == -1) { continue; }
+        if(fixedCount.at(i) <= 1) {
+            blockAnchors.append(anchors.at(i));
+        } else {
+            HasBlocks = false;
+        }
+    }
+
+    findBlocks(blockAnchors, isJunction);
+    for(int i = 0; i < Blocks.size(); i++) {
+        solveBlock(Blocks[i]);
+    }
+
+    if(!HasBlocks) {
+        QHash<int, QVector<int> > networkJunctions;
+        QHash<int, QVector<int> > networkTraverses;
+        for(int i = 0; i < count; i++) {
+            if(isJunction.at(i)) {
+                int root = findRoot(parents, i);
+                if(fixedCount.at(root) > 1) {
+                    networkJunctions[root].append(i);
+                }
+            }
+        }
+
+        for(int i = 0; i < Traverses.size(); i++) {
+            const Traverse& traverse = Traverses.at(i);
+            int root = findRoot(parents, traverse.Begin);
+            if(traverse.Begin != traverse.End && fixedCount.at(root) > 1) {
+                networkTraverses[root].append(i);
+            }
+        }
+
+        QHashIterator<int, QVector<int> > iter(networkJunctions);
+        while(iter.hasNext()) {
+            iter.next();
+            solveNetwork(iter.value(), networkTraverses.value(iter.key()));
+        }
+    }
+
+    foreach(const Traverse& traverse, Traverses) {
+        distributeTraverse(traverse, nullptr);
+    }
+
+    //Find all the stations that have changed
+    RoundedPositions.resize(count);
+    InLookup.resize(count);
+
+    QVector<int> activeStations;
+    activeStations.reserve(count);
+    for(int i = 0; i < count; i++) {
+        if(Active.at(i)) {
+            activeStations.append(i);
+        } else if(InLookup.at(i)) {
+            InLookup[i] = false;
+            Lookup.removePosition(NameIds.at(i));
+            ChangedStations.append(Names.at(i));
+        }
+    }
+
+    updateRoundedPositions(activeStations);
+}
+
+/**
+ * @brief cwLoopCloser::solveIncrementally
+ *
+ * Only re-solves the blocks and loops that have changed shots. Blocks downstream of a changed
+ * block are translated with their top junction.
+ */
+void cwLoopCloser::solveIncrementally()
+{
+    //Find the traverses that have changed
+    QSet<int> changedTraverses;
+    for(int i = 0; i < Shots.size(); i++) {
+        const Shot& shot = Shots.at(i);
+        const Shot& solvedShot = SolvedShots.at(i);
+        if(shot.Delta != solvedShot.Delta || shot.Variance != solvedShot.Variance) {
+            changedTraverses.insert(ShotTraverses.at(i));
+        }
+    }
+
+    if(changedTraverses.isEmpty()) {
+        return;
+    }
+
+    QSet<int> changedBlocks;
+    QSet<int> redistributedLoops;
+    foreach(int traverseIndex, changedTraverses) {
+        Traverse& traverse = Traverses[traverseIndex];
+        double oldVariance = traverse.Variance;
+        updateTraverse(traverse);
+
+        if(traverse.Block >= 0) {
+            changedBlocks.insert(traverse.Block);
+            if(traverse.Variance != oldVariance) {
+                //The weights have changed, the factorization is no longer valid
+                Blocks[traverse.Block].Factor.clear();
+            }
+        } else {
+            redistributedLoops.insert(traverseIndex);
+        }
+    }
+
+    //Re-solve the changed blocks, and move the blocks downstream of them. Parent blocks are
+    //always before their children.
+    QHash<int, Vector> displacements;
+    QVector<int> redistributedTraverses;
+    for(int i = 0; i < Blocks.size(); i++) {
+        Block& block = Blocks[i];
+        bool changed = changedBlocks.contains(i);
+        bool topMoved = displacements.contains(block.Top);
+
+        if(!changed && !topMoved) {
+            continue;
+        }
+
+        if(changed) {
+            QVector<Vector> oldPositions;
+            oldPositions.reserve(block.Junctions.size());
+            foreach(int junction, block.Junctions) {
+                oldPositions.append(Positions.at(junction));
+            }
+
+            solveBlock(block);
+
+            for(int j = 0; j < block.Junctions.size(); j++) {
+                int junction = block.Junctions.at(j);
+                const Vector& oldPosition = oldPositions.at(j);
+                const Vector& newPosition = Positions.at(junction);
+                Vector displacement(newPosition.X - oldPosition.X,
+                                    newPosition.Y - oldPosition.Y,
+                                    newPosition.Z - oldPosition.Z);
+                if(displacement != Vector()) {
+                    displacements.insert(junction, displacement);
+                }
+            }
+        } else {
+            Vector displacement = displacements.value(block.Top);
+            foreach(int junction, block.Junctions) {
+                Vector& position = Positions[junction];
+                position.X += displacement.X;
+                position.Y += displacement.Y;
+                position.Z += displacement.Z;
+                displacements.insert(junction, displacement);
+            }
+        }
+
+        redistributedTraverses += block.Traverses;
+    }
+
+    //Loops move with their junction
+    QHashIterator<int, Vector> displacementIter(displacements);
+    while(displacementIter.hasNext()) {
+        displacementIter.next();
+        foreach(int loop, JunctionLoops.value(displacementIter.key())) {
+            redistributedLoops.insert(loop);
+        }
+    }
+
+    foreach(int loop, redistributedLoops) {
+        redistributedTraverses.append(loop);
+    }
+
+    QVector<int> touchedStations;
+    foreach(int traverseIndex, redistributedTraverses) {
+        distributeTraverse(Traverses.at(traverseIndex), &touchedStations);
+    }
+
+    updateRoundedPositions(touchedStations);
+}
+
+/**
+ * @brief cwLoopCloser::findTraverses
+ *
+ * Reduces the network into traverses between junctions. Every network must have at least one
+ * junction, otherwise its shots won't be found.
+ */
+void cwLoopCloser::findTraverses(const QVector<QVector<int> > &stationShots,
+                                 const QVector<bool> &isJunction)
+{
+    QVector<bool> visitedShots(Shots.size(), false);
+    ShotTraverses.fill(-1, Shots.size());
+
+    for(int i = 0; i < Names.size(); i++) {
+        if(!isJunction.at(i)) { continue; }
+
+        foreach(int shotIndex, stationShots.at(i)) {
+            if(visitedShots.at(shotIndex)) { continue; }
+
+            Traverse traverse = walkTraverse(i, shotIndex, stationShots, isJunction, visitedShots);
+            int traverseIndex = Traverses.size();
+
+            foreach(int signedIndex, traverse.Shots) {
+                ShotTraverses[signedIndex < 0 ? -signedIndex - 1 : signedIndex] = traverseIndex;
+            }
+
+            if(traverse.Begin == traverse.End) {
+                JunctionLoops[traverse.Begin].append(traverseIndex);
+            }
+
+            Traverses.append(traverse);
+        }
+    }
+}
+
+/**
+ * @brief cwLoopCloser::walkTraverse
+ *
+ * Walks from the junction, begin, along shotIndex until it hits another junction
+ */
+cwLoopCloser::Traverse cwLoopCloser::walkTraverse(int begin,
+                                                  int shotIndex,
+                                                  const QVector<QVector<int> > &stationShots,
+                                                  const QVector<bool> &isJunction,
+                                                  QVector<bool> &visitedShots) const
+{
+    Traverse traverse;
+    traverse.Begin = begin;
+
+    int current = begin;
+    forever {
+        visitedShots[shotIndex] = true;
+
+        const Shot& shot = Shots.at(shotIndex);
+        bool reversed = shot.From != current;
+
+        traverse.Shots.append(reversed ? -shotIndex - 1 : shotIndex);
+
+        current = reversed ? shot.From : shot.To;
+        if(isJunction.at(current)) {
+            break;
+        }
+
+        //Not a junction, so the station has exactly two shots
+        const QVector<int>& shots = stationShots.at(current);
+        Q_ASSERT(shots.size() == 2);
+        shotIndex = shots.at(0) == shotIndex ? shots.at(1) : shots.at(0);
+    }
+
+    traverse.End = current;
+    updateTraverse(traverse);
+    return traverse;
+}
+
+/**
+ * @brief cwLoopCloser::updateTraverse
+ *
+ * Sums the vectors and variances of the shots in the traverse
+ */
+void cwLoopCloser::updateTraverse(Traverse &traverse) const
+{
+    traverse.Delta = Vector();
+    traverse.Variance = 0.0;
+
+    foreach(int signedIndex, traverse.Shots) {
+        bool reversed = signedIndex < 0;
+        const Shot& shot = Shots.at(reversed ? -signedIndex - 1 : signedIndex);
+        double sign = reversed ? -1.0 : 1.0;
+
+        traverse.Delta.X += sign * shot.Delta.X;
+        traverse.Delta.Y += sign * shot.Delta.Y;
+        traverse.Delta.Z += sign * shot.Delta.Z;
+        traverse.Variance += shot.Variance;
+    }
+}
+
+/**
+ * @brief cwLoopCloser::findBlocks
+ * @param anchors - The anchor junction of each network that will be split into blocks
+ *
+ * Finds the biconnected components of the junction network, starting at each anchor. Loop
+ * traverses aren't part of any block. The blocks are sorted so a block always comes after the
+ * block that contains its top junction.
+ */
+void cwLoopCloser::findBlocks(const QVector<int> &anchors, const QVector<bool> &isJunction)
+{
+    class Frame {
+    public:
+        Frame() : Junction(-1), ParentTraverse(-1), Next(0) {}
+        Frame(int junction, int parentTraverse) : Junction(junction), ParentTraverse(parentTraverse), Next(0) {}
+
+        int Junction;
+        int ParentTraverse;
+        int Next;
+    };
+
+    Q_UNUSED(isJunction);
+
+    int count = Names.size();
+
+    QVector<QVector<int> > junctionTraverses(count);
+    for(int i = 0; i < Traverses.size(); i++) {
+        const Traverse& traverse = Traverses.at(i);
+        if(traverse.Begin != traverse.End) {
+            junctionTraverses[traverse.Begin].append(i);
+            junctionTraverses[traverse.End].append(i);
+        }
+    }
+
+    //Iterative Tarjan, this can't recurse because survey networks can be very deep
+    QVector<int> discovered(count, -1);
+    QVector<int> low(count, -1);
+    QVector<int> traverseStack;
+    QVector<Frame> frames;
+    QVector<Block> finishedBlocks;
+    int time = 0;
+
+    foreach(int anchor, anchors) {
+        Q_ASSERT(isJunction.at(anchor));
+        if(discovered.at(anchor) != -1) { continue; }
+
+        discovered[anchor] = low[anchor] = time++;
+        frames.append(Frame(anchor, -1));
+
+        while(!frames.isEmpty()) {
+            Frame& frame = frames.last();
+            int junction = frame.Junction;
+
+            if(frame.Next < junctionTraverses.at(junction).size()) {
+                int traverseIndex = junctionTraverses.at(junction).at(frame.Next);
+                frame.Next++;
+
+                if(traverseIndex == frame.ParentTraverse) { continue; }
+
+                const Traverse& traverse = Traverses.at(traverseIndex);
+                int next = traverse.Begin == junction ? traverse.End : traverse.Begin;
+
+                if(discovered.at(next) == -1) {
+                    traverseStack.append(traverseIndex);
+                    discovered[next] = low[next] = time++;
+                    frames.append(Frame(next, traverseIndex)); //frame is invalid after this
+                } else if(discovered.at(next) < discovered.at(junction)) {
+                    traverseStack.append(traverseIndex);
+                    low[junction] = qMin(low.at(junction), discovered.at(next));
+                }
+            } else {
+                Frame finished = frames.last();
+                frames.removeLast();
+
+                if(frames.isEmpty()) { continue; }
+
+                int parent = frames.last().Junction;
+                low[parent] = qMin(low.at(parent), low.at(finished.Junction));
+
+                if(low.at(finished.Junction) >= discovered.at(parent)) {
+                    //parent is the top of a new block
+                    Block block;
+                    block.Top = parent;
+                    forever {
+                        int traverseIndex = traverseStack.last();
+                        traverseStack.removeLast();
+                        block.Traverses.append(traverseIndex);
+                        if(traverseIndex == finished.ParentTraverse) {
+                            break;
+                        }
+                    }
+                    finishedBlocks.append(block);
+                }
+            }
+        }
+    }
+
+    //Blocks are finished after their children, reverse them so parents come first
+    Blocks.reserve(finishedBlocks.size());
+    for(int i = finishedBlocks.size() - 1; i >= 0; i--) {
+        Block block = finishedBlocks.at(i);
+        int blockIndex = Blocks.size();
+
+        foreach(int traverseIndex, block.Traverses) {
+            Traverse& traverse = Traverses[traverseIndex];
+            traverse.Block = blockIndex;
+
+            int ends[2] = {traverse.Begin, traverse.End};
+            for(int j = 0; j < 2; j++) {
+                int junction = ends[j];
+                if(junction != block.Top && !block.LocalIndexes.contains(junction)) {
+                    block.LocalIndexes.insert(junction, block.Junctions.size());
+                    block.Junctions.append(junction);
+                }
+            }
+        }
+
+        Blocks.append(block);
+    }
+}
+
+/**
+ * @brief cwLoopCloser::solveBlock
+ *
+ * Solves the junctions in the block, with the block's top junction held in place. Small
+ * blocks keep their factorization, so they can be re-solved quickly if only the shot
+ * directions change. Large blocks are solved iteratively, starting at their current positions.
+ */
+void cwLoopCloser::solveBlock(Block &block)
+{
+    int size = block.Junctions.size();
+    if(size == 0) {
+        return;
+    }
+
+    QVector<double> rhs[3];
+    QVector<double> result[3];
+    for(int i = 0; i < 3; i++) {
+        rhs[i].fill(0.0, size);
+        result[i].fill(0.0, size);
+    }
+
+    bool needsMatrix = block.Factor.isEmpty() || size > DenseSolverLimit;
+    QVector<QHash<int, double> > matrix;
+    if(needsMatrix) {
+        matrix.resize(size);
+    }
+
+    assemble(block.Traverses, block.LocalIndexes, needsMatrix ? &matrix : nullptr, rhs);
+
+    if(size <= DenseSolverLimit && block.Factor.isEmpty()) {
+        QVector<double> denseMatrix = toDenseMatrix(matrix);
+        if(choleskyFactor(denseMatrix, size)) {
+            block.Factor = denseMatrix;
+        }
+    }
+
+    if(!block.Factor.isEmpty()) {
+        choleskySubstitute(block.Factor, size, rhs, result);
+    } else {
+        for(int i = 0; i < size; i++) {
+            const Vector& position = Positions.at(block.Junctions.at(i));
+            result[0][i] = position.X;
+            result[1][i] = position.Y;
+            result[2][i] = position.Z;
+        }
+        conjugateGradientSolve(matrix, rhs, result);
+    }
+
+    for(int i = 0; i < size; i++) {
+        Positions[block.Junctions.at(i)] = Vector(result[0].at(i), result[1].at(i), result[2].at(i));
+    }
+}
+
+/**
+ * @brief cwLoopCloser::solveNetwork
+ *
+ * Solves all the junctions in a network that has multiple fixed stations
+ */
+void cwLoopCloser::solveNetwork(const QVector<int> &junctions, const QVector<int> &traverseIndexes)
+{
+    QHash<int, int> localIndexes;
+    QVector<int> freeJunctions;
+    foreach(int junction, junctions) {
+        if(!FixedStations.contains(junction)) {
+            localIndexes.insert(junction, freeJunctions.size());
+            freeJunctions.append(junction);
+        }
+    }
+
+    int size = freeJunctions.size();
+    if(size == 0) {
+        return;
+    }
+
+    QVector<double> rhs[3];
+    QVector<double> result[3];
+    for(int i = 0; i < 3; i++) {
+        rhs[i].fill(0.0, size);
+        result[i].fill(0.0, size);
+    }
+
+    QVector<QHash<int, double> > matrix(size);
+    assemble(traverseIndexes, localIndexes, &matrix, rhs);
+
+    bool solved = false;
+    if(size <= DenseSolverLimit) {
+        QVector<double> denseMatrix = toDenseMatrix(matrix);
+        if(choleskyFactor(denseMatrix, size)) {
+            choleskySubstitute(denseMatrix, size, rhs, result);
+            solved = true;
+        }
+    }
+
+    if(!solved) {
+        conjugateGradientSolve(matrix, rhs, result);
+    }
+
+    for(int i = 0; i < size; i++) {
+        Positions[freeJunctions.at(i)] = Vector(result[0].at(i), result[1].at(i), result[2].at(i));
+    }
+}
+
+/**
+ * @brief cwLoopCloser::assemble
+ * @param traverseIndexes - The traverses between the junctions
+ * @param localIndexes - Maps the free junctions to rows, junctions that aren't in this are
+ * held at their current position
+ * @param matrix - The normal matrix output, if this is null, only rhs is assembled
+ * @param rhs - The three right hand sides, one for each axis
+ */
+void cwLoopCloser::assemble(const QVector<int> &traverseIndexes,
+                            const QHash<int, int> &localIndexes,
+                            QVector<QHash<int, double> > *matrix,
+                            QVector<double> rhs[]) const
+{
+    foreach(int traverseIndex, traverseIndexes) {
+        const Traverse& traverse = Traverses.at(traverseIndex);
+        if(traverse.Begin == traverse.End) {
+            //Loops don't constrain the junction
+            continue;
+        }
+
+        double weight = 1.0 / traverse.Variance;
+        int begin = localIndexes.value(traverse.Begin, -1);
+        int end = localIndexes.value(traverse.End, -1);
+        const Vector& delta = traverse.Delta;
+
+        if(end >= 0) {
+            rhs[0][end] += weight * delta.X;
+            rhs[1][end] += weight * delta.Y;
+            rhs[2][end] += weight * delta.Z;
+
+            if(matrix != nullptr) {
+                (*matrix)[end][end] += weight;
+            }
+
+            if(begin >= 0) {
+                if(matrix != nullptr) {
+                    (*matrix)[end][begin] -= weight;
+                }
+            } else {
+                const Vector& heldPosition = Positions.at(traverse.Begin);
+                rhs[0][end] += weight * heldPosition.X;
+                rhs[1][end] += weight * heldPosition.Y;
+                rhs[2][end] += weight * heldPosition.Z;
+            }
+        }
+
+        if(begin >= 0) {
+            rhs[0][begin] -= weight * delta.X;
+            rhs[1][begin] -= weight * delta.Y;
+            rhs[2][begin] -= weight * delta.Z;
+
+            if(matrix != nullptr) {
+                (*matrix)[begin][begin] += weight;
+            }
+
+            if(end >= 0) {
+                if(matrix != nullptr) {
+                    (*matrix)[begin][end] -= weight;
+                }
+            } else {
+                const Vector& heldPosition = Positions.at(traverse.End);
+                rhs[0][begin] += weight * heldPosition.X;
+                rhs[1][begin] += weight * heldPosition.Y;
+                rhs[2][begin] += weight * heldPosition.Z;
+            }
+        }
+    }
+}
+
+/**
+ * @brief cwLoopCloser::distributeTraverse
+ * @param touchedStations - If not null, all the stations that are updated are added to this
+ *
+ * Distributes the misclosure between the traverse's junctions along the shots in the traverse.
+ * The junctions should already be solved.
+ */
+void cwLoopCloser::distributeTraverse(const Traverse &traverse, QVector<int>* touchedStations)
+{
+    const Vector begin = Positions.at(traverse.Begin);
+    const Vector end = Positions.at(traverse.End);
+
+    Vector misclosure((end.X - begin.X) - traverse.Delta.X,
+                      (end.Y - begin.Y) - traverse.Delta.Y,
+                      (end.Z - begin.Z) - traverse.Delta.Z);
+
+    Vector current = begin;
+    for(int i = 0; i < traverse.Shots.size() - 1; i++) {
+        int signedIndex = traverse.Shots.at(i);
+        bool reversed = signedIndex < 0;
+        const Shot& shot = Shots.at(reversed ? -signedIndex - 1 : signedIndex);
+
+        double sign = reversed ? -1.0 : 1.0;
+        double fraction = shot.Variance / traverse.Variance;
+
+        current.X += sign * shot.Delta.X + misclosure.X * fraction;
+        current.Y += sign * shot.Delta.Y + misclosure.Y * fraction;
+        current.Z += sign * shot.Delta.Z + misclosure.Z * fraction;
+
+        int station = reversed ? shot.From : shot.To;
+        Positions[station] = current;
+
+        if(touchedStations != nullptr) {
+            touchedStations->append(station);
+        }
+    }
+
+    if(touchedStations != nullptr) {
+        touchedStations->append(traverse.Begin);
+        touchedStations->append(traverse.End);
+    }
+}
+
+/**
+ * @brief cwLoopCloser::updateRoundedPositions
+ * @param stations - The stations that may have moved
+ *
+ * Rounds the positions of stations, and updates the lookup and the changed stations with the
+ * stations that have moved.
+ */
+void cwLoopCloser::updateRoundedPositions(const QVector<int> &stations)
+{
+    double factor = 1.0 / PositionPrecision;
+
+    RoundedPositions.resize(Names.size());
+    InLookup.resize(Names.size());
+
+    foreach(int station, stations) {
+        const Vector& position = Positions.at(station);
+        QVector3D roundedPosition(qRound64(position.X * factor) / factor,
+                                  qRound64(position.Y * factor) / factor,
+                                  qRound64(position.Z * factor) / factor);
+
+        if(!InLookup.at(station) || RoundedPositions.at(station) != roundedPosition) {
+            RoundedPositions[station] = roundedPosition;
+            InLookup[station] = true;
+            Lookup.setPosition(NameIds.at(station), roundedPosition);
+            ChangedStations.append(Names.at(station));
+        }
+    }
+}
+
+/**
+ * @brief cwLoopCloser::choleskyFactor
+ * @param matrix - A dense, size by size, symmetric positive definite matrix. This is factored
+ * in place, the lower triangle holds L.
+ * @return False if the matrix isn't positive definite
+ */
+bool cwLoopCloser::choleskyFactor(QVector<double> &matrix, int size)
+{
+    for(int column = 0; column < size; column++) {
+        double diagonal = matrix.at(column * size + column);
+        for(int k = 0; k < column; k++) {
+            double value = matrix.at(column * size + k);
+            diagonal -= value * value;
+        }
+
+        if(diagonal <= 0.0) {
+            return false;
+        }
+
+        diagonal = sqrt(diagonal);
+        matrix[column * size + column] = diagonal;
+
+        for(int row = column + 1; row < size; row++) {
+            double value = matrix.at(row * size + column);
+            const double* rowData = matrix.constData() + row * size;
+            const double* columnData = matrix.constData() + column * size;
+            for(int k = 0; k < column; k++) {
+                value -= rowData[k] * columnData[k];
+            }
+            matrix[row * size + column] = value / diagonal;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief cwLoopCloser::choleskySubstitute
+ * @param factor - The factor from choleskyFactor()
+ * @param rhs - The three right hand sides, one for each axis
+ * @param result - The solution for each axis
+ */
+void cwLoopCloser::choleskySubstitute(const QVector<double> &factor, int size, QVector<double> rhs[], QVector<double> result[])
+{
+    for(int axis = 0; axis < 3; axis++) {
+        QVector<double>& x = result[axis];
+        x = rhs[axis];
+
+        //Forward substitution, L y = b
+        for(int row = 0; row < size; row++) {
+            double value = x.at(row);
+            for(int k = 0; k < row; k++) {
+                value -= factor.at(row * size + k) * x.at(k);
+            }
+            x[row] = value / factor.at(row * size + row);
+        }
+
+        //Back substitution, L^T x = y
+        for(int row = size - 1; row >= 0; row--) {
+            double value = x.at(row);
+            for(int k = row + 1; k < size; k++) {
+                value -= factor.at(k * size + row) * x.at(k);
+            }
+            x[row] = value / factor.at(row * size + row);
+        }
+    }
+}
+
+/**
+ * @brief cwLoopCloser::conjugateGradientSolve
+ * @param matrix - A sparse symmetric positive definite matrix, each row maps column to value
+ * @param rhs - The three right hand sides, one for each axis
+ * @param result - The solution for each axis, this is used as the initial guess
+ *
+ * Jacobi preconditioned conjugate gradient. This is used for large networks where a dense
+ * factorization is too expensive.
+ */
+void cwLoopCloser::conjugateGradientSolve(const QVector<QHash<int, double> > &matrix, QVector<double> rhs[], QVector<double> result[])
+{
+    int size = matrix.size();
+    int maxIterations = size * 10 + 100;
+    double tolerance = 1.0e-12;
+
+    QVector<double> inverseDiagonal(size);
+    for(int i = 0; i < size; i++) {
+        double diagonal = matrix.at(i).value(i, 0.0);
+        inverseDiagonal[i] = diagonal > 0.0 ? 1.0 / diagonal : 1.0;
+    }
+
+    auto multiply = [&](const QVector<double>& vector, QVector<double>& output) {
+        for(int row = 0; row < size; row++) {
+            double sum = 0.0;
+            QHash<int, double>::const_iterator iter;
+            for(iter = matrix.at(row).constBegin(); iter != matrix.at(row).constEnd(); ++iter) {
+                sum += iter.value() * vector.at(iter.key());
+            }
+            output[row] = sum;
+        }
+    };
+
+    auto dot = [size](const QVector<double>& a, const QVector<double>& b) {
+        double sum = 0.0;
+        for(int i = 0; i < size; i++) {
+            sum += a.at(i) * b.at(i);
+        }
+        return sum;
+    };
+
+    QVector<double> residual(size);
+    QVector<double> preconditioned(size);
+    QVector<double> direction(size);
+    QVector<double> product(size);
+
+    for(int axis = 0; axis < 3; axis++) {
+        QVector<double>& x = result[axis];
+        const QVector<double>& b = rhs[axis];
+
+        double threshold = tolerance * qMax(1.0, sqrt(dot(b, b)));
+
+        multiply(x, product);
+        for(int i = 0; i < size; i++) {
+            residual[i] = b.at(i) - product.at(i);
+            preconditioned[i] = residual.at(i) * inverseDiagonal.at(i);
+        }
+        direction = preconditioned;
+
+        double rz = dot(residual, preconditioned);
+
+        for(int iteration = 0; iteration < maxIterations; iteration++) {
+            if(sqrt(dot(residual, residual)) <= threshold) {
+                break;
+            }
+
+            multiply(direction, product);
+            double alpha = rz / dot(direction, product);
+
+            for(int i = 0; i < size; i++) {
+                x[i] += alpha * direction.at(i);
+                residual[i] -= alpha * product.at(i);
+                preconditioned[i] = residual.at(i) * inverseDiagonal.at(i);
+            }
+
+            double newRz = dot(residual, preconditioned);
+            double beta = newRz / rz;
+            rz = newRz;
+
+            for(int i = 0; i < size; i++) {
+                direction[i] = preconditioned.at(i) + beta * direction.at(i);
+            }
+        }
+    }
+}
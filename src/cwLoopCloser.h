@@ -0,0 +1,232 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWLOOPCLOSER_H
+#define CWLOOPCLOSER_H
+
+//Our includes
+#include "cwGlobals.h"
+#include "cwStationPositionLookup.h"
+
+//Qt includes
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QVector3D>
+
+/**
+ * @brief The cwLoopCloser class
+ *
+ * This is a native least squares network adjustment. It replaces the cavern round trip for
+ * generating station positions.
+ *
+ * Shots are added as reduced vectors (east, north, up in meters) with a variance. The network
+ * is reduced into traverses (chains of stations that only have two shots) that connect
+ * junction stations. The junctions are split into blocks (biconnected components), that only
+ * share a single junction with each other. Each block is solved with a weighted least squares
+ * system, and the misclosure of each traverse is then distributed along its shots in
+ * proportion to their variances.
+ *
+ * The loop closer keeps its network state between solves. Call clearShots(), add the shots
+ * again, and call solve(). If only the shot vectors have changed, only the blocks and loops
+ * that contain the changed shots are re-solved, the rest of the network downstream of them is
+ * translated. changedStations() returns the stations that moved.
+ *
+ * Station names are case insensitive.
+ */
+class CAVEWHERE_LIB_EXPORT cwLoopCloser
+{
+public:
+    class Vector {
+    public:
+        Vector() : X(0.0), Y(0.0), Z(0.0) {}
+        Vector(double x, double y, double z) : X(x), Y(y), Z(z) {}
+
+        bool operator==(const Vector& other) const {
+            return X == other.X && Y == other.Y && Z == other.Z;
+        }
+
+        bool operator!=(const Vector& other) const {
+            return !operator==(other);
+        }
+
+        double X;
+        double Y;
+        double Z;
+    };
+
+    cwLoopCloser();
+
+    void clear();
+    void clearShots();
+
+    int addStation(const QString& name);
+    void addShot(const QString& from, const QString& to, const Vector& delta, double variance);
+    void fixStation(const QString& name, const Vector& position);
+
+    int stationCount() const;
+    int shotCount() const;
+
+    void solve();
+
+    bool wasIncremental() const;
+    QStringList changedStations() const;
+
+    bool hasPosition(const QString& name) const;
+    Vector position(const QString& name) const;
+    cwStationPositionLookup positions() const;
+
+private:
+    class Shot {
+    public:
+        Shot() : From(-1), To(-1), Variance(0.0) {}
+
+        int From;
+        int To;
+        Vector Delta;
+        double Variance;
+    };
+
+    /**
+     * A traverse is a chain of shots between two junctions. Intermediate stations only
+     * have two shots. If Begin == End, the traverse is a loop.
+     */
+    class Traverse {
+    public:
+        Traverse() : Begin(-1), End(-1), Variance(0.0), Block(-1) {}
+
+        int Begin;
+        int End;
+        QVector<int> Shots; //Shot indexes from Begin to End, negative (-index - 1) if the shot is reversed
+        Vector Delta; //Sum of the shot vectors from Begin to End
+        double Variance; //Sum of the shot variances
+        int Block; //The block the traverse belongs to, -1 for loops
+    };
+
+    /**
+     * A block is a biconnected part of the junction network. Blocks are solved with Top held
+     * in place. Top is the junction that connects the block to its parent block, or the
+     * network's anchor.
+     */
+    class Block {
+    public:
+        Block() : Top(-1) {}
+
+        int Top;
+        QVector<int> Junctions; //All the junctions in the block, except Top
+        QHash<int, int> LocalIndexes; //Junction to row in the block's system
+        QVector<int> Traverses;
+        QVector<double> Factor; //Cached dense cholesky factor, empty if not factored
+    };
+
+    QVector<QString> Names;
+    QVector<int> NameIds; //Station id to cwStationNameTable id
+    QHash<int, int> NameToId; //cwStationNameTable id to station id
+    QVector<Shot> Shots;
+    QHash<int, Vector> FixedStations;
+
+    //The state of the last solve
+    QVector<Shot> SolvedShots;
+    QHash<int, Vector> SolvedFixedStations;
+    QVector<bool> Active; //Stations that have shots or are fixed
+    QVector<Traverse> Traverses;
+    QVector<int> ShotTraverses; //Shot index to traverse index
+    QVector<Block> Blocks; //Sorted so parent blocks come before their children
+    QHash<int, QVector<int> > JunctionLoops; //Junction to loop traverses
+    bool HasBlocks; //False if a network has more than one fixed station
+    bool HasSolution;
+    bool Incremental;
+
+    QVector<Vector> Positions;
+    QVector<QVector3D> RoundedPositions;
+    QVector<bool> InLookup; //Stations that are in Lookup
+    QStringList ChangedStations;
+    cwStationPositionLookup Lookup;
+
+    static const double MinimumVariance;
+    static const double PositionPrecision;
+    static const int DenseSolverLimit;
+
+    int stationId(const QString& name) const;
+
+    bool isSameNetwork() const;
+    void solveFully();
+    void solveIncrementally();
+
+    void findTraverses(const QVector<QVector<int> >& stationShots,
+                       const QVector<bool>& isJunction);
+    Traverse walkTraverse(int begin, int shotIndex,
+                          const QVector<QVector<int> >& stationShots,
+                          const QVector<bool>& isJunction,
+                          QVector<bool>& visitedShots) const;
+    void updateTraverse(Traverse& traverse) const;
+
+    void findBlocks(const QVector<int>& anchors, const QVector<bool>& isJunction);
+    void solveBlock(Block& block);
+    void solveNetwork(const QVector<int>& junctions, const QVector<int>& traverseIndexes);
+    void assemble(const QVector<int>& traverseIndexes,
+                  const QHash<int, int>& localIndexes,
+                  QVector<QHash<int, double> >* matrix,
+                  QVector<double> rhs[3]) const;
+    void distributeTraverse(const Traverse& traverse, QVector<int>* touchedStations);
+
+    void updateRoundedPositions(const QVector<int>& stations);
+
+    static bool choleskyFactor(QVector<double>& matrix, int size);
+    static void choleskySubstitute(const QVector<double>& factor, int size, QVector<double> rhs[3], QVector<double> result[3]);
+    static void conjugateGradientSolve(const QVector<QHash<int, double> >& matrix, QVector<double> rhs[3], QVector<double> result[3]);
+};
+
+/**
+ * @brief cwLoopCloser::stationCount
+ * @return The number of unique stations that have been added
+ */
+inline int cwLoopCloser::stationCount() const
+{
+    return Names.size();
+}
+
+/**
+ * @brief cwLoopCloser::shotCount
+ * @return The number of shots that have been added
+ */
+inline int cwLoopCloser::shotCount() const
+{
+    return Shots.size();
+}
+
+/**
+ * @brief cwLoopCloser::wasIncremental
+ * @return True if the last solve() only re-solved the parts of the network that changed
+ */
+inline bool cwLoopCloser::wasIncremental() const
+{
+    return Incremental;
+}
+
+/**
+ * @brief cwLoopCloser::changedStations
+ * @return The stations that have moved, been added, or been removed by the last solve(),
+ * compared to the previous solve()
+ */
+inline QStringList cwLoopCloser::changedStations() const
+{
+    return ChangedStations;
+}
+
+/**
+ * @brief cwLoopCloser::positions
+ * @return All the solved positions, rounded to the centimeter, which is the precision of
+ * cavern's .3d files.
+ */
+inline cwStationPositionLookup cwLoopCloser::positions() const
+{
+    return Lookup;
+}
+
+#endif // CWLOOPCLOSER_H
@@ -0,0 +1,276 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwLoopCloserTask.h"
+#include "cwCavingRegion.h"
+#include "cwCave.h"
+#include "cwTrip.h"
+#include "cwSurveyChunk.h"
+#include "cwShot.h"
+#include "cwStation.h"
+#include "cwTripCalibration.h"
+#include "cwUnits.h"
+#include "cwGlobals.h"
+
+//Std includes
+#include <math.h>
+
+const double cwLoopCloserTask::TapeStandardDeviation = 0.1; //In meters
+const double cwLoopCloserTask::AngleStandardDeviation = 2.5; //In degrees
+
+cwLoopCloserTask::cwLoopCloserTask(QObject *parent) :
+    cwTask(parent),
+    Region(nullptr)
+{
+}
+
+/**
+ * @brief cwLoopCloserTask::setRegion
+ * @param region - The region that will be loop closed. The task doesn't own the region, and
+ * the region must live on the same thread as the task.
+ */
+void cwLoopCloserTask::setRegion(cwCavingRegion *region)
+{
+    Region = region;
+}
+
+/**
+ * @brief cwLoopCloserTask::runTask
+ *
+ * Loop closes each cave in the region separately
+ */
+void cwLoopCloserTask::runTask()
+{
+    Results.clear();
+
+    if(Region == nullptr) {
+        done();
+        return;
+    }
+
+    LoopClosers.resize(Region->caveCount());
+    Results.resize(Region->caveCount());
+
+    for(int i = 0; i < Region->caveCount() && isRunning(); i++) {
+        cwCave* cave = Region->cave(i);
+        cwLoopCloser& loopCloser = LoopClosers[i];
+
+        //The cave's positions came from this loop closer's last solve, if they're still shared.
+        //Otherwise, the cave has been moved, or its positions came from somewhere else.
+        bool upToDate = loopCloser.positions().isSharedWith(cave->stationPositionLookup());
+        if(!upToDate) {
+            loopCloser.clear();
+        }
+
+        loopCloser.clearShots();
+        fixFirstStation(loopCloser, cave);
+
+        foreach(cwTrip* trip, cave->trips()) {
+            addTrip(loopCloser, trip);
+        }
+
+        loopCloser.solve();
+
+        Result& result = Results[i];
+        result.StationPositions = loopCloser.positions();
+        result.ChangedStations = loopCloser.changedStations();
+        result.ChangedStationsValid = upToDate;
+    }
+
+    done();
+}
+
+/**
+ * @brief cwLoopCloserTask::addTrip
+ *
+ * Adds all the valid shots in the trip to the loop closer
+ */
+void cwLoopCloserTask::addTrip(cwLoopCloser &loopCloser, cwTrip *trip) const
+{
+    const cwTripCalibration* calibration = trip->calibrations();
+    if(!calibration->hasFrontSights() && !calibration->hasBackSights()) {
+        return;
+    }
+
+    foreach(cwSurveyChunk* chunk, trip->chunks()) {
+        const cwStationColumns& stations = chunk->stationColumns();
+        const cwShotColumns& shots = chunk->shotColumns();
+        for(int i = 0; i < stations.size() - 1; i++) {
+            if(stations.nameId(i) < 0 || stations.nameId(i + 1) < 0) { continue; }
+            if(shots.distanceState(i) != cwDistanceStates::Valid) { continue; }
+
+            cwLoopCloser::Vector delta;
+            double variance;
+            if(shotVector(shots.at(i), calibration, &delta, &variance)) {
+                loopCloser.addShot(stations.name(i), stations.name(i + 1), delta, variance);
+            }
+        }
+    }
+}
+
+/**
+ * @brief cwLoopCloserTask::fixFirstStation
+ *
+ * This fixes the first station in the cave at the origin, if the cave has any stations. This
+ * is the same station cwSurvexExporterCaveTask fixes for cavern.
+ */
+void cwLoopCloserTask::fixFirstStation(cwLoopCloser &loopCloser, cwCave *cave) const
+{
+    if(!cave->trips().isEmpty()) {
+        cwTrip* firstTrip = cave->trips().first();
+        if(!firstTrip->chunks().isEmpty()) {
+            cwSurveyChunk* firstChunk = firstTrip->chunks().first();
+            if(!firstChunk->stationColumns().isEmpty()) {
+                loopCloser.fixStation(firstChunk->stationColumns().name(0), cwLoopCloser::Vector());
+            }
+        }
+    }
+}
+
+/**
+ * @brief cwLoopCloserTask::shotVector
+ * @param shot - The shot that'll be reduced
+ * @param calibration - The trip's calibration
+ * @param delta - Output, the vector of the shot in meters (east, north, up)
+ * @param variance - Output, the variance of the shot
+ * @return False if the shot doesn't have enough data to be reduced
+ *
+ * When both front and back sights exist, they are averaged like cavern does.
+ */
+bool cwLoopCloserTask::shotVector(const cwShot &shot,
+                                  const cwTripCalibration *calibration,
+                                  cwLoopCloser::Vector *delta,
+                                  double *variance)
+{
+    if(shot.distanceState() != cwDistanceStates::Valid) {
+        return false;
+    }
+
+    double distance = cwUnits::convert(shot.distance() + calibration->tapeCalibration(),
+                                       calibration->distanceUnit(),
+                                       cwUnits::Meters);
+
+    //Find the clino, vertical shots don't need a compass reading
+    bool frontSightVertical = calibration->hasFrontSights() &&
+            (shot.clinoState() == cwClinoStates::Up || shot.clinoState() == cwClinoStates::Down);
+    bool backSightVertical = calibration->hasBackSights() &&
+            (shot.backClinoState() == cwClinoStates::Up || shot.backClinoState() == cwClinoStates::Down);
+
+    double clino = 0.0;
+    double compass = 0.0;
+
+    if(frontSightVertical) {
+        clino = shot.clinoState() == cwClinoStates::Up ? 90.0 : -90.0;
+    } else if(backSightVertical) {
+        bool backUp = shot.backClinoState() == cwClinoStates::Up;
+        if(!calibration->hasCorrectedClinoBacksight()) {
+            backUp = !backUp;
+        }
+        clino = backUp ? 90.0 : -90.0;
+    } else {
+        bool hasFrontClino;
+        bool hasBackClino;
+        double front = frontClino(shot, calibration, &hasFrontClino);
+        double back = backClino(shot, calibration, &hasBackClino);
+
+        if(hasFrontClino && hasBackClino) {
+            clino = (front + back) * 0.5;
+        } else if(hasFrontClino) {
+            clino = front;
+        } else if(hasBackClino) {
+            clino = back;
+        } else {
+            return false;
+        }
+
+        bool hasFrontCompass;
+        bool hasBackCompass;
+        front = frontCompass(shot, calibration, &hasFrontCompass);
+        back = backCompass(shot, calibration, &hasBackCompass);
+
+        if(hasFrontCompass && hasBackCompass) {
+            //Average along the smallest arc between the two bearings
+            double difference = fmod(back - front, 360.0);
+            if(difference > 180.0) {
+                difference -= 360.0;
+            } else if(difference <= -180.0) {
+                difference += 360.0;
+            }
+            compass = front + difference * 0.5;
+        } else if(hasFrontCompass) {
+            compass = front;
+        } else if(hasBackCompass) {
+            compass = back;
+        } else {
+            return false;
+        }
+
+        compass += calibration->declination();
+    }
+
+    double clinoRadians = clino * cwGlobals::DegreesToRadians;
+    double compassRadians = compass * cwGlobals::DegreesToRadians;
+    double horizontal = distance * cos(clinoRadians);
+
+    if(frontSightVertical || backSightVertical) {
+        horizontal = 0.0;
+    }
+
+    delta->X = horizontal * sin(compassRadians);
+    delta->Y = horizontal * cos(compassRadians);
+    delta->Z = distance * sin(clinoRadians);
+
+    double angleError = distance * AngleStandardDeviation * cwGlobals::DegreesToRadians;
+    *variance = TapeStandardDeviation * TapeStandardDeviation + angleError * angleError;
+
+    return true;
+}
+
+/**
+ * @brief cwLoopCloserTask::frontCompass
+ * @return The calibrated frontsight compass bearing
+ */
+double cwLoopCloserTask::frontCompass(const cwShot &shot, const cwTripCalibration *calibration, bool *valid)
+{
+    *valid = calibration->hasFrontSights() && shot.compassState() == cwCompassStates::Valid;
+    double correction = calibration->hasCorrectedCompassFrontsight() ? -180.0 : 0.0;
+    return shot.compass() + calibration->frontCompassCalibration() + correction;
+}
+
+/**
+ * @brief cwLoopCloserTask::backCompass
+ * @return The calibrated backsight compass, converted into a frontsight bearing
+ */
+double cwLoopCloserTask::backCompass(const cwShot &shot, const cwTripCalibration *calibration, bool *valid)
+{
+    *valid = calibration->hasBackSights() && shot.backCompassState() == cwCompassStates::Valid;
+    double correction = calibration->hasCorrectedCompassBacksight() ? 0.0 : 180.0;
+    return shot.backCompass() + calibration->backCompassCalibration() + correction;
+}
+
+/**
+ * @brief cwLoopCloserTask::frontClino
+ * @return The calibrated frontsight clino
+ */
+double cwLoopCloserTask::frontClino(const cwShot &shot, const cwTripCalibration *calibration, bool *valid)
+{
+    *valid = calibration->hasFrontSights() && shot.clinoState() == cwClinoStates::Valid;
+    double scale = calibration->hasCorrectedClinoFrontsight() ? -1.0 : 1.0;
+    return (shot.clino() + calibration->frontClinoCalibration()) * scale;
+}
+
+/**
+ * @brief cwLoopCloserTask::backClino
+ * @return The calibrated backsight clino, converted into a frontsight clino
+ */
+double cwLoopCloserTask::backClino(const cwShot &shot, const cwTripCalibration *calibration, bool *valid)
+{
+    *valid = calibration->hasBackSights() && shot.backClinoState() == cwClinoStates::Valid;
+    double scale = calibration->hasCorrectedClinoBacksight() ? 1.0 : -1.0;
+    return (shot.backClino() + calibration->backClinoCalibration()) * scale;
+}
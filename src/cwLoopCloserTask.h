@@ -0,0 +1,96 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWLOOPCLOSERTASK_H
+#define CWLOOPCLOSERTASK_H
+
+//Our includes
+#include "cwTask.h"
+#include "cwLoopCloser.h"
+#include "cwStationPositionLookup.h"
+#include "cwGlobals.h"
+class cwCavingRegion;
+class cwCave;
+class cwTrip;
+class cwShot;
+class cwTripCalibration;
+
+//Qt includes
+#include <QVector>
+#include <QStringList>
+
+/**
+ * @brief The cwLoopCloserTask class
+ *
+ * Runs cwLoopCloser directly on the shot data in the region. This is the native alternative
+ * to exporting the region to survex and running cavern and plotsauce.
+ *
+ * The calibrations, front and back sights, are reduced the same way the survex exporter
+ * writes them for cavern. The first station in each cave is fixed at the origin.
+ *
+ * The task keeps a loop closer for each cave between runs. If a cave's shots only change
+ * direction or length, only the parts of the cave's network that contain the changed shots
+ * are re-solved, and the result has the stations that have moved.
+ *
+ * This class isn't thread safe!
+ */
+class CAVEWHERE_LIB_EXPORT cwLoopCloserTask : public cwTask
+{
+    Q_OBJECT
+
+public:
+    class Result {
+    public:
+        Result() : ChangedStationsValid(false) {}
+
+        cwStationPositionLookup StationPositions;
+        QStringList ChangedStations; //Stations that have moved, been added, or been removed
+        bool ChangedStationsValid; //False if ChangedStations isn't relative to the cave's current positions
+    };
+
+    explicit cwLoopCloserTask(QObject *parent = 0);
+
+    //Inputs
+    void setRegion(cwCavingRegion* region);
+
+    //Outputs
+    QVector<Result> results() const;
+
+    static bool shotVector(const cwShot& shot, const cwTripCalibration* calibration,
+                           cwLoopCloser::Vector* delta, double* variance);
+
+protected:
+    void runTask();
+
+private:
+    cwCavingRegion* Region;
+    QVector<cwLoopCloser> LoopClosers; //One for each cave, kept between runs
+    QVector<Result> Results;
+
+    static const double TapeStandardDeviation;
+    static const double AngleStandardDeviation;
+
+    void addTrip(cwLoopCloser& loopCloser, cwTrip* trip) const;
+    void fixFirstStation(cwLoopCloser& loopCloser, cwCave* cave) const;
+
+    static double frontCompass(const cwShot& shot, const cwTripCalibration* calibration, bool* valid);
+    static double backCompass(const cwShot& shot, const cwTripCalibration* calibration, bool* valid);
+    static double frontClino(const cwShot& shot, const cwTripCalibration* calibration, bool* valid);
+    static double backClino(const cwShot& shot, const cwTripCalibration* calibration, bool* valid);
+};
+
+/**
+ * @brief cwLoopCloserTask::results
+ * @return The station positions for each cave in the region, in the same order as the region's
+ * caves
+ */
+inline QVector<cwLoopCloserTask::Result> cwLoopCloserTask::results() const
+{
+    return Results;
+}
+
+#endif // CWLOOPCLOSERTASK_H
@@ -12,6 +12,7 @@
 #include "cwDebug.h"
 #include "cwImageResolution.h"
 #include "cwSurveyNoteModel.h"
+#include "cwRegionObjectId.h"
 
 //Std includes
 #include "cwMath.h"
@@ -23,7 +24,8 @@ cwNote::cwNote(QObject *parent) :
     QObject(parent),
     ParentTrip(nullptr),
     ParentCave(nullptr),
-    ImageResolution(new cwImageResolution(this))
+    ImageResolution(new cwImageResolution(this)),
+    Id(cwRegionObjectId::next())
 {
     DisplayRotation = 0.0;
     ImageResolution->setUpdateValue(true); //Update the value when the units have changed
@@ -37,7 +39,8 @@ cwNote::cwNote(const cwNote& object) :
     QObject(nullptr),
     ParentTrip(nullptr),
     ParentCave(nullptr),
-    ImageResolution(new cwImageResolution(this))
+    ImageResolution(new cwImageResolution(this)),
+    Id(cwRegionObjectId::next())
 {
     copy(object);
 
@@ -87,6 +90,77 @@ void cwNote::copy(const cwNote& object) {
     Q_ASSERT(Scraps.size() == object.scraps().size());
 }
 
+/**
+ * @brief cwNote::data
+ * @return A value copy of the note and its scraps
+ */
+cwNoteData cwNote::data() const
+{
+    cwNoteData data;
+    data.Id = Id;
+    data.Image = ImageIds;
+    data.Rotation = DisplayRotation;
+    data.ImageResolution = ImageResolution->value();
+    data.ImageResolutionUnit = (cwUnits::ImageResolutionUnit)ImageResolution->unit();
+
+    data.Scraps.reserve(Scraps.size());
+    foreach(cwScrap* scrap, Scraps) {
+        data.Scraps.append(scrap->data());
+    }
+
+    return data;
+}
+
+/**
+ * @brief cwNote::id
+ * @return The note's id, see cwRegionObjectId. Copies of the note get a new id
+ */
+qint64 cwNote::id() const
+{
+    return Id;
+}
+
+/**
+ * @brief cwNote::setId
+ * @param id - The id that was loaded with the note
+ */
+void cwNote::setId(qint64 id)
+{
+    cwRegionObjectId::reserve(id);
+    Id = id;
+}
+
+/**
+ * @brief cwNote::setData
+ * @param data - Replaces the note's image, rotation, resolution and scraps
+ */
+void cwNote::setData(const cwNoteData &data)
+{
+    if(data.Id != 0) {
+        setId(data.Id);
+    }
+    setImage(data.Image);
+    setRotate(data.Rotation);
+    ImageResolution->setValue(data.ImageResolution);
+    ImageResolution->setUnit(data.ImageResolutionUnit);
+
+    QList<cwScrap*> oldScraps = Scraps;
+
+    QList<cwScrap*> scraps;
+    scraps.reserve(data.Scraps.size());
+    foreach(const cwScrapData& scrapData, data.Scraps) {
+        cwScrap* scrap = new cwScrap();
+        scrap->setData(scrapData);
+        scraps.append(scrap);
+    }
+
+    setScraps(scraps);
+
+    foreach(cwScrap* scrap, oldScraps) {
+        scrap->deleteLater();
+    }
+}
+
 /**
   \brief Sets the image data for the page of notes
 
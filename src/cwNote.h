@@ -16,6 +16,7 @@
 #include "cwImage.h"
 #include "cwNoteStation.h"
 #include "cwNoteTranformation.h"
+#include "cwNoteData.h"
 class cwTrip;
 class cwScrap;
 class cwCave;
@@ -36,6 +37,12 @@ public:
     cwNote(const cwNote& object);
     cwNote& operator=(const cwNote& object);
 
+    cwNoteData data() const;
+    void setData(const cwNoteData& data);
+
+    qint64 id() const;
+    void setId(qint64 id);
+
     void setImage(cwImage image);
     cwImage image() const;
 
@@ -105,6 +112,8 @@ private:
 
     cwImageResolution* ImageResolution; //!< nullptr if the note should use image's resolution
 
+    qint64 Id; //!< The note's row in the project file, see cwRegionObjectId
+
     void copy(const cwNote& object);
     void setupScrap(cwScrap* scrap);
 
@@ -0,0 +1,41 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWNOTEDATA_H
+#define CWNOTEDATA_H
+
+//Our includes
+#include "cwImage.h"
+#include "cwScrapData.h"
+#include "cwUnits.h"
+
+//Qt includes
+#include <QList>
+
+/**
+ * @brief The cwNoteData class
+ *
+ * A value copy of cwNote and its scraps. This is part of a cwCavingRegionData snapshot.
+ */
+class cwNoteData {
+public:
+    cwNoteData() :
+        Id(0),
+        Rotation(0.0),
+        ImageResolution(0.0),
+        ImageResolutionUnit(cwUnits::DotsPerInch)
+    {}
+
+    qint64 Id; //!< See cwRegionObjectId, 0 if the note doesn't have an id
+    cwImage Image;
+    double Rotation;
+    double ImageResolution;
+    cwUnits::ImageResolutionUnit ImageResolutionUnit;
+    QList<cwScrapData> Scraps;
+};
+
+#endif // CWNOTEDATA_H
@@ -19,6 +19,9 @@
 #include "cwDebug.h"
 #include "cwSQLManager.h"
 #include "cwTaskManagerModel.h"
+#include "cwImageProvider.h"
+#include "cwTileLoadTask.h"
+#include "cwDxt1Encoder.h"
 
 //Qt includes
 #include <QDir>
@@ -63,6 +66,7 @@ void cwProject::createTempProjectFile() {
     if(isTemporaryProject()) {
         //Remove the old temp project file
         if(QFileInfo(filename()).exists()) {
+            cwImageProvider::closeConnections(filename());
             QFile::remove(filename());
         }
     }
@@ -96,15 +100,23 @@ void cwProject::createTempProjectFile() {
 
   The schema simple,
   Tables:
-  1. CavingRegion
-  2. Images
+  1. ObjectData
+  2. RegionObjects
+  3. Images
+  4. ImageTiles
 
-  Columns CavingRegion:
-  id | gunzipCompressedXML
+  Columns ObjectData (only read from older projects):
+  id | protoBuffer
+
+  Columns RegionObjects:
+  id | checksum | protoBuffer
 
   Columns Images:
   id | type | shouldDelete | data
 
+  Columns ImageTiles:
+  imageId | tileColumn | tileRow | type | tileData
+
   */
 void cwProject::createDefaultSchema() {
     createDefaultSchema(ProjectDatabase);
@@ -259,6 +271,7 @@ void cwProject::saveAs(QString newFilename){
 
     //Try to remove the existing file
     if(QFileInfo(newFilename).exists()) {
+        cwImageProvider::closeConnections(newFilename);
         bool couldRemove = QFile::remove(newFilename);
         if(!couldRemove) {
             qDebug() << "Couldn't remove " << newFilename;
@@ -274,6 +287,7 @@ void cwProject::saveAs(QString newFilename){
     }
 
     if(isTemporaryProject()) {
+        cwImageProvider::closeConnections(filename());
         QFile::remove(filename());
     }
 
@@ -403,6 +417,11 @@ void cwProject::deleteImageTask()
   */
 void cwProject::setFilename(QString newFilename) {
     if(newFilename != filename()) {
+        //Release the image connections to the old project file
+        if(!ProjectFile.isEmpty()) {
+            cwImageProvider::closeConnections(ProjectFile);
+        }
+
         ProjectFile = newFilename;
         emit filenameChanged(ProjectFile);
     }
@@ -450,9 +469,15 @@ void cwProject::addImages(QList<QUrl> noteImagePath, QObject* receiver, const ch
   This static function takes a database and adds the imageData to the database
 
   This returns the id of the image in the database
+
+  If withTransaction is false, the caller must have already begun a transaction, this is
+  useful for adding many images at once.
   */
-int cwProject::addImage(const QSqlDatabase& database, const cwImageData& imageData) {
-    cwSQLManager::Transaction transaction(&database);
+int cwProject::addImage(const QSqlDatabase& database, const cwImageData& imageData, bool withTransaction) {
+    if(withTransaction) {
+        cwSQLManager::Transaction transaction(&database);
+        return addImage(database, imageData, false);
+    }
 
     QString SQL = "INSERT INTO Images (type, shouldDelete, width, height, dotsPerMeter, imageData) "
             "VALUES (?, ?, ?, ?, ?, ?)";
@@ -482,11 +507,15 @@ int cwProject::addImage(const QSqlDatabase& database, const cwImageData& imageDa
  * @param database - The database where the image is going to be inserted into
  * @param imageData - The data that going to update the image
  * @param id - The id of the image that needs to be updated
+ * @param withTransaction - If false, the caller must have already begun a transaction
  * @return True if image was update successfully and false, if unsuccessful
  */
-bool cwProject::updateImage(const QSqlDatabase &database, const cwImageData &imageData, int id)
+bool cwProject::updateImage(const QSqlDatabase &database, const cwImageData &imageData, int id, bool withTransaction)
 {
-    cwSQLManager::Transaction transaction(&database);
+    if(withTransaction) {
+        cwSQLManager::Transaction transaction(&database);
+        return updateImage(database, imageData, id, false);
+    }
 
     QString SQL("UPDATE Images SET type=?, width=?, height=?, dotsPerMeter=?, imageData=? where id=?");
 
@@ -507,6 +536,116 @@ bool cwProject::updateImage(const QSqlDatabase &database, const cwImageData &ima
     return query.exec();
 }
 
+/**
+ * @brief cwProject::addTiledImage
+ * @param database - The database where the image is going to be inserted into
+ * @param imageData - An uncompressed DXT1 mipmap level
+ * @param codec - How each tile is compressed
+ * @param withTransaction - If false, the caller must have already begun a transaction
+ * @return The id of the image in the database, or -1 if it couldn't be added
+ *
+ * The mipmap is stored as separate rows of cwTileLoadTask::TileSize tiles in the ImageTiles
+ * table, so each tile can be read on its own. The image's row in the Images table only has the
+ * image's type and size, cwImageProvider::data() puts the tiles back together.
+ */
+int cwProject::addTiledImage(const QSqlDatabase &database, const cwImageData &imageData, cwBlobCodec::Codec codec, bool withTransaction)
+{
+    if(withTransaction) {
+        cwSQLManager::Transaction transaction(&database);
+        return addTiledImage(database, imageData, codec, false);
+    }
+
+    cwImageData metadata(imageData.size(), imageData.dotsPerMeter(), cwImageProvider::dxt1Format(codec), QByteArray());
+    int id = addImage(database, metadata, false);
+    if(id < 0 || !addImageTiles(database, imageData, codec, id)) {
+        return -1;
+    }
+
+    return id;
+}
+
+/**
+ * @brief cwProject::updateTiledImage
+ * @param database - The database where the image is going to be updated
+ * @param imageData - An uncompressed DXT1 mipmap level
+ * @param codec - How each tile is compressed
+ * @param id - The id of the image that needs to be updated
+ * @param withTransaction - If false, the caller must have already begun a transaction
+ * @return True if the image was updated, see addTiledImage()
+ */
+bool cwProject::updateTiledImage(const QSqlDatabase &database, const cwImageData &imageData, cwBlobCodec::Codec codec, int id, bool withTransaction)
+{
+    if(withTransaction) {
+        cwSQLManager::Transaction transaction(&database);
+        return updateTiledImage(database, imageData, codec, id, false);
+    }
+
+    cwImageData metadata(imageData.size(), imageData.dotsPerMeter(), cwImageProvider::dxt1Format(codec), QByteArray());
+    if(!updateImage(database, metadata, id, false)) {
+        return false;
+    }
+
+    return addImageTiles(database, imageData, codec, id);
+}
+
+/**
+ * @brief cwProject::addImageTiles
+ * @param database - The database connection, the caller must have already begun a transaction
+ * @param imageData - An uncompressed DXT1 mipmap level
+ * @param codec - How each tile is compressed
+ * @param id - The image's id in the Images table
+ * @return True if all the tiles were added
+ *
+ * Replaces all of the image's tiles in the ImageTiles table
+ */
+bool cwProject::addImageTiles(const QSqlDatabase &database, const cwImageData &imageData, cwBlobCodec::Codec codec, int id)
+{
+    //Projects from older versions don't have the table
+    createImageTilesTable(database);
+
+    QSize levelSize = imageData.size();
+    if(imageData.data().size() < cwDxt1Encoder::storageSize(levelSize)) {
+        qDebug() << "Mipmap is too small for its size" << levelSize << LOCATION;
+        return false;
+    }
+
+    QSqlQuery removeQuery(database);
+    removeQuery.prepare("DELETE FROM ImageTiles WHERE imageId == ?");
+    removeQuery.bindValue(0, id);
+    if(!removeQuery.exec()) {
+        qDebug() << "Couldn't remove image tiles: " << removeQuery.lastError() << LOCATION;
+        return false;
+    }
+
+    QSqlQuery query(database);
+    bool successful = query.prepare("INSERT INTO ImageTiles (imageId, tileColumn, tileRow, type, tileData) "
+                                    "VALUES (?, ?, ?, ?, ?)");
+    if(!successful) {
+        qDebug() << "Couldn't create Insert ImageTiles query: " << query.lastError() << LOCATION;
+        return false;
+    }
+
+    QSize gridSize = cwTileLoadTask::tileGridSize(levelSize);
+    for(int row = 0; row < gridSize.height(); row++) {
+        for(int column = 0; column < gridSize.width(); column++) {
+            QRect rect = cwTileLoadTask::tileRect(levelSize, QPoint(column, row));
+            QByteArray tileData = cwTileLoadTask::copyTile(imageData.data(), levelSize, rect);
+
+            query.bindValue(0, id);
+            query.bindValue(1, column);
+            query.bindValue(2, row);
+            query.bindValue(3, cwImageProvider::dxt1Format(codec));
+            query.bindValue(4, cwBlobCodec::compress(tileData, codec));
+            if(!query.exec()) {
+                qDebug() << "Couldn't insert image tile: " << query.lastError() << LOCATION;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
 /**
  * @brief cwProject::removeImage
  * @param database - The database connection
@@ -544,6 +683,16 @@ bool cwProject::removeImage(const QSqlDatabase &database, cwImage image, bool wi
 
     query.exec();
 
+    //Remove the mipmaps' tiles, see addTiledImage()
+    if(database.tables().contains("ImageTiles")) {
+        QSqlQuery removeTilesQuery(database);
+        removeTilesQuery.prepare("DELETE FROM ImageTiles WHERE imageId == ?");
+        foreach(int mipmapId, image.mipmaps()) {
+            removeTilesQuery.bindValue(0, mipmapId);
+            removeTilesQuery.exec();
+        }
+    }
+
     if(withTransaction) {
         cwSQLManager::instance()->endTransaction(database);
     }
@@ -575,6 +724,14 @@ void cwProject::createDefaultSchema(const QSqlDatabase &database)
     //Create ObjectData
     createTable(database, objectDataQuery);
 
+    //The caving region, split into a row for the region, each cave, trip, note, and scrap's geometry
+    QString regionObjectsQuery =
+            QString("CREATE TABLE IF NOT EXISTS RegionObjects (") +
+            QString("id INTEGER PRIMARY KEY,") + //The object's cwRegionObjectId, 0 for the region's row
+            QString("checksum BLOB,") + //Sha1 of protoBuffer, used to only write rows that changed
+            QString("protoBuffer BLOB)");
+    createTable(database, regionObjectsQuery);
+
     QString documentationTableQuery =
             QString("CREATE TABLE IF NOT EXISTS FileFormatDocumenation (") +
             QString("id INTEGER PRIMARY KEY AUTOINCREMENT,") + //First index
@@ -599,6 +756,27 @@ void cwProject::createDefaultSchema(const QSqlDatabase &database)
             QString("dotsPerMeter INTEGER,") + //The resolution of the image
             QString("imageData BLOB)"); //The blob that stores the image data
     createTable(database, imageTableQuery);
+
+    createImageTilesTable(database);
+}
+
+/**
+ * @brief cwProject::createImageTilesTable
+ * @param database
+ *
+ * Creates the table that stores the tiles of the mipmaps, see addTiledImage()
+ */
+void cwProject::createImageTilesTable(const QSqlDatabase &database)
+{
+    QString imageTilesTableQuery =
+            QString("CREATE TABLE IF NOT EXISTS ImageTiles (") +
+            QString("imageId INTEGER,") + //The mipmap's id in Images
+            QString("tileColumn INTEGER,") + //The tile's column in the mipmap
+            QString("tileRow INTEGER,") + //The tile's row in the mipmap
+            QString("type STRING,") + //Type of the tile, like the mipmap's type
+            QString("tileData BLOB,") + //The tile's DXT1 blocks
+            QString("PRIMARY KEY (imageId, tileColumn, tileRow))");
+    createTable(database, imageTilesTableQuery);
 }
 
 /**
@@ -12,6 +12,7 @@
 #include "cwTask.h"
 #include "cwImage.h"
 #include "cwImageData.h"
+#include "cwBlobCodec.h"
 #include "cwGlobals.h"
 class cwCave;
 class cwCavingRegion;
@@ -64,10 +65,13 @@ public:
 
     void addImages(QList<QUrl> noteImagePath, QObject* reciever, const char* slot);
 
-    static int addImage(const QSqlDatabase& database, const cwImageData& imageData);
-    static bool updateImage(const QSqlDatabase& database, const cwImageData& imageData, int id);
+    static int addImage(const QSqlDatabase& database, const cwImageData& imageData, bool withTransaction = true);
+    static bool updateImage(const QSqlDatabase& database, const cwImageData& imageData, int id, bool withTransaction = true);
     static bool removeImage(const QSqlDatabase& database, cwImage image, bool withTransaction = true);
 
+    static int addTiledImage(const QSqlDatabase& database, const cwImageData& imageData, cwBlobCodec::Codec codec, bool withTransaction = true);
+    static bool updateTiledImage(const QSqlDatabase& database, const cwImageData& imageData, cwBlobCodec::Codec codec, int id, bool withTransaction = true);
+
     static void createDefaultSchema(const QSqlDatabase& database);
 
     bool isTemporaryProject() const;
@@ -110,6 +114,8 @@ private:
 
     static void createTable(const QSqlDatabase& database, QString sql); //Helpers to createDefaultSchema
     static void insertDocumentation(const QSqlDatabase& database, QList<QPair<QString, QString> > filenames); //Helpers to createDefaultSchema
+    static void createImageTilesTable(const QSqlDatabase& database);
+    static bool addImageTiles(const QSqlDatabase& database, const cwImageData& imageData, cwBlobCodec::Codec codec, int id);
 
     void setFilename(QString newFilename);
 
@@ -0,0 +1,112 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwRangeAllocator.h"
+
+cwRangeAllocator::cwRangeAllocator() :
+    Capacity(0),
+    AllocatedSize(0)
+{
+}
+
+/**
+ * @brief cwRangeAllocator::allocate
+ * @param size - The number of elements in the range, must be greater than 0
+ * @return The offset of the range
+ *
+ * If this grows the capacity, the buffer needs to be reallocated to capacity() before the range
+ * is used.
+ */
+int cwRangeAllocator::allocate(int size)
+{
+    Q_ASSERT(size > 0);
+
+    //First fit
+    for(auto iter = FreeRanges.begin(); iter != FreeRanges.end(); ++iter) {
+        if(iter.value() >= size) {
+            int offset = iter.key();
+            int remaining = iter.value() - size;
+            FreeRanges.erase(iter);
+            if(remaining > 0) {
+                FreeRanges.insert(offset + size, remaining);
+            }
+
+            Allocations.insert(offset, size);
+            AllocatedSize += size;
+            return offset;
+        }
+    }
+
+    //Grow, reusing the free range at the end
+    int offset = Capacity;
+    if(!FreeRanges.isEmpty()) {
+        auto last = FreeRanges.end() - 1;
+        if(last.key() + last.value() == Capacity) {
+            offset = last.key();
+            FreeRanges.erase(last);
+        }
+    }
+
+    int newCapacity = qMax(Capacity * 2, offset + size);
+    if(offset + size < newCapacity) {
+        FreeRanges.insert(offset + size, newCapacity - (offset + size));
+    }
+    Capacity = newCapacity;
+
+    Allocations.insert(offset, size);
+    AllocatedSize += size;
+    return offset;
+}
+
+/**
+ * @brief cwRangeAllocator::free
+ * @param offset - The offset of a range from allocate()
+ *
+ * Frees the range, and merges it with the free ranges around it
+ */
+void cwRangeAllocator::free(int offset)
+{
+    if(!Allocations.contains(offset)) {
+        return;
+    }
+
+    int size = Allocations.take(offset);
+    AllocatedSize -= size;
+
+    //Merge with the next free range
+    auto next = FreeRanges.find(offset + size);
+    if(next != FreeRanges.end()) {
+        size += next.value();
+        FreeRanges.erase(next);
+    }
+
+    //Merge with the previous free range
+    auto previous = FreeRanges.lowerBound(offset);
+    if(previous != FreeRanges.begin()) {
+        --previous;
+        if(previous.key() + previous.value() == offset) {
+            previous.value() += size;
+            return;
+        }
+    }
+
+    FreeRanges.insert(offset, size);
+}
+
+/**
+ * @brief cwRangeAllocator::clear
+ *
+ * Frees all the ranges and sets the capacity to 0
+ */
+void cwRangeAllocator::clear()
+{
+    Capacity = 0;
+    AllocatedSize = 0;
+    FreeRanges.clear();
+    Allocations.clear();
+}
@@ -0,0 +1,75 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWRANGEALLOCATOR_H
+#define CWRANGEALLOCATOR_H
+
+//Our includes
+#include "cwGlobals.h"
+
+//Qt includes
+#include <QMap>
+#include <QHash>
+
+/**
+ * @brief The cwRangeAllocator class
+ *
+ * Hands out ranges of a buffer, like a vertex buffer that's shared by many objects. Ranges are
+ * allocated first fit, and freed ranges are merged with their free neighbours. When there's no
+ * free range that's big enough, the capacity grows, at least doubling, so the buffer only needs
+ * to be reallocated a few times.
+ *
+ * Offsets and sizes are in elements, not bytes.
+ */
+class CAVEWHERE_LIB_EXPORT cwRangeAllocator
+{
+public:
+    cwRangeAllocator();
+
+    int allocate(int size);
+    void free(int offset);
+    void clear();
+
+    int size(int offset) const;
+    int capacity() const;
+    int allocatedSize() const;
+
+private:
+    int Capacity;
+    int AllocatedSize;
+    QMap<int, int> FreeRanges; //Offset to size, sorted by offset
+    QHash<int, int> Allocations; //Offset to size
+};
+
+/**
+ * @brief cwRangeAllocator::size
+ * @return The size of the range that was allocated at offset, or 0 if offset isn't allocated
+ */
+inline int cwRangeAllocator::size(int offset) const
+{
+    return Allocations.value(offset, 0);
+}
+
+/**
+ * @brief cwRangeAllocator::capacity
+ * @return The size of the buffer that holds all the ranges
+ */
+inline int cwRangeAllocator::capacity() const
+{
+    return Capacity;
+}
+
+/**
+ * @brief cwRangeAllocator::allocatedSize
+ * @return The sum of all the allocated ranges
+ */
+inline int cwRangeAllocator::allocatedSize() const
+{
+    return AllocatedSize;
+}
+
+#endif // CWRANGEALLOCATOR_H
@@ -9,8 +9,7 @@
 #include "cwRegionIOTask.h"
 #include "cwCavingRegion.h"
 
-//Qt includes
-#include <QThread>
+const qint64 cwRegionIOTask::RegionRowId = 0;
 
 cwRegionIOTask::cwRegionIOTask(QObject* parent) :
     cwProjectIOTask(parent)
@@ -20,25 +19,15 @@ cwRegionIOTask::cwRegionIOTask(QObject* parent) :
 
 
 /**
-      This does a deap copy of the region, so it make a snapshot
-      */
+ * @brief cwRegionIOTask::setCavingRegion
+ * @param region
+ *
+ * This takes a snapshot of the region's data. The snapshot shares all the survey data with
+ * region, so this is cheap and doesn't need to block on the task's thread. Edits made to region
+ * after this call aren't seen by the task.
+ */
 void cwRegionIOTask::setCavingRegion(const cwCavingRegion& region) {
-    Q_ASSERT(thread() == Region->thread());
-
-    //Move the region to the current thread
-    if(QThread::currentThread() != thread()) {
-        QMetaObject::invokeMethod(this, "moveRegionToThread",
-                                  Qt::BlockingQueuedConnection,
-                                  Q_ARG(QThread*, QThread::currentThread()));
-    }
-
-    *Region = region;
-
-    //Move Region back to task's thread
-    if(QThread::currentThread() != thread()) {
-        Region->moveToThread(thread());
-        Region->setParent(this);
-    }
+    RegionData = region.data();
 }
 
 /**
@@ -47,29 +36,12 @@ void cwRegionIOTask::setCavingRegion(const cwCavingRegion& region) {
  *
  * This will copy the data out the region io task into region.
  *
- * This fuction makes sure that the thread for region is correct when coping
- * the region.
+ * Only the data is shared between the threads, region's caves, trips, and notes are created on
+ * the calling thread. The task must not be running.
  */
 void cwRegionIOTask::copyRegionTo(cwCavingRegion &region)
 {
-    Q_ASSERT(thread() == Region->thread());
-
-    //Move the region to the current thread
-    if(QThread::currentThread() != thread()) {
-        QMetaObject::invokeMethod(this, "moveRegionToThread",
-                                  Qt::BlockingQueuedConnection,
-                                  Q_ARG(QThread*, QThread::currentThread()));
-    }
-
-    //Preform copy
-    region = *Region;
-
-    //Move Region back to task's thread
-    if(QThread::currentThread() != thread()) {
-        Region->moveToThread(thread());
-        QMetaObject::invokeMethod(this, "updateRegionParent",
-                                  Qt::BlockingQueuedConnection);
-    }
+    region.setData(Region->data());
 }
 
 /**
@@ -78,27 +50,5 @@ void cwRegionIOTask::copyRegionTo(cwCavingRegion &region)
  */
 int cwRegionIOTask::version()
 {
-    return 1;
+    return 2;
 }
-
-/**
- * @brief cwRegionIOTask::moveRegionToThread
- * @param thread
- *
- * This moves Region to thread. We need this function because, objects can only be pushed to other
- * threads, and can't be pulled to threads. See Qt documentation for details.
- */
-void cwRegionIOTask::moveRegionToThread(QThread* thread)
-{
-    Region->setParent(nullptr);
-    Region->moveToThread(thread);
-}
-
-/**
- * @brief cwRegionIOTask::updateRegionParent
- */
-void cwRegionIOTask::updateRegionParent()
-{
-    Region->setParent(this);
-}
-
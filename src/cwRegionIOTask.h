@@ -10,6 +10,7 @@
 
 //Our includes
 #include "cwProjectIOTask.h"
+#include "cwCavingRegionData.h"
 class cwCavingRegion;
 
 class cwRegionIOTask : public cwProjectIOTask
@@ -24,12 +25,11 @@ public:
 
 protected:
     cwCavingRegion* Region;
+    cwCavingRegionData RegionData; //Snapshot from setCavingRegion()
 
-    static int version();
+    static const qint64 RegionRowId; //The id of the region's row in RegionObjects
 
-private:
-    Q_INVOKABLE void moveRegionToThread(QThread* thread);
-    Q_INVOKABLE void updateRegionParent();
+    static int version();
 };
 
 #endif // CWREGIONIOTASK_H
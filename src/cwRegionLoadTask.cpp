@@ -34,6 +34,7 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QSqlRecord>
+#include <QHash>
 
 //Std includes
 #include <sstream>
@@ -82,15 +83,21 @@ void cwRegionLoadTask::runTask() {
  */
 bool cwRegionLoadTask::loadFromProtoBuffer()
 {
-    bool okay;
-    QByteArray protoBufferData = readProtoBufferFromDatabase(&okay);
+    CavewhereProto::CavingRegion region;
+    bool couldParse;
+    bool hasRegionObjects = readRegionObjectsFromDatabase(region, &couldParse);
 
-    if(!okay) {
-        return false;
-    }
+    if(!hasRegionObjects) {
+        //Older projects store the whole region in a single row, it's migrated on the next save
+        bool okay;
+        QByteArray protoBufferData = readProtoBufferFromDatabase(&okay);
 
-    CavewhereProto::CavingRegion region;
-    bool couldParse = region.ParseFromArray(protoBufferData.data(), protoBufferData.size());
+        if(!okay) {
+            return false;
+        }
+
+        couldParse = region.ParseFromArray(protoBufferData.data(), protoBufferData.size());
+    }
 
     if(!couldParse) {
         qDebug() << "Couldn't read proto buffer. Corrupted?!";
@@ -145,6 +152,86 @@ QByteArray cwRegionLoadTask::readProtoBufferFromDatabase(bool* okay)
     return data;
 }
 
+/**
+ * @brief cwRegionLoadTask::readRegionObjectsFromDatabase
+ * @param region - Assembled from the rows of the RegionObjects table
+ * @param okay - Set to false, if the rows couldn't be parsed or a row is missing
+ * @return False if the project doesn't have any RegionObjects rows. Older projects store the
+ * region in ObjectData, see readProtoBufferFromDatabase()
+ */
+bool cwRegionLoadTask::readRegionObjectsFromDatabase(CavewhereProto::CavingRegion &region, bool *okay)
+{
+    cwSQLManager::Transaction transaction(&Database, cwSQLManager::ReadOnly);
+
+    *okay = false;
+
+    QSqlQuery selectRegionObjects(Database);
+    QString queryStr = QString("SELECT id, protoBuffer FROM RegionObjects");
+
+    if(!selectRegionObjects.exec(queryStr)) {
+        //Older projects don't have the table
+        return false;
+    }
+
+    QHash<qint64, QByteArray> rows;
+    while(selectRegionObjects.next()) {
+        rows.insert(selectRegionObjects.value(0).toLongLong(), selectRegionObjects.value(1).toByteArray());
+    }
+
+    if(rows.isEmpty()) {
+        return false;
+    }
+
+    auto parseRow = [&rows](qint64 id, google::protobuf::MessageLite* message) {
+        QHash<qint64, QByteArray>::const_iterator iter = rows.constFind(id);
+        if(iter == rows.constEnd()) {
+            qDebug() << "Region object is missing, id:" << id << LOCATION;
+            return false;
+        }
+        return message->ParseFromArray(iter.value().data(), iter.value().size());
+    };
+
+    //Parents list the ids of their children, in order
+    if(!parseRow(RegionRowId, &region)) {
+        return true;
+    }
+
+    for(int caveIndex = 0; caveIndex < region.caveids_size(); caveIndex++) {
+        CavewhereProto::Cave* protoCave = region.add_caves();
+        if(!parseRow(region.caveids(caveIndex), protoCave)) {
+            return true;
+        }
+
+        for(int tripIndex = 0; tripIndex < protoCave->tripids_size(); tripIndex++) {
+            CavewhereProto::Trip* protoTrip = protoCave->add_trips();
+            if(!parseRow(protoCave->tripids(tripIndex), protoTrip)) {
+                return true;
+            }
+
+            CavewhereProto::SurveyNoteModel* protoNoteModel = protoTrip->mutable_notemodel();
+            for(int noteIndex = 0; noteIndex < protoTrip->noteids_size(); noteIndex++) {
+                CavewhereProto::Note* protoNote = protoNoteModel->add_notes();
+                if(!parseRow(protoTrip->noteids(noteIndex), protoNote)) {
+                    return true;
+                }
+
+                //The scrap's geometry, scraps without geometry are triangulated again
+                for(int scrapIndex = 0; scrapIndex < protoNote->scraps_size(); scrapIndex++) {
+                    CavewhereProto::Scrap* protoScrap = protoNote->mutable_scraps(scrapIndex);
+                    if(protoScrap->has_id() && rows.contains(protoScrap->id())) {
+                        if(!parseRow(protoScrap->id(), protoScrap->mutable_triangledata())) {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    *okay = true;
+    return true;
+}
+
 /**
  * @brief cwRegionLoadTask::loadCavingRegion
  * @param region
@@ -182,6 +269,9 @@ void cwRegionLoadTask::loadCave(const CavewhereProto::Cave& protoCave, cwCave *c
     QList<cwTrip*> trips;
     trips.reserve(protoCave.trips_size());
 
+    if(protoCave.has_id()) {
+        cave->setId(protoCave.id());
+    }
     cave->setName(name);
     cave->length()->setUnit(lengthUnit);
     cave->depth()->setUnit(depthUnit);
@@ -210,6 +300,9 @@ void cwRegionLoadTask::loadTrip(const CavewhereProto::Trip& protoTrip, cwTrip *t
     QString tripName = loadString(protoTrip.name());
     QDate tripDate = loadDate(protoTrip.date());
 
+    if(protoTrip.has_id()) {
+        trip->setId(protoTrip.id());
+    }
     trip->setName(tripName);
     trip->setDate(tripDate);
 
@@ -329,6 +422,9 @@ void cwRegionLoadTask::loadNote(const CavewhereProto::Note& protoNote, cwNote *n
     cwImage image = loadImage(protoNote.image());
     double rotation = protoNote.rotation();
 
+    if(protoNote.has_id()) {
+        note->setId(protoNote.id());
+    }
     note->setImage(image);
     note->setRotate(rotation);
 
@@ -377,6 +473,10 @@ cwImage cwRegionLoadTask::loadImage(const CavewhereProto::Image& protoImage)
  */
 void cwRegionLoadTask::loadScrap(const CavewhereProto::Scrap& protoScrap, cwScrap *scrap)
 {
+    if(protoScrap.has_id()) {
+        scrap->setId(protoScrap.id());
+    }
+
     QVector<QPointF> outlinePoint;
     outlinePoint.resize(protoScrap.outlinepoints_size());
     for(int i = 0; i < protoScrap.outlinepoints_size(); i++) {
@@ -452,6 +552,11 @@ cwTriangulatedData cwRegionLoadTask::loadTriangulatedData(const CavewhereProto::
     cwImage image = loadImage(protoTriangulatedData.croppedimage());
     data.setCroppedImage(image);
 
+    if(protoTriangulatedData.has_cropposition() && protoTriangulatedData.has_cropsize()) {
+        data.setCropRect(QRectF(loadPointF(protoTriangulatedData.cropposition()),
+                                loadSizeF(protoTriangulatedData.cropsize())));
+    }
+
     QVector<QVector3D> points;
     points.resize(protoTriangulatedData.points_size());
     for(int i = 0; i < protoTriangulatedData.points_size(); i++) {
@@ -476,11 +581,37 @@ cwTriangulatedData cwRegionLoadTask::loadTriangulatedData(const CavewhereProto::
         leadPositions[i] = loadVector3D(protoTriangulatedData.leadpositions(i));
     }
 
+    QList<cwTriangulatedData::LevelOfDetail> levels;
+    for(int i = 0; i < protoTriangulatedData.levelsofdetail_size(); i++) {
+        const CavewhereProto::TriangulatedLevelOfDetail& protoLevel = protoTriangulatedData.levelsofdetail(i);
+
+        cwTriangulatedData::LevelOfDetail level;
+        level.GridSpacing = protoLevel.gridspacing();
+
+        level.Points.resize(protoLevel.points_size());
+        for(int j = 0; j < protoLevel.points_size(); j++) {
+            level.Points[j] = loadVector3D(protoLevel.points(j));
+        }
+
+        level.TexCoords.resize(protoLevel.texcoords_size());
+        for(int j = 0; j < protoLevel.texcoords_size(); j++) {
+            level.TexCoords[j] = loadVector2D(protoLevel.texcoords(j));
+        }
+
+        level.Indices.resize(protoLevel.indices_size());
+        for(int j = 0; j < protoLevel.indices_size(); j++) {
+            level.Indices[j] = protoLevel.indices(j);
+        }
+
+        levels.append(level);
+    }
+
     bool stale = protoTriangulatedData.stale();
 
     data.setPoints(points);
     data.setTexCoords(texCoords);
     data.setIndices(indexes);
+    data.setLevelsOfDetail(levels);
     data.setLeadPoints(leadPositions);
     data.setStale(stale);
 
@@ -52,6 +52,7 @@ protected:
 private:
     bool loadFromProtoBuffer();
     QByteArray readProtoBufferFromDatabase(bool* okay);
+    bool readRegionObjectsFromDatabase(CavewhereProto::CavingRegion& region, bool* okay);
 
     void loadCavingRegion(const CavewhereProto::CavingRegion& region);
     void loadCave(const CavewhereProto::Cave& protoCave, cwCave* cave);
@@ -0,0 +1,32 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwRegionObjectId.h"
+
+QAtomicInteger<qint64> cwRegionObjectId::LastId;
+
+/**
+ * @brief cwRegionObjectId::next
+ * @return A new id, that's larger than all the ids that have been handed out or reserved
+ */
+qint64 cwRegionObjectId::next()
+{
+    return LastId.fetchAndAddOrdered(1) + 1;
+}
+
+/**
+ * @brief cwRegionObjectId::reserve
+ * @param id - An id that was loaded from a project, next() won't return it
+ */
+void cwRegionObjectId::reserve(qint64 id)
+{
+    qint64 lastId = LastId.load();
+    while(lastId < id && !LastId.testAndSetOrdered(lastId, id)) {
+        lastId = LastId.load();
+    }
+}
@@ -0,0 +1,37 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWREGIONOBJECTID_H
+#define CWREGIONOBJECTID_H
+
+//Our includes
+#include "cwGlobals.h"
+
+//Qt includes
+#include <QAtomicInteger>
+
+/**
+ * @brief The cwRegionObjectId class
+ *
+ * Hands out the ids of caves, trips, notes, and scraps. An object keeps its id for its whole
+ * life, and the id is saved with it. The object's row in the project file is keyed by its id,
+ * so the row doesn't move when objects are inserted or removed before it.
+ *
+ * Ids are unique within the process. Ids that are loaded from a project are reserved, so new
+ * objects never reuse them. 0 is never handed out, it's the id of the region's row.
+ */
+class CAVEWHERE_LIB_EXPORT cwRegionObjectId
+{
+public:
+    static qint64 next();
+    static void reserve(qint64 id);
+
+private:
+    static QAtomicInteger<qint64> LastId;
+};
+
+#endif // CWREGIONOBJECTID_H
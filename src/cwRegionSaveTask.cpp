@@ -31,6 +31,7 @@
 #include "cwDebug.h"
 #include "cwSQLManager.h"
 #include "cwLead.h"
+#include "cwRegionObjectId.h"
 
 ////Serielization includes
 //#include "cwSerialization.h"
@@ -39,6 +40,8 @@
 //Qt includes
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QCryptographicHash>
+#include <QSet>
 
 //Std includes
 #include <sstream>
@@ -65,7 +68,7 @@ void cwRegionSaveTask::runTask() {
     }
 
     //Clear the region of data
-    *Region = cwCavingRegion();
+    RegionData = cwCavingRegionData();
 
     qDebug() << "Finished saving!!!";
 
@@ -78,40 +81,282 @@ void cwRegionSaveTask::runTask() {
  * @brief cwRegionSaveTask::saveToProtoBuffer
  *
  * Save cavewhere object data usingo google protobuffer
+ *
+ * The region is split into rows in the RegionObjects table, one for the region, each cave, trip,
+ * and note, and one for each scrap's triangulated geometry. Rows are keyed by the object's id,
+ * and parents list the ids of their children, so inserting or removing an object doesn't move
+ * the rows of its siblings. Only the rows that have changed since the last save are written.
  */
 void cwRegionSaveTask::saveToProtoBuffer()
 {
     cwSQLManager::Transaction transaction(&Database);
 
-    CavewhereProto::CavingRegion region;
-    saveCavingRegion(region);
+    assignRowIds();
 
-    std::string regionString = region.SerializeAsString();
+    RowWriter writer(Database);
+    QHash<qint64, SavedGeometry> geometryCache;
 
-    QByteArray regionByteArray;
-    if(!regionString.empty()) {
-        regionByteArray = QByteArray(&regionString[0], regionString.size());
+    //The region's row, the caves are saved in their own rows
+    CavewhereProto::CavingRegion protoRegion;
+    protoRegion.set_version(version());
+    foreach(const cwCaveData& cave, RegionData.Caves) {
+        protoRegion.add_caveids(cave.Id);
+    }
+    saveRow(writer, RegionRowId, protoRegion);
+
+    foreach(const cwCaveData& cave, RegionData.Caves) {
+        cwCaveData caveOnly = cave;
+        caveOnly.Trips.clear();
+
+        CavewhereProto::Cave protoCave;
+        saveCave(&protoCave, caveOnly);
+        foreach(const cwTripData& trip, cave.Trips) {
+            protoCave.add_tripids(trip.Id);
+        }
+        saveRow(writer, cave.Id, protoCave);
+
+        foreach(const cwTripData& trip, cave.Trips) {
+            cwTripData tripOnly = trip;
+            tripOnly.Notes.clear();
+
+            CavewhereProto::Trip protoTrip;
+            saveTrip(&protoTrip, tripOnly);
+            foreach(const cwNoteData& note, trip.Notes) {
+                protoTrip.add_noteids(note.Id);
+            }
+            saveRow(writer, trip.Id, protoTrip);
+
+            foreach(const cwNoteData& note, trip.Notes) {
+                //The scrap's geometry is saved in it's own row
+                cwNoteData noteOnly = note;
+                for(int i = 0; i < noteOnly.Scraps.size(); i++) {
+                    noteOnly.Scraps[i].TriangulationData = cwTriangulatedData();
+                }
+
+                CavewhereProto::Note protoNote;
+                saveNote(&protoNote, noteOnly);
+                for(int i = 0; i < protoNote.scraps_size(); i++) {
+                    protoNote.mutable_scraps(i)->clear_triangledata();
+                }
+                saveRow(writer, note.Id, protoNote);
+
+                foreach(const cwScrapData& scrap, note.Scraps) {
+                    saveGeometry(writer, scrap.Id, scrap.TriangulationData, geometryCache);
+                }
+            }
+        }
     }
 
-    QSqlQuery insertCavingRegion(Database);
-    QString queryStr =
-            QString("INSERT OR REPLACE INTO ObjectData ") +
-            QString("(id, protoBuffer) ") +
-            QString("VALUES (1, ?)");
+    //Remove the rows of caves, trips, notes and scraps that have been removed
+    writer.removeUnwrittenRows();
+
+    //The region is now stored in RegionObjects
+    removeSingleRowRegion();
+
+    GeometryCache = geometryCache;
+}
+
+/**
+ * @brief cwRegionSaveTask::assignRowIds
+ *
+ * Makes sure every cave, trip, note and scrap in RegionData has its own row id. Objects keep the
+ * id from cwRegionObjectId, this only replaces ids that are missing or used twice, for example
+ * when the data was copied with setData() into another object in the same region.
+ */
+void cwRegionSaveTask::assignRowIds()
+{
+    QSet<qint64> usedIds;
+    usedIds.insert(RegionRowId);
+
+    auto assignId = [&usedIds](qint64& id) {
+        if(id <= 0 || usedIds.contains(id)) {
+            id = cwRegionObjectId::next();
+        }
+        usedIds.insert(id);
+    };
+
+    for(int caveIndex = 0; caveIndex < RegionData.Caves.size(); caveIndex++) {
+        cwCaveData& cave = RegionData.Caves[caveIndex];
+        assignId(cave.Id);
+
+        for(int tripIndex = 0; tripIndex < cave.Trips.size(); tripIndex++) {
+            cwTripData& trip = cave.Trips[tripIndex];
+            assignId(trip.Id);
+
+            for(int noteIndex = 0; noteIndex < trip.Notes.size(); noteIndex++) {
+                cwNoteData& note = trip.Notes[noteIndex];
+                assignId(note.Id);
+
+                for(int scrapIndex = 0; scrapIndex < note.Scraps.size(); scrapIndex++) {
+                    assignId(note.Scraps[scrapIndex].Id);
+                }
+            }
+        }
+    }
+}
 
-    bool successful = insertCavingRegion.prepare(queryStr);
-    if(!successful) {
-        qDebug() << "Couldn't create query to insert region proto buffer data:" << insertCavingRegion.lastError();
-        stop();
+/**
+ * @brief cwRegionSaveTask::saveRow
+ *
+ * Serializes message and writes it to id's row, if it has changed
+ */
+void cwRegionSaveTask::saveRow(cwRegionSaveTask::RowWriter &writer,
+                               qint64 id,
+                               const google::protobuf::MessageLite &message)
+{
+    std::string messageString = message.SerializeAsString();
+    QByteArray protoBuffer(messageString.data(), (int)messageString.size());
+    writer.write(id, protoBuffer, RowWriter::checksum(protoBuffer));
+}
+
+/**
+ * @brief cwRegionSaveTask::saveGeometry
+ *
+ * Writes the scrap's triangulated data to the row with the scrap's id. If the triangulated data
+ * is still shared with the data from the last save, and the row hasn't changed, the data isn't
+ * serialized again.
+ *
+ * @param geometryCache - The geometry that's been saved, this will become the GeometryCache
+ */
+void cwRegionSaveTask::saveGeometry(cwRegionSaveTask::RowWriter &writer,
+                                    qint64 id,
+                                    const cwTriangulatedData &triangulatedData,
+                                    QHash<qint64, cwRegionSaveTask::SavedGeometry> &geometryCache)
+{
+    SavedGeometry savedGeometry = GeometryCache.value(id);
+    if(savedGeometry.Data.isSharedWith(triangulatedData) &&
+            writer.isSaved(id, savedGeometry.Checksum))
+    {
+        writer.write(id, QByteArray(), savedGeometry.Checksum);
+        geometryCache.insert(id, savedGeometry);
+        return;
     }
 
-    insertCavingRegion.bindValue(0, regionByteArray);
-    bool success = insertCavingRegion.exec();
+    CavewhereProto::TriangulatedData protoTriangulatedData;
+    saveTriangulatedData(&protoTriangulatedData, triangulatedData);
 
+    std::string messageString = protoTriangulatedData.SerializeAsString();
+    QByteArray protoBuffer(messageString.data(), (int)messageString.size());
+
+    savedGeometry.Data = triangulatedData;
+    savedGeometry.Checksum = RowWriter::checksum(protoBuffer);
+    writer.write(id, protoBuffer, savedGeometry.Checksum);
+    geometryCache.insert(id, savedGeometry);
+}
+
+/**
+ * @brief cwRegionSaveTask::removeSingleRowRegion
+ *
+ * Older projects stored the whole region in a single row of ObjectData. Once the region has
+ * been saved to RegionObjects, the old row is removed, so it's never loaded instead.
+ */
+void cwRegionSaveTask::removeSingleRowRegion()
+{
+    QSqlQuery removeQuery(Database);
+    QString queryStr = QString("DELETE FROM ObjectData WHERE id = 1");
+
+    bool success = removeQuery.exec(queryStr);
     if(!success) {
-        qDebug()  << "Couldn't execute query:" << insertCavingRegion.lastError().databaseText() << queryStr << LOCATION;
+        qDebug() << "Couldn't execute query:" << removeQuery.lastError().databaseText() << queryStr << LOCATION;
     }
+}
 
+/**
+ * @brief cwRegionSaveTask::RowWriter::RowWriter
+ *
+ * Prepares the queries and reads the checksums of the rows that are already saved
+ */
+cwRegionSaveTask::RowWriter::RowWriter(const QSqlDatabase &database) :
+    InsertQuery(database),
+    DeleteQuery(database)
+{
+    QString insertStr =
+            QString("INSERT OR REPLACE INTO RegionObjects ") +
+            QString("(id, checksum, protoBuffer) ") +
+            QString("VALUES (?, ?, ?)");
+
+    if(!InsertQuery.prepare(insertStr)) {
+        qDebug() << "Couldn't create query to insert region object:" << InsertQuery.lastError() << LOCATION;
+    }
+
+    QString deleteStr = QString("DELETE FROM RegionObjects WHERE id = ?");
+
+    if(!DeleteQuery.prepare(deleteStr)) {
+        qDebug() << "Couldn't create query to delete region object:" << DeleteQuery.lastError() << LOCATION;
+    }
+
+    QSqlQuery selectQuery(database);
+    QString selectStr = QString("SELECT id, checksum FROM RegionObjects");
+    if(!selectQuery.exec(selectStr)) {
+        qDebug() << "Couldn't execute query:" << selectQuery.lastError().databaseText() << selectStr << LOCATION;
+        return;
+    }
+
+    while(selectQuery.next()) {
+        SavedChecksums.insert(selectQuery.value(0).toLongLong(), selectQuery.value(1).toByteArray());
+    }
+}
+
+/**
+ * @brief cwRegionSaveTask::RowWriter::isSaved
+ * @return True if the row with id is already saved with checksum
+ */
+bool cwRegionSaveTask::RowWriter::isSaved(qint64 id, const QByteArray &checksum) const
+{
+    QHash<qint64, QByteArray>::const_iterator iter = SavedChecksums.constFind(id);
+    return iter != SavedChecksums.constEnd() && iter.value() == checksum;
+}
+
+/**
+ * @brief cwRegionSaveTask::RowWriter::write
+ *
+ * Writes protoBuffer to the row with id. If the row is already saved with the same checksum,
+ * this does nothing, and protoBuffer can be empty.
+ */
+void cwRegionSaveTask::RowWriter::write(qint64 id,
+                                        const QByteArray &protoBuffer,
+                                        const QByteArray &checksum)
+{
+    bool saved = isSaved(id, checksum);
+    SavedChecksums.remove(id);
+
+    if(saved) {
+        return;
+    }
+
+    InsertQuery.bindValue(0, id);
+    InsertQuery.bindValue(1, checksum);
+    InsertQuery.bindValue(2, protoBuffer);
+
+    if(!InsertQuery.exec()) {
+        qDebug() << "Couldn't execute query:" << InsertQuery.lastError().databaseText() << LOCATION;
+    }
+}
+
+/**
+ * @brief cwRegionSaveTask::RowWriter::removeUnwrittenRows
+ *
+ * Removes all the rows that haven't been written, since the RowWriter was created
+ */
+void cwRegionSaveTask::RowWriter::removeUnwrittenRows()
+{
+    foreach(qint64 id, SavedChecksums.keys()) {
+        DeleteQuery.bindValue(0, id);
+
+        if(!DeleteQuery.exec()) {
+            qDebug() << "Couldn't execute query:" << DeleteQuery.lastError().databaseText() << LOCATION;
+        }
+    }
+    SavedChecksums.clear();
+}
+
+/**
+ * @brief cwRegionSaveTask::RowWriter::checksum
+ * @return The checksum of protoBuffer, used to find rows that have changed
+ */
+QByteArray cwRegionSaveTask::RowWriter::checksum(const QByteArray &protoBuffer)
+{
+    return QCryptographicHash::hash(protoBuffer, QCryptographicHash::Sha1);
 }
 
 /**
@@ -119,19 +364,20 @@ void cwRegionSaveTask::saveToProtoBuffer()
  * @param protoCave
  * @param cave
  */
-void cwRegionSaveTask::saveCave(CavewhereProto::Cave *protoCave, cwCave *cave)
+void cwRegionSaveTask::saveCave(CavewhereProto::Cave *protoCave, const cwCaveData &cave)
 {
-    saveString(protoCave->mutable_name(), cave->name());
-    protoCave->set_lengthunit((CavewhereProto::Units_LengthUnit)cave->length()->unit());
-    protoCave->set_depthunit((CavewhereProto::Units_LengthUnit)cave->depth()->unit());
+    protoCave->set_id(cave.Id);
+    saveString(protoCave->mutable_name(), cave.Name);
+    protoCave->set_lengthunit((CavewhereProto::Units_LengthUnit)cave.LengthUnit);
+    protoCave->set_depthunit((CavewhereProto::Units_LengthUnit)cave.DepthUnit);
 
-    foreach(cwTrip* trip, cave->trips()) {
+    foreach(const cwTripData& trip, cave.Trips) {
         CavewhereProto::Trip* protoTrip = protoCave->add_trips();
         saveTrip(protoTrip, trip);
     }
 
-    saveStationLookup(protoCave->mutable_stationpositionlookup(), cave->stationPositionLookup());
-    protoCave->set_stationpositionlookupstale(cave->isStationPositionLookupStale());
+    saveStationLookup(protoCave->mutable_stationpositionlookup(), cave.StationPositions);
+    protoCave->set_stationpositionlookupstale(cave.StationPositionsStale);
 }
 
 /**
@@ -139,15 +385,16 @@ void cwRegionSaveTask::saveCave(CavewhereProto::Cave *protoCave, cwCave *cave)
  * @param protoTrip
  * @param trip
  */
-void cwRegionSaveTask::saveTrip(CavewhereProto::Trip *protoTrip, cwTrip *trip)
+void cwRegionSaveTask::saveTrip(CavewhereProto::Trip *protoTrip, const cwTripData &trip)
 {
-    saveString(protoTrip->mutable_name(), trip->name());
-    saveDate(protoTrip->mutable_date(), trip->date());
-    saveSurveyNoteModel(protoTrip->mutable_notemodel(), trip->notes());
-    saveTripCalibration(protoTrip->mutable_tripcalibration(), trip->calibrations());
-    saveTeam(protoTrip->mutable_team(), trip->team());
-
-    foreach(cwSurveyChunk* chunk, trip->chunks()) {
+    protoTrip->set_id(trip.Id);
+    saveString(protoTrip->mutable_name(), trip.Name);
+    saveDate(protoTrip->mutable_date(), trip.Date);
+    saveSurveyNoteModel(protoTrip->mutable_notemodel(), trip.Notes);
+    saveTripCalibration(protoTrip->mutable_tripcalibration(), trip.Calibration);
+    saveTeam(protoTrip->mutable_team(), trip.Team);
+
+    foreach(const cwSurveyChunkData& chunk, trip.Chunks) {
         CavewhereProto::SurveyChunk* protoChunk = protoTrip->add_chunks();
         saveSurveyChunk(protoChunk, chunk);
     }
@@ -156,11 +403,11 @@ void cwRegionSaveTask::saveTrip(CavewhereProto::Trip *protoTrip, cwTrip *trip)
 /**
  * @brief cwRegionSaveTask::saveSurveyNoteModel
  * @param protoNoteModel
- * @param noteModel
+ * @param notes
  */
-void cwRegionSaveTask::saveSurveyNoteModel(CavewhereProto::SurveyNoteModel *protoNoteModel, cwSurveyNoteModel *noteModel)
+void cwRegionSaveTask::saveSurveyNoteModel(CavewhereProto::SurveyNoteModel *protoNoteModel, const QList<cwNoteData> &notes)
 {
-    foreach(cwNote* note, noteModel->notes()) {
+    foreach(const cwNoteData& note, notes) {
         CavewhereProto::Note* protoNote = protoNoteModel->add_notes();
         saveNote(protoNote, note);
     }
@@ -171,21 +418,21 @@ void cwRegionSaveTask::saveSurveyNoteModel(CavewhereProto::SurveyNoteModel *prot
  * @param protoTripCalibration
  * @param tripCalibration
  */
-void cwRegionSaveTask::saveTripCalibration(CavewhereProto::TripCalibration *proto, cwTripCalibration *tripCalibration)
+void cwRegionSaveTask::saveTripCalibration(CavewhereProto::TripCalibration *proto, const cwTripCalibrationData &tripCalibration)
 {
-    proto->set_correctedcompassbacksight(tripCalibration->hasCorrectedCompassBacksight());
-    proto->set_correctedclinobacksight(tripCalibration->hasCorrectedClinoBacksight());
-    proto->set_tapecalibration(tripCalibration->tapeCalibration());
-    proto->set_frontcompasscalibration(tripCalibration->frontCompassCalibration());
-    proto->set_frontclinocalibration(tripCalibration->frontClinoCalibration());
-    proto->set_backcompassscalibration(tripCalibration->backCompassCalibration());
-    proto->set_backclinocalibration(tripCalibration->backClinoCalibration());
-    proto->set_declination(tripCalibration->declination());
-    proto->set_distanceunit((CavewhereProto::Units_LengthUnit)tripCalibration->distanceUnit());
-    proto->set_frontsights(tripCalibration->hasFrontSights());
-    proto->set_backsights(tripCalibration->hasBackSights());
-    proto->set_correctedcompassfrontsight(tripCalibration->hasCorrectedCompassFrontsight());
-    proto->set_correctedclinofrontsight(tripCalibration->hasCorrectedClinoFrontsight());
+    proto->set_correctedcompassbacksight(tripCalibration.CorrectedCompassBacksight);
+    proto->set_correctedclinobacksight(tripCalibration.CorrectedClinoBacksight);
+    proto->set_tapecalibration(tripCalibration.TapeCalibration);
+    proto->set_frontcompasscalibration(tripCalibration.FrontCompassCalibration);
+    proto->set_frontclinocalibration(tripCalibration.FrontClinoCalibration);
+    proto->set_backcompassscalibration(tripCalibration.BackCompassCalibration);
+    proto->set_backclinocalibration(tripCalibration.BackClinoCalibration);
+    proto->set_declination(tripCalibration.Declination);
+    proto->set_distanceunit((CavewhereProto::Units_LengthUnit)tripCalibration.DistanceUnit);
+    proto->set_frontsights(tripCalibration.FrontSights);
+    proto->set_backsights(tripCalibration.BackSights);
+    proto->set_correctedcompassfrontsight(tripCalibration.CorrectedCompassFrontsight);
+    proto->set_correctedclinofrontsight(tripCalibration.CorrectedClinoFrontsight);
 }
 
 /**
@@ -193,16 +440,16 @@ void cwRegionSaveTask::saveTripCalibration(CavewhereProto::TripCalibration *prot
  * @param protoChunk
  * @param chunk
  */
-void cwRegionSaveTask::saveSurveyChunk(CavewhereProto::SurveyChunk *protoChunk, cwSurveyChunk *chunk)
+void cwRegionSaveTask::saveSurveyChunk(CavewhereProto::SurveyChunk *protoChunk, const cwSurveyChunkData &chunk)
 {
-    foreach(cwStation station, chunk->stations()) {
+    for(int i = 0; i < chunk.Stations.size(); i++) {
         CavewhereProto::Station* protoStation = protoChunk->add_stations();
-        saveStation(protoStation, station);
+        saveStation(protoStation, chunk.Stations.at(i));
     }
 
-    foreach(cwShot shot, chunk->shots()) {
+    for(int i = 0; i < chunk.Shots.size(); i++) {
         CavewhereProto::Shot* protoShot = protoChunk->add_shots();
-        saveShot(protoShot, shot);
+        saveShot(protoShot, chunk.Shots.at(i));
     }
 }
 
@@ -211,9 +458,9 @@ void cwRegionSaveTask::saveSurveyChunk(CavewhereProto::SurveyChunk *protoChunk,
  * @param protoTeam
  * @param team
  */
-void cwRegionSaveTask::saveTeam(CavewhereProto::Team *protoTeam, cwTeam *team)
+void cwRegionSaveTask::saveTeam(CavewhereProto::Team *protoTeam, const QList<cwTeamMember> &team)
 {
-    foreach(cwTeamMember teamMember, team->teamMembers()) {
+    foreach(const cwTeamMember& teamMember, team) {
         CavewhereProto::TeamMember* protoTeamMember = protoTeam->add_teammembers();
         saveTeamMember(protoTeamMember, teamMember);
     }
@@ -225,13 +472,14 @@ void cwRegionSaveTask::saveTeam(CavewhereProto::Team *protoTeam, cwTeam *team)
  * @param protoNote
  * @param note
  */
-void cwRegionSaveTask::saveNote(CavewhereProto::Note *protoNote, cwNote *note)
+void cwRegionSaveTask::saveNote(CavewhereProto::Note *protoNote, const cwNoteData &note)
 {
-    saveImage(protoNote->mutable_image(), note->image());
-    protoNote->set_rotation(note->rotate());
-    saveImageResolution(protoNote->mutable_imageresolution(), note->imageResolution());
+    protoNote->set_id(note.Id);
+    saveImage(protoNote->mutable_image(), note.Image);
+    protoNote->set_rotation(note.Rotation);
+    saveImageResolution(protoNote->mutable_imageresolution(), note.ImageResolution, note.ImageResolutionUnit);
 
-    foreach(cwScrap* scrap, note->scraps()) {
+    foreach(const cwScrapData& scrap, note.Scraps) {
         CavewhereProto::Scrap* protoScrap = protoNote->add_scraps();
         saveScrap(protoScrap, scrap);
     }
@@ -259,38 +507,43 @@ void cwRegionSaveTask::saveImage(CavewhereProto::Image *protoImage, const cwImag
  * @param protoScrap
  * @param scrap
  */
-void cwRegionSaveTask::saveScrap(CavewhereProto::Scrap *protoScrap, cwScrap *scrap)
+void cwRegionSaveTask::saveScrap(CavewhereProto::Scrap *protoScrap, const cwScrapData &scrap)
 {
-    foreach(QPointF outlinePoint, scrap->points()) {
+    protoScrap->set_id(scrap.Id);
+
+    foreach(QPointF outlinePoint, scrap.OutlinePoints) {
         QtProto::QPointF* protoPoint = protoScrap->add_outlinepoints();
         savePointF(protoPoint, outlinePoint);
     }
 
-    foreach(cwNoteStation station, scrap->stations()) {
+    foreach(const cwNoteStation& station, scrap.Stations) {
         CavewhereProto::NoteStation* protoNoteStation = protoScrap->add_notestations();
         saveNoteStation(protoNoteStation, station);
     }
 
-    foreach(const cwLead& lead, scrap->leads()) {
+    foreach(const cwLead& lead, scrap.Leads) {
         CavewhereProto::Lead* protoLead = protoScrap->add_leads();
         saveLead(protoLead, lead);
     }
 
-    saveNoteTranformation(protoScrap->mutable_notetransformation(), scrap->noteTransformation());
-    protoScrap->set_calculatenotetransform(scrap->calculateNoteTransform());
-    saveTriangulatedData(protoScrap->mutable_triangledata(), scrap->triangulationData());
-    protoScrap->set_type((CavewhereProto::Scrap_ScrapType)scrap->type());
+    saveNoteTranformation(protoScrap->mutable_notetransformation(), scrap);
+    protoScrap->set_calculatenotetransform(scrap.CalculateNoteTransform);
+    saveTriangulatedData(protoScrap->mutable_triangledata(), scrap.TriangulationData);
+    protoScrap->set_type((CavewhereProto::Scrap_ScrapType)scrap.Type);
 }
 
 /**
  * @brief cwRegionSaveTask::saveImageResolution
  * @param protoImageRes
- * @param imageResolution
+ * @param value
+ * @param unit
  */
-void cwRegionSaveTask::saveImageResolution(CavewhereProto::ImageResolution *protoImageRes, cwImageResolution *imageResolution)
+void cwRegionSaveTask::saveImageResolution(CavewhereProto::ImageResolution *protoImageRes,
+                                           double value,
+                                           cwUnits::ImageResolutionUnit unit)
 {
-    protoImageRes->set_value(imageResolution->value());
-    protoImageRes->set_unit((CavewhereProto::Units_ImageResolutionUnit)imageResolution->unit());
+    protoImageRes->set_value(value);
+    protoImageRes->set_unit((CavewhereProto::Units_ImageResolutionUnit)unit);
 }
 
 /**
@@ -307,16 +560,16 @@ void cwRegionSaveTask::saveNoteStation(CavewhereProto::NoteStation* protoNoteSta
 /**
  * @brief cwRegionSaveTask::saveNoteTranformation
  * @param protoNoteTransformation
- * @param noteTransformation
+ * @param scrap - The scrap that has the note transformation
  */
 void cwRegionSaveTask::saveNoteTranformation(CavewhereProto::NoteTranformation *protoNoteTransformation,
-                                             cwNoteTranformation *noteTransformation)
+                                             const cwScrapData &scrap)
 {
-    protoNoteTransformation->set_northup(noteTransformation->northUp());
+    protoNoteTransformation->set_northup(scrap.NorthUp);
     saveLength(protoNoteTransformation->mutable_scalenumerator(),
-               noteTransformation->scaleNumerator());
+               scrap.ScaleNumerator, scrap.ScaleNumeratorUnit);
     saveLength(protoNoteTransformation->mutable_scaledenominator(),
-               noteTransformation->scaleDenominator());
+               scrap.ScaleDenominator, scrap.ScaleDenominatorUnit);
 }
 
 /**
@@ -330,6 +583,11 @@ void cwRegionSaveTask::saveTriangulatedData(CavewhereProto::TriangulatedData *pr
     saveImage(protoTriangulatedData->mutable_croppedimage(),
               triangluatedData.croppedImage());
 
+    if(triangluatedData.isCropReference()) {
+        savePointF(protoTriangulatedData->mutable_cropposition(), triangluatedData.cropRect().topLeft());
+        saveSizeF(protoTriangulatedData->mutable_cropsize(), triangluatedData.cropRect().size());
+    }
+
     foreach(QVector3D point, triangluatedData.points()) {
         QtProto::QVector3D* protoVector3D = protoTriangulatedData->add_points();
         saveVector3D(protoVector3D, point);
@@ -349,6 +607,23 @@ void cwRegionSaveTask::saveTriangulatedData(CavewhereProto::TriangulatedData *pr
         saveVector3D(protoVector3D, leadPoint);
     }
 
+    foreach(const cwTriangulatedData::LevelOfDetail& level, triangluatedData.levelsOfDetail()) {
+        CavewhereProto::TriangulatedLevelOfDetail* protoLevel = protoTriangulatedData->add_levelsofdetail();
+        protoLevel->set_gridspacing(level.GridSpacing);
+
+        foreach(QVector3D point, level.Points) {
+            saveVector3D(protoLevel->add_points(), point);
+        }
+
+        foreach(QVector2D texCoord, level.TexCoords) {
+            saveVector2D(protoLevel->add_texcoords(), texCoord);
+        }
+
+        foreach(uint index, level.Indices) {
+            protoLevel->add_indices(index);
+        }
+    }
+
     protoTriangulatedData->set_stale(triangluatedData.isStale());
 }
 
@@ -437,12 +712,13 @@ void cwRegionSaveTask::saveStringList(QtProto::QStringList *protoStringList, QSt
 /**
  * @brief cwRegionSaveTask::saveLength
  * @param protoLength
- * @param length
+ * @param value
+ * @param unit
  */
-void cwRegionSaveTask::saveLength(CavewhereProto::Length *protoLength, cwLength *length)
+void cwRegionSaveTask::saveLength(CavewhereProto::Length *protoLength, double value, cwUnits::LengthUnit unit)
 {
-    protoLength->set_value(length->value());
-    protoLength->set_unit((CavewhereProto::Units_LengthUnit)length->unit());
+    protoLength->set_value(value);
+    protoLength->set_unit((CavewhereProto::Units_LengthUnit)unit);
 }
 
 /**
@@ -494,20 +770,6 @@ void cwRegionSaveTask::saveShot(CavewhereProto::Shot *protoShot, const cwShot &s
     protoShot->set_includedistance(shot.isDistanceIncluded());
 }
 
-/**
- * @brief cwRegionSaveTask::saveCavingRegion
- * @param region
- */
-void cwRegionSaveTask::saveCavingRegion(CavewhereProto::CavingRegion &region)
-{
-    foreach(cwCave* cave, Region->caves()) {
-        CavewhereProto::Cave* protoCave = region.add_caves();
-        saveCave(protoCave, cave);
-    }
-
-    region.set_version(version());
-}
-
 /**
  * @brief cwRegionSaveTask::saveStationLookup
  * @param positionLookup
@@ -518,14 +780,11 @@ void cwRegionSaveTask::saveCavingRegion(CavewhereProto::CavingRegion &region)
 void cwRegionSaveTask::saveStationLookup(CavewhereProto::StationPositionLookup *positionLookup,
                                          const cwStationPositionLookup &stationLookup)
 {
-    QMap<QString, QVector3D> positions = stationLookup.positions();
-    QMapIterator<QString, QVector3D> iter(positions);
-    while(iter.hasNext()) {
-        iter.next();
-
+    cwStationNameTable* nameTable = cwStationNameTable::instance();
+    foreach(int stationId, stationLookup.stationIds()) {
         CavewhereProto::StationPositionLookup_NamePosition* namePosition = positionLookup->add_stationpositions();
-        saveString(namePosition->mutable_stationname(), iter.key());
-        saveVector3D(namePosition->mutable_position(), iter.value());
+        saveString(namePosition->mutable_stationname(), nameTable->name(stationId));
+        saveVector3D(namePosition->mutable_position(), stationLookup.position(stationId));
     }
 }
 
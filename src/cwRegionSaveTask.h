@@ -10,20 +10,11 @@
 
 //Our includes
 #include "cwRegionIOTask.h"
-class cwCave;
-class cwTrip;
-class cwSurveyNoteModel;
-class cwTripCalibration;
-class cwSurveyChunk;
-class cwTeam;
-class cwNote;
+#include "cwCavingRegionData.h"
+#include "cwTriangulatedData.h"
 class cwImage;
-class cwScrap;
-class cwImageResolution;
 class cwNoteStation;
-class cwNoteTranformation;
 class cwTriangulatedData;
-class cwLength;
 class cwTeamMember;
 class cwStation;
 class cwShot;
@@ -34,6 +25,10 @@ class cwLead;
 #include "cavewhere.pb.h"
 #include "qt.pb.h"
 
+//Qt includes
+#include <QHash>
+#include <QSqlQuery>
+
 class cwRegionSaveTask : public cwRegionIOTask
 {
     Q_OBJECT
@@ -48,41 +43,80 @@ protected:
     void runTask();
 
 private:
+    /**
+      Writes rows to the RegionObjects table, skipping the rows whose checksum hasn't changed
+      since they were last saved. Rows that are in the table, but aren't written or kept, are
+      removed by removeUnwrittenRows().
+      */
+    class RowWriter {
+    public:
+        RowWriter(const QSqlDatabase& database);
+
+        bool isSaved(qint64 id, const QByteArray& checksum) const;
+        void write(qint64 id, const QByteArray& protoBuffer, const QByteArray& checksum);
+        void removeUnwrittenRows();
+
+        static QByteArray checksum(const QByteArray& protoBuffer);
+
+    private:
+        QSqlQuery InsertQuery;
+        QSqlQuery DeleteQuery;
+        QHash<qint64, QByteArray> SavedChecksums; //Rows in the table that haven't been written yet, by id
+    };
+
+    /**
+      A scrap's geometry from the last save, so unchanged geometry isn't serialized again
+      */
+    class SavedGeometry {
+    public:
+        cwTriangulatedData Data;
+        QByteArray Checksum;
+    };
+
+    QHash<qint64, SavedGeometry> GeometryCache; //By the scrap's id
 
     void saveToProtoBuffer();
-    void saveCave(CavewhereProto::Cave* protoCave, cwCave* cave);
-    void saveTrip(CavewhereProto::Trip* protoTrip, cwTrip* trip);
+    void assignRowIds();
+    void saveRow(RowWriter& writer, qint64 id, const google::protobuf::MessageLite& message);
+    void saveGeometry(RowWriter& writer,
+                      qint64 id,
+                      const cwTriangulatedData& triangulatedData,
+                      QHash<qint64, SavedGeometry>& geometryCache);
+    void removeSingleRowRegion();
+    void saveCave(CavewhereProto::Cave* protoCave, const cwCaveData& cave);
+    void saveTrip(CavewhereProto::Trip* protoTrip, const cwTripData& trip);
     void saveSurveyNoteModel(CavewhereProto::SurveyNoteModel* protoNoteModel,
-                             cwSurveyNoteModel* noteModel);
+                             const QList<cwNoteData>& notes);
     void saveTripCalibration(CavewhereProto::TripCalibration* protoTripCalibration,
-                             cwTripCalibration* tripCalibration);
+                             const cwTripCalibrationData& tripCalibration);
     void saveSurveyChunk(CavewhereProto::SurveyChunk* protoChunk,
-                         cwSurveyChunk* chunk);
+                         const cwSurveyChunkData& chunk);
     void saveTeam(CavewhereProto::Team* protoTeam,
-                  cwTeam* team);
+                  const QList<cwTeamMember>& team);
     void saveNote(CavewhereProto::Note* protoNote,
-                  cwNote* note);
+                  const cwNoteData& note);
     void saveImage(CavewhereProto::Image* protoImage,
                    const cwImage& image);
     void saveScrap(CavewhereProto::Scrap* protoScrap,
-                   cwScrap* scrap);
+                   const cwScrapData& scrap);
     void saveImageResolution(CavewhereProto::ImageResolution* protoImageRes,
-                             cwImageResolution* imageResolution);
+                             double value,
+                             cwUnits::ImageResolutionUnit unit);
     void saveNoteStation(CavewhereProto::NoteStation* protoNoteStation,
                          const cwNoteStation& noteStation);
     void saveNoteTranformation(CavewhereProto::NoteTranformation* protoNoteTransformation,
-                               cwNoteTranformation* noteTransformation);
+                               const cwScrapData& scrap);
     void saveTriangulatedData(CavewhereProto::TriangulatedData* protoTriangulatedData,
                               const cwTriangulatedData& triangluatedData);
     void saveLength(CavewhereProto::Length* protoLength,
-                    cwLength* length);
+                    double value,
+                    cwUnits::LengthUnit unit);
     void saveTeamMember(CavewhereProto::TeamMember* protoTeamMember,
                         const cwTeamMember& teamMember);
     void saveStation(CavewhereProto::Station* protoStation,
                      const cwStation& station);
     void saveShot(CavewhereProto::Shot* protoShot,
                   const cwShot& shot);
-    void saveCavingRegion(CavewhereProto::CavingRegion& region);
     void saveStationLookup(CavewhereProto::StationPositionLookup* positionLookup,
                            const cwStationPositionLookup& stationLookup);
     void saveLead(CavewhereProto::Lead* protoLead, const cwLead& lead);
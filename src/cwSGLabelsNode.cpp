@@ -0,0 +1,64 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwSGLabelsNode.h"
+
+//Qt includes
+#include <QSGGeometry>
+#include <QSGTextureMaterial>
+#include <QSGTexture>
+#include <qgl.h>
+
+cwSGLabelsNode::cwSGLabelsNode() :
+    Texture(nullptr)
+{
+    QSGTextureMaterial* material = new QSGTextureMaterial();
+    material->setFiltering(QSGTexture::Linear);
+    setMaterial(material);
+
+    QSGGeometry* geometry = new QSGGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0);
+    geometry->setDrawingMode(GL_TRIANGLES);
+    setGeometry(geometry);
+
+    setFlags(QSGNode::OwnsMaterial | QSGNode::OwnsGeometry);
+}
+
+cwSGLabelsNode::~cwSGLabelsNode()
+{
+    delete Texture;
+}
+
+/**
+ * @brief cwSGLabelsNode::setTexture
+ * @param texture - The glyph atlas texture, this node takes ownership of it
+ *
+ * The old texture is deleted.
+ */
+void cwSGLabelsNode::setTexture(QSGTexture *texture)
+{
+    if(Texture != texture) {
+        delete Texture;
+        Texture = texture;
+        static_cast<QSGTextureMaterial*>(material())->setTexture(Texture);
+        markDirty(DirtyMaterial);
+    }
+}
+
+/**
+ * @brief cwSGLabelsNode::allocateQuads
+ * @param numberOfQuads - The number of glyphs that will be drawn
+ * @return The vertices, two triangles (six vertices) per quad
+ *
+ * The caller fills in all the vertices that are returned.
+ */
+QSGGeometry::TexturedPoint2D* cwSGLabelsNode::allocateQuads(int numberOfQuads)
+{
+    geometry()->allocate(numberOfQuads * 6);
+    markDirty(DirtyGeometry);
+    return geometry()->vertexDataAsTexturedPoint2D();
+}
@@ -0,0 +1,46 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWSGLABELSNODE_H
+#define CWSGLABELSNODE_H
+
+//Qt includes
+#include <QSGGeometryNode>
+class QSGTexture;
+
+/**
+ * @brief The cwSGLabelsNode class
+ *
+ * Draws all of the labels' glyphs as textured quads from one glyph atlas texture, so every label
+ * is drawn with one draw call.
+ */
+class cwSGLabelsNode : public QSGGeometryNode
+{
+public:
+    cwSGLabelsNode();
+    ~cwSGLabelsNode();
+
+    QSGTexture* texture() const;
+    void setTexture(QSGTexture* texture);
+
+    QSGGeometry::TexturedPoint2D* allocateQuads(int numberOfQuads);
+
+private:
+    QSGTexture* Texture; //!< Owned by this node
+
+};
+
+/**
+ * @brief cwSGLabelsNode::texture
+ * @return The glyph atlas texture
+ */
+inline QSGTexture* cwSGLabelsNode::texture() const
+{
+    return Texture;
+}
+
+#endif // CWSGLABELSNODE_H
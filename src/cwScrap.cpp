@@ -15,6 +15,8 @@
 #include "cwGlobals.h"
 #include "cwTrip.h"
 #include "cwTripCalibration.h"
+#include "cwStationOccurrenceIndex.h"
+#include "cwRegionObjectId.h"
 
 //Qt includes
 #include <QDebug>
@@ -32,7 +34,8 @@ cwScrap::cwScrap(QObject *parent) :
     Type(Plan),
     ParentNote(nullptr),
     ParentCave(nullptr),
-    TriangulationDataDirty(false)
+    TriangulationDataDirty(false),
+    Id(cwRegionObjectId::next())
 {
     setCalculateNoteTransform(true);
 }
@@ -43,7 +46,8 @@ cwScrap::cwScrap(const cwScrap& other)
       CalculateNoteTransform(false),
       ParentNote(nullptr),
       ParentCave(nullptr),
-      TriangulationDataDirty(false)
+      TriangulationDataDirty(false),
+    Id(cwRegionObjectId::next())
 {
     setCalculateNoteTransform(true);
     copy(other);
@@ -831,12 +835,7 @@ QString cwScrap::guessNeighborStationName(const cwNoteStation& previousStation,
     cwCave* parentCave = parentNote()->parentTrip()->parentCave();
     cwStationPositionLookup stationLookup = parentCave->stationPositionLookup();
 
-    QSet<cwStation> neigborStations;
-
-    foreach(cwTrip* trip, parentCave->trips()) {
-        QSet<cwStation> tripStations = trip->neighboringStations(previousStation.name());
-        neigborStations.unite(tripStations);
-    }
+    QSet<cwStation> neigborStations = parentCave->stationOccurrenceIndex()->neighboringStations(previousStation.name());
 
     //Make sure we have neigbors
     if(neigborStations.isEmpty()) {
@@ -1161,6 +1160,69 @@ const cwScrap & cwScrap::copy(const cwScrap &other) {
     return *this;
 }
 
+/**
+ * @brief cwScrap::data
+ * @return A value copy of the scrap
+ */
+cwScrapData cwScrap::data() const
+{
+    cwScrapData data;
+    data.Id = Id;
+    data.OutlinePoints = OutlinePoints;
+    data.Stations = Stations;
+    data.Leads = Leads;
+    data.NorthUp = NoteTransformation->northUp();
+    data.ScaleNumerator = NoteTransformation->scaleNumerator()->value();
+    data.ScaleNumeratorUnit = (cwUnits::LengthUnit)NoteTransformation->scaleNumerator()->unit();
+    data.ScaleDenominator = NoteTransformation->scaleDenominator()->value();
+    data.ScaleDenominatorUnit = (cwUnits::LengthUnit)NoteTransformation->scaleDenominator()->unit();
+    data.CalculateNoteTransform = CalculateNoteTransform;
+    data.TriangulationData = TriangulationData;
+    data.Type = Type;
+    return data;
+}
+
+/**
+ * @brief cwScrap::id
+ * @return The scrap's id, see cwRegionObjectId. Copies of the scrap get a new id
+ */
+qint64 cwScrap::id() const
+{
+    return Id;
+}
+
+/**
+ * @brief cwScrap::setId
+ * @param id - The id that was loaded with the scrap
+ */
+void cwScrap::setId(qint64 id)
+{
+    cwRegionObjectId::reserve(id);
+    Id = id;
+}
+
+/**
+ * @brief cwScrap::setData
+ * @param data - Replaces all the data in the scrap
+ */
+void cwScrap::setData(const cwScrapData &data)
+{
+    if(data.Id != 0) {
+        setId(data.Id);
+    }
+    setPoints(data.OutlinePoints);
+    setStations(data.Stations);
+    setLeads(data.Leads);
+    NoteTransformation->setNorthUp(data.NorthUp);
+    NoteTransformation->scaleNumerator()->setValue(data.ScaleNumerator);
+    NoteTransformation->scaleNumerator()->setUnit(data.ScaleNumeratorUnit);
+    NoteTransformation->scaleDenominator()->setValue(data.ScaleDenominator);
+    NoteTransformation->scaleDenominator()->setUnit(data.ScaleDenominatorUnit);
+    setCalculateNoteTransform(data.CalculateNoteTransform);
+    setTriangulationData(data.TriangulationData);
+    setType((ScrapType)data.Type);
+}
+
 /**
     \brief Set the parent cave for the scrap
   */
@@ -20,6 +20,7 @@
 #include "cwNoteStation.h"
 #include "cwTriangulatedData.h"
 #include "cwLead.h"
+#include "cwScrapData.h"
 class cwNote;
 class cwCave;
 
@@ -66,6 +67,12 @@ public:
     cwScrap(const cwScrap& other);
     const cwScrap& operator =(const cwScrap& other);
 
+    cwScrapData data() const;
+    void setData(const cwScrapData& data);
+
+    qint64 id() const;
+    void setId(qint64 id);
+
     void setParentNote(cwNote* trip);
     cwNote* parentNote() const;
 
@@ -208,6 +215,8 @@ private:
     cwTriangulatedData TriangulationData;
     bool TriangulationDataDirty;
 
+    qint64 Id; //!< The scrap's row in the project file, see cwRegionObjectId
+
     //Clamps a pointF that's in note coordinates to the scrap
     QPointF clampToScrap(QPointF point);
     bool pointOnLine(QLineF line, QPointF point);
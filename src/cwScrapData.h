@@ -0,0 +1,56 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWSCRAPDATA_H
+#define CWSCRAPDATA_H
+
+//Our includes
+#include "cwNoteStation.h"
+#include "cwLead.h"
+#include "cwTriangulatedData.h"
+#include "cwUnits.h"
+
+//Qt includes
+#include <QList>
+#include <QPolygonF>
+
+/**
+ * @brief The cwScrapData class
+ *
+ * A value copy of cwScrap. This is part of a cwCavingRegionData snapshot.
+ */
+class cwScrapData {
+public:
+    cwScrapData() :
+        Id(0),
+        NorthUp(0.0),
+        ScaleNumerator(1.0),
+        ScaleNumeratorUnit(cwUnits::Meters),
+        ScaleDenominator(1.0),
+        ScaleDenominatorUnit(cwUnits::Meters),
+        CalculateNoteTransform(false),
+        Type(0)
+    {}
+
+    qint64 Id; //!< See cwRegionObjectId, 0 if the scrap doesn't have an id
+    QPolygonF OutlinePoints;
+    QList<cwNoteStation> Stations;
+    QList<cwLead> Leads;
+
+    //The note transformation
+    double NorthUp;
+    double ScaleNumerator;
+    cwUnits::LengthUnit ScaleNumeratorUnit;
+    double ScaleDenominator;
+    cwUnits::LengthUnit ScaleDenominatorUnit;
+    bool CalculateNoteTransform;
+
+    cwTriangulatedData TriangulationData;
+    int Type; //cwScrap::ScrapType
+};
+
+#endif // CWSCRAPDATA_H
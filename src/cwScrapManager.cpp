@@ -446,7 +446,6 @@ void cwScrapManager::updateScrapGeometryHelper(QList<cwScrap *> scraps)
             scrapData.append(mapScrapToTriangulateInData(scrap));
         }
 
-        TriangulateTask->setProjectFilename(Project->filename());
         TriangulateTask->setScrapData(scrapData);
         TriangulateTask->start();
     } else {
@@ -480,13 +479,16 @@ cwTriangulateInData cwScrapManager::mapScrapToTriangulateInData(cwScrap *scrap)
   */
 QList<cwTriangulateStation> cwScrapManager::mapNoteStationsToTriangulateStation(QList<cwNoteStation> noteStations,
                                                                                 const cwStationPositionLookup& positionLookup) const {
+    cwStationNameTable* nameTable = cwStationNameTable::instance();
+
     QList<cwTriangulateStation> stations;
     foreach(cwNoteStation noteStation, noteStations) {
-        if(positionLookup.hasPosition(noteStation.name())) {
+        int stationId = nameTable->find(noteStation.name());
+        if(positionLookup.hasPosition(stationId)) {
             cwTriangulateStation station;
             station.setName(noteStation.name());
             station.setNotePosition(noteStation.positionOnNote());
-            station.setPosition(positionLookup.position(noteStation.name()));
+            station.setPosition(positionLookup.position(stationId));
             stations.append(cwTriangulateStation(station));
         }
     }
@@ -836,19 +838,21 @@ void cwScrapManager::taskFinished() {
                 validScraps.append(scrap);
                 validScrapTriangleDataset.append(triangleData);
             } else {
-                //Scrap has been delete
-                imagesToRemove.append(triangleData.croppedImage());
+                //Scrap has been delete, crop references share the note's images
+                if(!triangleData.isCropReference()) {
+                    imagesToRemove.append(triangleData.croppedImage());
+                }
                 continue;
             }
         }
 
         DeletedScraps.clear();
 
-        //Removed all cropped image data
+        //Removed all the standalone cropped images, crop references share the note's images
         foreach(cwScrap* scrap, validScraps) {
-            cwImage image = scrap->triangulationData().croppedImage();
-            qDebug() << "Image is valid:" << image.isValid();
-            if(image.isValid()) {
+            cwTriangulatedData oldData = scrap->triangulationData();
+            cwImage image = oldData.croppedImage();
+            if(image.isValid() && !oldData.isCropReference()) {
                 imagesToRemove.append(image);
             }
         }
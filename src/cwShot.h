@@ -69,6 +69,8 @@ public:
     bool sameIntervalPointer(const cwShot& other) const;
 
 private:
+    friend class cwShotColumns;
+
     enum ValidState {
         Invalid,
         ValidEmpty,
@@ -0,0 +1,170 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwShotColumns.h"
+
+cwShotColumns::cwShotColumns() :
+    Data(new PrivateData())
+{
+}
+
+/**
+ * @brief cwShotColumns::reserve
+ * Reserves space for size shots in each column
+ */
+void cwShotColumns::reserve(int size)
+{
+    Data->Distance.reserve(size);
+    Data->Compass.reserve(size);
+    Data->BackCompass.reserve(size);
+    Data->Clino.reserve(size);
+    Data->BackClino.reserve(size);
+    Data->States.reserve(size);
+}
+
+/**
+ * @brief cwShotColumns::clear
+ * Removes all the shots
+ */
+void cwShotColumns::clear()
+{
+    Data->Distance.clear();
+    Data->Compass.clear();
+    Data->BackCompass.clear();
+    Data->Clino.clear();
+    Data->BackClino.clear();
+    Data->States.clear();
+}
+
+/**
+ * @brief cwShotColumns::at
+ * @return A copy of the shot at index. Changing the shot doesn't change the columns, use
+ * replace() to do that.
+ */
+cwShot cwShotColumns::at(int index) const
+{
+    cwShot shot;
+    cwShot::PrivateData* shotData = shot.Data.data();
+    shotData->Distance = Data->Distance.at(index);
+    shotData->Compass = Data->Compass.at(index);
+    shotData->BackCompass = Data->BackCompass.at(index);
+    shotData->Clino = Data->Clino.at(index);
+    shotData->BackClino = Data->BackClino.at(index);
+    shotData->DistanceState = distanceState(index);
+    shotData->CompassState = compassState(index);
+    shotData->BackCompassState = backCompassState(index);
+    shotData->ClinoState = clinoState(index);
+    shotData->BackClinoState = backClinoState(index);
+    shotData->IncludeDistance = isDistanceIncluded(index);
+    return shot;
+}
+
+/**
+ * @brief cwShotColumns::append
+ * Adds shot to the end of the columns
+ */
+void cwShotColumns::append(const cwShot &shot)
+{
+    insert(size(), shot);
+}
+
+/**
+ * @brief cwShotColumns::insert
+ * Inserts shot at index. Index must be between 0 and size()
+ */
+void cwShotColumns::insert(int index, const cwShot &shot)
+{
+    Q_ASSERT(index >= 0 && index <= size());
+    Data->Distance.insert(index, 0.0);
+    Data->Compass.insert(index, 0.0);
+    Data->BackCompass.insert(index, 0.0);
+    Data->Clino.insert(index, 0.0);
+    Data->BackClino.insert(index, 0.0);
+    Data->States.insert(index, 0);
+    set(index, shot);
+}
+
+/**
+ * @brief cwShotColumns::replace
+ * Replaces the shot at index with shot
+ */
+void cwShotColumns::replace(int index, const cwShot &shot)
+{
+    Q_ASSERT(index >= 0 && index < size());
+    set(index, shot);
+}
+
+/**
+ * @brief cwShotColumns::removeAt
+ * Removes the shot at index
+ */
+void cwShotColumns::removeAt(int index)
+{
+    remove(index, 1);
+}
+
+/**
+ * @brief cwShotColumns::remove
+ * Removes count shots, starting at index
+ */
+void cwShotColumns::remove(int index, int count)
+{
+    Q_ASSERT(index >= 0 && count >= 0 && index + count <= size());
+    Data->Distance.remove(index, count);
+    Data->Compass.remove(index, count);
+    Data->BackCompass.remove(index, count);
+    Data->Clino.remove(index, count);
+    Data->BackClino.remove(index, count);
+    Data->States.remove(index, count);
+}
+
+/**
+ * @brief cwShotColumns::toList
+ * @return All the shots as a list of cwShot
+ */
+QList<cwShot> cwShotColumns::toList() const
+{
+    QList<cwShot> shots;
+    shots.reserve(size());
+    for(int i = 0; i < size(); i++) {
+        shots.append(at(i));
+    }
+    return shots;
+}
+
+/**
+ * @brief cwShotColumns::packStates
+ * @return The shot's reading states packed with StateBits
+ */
+quint8 cwShotColumns::packStates(const cwShot &shot)
+{
+    quint8 states = 0;
+    states |= (shot.distanceState() & OneBitMask) << DistanceShift;
+    states |= (shot.compassState() & OneBitMask) << CompassShift;
+    states |= (shot.backCompassState() & OneBitMask) << BackCompassShift;
+    states |= (shot.clinoState() & TwoBitMask) << ClinoShift;
+    states |= (shot.backClinoState() & TwoBitMask) << BackClinoShift;
+    if(!shot.isDistanceIncluded()) {
+        states |= OneBitMask << DistanceExcludedShift;
+    }
+    return states;
+}
+
+/**
+ * @brief cwShotColumns::set
+ * Copies shot's data into the columns at index
+ */
+void cwShotColumns::set(int index, const cwShot &shot)
+{
+    Data->Distance[index] = shot.distance();
+    Data->Compass[index] = shot.compass();
+    Data->BackCompass[index] = shot.backCompass();
+    Data->Clino[index] = shot.clino();
+    Data->BackClino[index] = shot.backClino();
+    Data->States[index] = packStates(shot);
+}
@@ -0,0 +1,184 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWSHOTCOLUMNS_H
+#define CWSHOTCOLUMNS_H
+
+//Our includes
+#include "cwShot.h"
+#include "cwReadingStates.h"
+#include "cwGlobals.h"
+
+//Qt includes
+#include <QSharedDataPointer>
+#include <QVector>
+#include <QList>
+
+/**
+ * @brief The cwShotColumns class
+ *
+ * Stores a list of shots as columns, instead of a list of cwShot. Each reading is in its own
+ * contiguous array of doubles, and all the reading states, and if the distance is included, are
+ * packed into a byte per shot.
+ *
+ * The interface mirrors QList<cwShot>, at() returns a cwShot that's a copy of the shot's data.
+ * Use the column accessors, like distance() and compassState(), when only a few values are
+ * needed.
+ *
+ * This class is implicitly shared.
+ */
+class CAVEWHERE_LIB_EXPORT cwShotColumns
+{
+public:
+    cwShotColumns();
+
+    int size() const;
+    int count() const { return size(); }
+    bool isEmpty() const;
+    bool empty() const { return isEmpty(); }
+
+    void reserve(int size);
+    void clear();
+
+    cwShot at(int index) const;
+    cwShot operator[](int index) const { return at(index); }
+    cwShot first() const { return at(0); }
+    cwShot last() const { return at(size() - 1); }
+
+    void append(const cwShot& shot);
+    void insert(int index, const cwShot& shot);
+    void replace(int index, const cwShot& shot);
+    void removeAt(int index);
+    void remove(int index, int count);
+
+    QList<cwShot> toList() const;
+
+    double distance(int index) const;
+    double compass(int index) const;
+    double backCompass(int index) const;
+    double clino(int index) const;
+    double backClino(int index) const;
+
+    cwDistanceStates::State distanceState(int index) const;
+    cwCompassStates::State compassState(int index) const;
+    cwCompassStates::State backCompassState(int index) const;
+    cwClinoStates::State clinoState(int index) const;
+    cwClinoStates::State backClinoState(int index) const;
+    bool isDistanceIncluded(int index) const;
+
+    bool isShotEmpty(int index) const;
+
+    bool isSharedWith(const cwShotColumns& other) const;
+
+private:
+    //Layout of the bits in States
+    enum StateBits {
+        DistanceShift = 0, //1 bit, cwDistanceStates::State
+        CompassShift = 1, //1 bit, cwCompassStates::State
+        BackCompassShift = 2, //1 bit, cwCompassStates::State
+        ClinoShift = 3, //2 bits, cwClinoStates::State
+        BackClinoShift = 5, //2 bits, cwClinoStates::State
+        DistanceExcludedShift = 7, //1 bit, set if the distance isn't included
+
+        OneBitMask = 0x1,
+        TwoBitMask = 0x3
+    };
+
+    class PrivateData : public QSharedData {
+    public:
+        QVector<double> Distance;
+        QVector<double> Compass;
+        QVector<double> BackCompass;
+        QVector<double> Clino;
+        QVector<double> BackClino;
+        QVector<quint8> States; //Packed with StateBits
+    };
+
+    QSharedDataPointer<PrivateData> Data;
+
+    static quint8 packStates(const cwShot& shot);
+    int state(int index, int shift, int mask) const;
+    void set(int index, const cwShot& shot);
+};
+
+inline int cwShotColumns::size() const {
+    return Data->States.size();
+}
+
+inline bool cwShotColumns::isEmpty() const {
+    return Data->States.isEmpty();
+}
+
+inline double cwShotColumns::distance(int index) const {
+    return Data->Distance.at(index);
+}
+
+inline double cwShotColumns::compass(int index) const {
+    return Data->Compass.at(index);
+}
+
+inline double cwShotColumns::backCompass(int index) const {
+    return Data->BackCompass.at(index);
+}
+
+inline double cwShotColumns::clino(int index) const {
+    return Data->Clino.at(index);
+}
+
+inline double cwShotColumns::backClino(int index) const {
+    return Data->BackClino.at(index);
+}
+
+inline int cwShotColumns::state(int index, int shift, int mask) const {
+    return (Data->States.at(index) >> shift) & mask;
+}
+
+inline cwDistanceStates::State cwShotColumns::distanceState(int index) const {
+    return static_cast<cwDistanceStates::State>(state(index, DistanceShift, OneBitMask));
+}
+
+inline cwCompassStates::State cwShotColumns::compassState(int index) const {
+    return static_cast<cwCompassStates::State>(state(index, CompassShift, OneBitMask));
+}
+
+inline cwCompassStates::State cwShotColumns::backCompassState(int index) const {
+    return static_cast<cwCompassStates::State>(state(index, BackCompassShift, OneBitMask));
+}
+
+inline cwClinoStates::State cwShotColumns::clinoState(int index) const {
+    return static_cast<cwClinoStates::State>(state(index, ClinoShift, TwoBitMask));
+}
+
+inline cwClinoStates::State cwShotColumns::backClinoState(int index) const {
+    return static_cast<cwClinoStates::State>(state(index, BackClinoShift, TwoBitMask));
+}
+
+inline bool cwShotColumns::isDistanceIncluded(int index) const {
+    return state(index, DistanceExcludedShift, OneBitMask) == 0;
+}
+
+/**
+ * @brief cwShotColumns::isShotEmpty
+ * @return True if none of the shot's readings have been entered
+ */
+inline bool cwShotColumns::isShotEmpty(int index) const {
+    return distanceState(index) == cwDistanceStates::Empty &&
+            compassState(index) == cwCompassStates::Empty &&
+            backCompassState(index) == cwCompassStates::Empty &&
+            clinoState(index) == cwClinoStates::Empty &&
+            backClinoState(index) == cwClinoStates::Empty;
+}
+
+/**
+  Returns true if other is an implicitly shared copy of these columns. This is a quick way to
+  check if the columns haven't been modified since they were copied.
+  */
+inline bool cwShotColumns::isSharedWith(const cwShotColumns& other) const {
+    return Data.constData() == other.Data.constData();
+}
+
+#endif // CWSHOTCOLUMNS_H
@@ -0,0 +1,170 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwStationColumns.h"
+#include "cwStationNameTable.h"
+
+cwStationColumns::cwStationColumns() :
+    Data(new PrivateData())
+{
+}
+
+/**
+ * @brief cwStationColumns::reserve
+ * Reserves space for size stations in each column
+ */
+void cwStationColumns::reserve(int size)
+{
+    Data->Names.reserve(size);
+    Data->NameIds.reserve(size);
+    Data->Left.reserve(size);
+    Data->Right.reserve(size);
+    Data->Up.reserve(size);
+    Data->Down.reserve(size);
+    Data->States.reserve(size);
+}
+
+/**
+ * @brief cwStationColumns::clear
+ * Removes all the stations
+ */
+void cwStationColumns::clear()
+{
+    Data->Names.clear();
+    Data->NameIds.clear();
+    Data->Left.clear();
+    Data->Right.clear();
+    Data->Up.clear();
+    Data->Down.clear();
+    Data->States.clear();
+}
+
+/**
+ * @brief cwStationColumns::at
+ * @return A copy of the station at index. Changing the station doesn't change the columns, use
+ * replace() to do that.
+ */
+cwStation cwStationColumns::at(int index) const
+{
+    cwStation station;
+    cwStation::PrivateData* stationData = station.Data.data();
+    stationData->Name = Data->Names.at(index);
+    stationData->Left = Data->Left.at(index);
+    stationData->Right = Data->Right.at(index);
+    stationData->Up = Data->Up.at(index);
+    stationData->Down = Data->Down.at(index);
+    stationData->LeftState = leftState(index);
+    stationData->RightState = rightState(index);
+    stationData->UpState = upState(index);
+    stationData->DownState = downState(index);
+    return station;
+}
+
+/**
+ * @brief cwStationColumns::append
+ * Adds station to the end of the columns
+ */
+void cwStationColumns::append(const cwStation &station)
+{
+    insert(size(), station);
+}
+
+/**
+ * @brief cwStationColumns::insert
+ * Inserts station at index. Index must be between 0 and size()
+ */
+void cwStationColumns::insert(int index, const cwStation &station)
+{
+    Q_ASSERT(index >= 0 && index <= size());
+    Data->Names.insert(index, QString());
+    Data->NameIds.insert(index, -1);
+    Data->Left.insert(index, 0.0);
+    Data->Right.insert(index, 0.0);
+    Data->Up.insert(index, 0.0);
+    Data->Down.insert(index, 0.0);
+    Data->States.insert(index, 0);
+    set(index, station);
+}
+
+/**
+ * @brief cwStationColumns::replace
+ * Replaces the station at index with station
+ */
+void cwStationColumns::replace(int index, const cwStation &station)
+{
+    Q_ASSERT(index >= 0 && index < size());
+    set(index, station);
+}
+
+/**
+ * @brief cwStationColumns::removeAt
+ * Removes the station at index
+ */
+void cwStationColumns::removeAt(int index)
+{
+    remove(index, 1);
+}
+
+/**
+ * @brief cwStationColumns::remove
+ * Removes count stations, starting at index
+ */
+void cwStationColumns::remove(int index, int count)
+{
+    Q_ASSERT(index >= 0 && count >= 0 && index + count <= size());
+    Data->Names.remove(index, count);
+    Data->NameIds.remove(index, count);
+    Data->Left.remove(index, count);
+    Data->Right.remove(index, count);
+    Data->Up.remove(index, count);
+    Data->Down.remove(index, count);
+    Data->States.remove(index, count);
+}
+
+/**
+ * @brief cwStationColumns::toList
+ * @return All the stations as a list of cwStation
+ */
+QList<cwStation> cwStationColumns::toList() const
+{
+    QList<cwStation> stations;
+    stations.reserve(size());
+    for(int i = 0; i < size(); i++) {
+        stations.append(at(i));
+    }
+    return stations;
+}
+
+/**
+ * @brief cwStationColumns::packStates
+ * @return The station's LRUD states as StateBit flags
+ */
+quint8 cwStationColumns::packStates(const cwStation &station)
+{
+    quint8 states = 0;
+    if(station.leftInputState() == cwDistanceStates::Empty) { states |= LeftEmpty; }
+    if(station.rightInputState() == cwDistanceStates::Empty) { states |= RightEmpty; }
+    if(station.upInputState() == cwDistanceStates::Empty) { states |= UpEmpty; }
+    if(station.downInputState() == cwDistanceStates::Empty) { states |= DownEmpty; }
+    return states;
+}
+
+/**
+ * @brief cwStationColumns::set
+ * Copies station's data into the columns at index
+ */
+void cwStationColumns::set(int index, const cwStation &station)
+{
+    Data->Names[index] = station.name();
+    Data->NameIds[index] = cwStationNameTable::instance()->intern(station.name());
+    Data->Left[index] = station.left();
+    Data->Right[index] = station.right();
+    Data->Up[index] = station.up();
+    Data->Down[index] = station.down();
+    Data->States[index] = packStates(station);
+}
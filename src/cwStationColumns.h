@@ -0,0 +1,179 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWSTATIONCOLUMNS_H
+#define CWSTATIONCOLUMNS_H
+
+//Our includes
+#include "cwStation.h"
+#include "cwReadingStates.h"
+#include "cwGlobals.h"
+
+//Qt includes
+#include <QSharedDataPointer>
+#include <QString>
+#include <QVector>
+#include <QList>
+
+/**
+ * @brief The cwStationColumns class
+ *
+ * Stores a list of stations as columns, instead of a list of cwStation. Each LRUD reading is in
+ * its own contiguous array of doubles, the reading states are packed into a byte per station, and
+ * each station name is also stored as its cwStationNameTable id. Scanning a column doesn't chase a
+ * pointer per station, and doesn't allocate.
+ *
+ * The interface mirrors QList<cwStation>, at() returns a cwStation that's a copy of the
+ * station's data. Use the column accessors, like name() and left(), when only one value is
+ * needed.
+ *
+ * This class is implicitly shared.
+ */
+class CAVEWHERE_LIB_EXPORT cwStationColumns
+{
+public:
+    cwStationColumns();
+
+    int size() const;
+    int count() const { return size(); }
+    bool isEmpty() const;
+    bool empty() const { return isEmpty(); }
+
+    void reserve(int size);
+    void clear();
+
+    cwStation at(int index) const;
+    cwStation operator[](int index) const { return at(index); }
+    cwStation first() const { return at(0); }
+    cwStation last() const { return at(size() - 1); }
+
+    void append(const cwStation& station);
+    void insert(int index, const cwStation& station);
+    void replace(int index, const cwStation& station);
+    void removeAt(int index);
+    void remove(int index, int count);
+
+    QList<cwStation> toList() const;
+
+    QString name(int index) const;
+    int nameId(int index) const;
+    double left(int index) const;
+    double right(int index) const;
+    double up(int index) const;
+    double down(int index) const;
+
+    cwDistanceStates::State leftState(int index) const;
+    cwDistanceStates::State rightState(int index) const;
+    cwDistanceStates::State upState(int index) const;
+    cwDistanceStates::State downState(int index) const;
+
+    bool isStationEmpty(int index) const;
+
+    bool isSharedWith(const cwStationColumns& other) const;
+
+private:
+    //Bits in States, a bit is set when the reading is empty
+    enum StateBit {
+        LeftEmpty = 0x1,
+        RightEmpty = 0x2,
+        UpEmpty = 0x4,
+        DownEmpty = 0x8
+    };
+
+    class PrivateData : public QSharedData {
+    public:
+        QVector<QString> Names;
+        QVector<int> NameIds; //From cwStationNameTable, -1 for empty names
+        QVector<double> Left;
+        QVector<double> Right;
+        QVector<double> Up;
+        QVector<double> Down;
+        QVector<quint8> States; //StateBit flags
+    };
+
+    QSharedDataPointer<PrivateData> Data;
+
+    static quint8 packStates(const cwStation& station);
+    cwDistanceStates::State state(int index, StateBit bit) const;
+    void set(int index, const cwStation& station);
+};
+
+inline int cwStationColumns::size() const {
+    return Data->NameIds.size();
+}
+
+inline bool cwStationColumns::isEmpty() const {
+    return Data->NameIds.isEmpty();
+}
+
+inline QString cwStationColumns::name(int index) const {
+    return Data->Names.at(index);
+}
+
+/**
+ * @brief cwStationColumns::nameId
+ * @return The station's name id from cwStationNameTable, or -1 if the station doesn't have a name.
+ * Two stations have the same id, if their names are the same, ignoring case.
+ */
+inline int cwStationColumns::nameId(int index) const {
+    return Data->NameIds.at(index);
+}
+
+inline double cwStationColumns::left(int index) const {
+    return Data->Left.at(index);
+}
+
+inline double cwStationColumns::right(int index) const {
+    return Data->Right.at(index);
+}
+
+inline double cwStationColumns::up(int index) const {
+    return Data->Up.at(index);
+}
+
+inline double cwStationColumns::down(int index) const {
+    return Data->Down.at(index);
+}
+
+inline cwDistanceStates::State cwStationColumns::state(int index, StateBit bit) const {
+    return Data->States.at(index) & bit ? cwDistanceStates::Empty : cwDistanceStates::Valid;
+}
+
+inline cwDistanceStates::State cwStationColumns::leftState(int index) const {
+    return state(index, LeftEmpty);
+}
+
+inline cwDistanceStates::State cwStationColumns::rightState(int index) const {
+    return state(index, RightEmpty);
+}
+
+inline cwDistanceStates::State cwStationColumns::upState(int index) const {
+    return state(index, UpEmpty);
+}
+
+inline cwDistanceStates::State cwStationColumns::downState(int index) const {
+    return state(index, DownEmpty);
+}
+
+/**
+ * @brief cwStationColumns::isStationEmpty
+ * @return True if the station at index doesn't have a name or any LRUD data
+ */
+inline bool cwStationColumns::isStationEmpty(int index) const {
+    const quint8 allEmpty = LeftEmpty | RightEmpty | UpEmpty | DownEmpty;
+    return Data->NameIds.at(index) < 0 && Data->States.at(index) == allEmpty;
+}
+
+/**
+  Returns true if other is an implicitly shared copy of these columns. This is a quick way to
+  check if the columns haven't been modified since they were copied.
+  */
+inline bool cwStationColumns::isSharedWith(const cwStationColumns& other) const {
+    return Data.constData() == other.Data.constData();
+}
+
+#endif // CWSTATIONCOLUMNS_H
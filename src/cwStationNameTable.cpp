@@ -0,0 +1,139 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwStationNameTable.h"
+
+//Qt includes
+#include <QChar>
+#include <QReadLocker>
+#include <QWriteLocker>
+
+cwStationNameTable::cwStationNameTable()
+{
+}
+
+/**
+ * @brief cwStationNameTable::instance
+ * @return The singleton instance of this class
+ */
+cwStationNameTable *cwStationNameTable::instance()
+{
+    static cwStationNameTable table;
+    return &table;
+}
+
+/**
+ * @brief cwStationNameTable::intern
+ * @param stationName - The name of the station
+ * @return The id of stationName. If stationName hasn't been interned yet, it's added to the
+ * table. Returns -1 if stationName is empty.
+ */
+int cwStationNameTable::intern(const QString &stationName)
+{
+    int id = find(stationName);
+    if(id >= 0 || stationName.isEmpty()) {
+        return id;
+    }
+
+    QWriteLocker locker(&Lock);
+
+    //Another thread may have added the name, while we didn't have the lock
+    QHash<Key, int>::const_iterator iter = NameToId.constFind(Key(stationName));
+    if(iter != NameToId.constEnd()) {
+        return iter.value();
+    }
+
+    id = Names.size();
+    QString lowerName = stationName.toLower();
+    Names.append(lowerName);
+    NameToId.insert(Key(lowerName), id);
+    return id;
+}
+
+/**
+ * @brief cwStationNameTable::find
+ * @param stationName - The name of the station
+ * @return The id of stationName, or -1 if stationName hasn't been interned
+ */
+int cwStationNameTable::find(const QString &stationName) const
+{
+    QReadLocker locker(&Lock);
+    return NameToId.value(Key(stationName), -1);
+}
+
+/**
+ * @brief cwStationNameTable::name
+ * @param id - The id returned from intern()
+ * @return The lower case name of the station, or an empty string if id is invalid
+ */
+QString cwStationNameTable::name(int id) const
+{
+    QReadLocker locker(&Lock);
+    return Names.value(id);
+}
+
+/**
+ * @brief cwStationNameTable::count
+ * @return The number of station names in the table. All ids are less than count()
+ */
+int cwStationNameTable::count() const
+{
+    QReadLocker locker(&Lock);
+    return Names.size();
+}
+
+/**
+ * @brief cwStationNameTable::toLower
+ * @return The lower case character, this doesn't allocate
+ */
+ushort cwStationNameTable::toLower(ushort character)
+{
+    if(character < 128) {
+        if(character >= 'A' && character <= 'Z') {
+            return character + ('a' - 'A');
+        }
+        return character;
+    }
+    return QChar::toLower(character);
+}
+
+/**
+ * @brief cwStationNameTable::Key::operator ==
+ * @return True if the names are the same, ignoring case
+ */
+bool cwStationNameTable::Key::operator==(const cwStationNameTable::Key &other) const
+{
+    if(Name.size() != other.Name.size()) {
+        return false;
+    }
+
+    const QChar* data = Name.constData();
+    const QChar* otherData = other.Name.constData();
+    for(int i = 0; i < Name.size(); i++) {
+        ushort character = data[i].unicode();
+        ushort otherCharacter = otherData[i].unicode();
+        if(character != otherCharacter && toLower(character) != toLower(otherCharacter)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief cwStationNameTable::Key::hash
+ * @return The hash of the lower case name
+ */
+uint cwStationNameTable::Key::hash(uint seed) const
+{
+    uint hash = seed;
+    const QChar* data = Name.constData();
+    for(int i = 0; i < Name.size(); i++) {
+        hash = 31 * hash + toLower(data[i].unicode());
+    }
+    return hash;
+}
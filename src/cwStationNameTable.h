@@ -0,0 +1,74 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWSTATIONNAMETABLE_H
+#define CWSTATIONNAMETABLE_H
+
+//Our includes
+#include "cwGlobals.h"
+
+//Qt includes
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QReadWriteLock>
+
+/**
+ * @brief The cwStationNameTable class
+ *
+ * This is a singleton class. To use the class use cwStationNameTable::instance()
+ *
+ * The table interns station names and gives each unique name an integer id. Station names are
+ * case insensitive, the name is converted to lower case once, when it's first interned. Ids
+ * are never removed, so they're stable for the life of the application and can be shared
+ * between caves and threads.
+ *
+ * Looking up a name doesn't allocate, the name is hashed and compared case insensitively.
+ *
+ * This class is thread safe.
+ */
+class CAVEWHERE_LIB_EXPORT cwStationNameTable
+{
+public:
+    static cwStationNameTable* instance();
+
+    int intern(const QString& stationName);
+    int find(const QString& stationName) const;
+    QString name(int id) const;
+    int count() const;
+
+private:
+    /**
+     * Wraps a station name so it's hashed and compared case insensitively
+     */
+    class Key {
+    public:
+        Key() {}
+        Key(const QString& name) : Name(name) {}
+
+        bool operator==(const Key& other) const;
+
+        friend uint qHash(const Key& key, uint seed = 0) {
+            return key.hash(seed);
+        }
+
+        QString Name;
+
+    private:
+        uint hash(uint seed) const;
+    };
+
+    mutable QReadWriteLock Lock;
+    QHash<Key, int> NameToId;
+    QVector<QString> Names; //Lower case, indexed by id
+
+    cwStationNameTable();
+
+    static ushort toLower(ushort character);
+};
+
+#endif // CWSTATIONNAMETABLE_H
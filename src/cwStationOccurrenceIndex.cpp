@@ -0,0 +1,418 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwStationOccurrenceIndex.h"
+#include "cwStationNameTable.h"
+#include "cwCave.h"
+#include "cwTrip.h"
+#include "cwSurveyNoteModel.h"
+#include "cwNote.h"
+#include "cwScrap.h"
+#include "cwNoteStation.h"
+
+cwStationOccurrenceIndex::cwStationOccurrenceIndex(cwCave *cave) :
+    QObject(cave),
+    Cave(cave),
+    Dirty(true)
+{
+    connect(Cave, &cwCave::insertedTrips, this, &cwStationOccurrenceIndex::invalidate);
+    connect(Cave, &cwCave::removedTrips, this, &cwStationOccurrenceIndex::invalidate);
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::chunkOccurrences
+ * @return All the places where stationName is in the cave's survey chunks
+ */
+QList<cwStationOccurrenceIndex::ChunkOccurrence> cwStationOccurrenceIndex::chunkOccurrences(const QString &stationName) const
+{
+    ensureIndexed();
+    int id = cwStationNameTable::instance()->find(stationName);
+    return ChunkOccurrences.value(id).toList();
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::scrapOccurrences
+ * @return All the places where stationName is in the cave's scraps
+ */
+QList<cwStationOccurrenceIndex::ScrapOccurrence> cwStationOccurrenceIndex::scrapOccurrences(const QString &stationName) const
+{
+    ensureIndexed();
+    int id = cwStationNameTable::instance()->find(stationName);
+    return ScrapOccurrences.value(id).toList();
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::hasStation
+ * @param trip - If not null, only stations in trip are considered
+ * @return True if stationName is in a survey chunk
+ */
+bool cwStationOccurrenceIndex::hasStation(const QString &stationName, const cwTrip *trip) const
+{
+    ensureIndexed();
+    int id = cwStationNameTable::instance()->find(stationName);
+
+    QHash<int, QVector<ChunkOccurrence> >::const_iterator iter = ChunkOccurrences.constFind(id);
+    if(iter == ChunkOccurrences.constEnd()) {
+        return false;
+    }
+
+    if(trip == nullptr) {
+        return true;
+    }
+
+    foreach(const ChunkOccurrence& occurrence, iter.value()) {
+        if(occurrence.Chunk->parentTrip() == trip) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::neighboringStations
+ * @param trip - If not null, only neighbors in trip are returned
+ * @return The stations that are connected to stationName by a shot
+ */
+QSet<cwStation> cwStationOccurrenceIndex::neighboringStations(const QString &stationName, const cwTrip *trip) const
+{
+    ensureIndexed();
+    int id = cwStationNameTable::instance()->find(stationName);
+
+    QSet<cwStation> neighbors;
+    foreach(const ChunkOccurrence& occurrence, ChunkOccurrences.value(id)) {
+        if(trip != nullptr && occurrence.Chunk->parentTrip() != trip) {
+            continue;
+        }
+
+        cwStation previousStation = occurrence.Chunk->station(occurrence.StationIndex - 1);
+        cwStation nextStation = occurrence.Chunk->station(occurrence.StationIndex + 1);
+
+        if(previousStation.isValid()) { neighbors.insert(previousStation); }
+        if(nextStation.isValid()) { neighbors.insert(nextStation); }
+    }
+
+    return neighbors;
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::trips
+ * @return All the trips that have stationName in their survey chunks
+ */
+QList<cwTrip *> cwStationOccurrenceIndex::trips(const QString &stationName) const
+{
+    ensureIndexed();
+    int id = cwStationNameTable::instance()->find(stationName);
+
+    QList<cwTrip*> trips;
+    foreach(const ChunkOccurrence& occurrence, ChunkOccurrences.value(id)) {
+        cwTrip* trip = occurrence.Chunk->parentTrip();
+        if(!trips.contains(trip)) {
+            trips.append(trip);
+        }
+    }
+    return trips;
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::scraps
+ * @return All the scraps that have a note station named stationName
+ */
+QList<cwScrap *> cwStationOccurrenceIndex::scraps(const QString &stationName) const
+{
+    ensureIndexed();
+    int id = cwStationNameTable::instance()->find(stationName);
+
+    QList<cwScrap*> scraps;
+    foreach(const ScrapOccurrence& occurrence, ScrapOccurrences.value(id)) {
+        if(!scraps.contains(occurrence.Scrap)) {
+            scraps.append(occurrence.Scrap);
+        }
+    }
+    return scraps;
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::stationNames
+ * @return The lower case names of all the stations in the cave's survey chunks. This is useful
+ * for station name completion.
+ */
+QStringList cwStationOccurrenceIndex::stationNames() const
+{
+    ensureIndexed();
+
+    cwStationNameTable* table = cwStationNameTable::instance();
+
+    QStringList names;
+    names.reserve(ChunkOccurrences.size());
+    for(auto iter = ChunkOccurrences.constBegin(); iter != ChunkOccurrences.constEnd(); ++iter) {
+        names.append(table->name(iter.key()));
+    }
+    return names;
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::invalidate
+ *
+ * Rebuilds the index the next time it's queried. This is called when trips, chunks, notes, or
+ * scraps are added or removed.
+ */
+void cwStationOccurrenceIndex::invalidate()
+{
+    Dirty = true;
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::reindexChunk
+ *
+ * Called when stations are added or removed from a chunk
+ */
+void cwStationOccurrenceIndex::reindexChunk()
+{
+    cwSurveyChunk* chunk = static_cast<cwSurveyChunk*>(sender());
+    if(Dirty || !ChunkStationIds.contains(chunk)) {
+        return;
+    }
+
+    unindexChunk(chunk);
+    indexChunk(chunk);
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::chunkDataChanged
+ *
+ * Only station names are indexed, so other data changes are ignored
+ */
+void cwStationOccurrenceIndex::chunkDataChanged(cwSurveyChunk::DataRole role, int index)
+{
+    Q_UNUSED(index);
+    if(role == cwSurveyChunk::StationNameRole) {
+        reindexChunk();
+    }
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::reindexScrap
+ *
+ * Called when a scrap's note stations are added, removed, or renamed
+ */
+void cwStationOccurrenceIndex::reindexScrap()
+{
+    cwScrap* scrap = static_cast<cwScrap*>(sender());
+    if(Dirty || !ScrapStationIds.contains(scrap)) {
+        return;
+    }
+
+    unindexScrap(scrap);
+    indexScrap(scrap);
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::ensureIndexed
+ *
+ * Rebuilds the index, if it has been invalidated
+ */
+void cwStationOccurrenceIndex::ensureIndexed() const
+{
+    if(Dirty) {
+        const_cast<cwStationOccurrenceIndex*>(this)->rebuild();
+    }
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::rebuild
+ *
+ * Indexes all the chunks and scraps in the cave, and listens to them for changes
+ */
+void cwStationOccurrenceIndex::rebuild()
+{
+    disconnectAll();
+    ChunkOccurrences.clear();
+    ScrapOccurrences.clear();
+    ChunkStationIds.clear();
+    ScrapStationIds.clear();
+
+    foreach(cwTrip* trip, Cave->trips()) {
+        connectTo(trip);
+
+        foreach(cwSurveyChunk* chunk, trip->chunks()) {
+            connectTo(chunk);
+            indexChunk(chunk);
+        }
+
+        foreach(cwNote* note, trip->notes()->notes()) {
+            ConnectedObjects.append(note);
+            connect(note, &cwNote::insertedScraps, this, &cwStationOccurrenceIndex::invalidate);
+            connect(note, &cwNote::removedScraps, this, &cwStationOccurrenceIndex::invalidate);
+            connect(note, &cwNote::scrapsReset, this, &cwStationOccurrenceIndex::invalidate);
+
+            foreach(cwScrap* scrap, note->scraps()) {
+                connectTo(scrap);
+                indexScrap(scrap);
+            }
+        }
+    }
+
+    Dirty = false;
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::connectTo
+ *
+ * Invalidates the index when the trip's chunks or notes are added or removed
+ */
+void cwStationOccurrenceIndex::connectTo(cwTrip *trip)
+{
+    ConnectedObjects.append(trip);
+    connect(trip, &cwTrip::chunksInserted, this, &cwStationOccurrenceIndex::invalidate);
+    connect(trip, &cwTrip::chunksRemoved, this, &cwStationOccurrenceIndex::invalidate);
+    connect(trip, &cwTrip::parentCaveChanged, this, &cwStationOccurrenceIndex::invalidate);
+
+    cwSurveyNoteModel* notes = trip->notes();
+    ConnectedObjects.append(notes);
+    connect(notes, &cwSurveyNoteModel::rowsInserted, this, &cwStationOccurrenceIndex::invalidate);
+    connect(notes, &cwSurveyNoteModel::rowsRemoved, this, &cwStationOccurrenceIndex::invalidate);
+    connect(notes, &cwSurveyNoteModel::modelReset, this, &cwStationOccurrenceIndex::invalidate);
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::connectTo
+ *
+ * Reindexes the chunk when its stations change
+ */
+void cwStationOccurrenceIndex::connectTo(cwSurveyChunk *chunk)
+{
+    ConnectedObjects.append(chunk);
+    connect(chunk, &cwSurveyChunk::stationsAdded, this, &cwStationOccurrenceIndex::reindexChunk);
+    connect(chunk, &cwSurveyChunk::stationsRemoved, this, &cwStationOccurrenceIndex::reindexChunk);
+    connect(chunk, &cwSurveyChunk::dataChanged, this, &cwStationOccurrenceIndex::chunkDataChanged);
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::connectTo
+ *
+ * Reindexes the scrap when its note stations change
+ */
+void cwStationOccurrenceIndex::connectTo(cwScrap *scrap)
+{
+    ConnectedObjects.append(scrap);
+    connect(scrap, &cwScrap::stationAdded, this, &cwStationOccurrenceIndex::reindexScrap);
+    connect(scrap, &cwScrap::stationNameChanged, this, &cwStationOccurrenceIndex::reindexScrap);
+    connect(scrap, &cwScrap::stationRemoved, this, &cwStationOccurrenceIndex::reindexScrap);
+    connect(scrap, &cwScrap::stationsReset, this, &cwStationOccurrenceIndex::reindexScrap);
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::disconnectAll
+ *
+ * Disconnects from all the trips, notes, chunks, and scraps that are still alive
+ */
+void cwStationOccurrenceIndex::disconnectAll()
+{
+    foreach(const QPointer<QObject>& object, ConnectedObjects) {
+        if(!object.isNull()) {
+            disconnect(object.data(), nullptr, this, nullptr);
+        }
+    }
+    ConnectedObjects.clear();
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::indexChunk
+ *
+ * Adds all the chunk's stations to the index
+ */
+void cwStationOccurrenceIndex::indexChunk(cwSurveyChunk *chunk)
+{
+    const cwStationColumns& stations = chunk->stationColumns();
+    QVector<int> stationIds;
+    stationIds.reserve(stations.size());
+
+    for(int i = 0; i < stations.size(); i++) {
+        int id = stations.nameId(i);
+        stationIds.append(id);
+        if(id >= 0) {
+            ChunkOccurrences[id].append(ChunkOccurrence(chunk, i));
+        }
+    }
+
+    ChunkStationIds.insert(chunk, stationIds);
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::unindexChunk
+ *
+ * Removes all the chunk's stations from the index
+ */
+void cwStationOccurrenceIndex::unindexChunk(cwSurveyChunk *chunk)
+{
+    removeOccurrences(ChunkOccurrences, ChunkStationIds.take(chunk), chunk, &ChunkOccurrence::Chunk);
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::indexScrap
+ *
+ * Adds all the scrap's note stations to the index
+ */
+void cwStationOccurrenceIndex::indexScrap(cwScrap *scrap)
+{
+    cwStationNameTable* table = cwStationNameTable::instance();
+
+    QList<cwNoteStation> stations = scrap->stations();
+    QVector<int> stationIds;
+    stationIds.reserve(stations.size());
+
+    for(int i = 0; i < stations.size(); i++) {
+        int id = table->intern(stations.at(i).name());
+        stationIds.append(id);
+        if(id >= 0) {
+            ScrapOccurrences[id].append(ScrapOccurrence(scrap, i));
+        }
+    }
+
+    ScrapStationIds.insert(scrap, stationIds);
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::unindexScrap
+ *
+ * Removes all the scrap's note stations from the index
+ */
+void cwStationOccurrenceIndex::unindexScrap(cwScrap *scrap)
+{
+    removeOccurrences(ScrapOccurrences, ScrapStationIds.take(scrap), scrap, &ScrapOccurrence::Scrap);
+}
+
+/**
+ * @brief cwStationOccurrenceIndex::removeOccurrences
+ *
+ * Removes all the occurrences of object, from the stations in stationIds
+ */
+template<typename T, typename Occurrence>
+void cwStationOccurrenceIndex::removeOccurrences(QHash<int, QVector<Occurrence> > &occurrences,
+                                                 const QVector<int> &stationIds,
+                                                 T *object,
+                                                 T *Occurrence::*member)
+{
+    foreach(int id, stationIds) {
+        typename QHash<int, QVector<Occurrence> >::iterator iter = occurrences.find(id);
+        if(iter == occurrences.end()) {
+            continue;
+        }
+
+        QVector<Occurrence>& list = iter.value();
+        for(int i = list.size() - 1; i >= 0; i--) {
+            if(list.at(i).*member == object) {
+                list.remove(i);
+            }
+        }
+
+        if(list.isEmpty()) {
+            occurrences.erase(iter);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWSTATIONOCCURRENCEINDEX_H
+#define CWSTATIONOCCURRENCEINDEX_H
+
+//Our includes
+#include "cwGlobals.h"
+#include "cwStation.h"
+#include "cwSurveyChunk.h"
+class cwCave;
+class cwTrip;
+class cwScrap;
+
+//Qt includes
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QList>
+#include <QSet>
+#include <QPointer>
+#include <QStringList>
+
+/**
+ * @brief The cwStationOccurrenceIndex class
+ *
+ * Indexes where each station appears in a cave, in the survey chunks (and so the trips and
+ * shots), and in the scraps' note stations. Stations are keyed by their cwStationNameTable id,
+ * so lookups are case insensitive and don't compare strings.
+ *
+ * The index is kept up to date incrementally. When a station is edited in a chunk or a scrap, only
+ * that chunk or scrap is reindexed. When trips, chunks, notes, or scraps are added or removed, the
+ * index is rebuilt the next time it's queried.
+ *
+ * The index is owned by the cwCave, and must only be used on the cave's thread.
+ */
+class CAVEWHERE_LIB_EXPORT cwStationOccurrenceIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * A station in a survey chunk. The station's shots are at StationIndex - 1 and StationIndex.
+     */
+    class ChunkOccurrence {
+    public:
+        ChunkOccurrence() : Chunk(nullptr), StationIndex(-1) {}
+        ChunkOccurrence(cwSurveyChunk* chunk, int stationIndex) : Chunk(chunk), StationIndex(stationIndex) {}
+
+        cwSurveyChunk* Chunk;
+        int StationIndex;
+    };
+
+    /**
+     * A note station in a scrap
+     */
+    class ScrapOccurrence {
+    public:
+        ScrapOccurrence() : Scrap(nullptr), NoteStationIndex(-1) {}
+        ScrapOccurrence(cwScrap* scrap, int noteStationIndex) : Scrap(scrap), NoteStationIndex(noteStationIndex) {}
+
+        cwScrap* Scrap;
+        int NoteStationIndex;
+    };
+
+    explicit cwStationOccurrenceIndex(cwCave* cave);
+
+    QList<ChunkOccurrence> chunkOccurrences(const QString& stationName) const;
+    QList<ScrapOccurrence> scrapOccurrences(const QString& stationName) const;
+
+    bool hasStation(const QString& stationName, const cwTrip* trip = nullptr) const;
+    QSet<cwStation> neighboringStations(const QString& stationName, const cwTrip* trip = nullptr) const;
+    QList<cwTrip*> trips(const QString& stationName) const;
+    QList<cwScrap*> scraps(const QString& stationName) const;
+    QStringList stationNames() const;
+
+public slots:
+    void invalidate();
+
+private slots:
+    void reindexChunk();
+    void chunkDataChanged(cwSurveyChunk::DataRole role, int index);
+    void reindexScrap();
+
+private:
+    cwCave* Cave;
+
+    //Rebuilt by rebuild(), when Dirty is true
+    mutable bool Dirty;
+    mutable QHash<int, QVector<ChunkOccurrence> > ChunkOccurrences; //Station id to occurrences
+    mutable QHash<int, QVector<ScrapOccurrence> > ScrapOccurrences; //Station id to occurrences
+    mutable QHash<cwSurveyChunk*, QVector<int> > ChunkStationIds; //Station ids indexed for each chunk
+    mutable QHash<cwScrap*, QVector<int> > ScrapStationIds; //Station ids indexed for each scrap
+    mutable QList<QPointer<QObject> > ConnectedObjects;
+
+    void ensureIndexed() const;
+    void rebuild();
+    void connectTo(cwTrip* trip);
+    void connectTo(cwSurveyChunk* chunk);
+    void connectTo(cwScrap* scrap);
+    void disconnectAll();
+
+    void indexChunk(cwSurveyChunk* chunk);
+    void unindexChunk(cwSurveyChunk* chunk);
+    void indexScrap(cwScrap* scrap);
+    void unindexScrap(cwScrap* scrap);
+
+    template<typename T, typename Occurrence>
+    static void removeOccurrences(QHash<int, QVector<Occurrence> >& occurrences,
+                                  const QVector<int>& stationIds,
+                                  T* object,
+                                  T* Occurrence::*member);
+};
+
+#endif // CWSTATIONOCCURRENCEINDEX_H
@@ -5,9 +5,83 @@
 **
 **************************************************************************/
 
+//Our includes
 #include "cwStationPositionLookup.h"
 
-cwStationPositionLookup::cwStationPositionLookup()
+//Std includes
+#include <algorithm>
+
+cwStationPositionLookup::cwStationPositionLookup() :
+    Data(new PrivateData)
 {
 }
 
+/**
+  Sets the position of the station.  If the station already exists, this will
+  overwrite the position of the existing station. Invalid ids are ignored.
+  */
+void cwStationPositionLookup::setPosition(int stationId, const QVector3D &stationPosition)
+{
+    if(stationId < 0) {
+        return;
+    }
+
+    int index = Data->Indexes.value(stationId, -1);
+    if(index < 0) {
+        Data->Indexes.insert(stationId, Data->Ids.size());
+        Data->Ids.append(stationId);
+        Data->Positions.append(stationPosition);
+    } else {
+        Data->Positions[index] = stationPosition;
+    }
+}
+
+/**
+  Removes the station's position. If the station doesn't exist, this does nothing
+
+  The last station is moved into the removed station's place, so the arrays stay dense.
+  */
+void cwStationPositionLookup::removePosition(int stationId)
+{
+    int index = Data->Indexes.value(stationId, -1);
+    if(index < 0) {
+        return;
+    }
+
+    int last = Data->Ids.size() - 1;
+    if(index != last) {
+        int lastId = Data->Ids.at(last);
+        Data->Ids[index] = lastId;
+        Data->Positions[index] = Data->Positions.at(last);
+        Data->Indexes[lastId] = index;
+    }
+
+    Data->Ids.removeLast();
+    Data->Positions.removeLast();
+    Data->Indexes.remove(stationId);
+}
+
+/**
+  Returns the ids of all the stations that have a position, in increasing order
+  */
+QVector<int> cwStationPositionLookup::stationIds() const
+{
+    QVector<int> ids = Data->Ids;
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+/**
+  Gets all the positions in the model, the keys are the lower case station names
+
+  This builds a new map, prefer stationIds() and position() in tight loops.
+  */
+QMap<QString, QVector3D> cwStationPositionLookup::positions() const
+{
+    QMap<QString, QVector3D> positions;
+    cwStationNameTable* table = cwStationNameTable::instance();
+    foreach(int id, stationIds()) {
+        positions.insert(table->name(id), position(id));
+    }
+    return positions;
+}
@@ -12,34 +12,82 @@
 #include <QVector3D>
 #include <QString>
 #include <QMap>
+#include <QHash>
+#include <QVector>
+#include <QSharedData>
 
 //Our includes
 #include "cwGlobals.h"
+#include "cwStationNameTable.h"
 
 /**
   The station position model holds the position of all the stations
   in a cave.
+
+  Positions are stored in a dense array, with one entry per station in the cave. A hash maps
+  the station's id in cwStationNameTable to its entry, so the lookup's size depends only on
+  the cave, not on how many names have been interned. The functions that take a station name are adapters that look up
+  the station's id, they don't allocate. Use the id functions in tight loops, to skip the
+  name lookup.
+
+  This class is implicitly shared.
   */
 class CAVEWHERE_LIB_EXPORT cwStationPositionLookup {
 public:
     cwStationPositionLookup();
 
     void clearStations();
+
+    void setPosition(int stationId, const QVector3D& stationPosition);
+    void removePosition(int stationId);
+    QVector3D position(int stationId) const;
+    bool hasPosition(int stationId) const;
+
     void setPosition(const QString& stationName, const QVector3D& stationPosition);
+    void removePosition(const QString& stationName);
     QVector3D position(const QString& stationName) const;
-    bool hasPosition(QString stationName) const;
+    bool hasPosition(const QString& stationName) const;
 
+    int count() const;
+    QVector<int> stationIds() const;
     QMap<QString, QVector3D> positions() const;
 
+    bool isSharedWith(const cwStationPositionLookup& other) const;
+
 private:
-    QMap<QString, QVector3D> StationPositions;
+    class PrivateData : public QSharedData {
+    public:
+        QHash<int, int> Indexes; //Station id to the index in Ids and Positions
+        QVector<int> Ids;
+        QVector<QVector3D> Positions;
+    };
+
+    QSharedDataPointer<PrivateData> Data;
 };
 
 /**
   Clears all the station of there data
   */
 inline void cwStationPositionLookup::clearStations() {
-    StationPositions.clear();
+    Data->Indexes.clear();
+    Data->Ids.clear();
+    Data->Positions.clear();
+}
+
+/**
+  Get's the station position with stationId.  If stationId doesn't exist, this
+  will return QVector3D()
+  */
+inline QVector3D cwStationPositionLookup::position(int stationId) const {
+    int index = Data->Indexes.value(stationId, -1);
+    return index >= 0 ? Data->Positions.at(index) : QVector3D();
+}
+
+/**
+  Checks if the station position model has the position
+  */
+inline bool cwStationPositionLookup::hasPosition(int stationId) const {
+    return Data->Indexes.contains(stationId);
 }
 
 /**
@@ -47,7 +95,14 @@ inline void cwStationPositionLookup::clearStations() {
   overwrite the position of the existing station
   */
 inline void cwStationPositionLookup::setPosition(const QString& stationName, const QVector3D& stationPosition) {
-    StationPositions[stationName.toLower()] = stationPosition;
+    setPosition(cwStationNameTable::instance()->intern(stationName), stationPosition);
+}
+
+/**
+  Removes the station's position. If the station doesn't exist, this does nothing
+  */
+inline void cwStationPositionLookup::removePosition(const QString& stationName) {
+    removePosition(cwStationNameTable::instance()->find(stationName));
 }
 
 /**
@@ -55,23 +110,30 @@ inline void cwStationPositionLookup::setPosition(const QString& stationName, con
   will return QVector3D()
   */
 inline QVector3D cwStationPositionLookup::position(const QString& stationName) const {
-    return StationPositions.value(stationName.toLower(), QVector3D());
+    return position(cwStationNameTable::instance()->find(stationName));
 }
 
 /**
   Checks if the station position model has the position
   */
-inline bool cwStationPositionLookup::hasPosition(QString stationName) const {
-    return StationPositions.contains(stationName.toLower());
+inline bool cwStationPositionLookup::hasPosition(const QString& stationName) const {
+    return hasPosition(cwStationNameTable::instance()->find(stationName));
 }
 
 /**
-  Gets all the positions in the model
+  Returns the number of stations that have a position
   */
-inline QMap<QString, QVector3D> cwStationPositionLookup::positions() const {
-    return StationPositions;
+inline int cwStationPositionLookup::count() const {
+    return Data->Ids.size();
 }
 
+/**
+  Returns true if other is an implicitly shared copy of this lookup. This is a quick way to
+  check if the lookup hasn't been modified since it was copied.
+  */
+inline bool cwStationPositionLookup::isSharedWith(const cwStationPositionLookup& other) const {
+    return Data.constData() == other.Data.constData();
+}
 
 
 #endif // CWSTATIONPOSITIONMODEL_H
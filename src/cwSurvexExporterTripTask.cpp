@@ -197,14 +197,15 @@ void cwSurvexExporterTripTask::writeLRUDData(QTextStream& stream, cwTrip* trip)
     foreach(cwSurveyChunk* chunk, trip->chunks()) {
         stream << "*data passage station left right up down ignoreall" << endl;
 
-        foreach(cwStation station, chunk->stations()) {
-            if(station.isValid()) {
+        const cwStationColumns& stations = chunk->stationColumns();
+        for(int i = 0; i < stations.size(); i++) {
+            if(stations.nameId(i) >= 0) {
                 QString dataLine = dataLineTemplate
-                        .arg(station.name(), TextPadding)
-                        .arg(toSupportedLength(station.left(), station.leftInputState()), TextPadding)
-                        .arg(toSupportedLength(station.right(), station.rightInputState()), TextPadding)
-                        .arg(toSupportedLength(station.up(), station.upInputState()), TextPadding)
-                        .arg(toSupportedLength(station.down(), station.downInputState()), TextPadding);
+                        .arg(stations.name(i), TextPadding)
+                        .arg(toSupportedLength(stations.left(i), stations.leftState(i)), TextPadding)
+                        .arg(toSupportedLength(stations.right(i), stations.rightState(i)), TextPadding)
+                        .arg(toSupportedLength(stations.up(i), stations.upState(i)), TextPadding)
+                        .arg(toSupportedLength(stations.down(i), stations.downState(i)), TextPadding);
 
                 stream << dataLine << endl;
             }
@@ -317,22 +318,24 @@ void cwSurvexExporterTripTask::writeChunk(QTextStream& stream,
         dataLineTemplate = QString("%1 %2 %3 %4 %5");
     }
 
-    for(int i = 0; i < chunk->stationCount() - 1; i++) {
+    const cwStationColumns& stations = chunk->stationColumns();
+    const cwShotColumns& shots = chunk->shotColumns();
+
+    for(int i = 0; i < stations.size() - 1; i++) {
 
         //Make sure we can still be run
         if(!parentIsRunning() && !isRunning()) { return; }
 
-        cwStation fromStation = chunk->station(i);
-        cwStation toStation = chunk->station(i + 1);
-        cwShot shot = chunk->shot(i);
+        if(stations.nameId(i) < 0 || stations.nameId(i + 1) < 0) { continue; }
 
-        if(!fromStation.isValid() || !toStation.isValid()) { continue; }
+        QString fromStationName = stations.name(i);
+        QString toStationName = stations.name(i + 1);
 
-        QString distance = toSupportedLength(shot.distance(), cwDistanceStates::Valid);
-        QString compass = compassToString(shot.compass(), shot.compassState());
-        QString backCompass = compassToString(shot.backCompass(), shot.backCompassState());
-        QString clino = clinoToString(shot.clino(), shot.clinoState());
-        QString backClino = clinoToString(shot.backClino(), shot.backClinoState());
+        QString distance = toSupportedLength(shots.distance(i), cwDistanceStates::Valid);
+        QString compass = compassToString(shots.compass(i), shots.compassState(i));
+        QString backCompass = compassToString(shots.backCompass(i), shots.backCompassState(i));
+        QString clino = clinoToString(shots.clino(i), shots.clinoState(i));
+        QString backClino = clinoToString(shots.backClino(i), shots.backClinoState(i));
 
         //Make sure the model is good
         if(distance.isEmpty()) { continue; }
@@ -342,15 +345,15 @@ void cwSurvexExporterTripTask::writeChunk(QTextStream& stream,
                     backClino.compare("up", Qt::CaseInsensitive) != 0 &&
                     backClino.compare("down", Qt::CaseInsensitive) != 0) {
                Errors.append(QString("Error: No compass reading for %1 to %2")
-                             .arg(fromStation.name())
-                             .arg(toStation.name()));
+                             .arg(fromStationName)
+                             .arg(toStationName));
            }
         }
 
         if(clino.isEmpty() && backClino.isEmpty()) {
             Errors.append(QString("Error: No Clino reading for %1 to %2")
-                          .arg(fromStation.name())
-                          .arg(toStation.name()));
+                          .arg(fromStationName)
+                          .arg(toStationName));
         }
 
         if(compass.isEmpty()) { compass = "-"; }
@@ -370,8 +373,8 @@ void cwSurvexExporterTripTask::writeChunk(QTextStream& stream,
         QString line;
         if(hasFrontSights && hasBackSights) {
              line = dataLineTemplate
-                    .arg(fromStation.name(), TextPadding)
-                    .arg(toStation.name(), TextPadding)
+                    .arg(fromStationName, TextPadding)
+                    .arg(toStationName, TextPadding)
                     .arg(distance, TextPadding)
                     .arg(compass, TextPadding)
                     .arg(backCompass, TextPadding)
@@ -379,29 +382,29 @@ void cwSurvexExporterTripTask::writeChunk(QTextStream& stream,
                     .arg(backClino, TextPadding);
         } else if(hasFrontSights) {
             line = dataLineTemplate
-                   .arg(fromStation.name(), TextPadding)
-                   .arg(toStation.name(), TextPadding)
+                   .arg(fromStationName, TextPadding)
+                   .arg(toStationName, TextPadding)
                    .arg(distance, TextPadding)
                    .arg(compass, TextPadding)
                    .arg(clino, TextPadding);
         } else if(hasBackSights) {
             line = dataLineTemplate
-                   .arg(fromStation.name(), TextPadding)
-                   .arg(toStation.name(), TextPadding)
+                   .arg(fromStationName, TextPadding)
+                   .arg(toStationName, TextPadding)
                    .arg(distance, TextPadding)
                    .arg(backCompass, TextPadding)
                    .arg(backClino, TextPadding);
         }
 
         //Distance should be excluded, mark as duplicate
-        if(!shot.isDistanceIncluded()) {
+        if(!shots.isDistanceIncluded(i)) {
             stream << "*flags duplicate" << endl;
         }
 
         stream << line << endl;
 
         //Turn duplication off
-        if(!shot.isDistanceIncluded()) {
+        if(!shots.isDistanceIncluded(i)) {
             stream << "*flags not duplicate" << endl;
         }
 
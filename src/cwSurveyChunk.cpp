@@ -18,6 +18,7 @@
 #include "cwDistanceValidator.h"
 #include "cwClinoValidator.h"
 #include "cwTripCalibration.h"
+#include "cwStationNameTable.h"
 
 //Qt includes
 #include <QHash>
@@ -32,6 +33,9 @@
 cwSurveyChunk::cwSurveyChunk(QObject * parent) :
     QObject(parent),
     ErrorModel(new cwErrorModel(this)),
+    CellFatalCount(0),
+    CellWarningCount(0),
+    StationsAndShotsEmpty(true),
     ParentTrip(nullptr)
 {
 
@@ -45,6 +49,9 @@ cwSurveyChunk::cwSurveyChunk(QObject * parent) :
 cwSurveyChunk::cwSurveyChunk(const cwSurveyChunk& chunk) :
     QObject(),
     ErrorModel(new cwErrorModel(this)),
+    CellFatalCount(0),
+    CellWarningCount(0),
+    StationsAndShotsEmpty(true),
     ParentTrip(nullptr)
 {
 
@@ -53,6 +60,66 @@ cwSurveyChunk::cwSurveyChunk(const cwSurveyChunk& chunk) :
 
     //Copy all the shots
     Shots = chunk.Shots;
+
+    StationsAndShotsEmpty = isStationAndShotsEmpty();
+}
+
+/**
+ * @brief cwSurveyChunk::data
+ * @return The stations and shots in the chunk. This doesn't copy the stations and shots, they
+ * are implicitly shared.
+ */
+cwSurveyChunkData cwSurveyChunk::data() const
+{
+    cwSurveyChunkData data;
+    data.Stations = Stations;
+    data.Shots = Shots;
+    return data;
+}
+
+/**
+ * @brief cwSurveyChunk::setData
+ * @param data - Replaces all the stations and shots in the chunk
+ *
+ * If data doesn't have one more station than shots, the chunk isn't changed.
+ */
+void cwSurveyChunk::setData(const cwSurveyChunkData &data)
+{
+    bool empty = data.Stations.isEmpty() && data.Shots.isEmpty();
+    if(!empty && data.Stations.size() - 1 != data.Shots.size()) {
+        qDebug() << "Shot, station count mismatch, survey chunk invalid:" << data.Stations.size() << data.Shots.size() << LOCATION;
+        return;
+    }
+
+    //Remove the old stations and shots
+    int lastStationIndex = Stations.size() - 1;
+    int lastShotIndex = Shots.size() - 1;
+    Stations.clear();
+    Shots.clear();
+    clearCellErrors();
+
+    if(lastStationIndex >= 0) {
+        notifyStationsRemoved(0, lastStationIndex);
+    }
+
+    if(lastShotIndex >= 0) {
+        notifyShotsRemoved(0, lastShotIndex);
+    }
+
+    //Add the new ones
+    Stations = data.Stations;
+    Shots = data.Shots;
+
+    if(!Shots.isEmpty()) {
+        notifyShotsAdded(0, Shots.size() - 1);
+    }
+
+    if(!Stations.isEmpty()) {
+        notifyStationsAdded(0, Stations.size() - 1);
+    }
+
+    StationsAndShotsEmpty = isStationAndShotsEmpty();
+    checkForErrors(0, Stations.size() - 1, 0, Shots.size() - 1);
 }
 
 /**
@@ -164,17 +231,15 @@ void cwSurveyChunk::appendNewShot() {
         //Make valid
         for(int i = Stations.size(); i < 2; i++) {
             Stations.append(cwStation());
-            emit stationsAdded(i, i);
+            notifyStationsAdded(i, i);
         }
 
         if(Shots.size() != 1) {
             Shots.append(cwShot());
-            emit shotsAdded(0, 0);
+            notifyShotsAdded(0, 0);
         }
 
-        checkForStationError(Stations.size() - 2);
-        checkForStationError(Stations.size() - 1);
-        checkForShotError(Shots.size() - 1);
+        checkForErrors(0, Stations.size() - 1, 0, Shots.size() - 1);
 
         return;
     }
@@ -212,19 +277,18 @@ void cwSurveyChunk::appendShot(cwStation fromStation, cwStation toStation, cwSho
     int firstIndex = Stations.size();
     if(Stations.empty()) {
         Stations.append(fromStation);
-        checkForStationError(Stations.size() - 1);
     }
 
     index = Shots.size();
     Shots.append(shot);
-    emit shotsAdded(index, index);
+    notifyShotsAdded(index, index);
 
     index = Stations.size();
     Stations.append(toStation);
-    emit stationsAdded(firstIndex, index);
+    notifyStationsAdded(firstIndex, index);
 
-    checkForStationError(Stations.size() - 1);
-    checkForShotError(Shots.size() - 1);
+    //The previous last station now has a shot below it
+    checkForErrors(firstIndex - 1, Stations.size() - 1, Shots.size() - 1, Shots.size() - 1);
 }
 
 /**
@@ -260,16 +324,16 @@ cwSurveyChunk* cwSurveyChunk::splitAtStation(int stationIndex) {
 
     //Remove the stations and shots from the list
     int shotIndex = stationIndex - 1;
-    QList<cwStation>::iterator stationIter = Stations.begin() + stationIndex;
-    QList<cwShot>::iterator shotIter = Shots.begin() + shotIndex;
-    Stations.erase(stationIter, Stations.end());
-    Shots.erase(shotIter, Shots.end());
+    Stations.remove(stationIndex, Stations.size() - stationIndex);
+    Shots.remove(shotIndex, Shots.size() - shotIndex);
+    removeCellErrorRows(true, stationIndex, stationEnd - stationIndex + 1);
+    removeCellErrorRows(false, shotIndex, shotEnd - shotIndex + 1);
 
-    emit stationsRemoved(stationIndex, stationEnd);
-    emit shotsRemoved(shotIndex, shotEnd);
+    notifyStationsRemoved(stationIndex, stationEnd);
+    notifyShotsRemoved(shotIndex, shotEnd);
 
-    //Check for errors
-    updateErrors();
+    //Check for errors, the last station no longer has a shot below it
+    checkForErrors(stationIndex - 1, stationIndex - 1, shotIndex - 1, shotIndex - 1);
 
     //Append a new last station
     appendNewShot();
@@ -303,11 +367,14 @@ void cwSurveyChunk::insertStation(int stationIndex, Direction direction) {
 
     Stations.insert(stationIndex, station);
     Shots.insert(shotIndex, cwShot());
+    insertCellErrorRows(true, stationIndex, 1);
+    insertCellErrorRows(false, shotIndex, 1);
 
-    emit stationsAdded(stationIndex, stationIndex);
-    emit shotsAdded(shotIndex, shotIndex);
+    notifyStationsAdded(stationIndex, stationIndex);
+    notifyShotsAdded(shotIndex, shotIndex);
 
-    updateErrors();
+    //Only the new rows and their neighbors have changed
+    checkForErrors(stationIndex - 1, stationIndex + 1, shotIndex - 1, shotIndex + 1);
 }
 
 /**
@@ -329,12 +396,15 @@ void cwSurveyChunk::insertShot(int shotIndex, Direction direction) {
     cwStation station;
 
     Stations.insert(stationIndex, station);
-    emit stationsAdded(stationIndex, stationIndex);
+    insertCellErrorRows(true, stationIndex, 1);
+    notifyStationsAdded(stationIndex, stationIndex);
 
     Shots.insert(shotIndex, cwShot());
-    emit shotsAdded(shotIndex, shotIndex);
+    insertCellErrorRows(false, shotIndex, 1);
+    notifyShotsAdded(shotIndex, shotIndex);
 
-    updateErrors();
+    //Only the new rows and their neighbors have changed
+    checkForErrors(stationIndex - 1, stationIndex + 1, shotIndex - 1, shotIndex + 1);
 }
 
 
@@ -345,7 +415,7 @@ void cwSurveyChunk::insertShot(int shotIndex, Direction direction) {
   */
 bool cwSurveyChunk::canAddShot(const cwStation& fromStation, const cwStation& toStation) {
     Q_UNUSED(toStation);
-    return Stations.empty() || Stations.last().name().compare(fromStation.name(), Qt::CaseInsensitive) == 0;
+    return Stations.empty() || Stations.name(Stations.size() - 1).compare(fromStation.name(), Qt::CaseInsensitive) == 0;
 }
 
 ///**
@@ -404,8 +474,8 @@ void cwSurveyChunk::removeStation(int stationIndex, Direction shot) {
     //Remove them
     remove(stationIndex, shotIndex);
 
-    //Refresh all the errors
-    updateErrors();
+    //Refresh the errors around the removed rows
+    checkForErrors(stationIndex - 1, stationIndex + 1, shotIndex - 1, shotIndex + 1);
 }
 
 /**
@@ -441,8 +511,8 @@ void cwSurveyChunk::removeShot(int shotIndex, Direction station) {
     //Remove them
     remove(stationIndex, shotIndex);
 
-    //Refresh all the errors
-    updateErrors();
+    //Refresh the errors around the removed rows
+    checkForErrors(stationIndex - 1, stationIndex + 1, shotIndex - 1, shotIndex + 1);
 }
 
 /**
@@ -498,26 +568,26 @@ bool cwSurveyChunk::isShotRole(cwSurveyChunk::DataRole role) const {
   */
 QString cwSurveyChunk::guessLastStationName() const {
     //Need a least two stations for this to work.
-    if(stations().size() < 2) {
+    if(Stations.size() < 2) {
         return QString();
     }
 
-    if(stations().last().name().isEmpty()) {
+    if(Stations.nameId(Stations.size() - 1) < 0) {
         QString stationName;
 
-        if(stations().size() == 2) {
+        if(Stations.size() == 2) {
             //Try to get the station name from the previous chunk
             QList<cwSurveyChunk*> chunks = parentTrip()->chunks();
             int index = chunks.indexOf(const_cast<cwSurveyChunk*>(this)) - 1;
             cwSurveyChunk* previousChunk = parentTrip()->chunk(index);
-            if(previousChunk != nullptr) {
-                stationName = previousChunk->stations().last().name();
+            if(previousChunk != nullptr && !previousChunk->Stations.isEmpty()) {
+                stationName = previousChunk->Stations.name(previousChunk->Stations.size() - 1);
             }
         }
 
         if(stationName.isEmpty()) {
-            int secondToLastStation = stations().size() - 2;
-            stationName = stations().at(secondToLastStation).name();
+            int secondToLastStation = Stations.size() - 2;
+            stationName = Stations.name(secondToLastStation);
         }
 
         QString nextStation = guessNextStation(stationName);
@@ -557,14 +627,15 @@ QString cwSurveyChunk::guessNextStation(QString stationName) const {
  */
 void cwSurveyChunk::setStation(cwStation station, int index){
     if(index < 0 || index >= Stations.size()) { return; }
-    Stations[index] = station;
-    dataChanged(StationNameRole, index);
-    dataChanged(StationLeftRole, index);
-    dataChanged(StationRightRole, index);
-    dataChanged(StationUpRole, index);
-    dataChanged(StationDownRole, index);
-
-    checkForStationError(index);
+    Stations.replace(index, station);
+    notifyDataChanged(StationNameRole, index);
+    notifyDataChanged(StationLeftRole, index);
+    notifyDataChanged(StationRightRole, index);
+    notifyDataChanged(StationUpRole, index);
+    notifyDataChanged(StationDownRole, index);
+
+    //Checks the station's LRUD and the shots next to it
+    checkForErrorOnDataChanged(StationNameRole, index);
 }
 
 /**
@@ -581,24 +652,14 @@ bool cwSurveyChunk::isStationAndShotsEmpty() const
         return true;
     }
 
-    foreach(cwStation station, Stations) {
-        if(!station.name().isEmpty() ||
-                station.leftInputState() != cwDistanceStates::Empty ||
-                station.rightInputState() != cwDistanceStates::Empty ||
-                station.upInputState() != cwDistanceStates::Empty ||
-                station.downInputState() != cwDistanceStates::Empty)
-        {
+    for(int i = 0; i < Stations.size(); i++) {
+        if(!Stations.isStationEmpty(i)) {
             return false;
         }
     }
 
-    foreach(cwShot shot, Shots) {
-        if(shot.distanceState() != cwDistanceStates::Empty ||
-                shot.backCompassState() != cwCompassStates::Empty ||
-                shot.compassState() != cwCompassStates::Empty ||
-                shot.clinoState() != cwClinoStates::Empty ||
-                shot.backClinoState() != cwClinoStates::Empty)
-        {
+    for(int i = 0; i < Shots.size(); i++) {
+        if(!Shots.isShotEmpty(i)) {
             return false;
         }
     }
@@ -625,29 +686,27 @@ QVariant cwSurveyChunk::data(DataRole role, int index) const {
 QVariant cwSurveyChunk::stationData(DataRole role, int index) const {
     if(index < 0 || index >= Stations.size()) { return QVariant(); }
 
-    const cwStation& station = Stations[index];
-
     switch (role) {
     case StationNameRole:
-        return station.name();
+        return Stations.name(index);
     case StationLeftRole:
-        if(station.leftInputState() == cwDistanceStates::Valid) {
-            return QString::number(station.left(), 'g', -1);
+        if(Stations.leftState(index) == cwDistanceStates::Valid) {
+            return QString::number(Stations.left(index), 'g', -1);
         }
         break;
     case StationRightRole:
-        if(station.rightInputState() == cwDistanceStates::Valid) {
-            return QString::number(station.right(), 'g', -1);
+        if(Stations.rightState(index) == cwDistanceStates::Valid) {
+            return QString::number(Stations.right(index), 'g', -1);
         }
         break;
     case StationUpRole:
-        if(station.upInputState() == cwDistanceStates::Valid) {
-            return QString::number(station.up(), 'g', -1);
+        if(Stations.upState(index) == cwDistanceStates::Valid) {
+            return QString::number(Stations.up(index), 'g', -1);
         }
         break;
     case StationDownRole:
-        if(station.downInputState() == cwDistanceStates::Valid) {
-            return QString::number(station.down(), 'g', -1);
+        if(Stations.downState(index) == cwDistanceStates::Valid) {
+            return QString::number(Stations.down(index), 'g', -1);
         }
         break;
     default:
@@ -662,30 +721,28 @@ QVariant cwSurveyChunk::stationData(DataRole role, int index) const {
 QVariant cwSurveyChunk::shotData(DataRole role, int index) const {
     if(index < 0 || index >= Shots.size()) { return QVariant(); }
 
-    const cwShot& shot = Shots[index];
-
     switch(role) {
     case ShotDistanceRole:
-        if(shot.distanceState() == cwDistanceStates::Valid) {
-            return QString::number(shot.distance(), 'g', -1);
+        if(Shots.distanceState(index) == cwDistanceStates::Valid) {
+            return QString::number(Shots.distance(index), 'g', -1);
         }
         break;
     case ShotDistanceIncludedRole:
-        return shot.isDistanceIncluded();
+        return Shots.isDistanceIncluded(index);
     case ShotCompassRole:
-        if(shot.compassState() == cwCompassStates::Valid) {
-            return QString::number(shot.compass(), 'g', -1);
+        if(Shots.compassState(index) == cwCompassStates::Valid) {
+            return QString::number(Shots.compass(index), 'g', -1);
         }
         break;
     case ShotBackCompassRole:
-        if(shot.backCompassState() == cwCompassStates::Valid) {
-            return QString::number(shot.backCompass(), 'g', -1);
+        if(Shots.backCompassState(index) == cwCompassStates::Valid) {
+            return QString::number(Shots.backCompass(index), 'g', -1);
         }
         break;
     case ShotClinoRole: {
-        switch(shot.clinoState()) {
+        switch(Shots.clinoState(index)) {
         case cwClinoStates::Valid:
-            return QString::number(shot.clino(), 'g', -1);
+            return QString::number(Shots.clino(index), 'g', -1);
         case cwClinoStates::Empty:
             return QVariant();
         case cwClinoStates::Down:
@@ -696,9 +753,9 @@ QVariant cwSurveyChunk::shotData(DataRole role, int index) const {
         break;
     }
     case ShotBackClinoRole:
-        switch(shot.backClinoState()) {
+        switch(Shots.backClinoState(index)) {
         case cwClinoStates::Valid:
-            return QString::number(shot.backClino(), 'g', -1);
+            return QString::number(Shots.backClino(index), 'g', -1);
         case cwClinoStates::Empty:
             return QVariant();
         case cwClinoStates::Down:
@@ -729,33 +786,32 @@ void cwSurveyChunk::setStationData(cwSurveyChunk::DataRole role, int index, cons
     }
 
     QString dataString = data.toString();
-    cwStation& station = Stations[index];
+    cwStation station = Stations.at(index);
 
     switch (role) {
     case StationNameRole:
         station.setName(dataString);
-        emit dataChanged(role, index);
         break;
     case StationLeftRole:
         station.setLeft(dataString);
-        emit dataChanged(role, index);
         break;
     case StationRightRole:
         station.setRight(dataString);
-        emit dataChanged(role, index);
         break;
     case StationUpRole:
         station.setUp(dataString);
-        emit dataChanged(role, index);
         break;
     case StationDownRole:
         station.setDown(dataString);
-        emit dataChanged(role, index);
         break;
     default:
         qDebug() << "Can't find role:" << role << LOCATION;
+        return;
     }
 
+    Stations.replace(index, station);
+    notifyDataChanged(role, index);
+
     checkForErrorOnDataChanged(role, index);
 
 }
@@ -775,42 +831,46 @@ void cwSurveyChunk::setShotData(cwSurveyChunk::DataRole role, int index, const Q
         return;
     }
 
-    cwShot& shot = Shots[index];
+    cwShot shot = Shots.at(index);
 
     switch(role) {
     case ShotDistanceRole:
         shot.setDistance(data.toString());
-        emit dataChanged(role, index);
         break;
     case ShotDistanceIncludedRole:
         shot.setDistanceIncluded(data.toBool());
-        emit dataChanged(role, index);
         break;
     case ShotCompassRole:
         shot.setCompass(data.toString());
-        emit dataChanged(role, index);
         break;
     case ShotBackCompassRole:
         shot.setBackCompass(data.toString());
-        emit dataChanged(role, index);
         break;
     case ShotClinoRole:
         shot.setClino(data.toString());
-        emit dataChanged(role, index);
         break;
     case ShotBackClinoRole:
         shot.setBackClino(data.toString());
-        emit  dataChanged(role, index);
         break;
     default:
         qDebug() << "Can't find role:" << role << LOCATION;
+        return;
     }
 
+    Shots.replace(index, shot);
+    notifyDataChanged(role, index);
+
     checkForErrorOnDataChanged(role, index);
 }
 
 void cwSurveyChunk::checkForErrorOnDataChanged(cwSurveyChunk::DataRole role, int index)
 {
+    if(isBulkEditing()) {
+        //Checked once, in endBulkEdit()
+        return;
+    }
+
+    checkForEmptyChanged();
     checkForError(role, index);
 
     //Check dependent boxes
@@ -900,7 +960,7 @@ void cwSurveyChunk::checkForError(cwSurveyChunk::DataRole role, int index)
         QString stationName = data(StationNameRole, index).toString();
 
         if(stationName.isEmpty()) {
-            if(!isStationAndShotsEmpty()) {
+            if(!StationsAndShotsEmpty) {
 
                 if(!(isShotDataEmpty(index) &&
                         isShotDataEmpty(index - 1) &&
@@ -934,30 +994,34 @@ void cwSurveyChunk::checkForError(cwSurveyChunk::DataRole role, int index)
         break;
     }
 
-    CellIndex cellIndex = CellIndex(index, role);
-    cwErrorModel* cellModel = nullptr;
-    if(!CellErrorModels.contains(cellIndex) && !errors.isEmpty()) {
-        cellModel = new cwErrorModel(ErrorModel);
-        cellModel->setParentModel(ErrorModel);
-        CellErrorModels.insert(cellIndex, cellModel);
-    } else {
-        cellModel = CellErrorModels.value(cellIndex, nullptr);
+    setCellErrors(CellIndex(index, role), errors);
+}
+
+/**
+ * @brief cwSurveyChunk::checkForErrors
+ * @param firstStation - The first station that'll be checked
+ * @param lastStation - The last station that'll be checked
+ * @param firstShot - The first shot that'll be checked
+ * @param lastShot - The last shot that'll be checked
+ *
+ * Checks all the stations and shots in the ranges. The ranges are clamped to the stations and
+ * shots in the chunk. Use this to only check the rows that are affected by an edit.
+ */
+void cwSurveyChunk::checkForErrors(int firstStation, int lastStation, int firstShot, int lastShot)
+{
+    if(isBulkEditing()) {
+        //Checked once, in endBulkEdit()
+        return;
     }
 
-    if(cellModel != nullptr) {
-        if(errors.isEmpty()) {
-            //Delete the cellModel and clear it from the database of errors
-            cellModel->setParentModel(nullptr);
-            cellModel->deleteLater();
-            CellErrorModels.remove(cellIndex);
-        }  else {
-            //Clear the previous errors
-            if(cellModel->errors()->toList() != errors) {
-                cellModel->errors()->clear();
-                cellModel->errors()->append(errors);
-                emit errorsChanged(role, index);
-            }
-        }
+    checkForEmptyChanged();
+
+    for(int i = qMax(0, firstStation); i <= qMin(lastStation, Stations.size() - 1); i++) {
+        checkForStationError(i);
+    }
+
+    for(int i = qMax(0, firstShot); i <= qMin(lastShot, Shots.size() - 1); i++) {
+        checkForShotError(i);
     }
 }
 
@@ -992,6 +1056,23 @@ void cwSurveyChunk::checkForShotError(int index)
     checkForError(ShotBackClinoRole, index);
 }
 
+/**
+ * @brief cwSurveyChunk::checkForEmptyChanged
+ *
+ * Empty station names are only errors if the chunk has data. When the chunk goes from empty to
+ * having data, or back, all the station names are checked again.
+ */
+void cwSurveyChunk::checkForEmptyChanged()
+{
+    bool empty = isStationAndShotsEmpty();
+    if(empty != StationsAndShotsEmpty) {
+        StationsAndShotsEmpty = empty;
+        for(int i = 0; i < Stations.size(); i++) {
+            checkForError(StationNameRole, i);
+        }
+    }
+}
+
 /**
  * @brief cwSurveyChunk::checkLRUDError
  * @param role
@@ -1314,19 +1395,162 @@ bool cwSurveyChunk::isStationDataEmpty(int index) const
 
 
 /**
- * @brief cwSurveyChunk::updateErrorIndexes
+ * @brief cwSurveyChunk::setCellErrors
+ * @param cell - The index and role of the cell
+ * @param errors - The cell's new errors
+ *
+ * Stores the cell's errors, and updates the error counts and the cell's cwErrorModel, if it has
+ * been created by errorsAt(). Cells without errors aren't stored.
  */
-void cwSurveyChunk::updateErrors()
+void cwSurveyChunk::setCellErrors(const CellIndex &cell, const QList<cwError> &errors)
 {
-    clearErrors();
+    QList<cwError> oldErrors = CellErrors.value(cell);
+    if(oldErrors == errors) {
+        return;
+    }
 
-    for(int i = 0; i < Shots.size(); i++) {
-        checkForShotError(i);
+    addToCellErrorCount(oldErrors, -1);
+    addToCellErrorCount(errors, 1);
+
+    if(errors.isEmpty()) {
+        CellErrors.remove(cell);
+    } else {
+        CellErrors.insert(cell, errors);
     }
 
-    for(int i = 0; i < Stations.size(); i++) {
-        checkForStationError(i);
+    cwErrorModel* cellModel = CellErrorModels.value(cell, nullptr);
+    if(cellModel != nullptr) {
+        if(errors.isEmpty()) {
+            CellErrorModels.remove(cell);
+            cellModel->deleteLater();
+        } else {
+            cellModel->errors()->clear();
+            cellModel->errors()->append(errors);
+        }
+    }
+
+    ErrorModel->setUnlistedCount(CellFatalCount, CellWarningCount);
+    emit errorsChanged(static_cast<DataRole>(cell.role()), cell.index());
+}
+
+/**
+ * @brief cwSurveyChunk::addToCellErrorCount
+ * @param errors - The errors that are counted
+ * @param sign - 1 to add the errors to the count, -1 to remove them
+ */
+void cwSurveyChunk::addToCellErrorCount(const QList<cwError> &errors, int sign)
+{
+    foreach(const cwError& error, errors) {
+        switch(error.type()) {
+        case cwError::Fatal:
+            CellFatalCount += sign;
+            break;
+        case cwError::Warning:
+            if(!error.suppressed()) {
+                CellWarningCount += sign;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief cwSurveyChunk::clearCellErrors
+ *
+ * Removes all the cell errors and their cwErrorModels
+ */
+void cwSurveyChunk::clearCellErrors()
+{
+    foreach(cwErrorModel* cellModel, CellErrorModels) {
+        cellModel->deleteLater();
+    }
+
+    CellErrorModels.clear();
+    CellErrors.clear();
+    CellFatalCount = 0;
+    CellWarningCount = 0;
+    ErrorModel->setUnlistedCount(CellFatalCount, CellWarningCount);
+}
+
+/**
+ * Returns a copy of cells where each cell has been moved by shift. Cells that shift
+ * returns an invalid (negative) index for are dropped.
+ */
+template<typename Cells, typename Shift>
+static Cells shiftCells(const Cells& cells, Shift shift)
+{
+    Cells shifted;
+    for(auto iter = cells.constBegin(); iter != cells.constEnd(); ++iter) {
+        auto cell = shift(iter.key());
+        if(cell.index() >= 0) {
+            shifted.insert(cell, iter.value());
+        }
     }
+    return shifted;
+}
+
+/**
+ * @brief cwSurveyChunk::insertCellErrorRows
+ * @param stationRows - True to move the station rows, false to move the shot rows
+ * @param index - Where the rows were inserted
+ * @param count - The number of rows that were inserted
+ *
+ * Moves the cell errors below index down, so they stay with their station or shot
+ */
+void cwSurveyChunk::insertCellErrorRows(bool stationRows, int index, int count)
+{
+    auto shift = [=](const CellIndex& cell) {
+        if(isStationRole(static_cast<DataRole>(cell.role())) == stationRows && cell.index() >= index) {
+            return CellIndex(cell.index() + count, cell.role());
+        }
+        return cell;
+    };
+
+    CellErrors = shiftCells(CellErrors, shift);
+    CellErrorModels = shiftCells(CellErrorModels, shift);
+}
+
+/**
+ * @brief cwSurveyChunk::removeCellErrorRows
+ * @param stationRows - True to remove station rows, false to remove the shot rows
+ * @param index - The first row that was removed
+ * @param count - The number of rows that were removed
+ *
+ * Removes the cell errors in the removed rows, and moves the cell errors below them up
+ */
+void cwSurveyChunk::removeCellErrorRows(bool stationRows, int index, int count)
+{
+    auto inRows = [=](const CellIndex& cell) {
+        return isStationRole(static_cast<DataRole>(cell.role())) == stationRows;
+    };
+
+    for(auto iter = CellErrors.begin(); iter != CellErrors.end();) {
+        const CellIndex& cell = iter.key();
+        if(inRows(cell) && cell.index() >= index && cell.index() < index + count) {
+            addToCellErrorCount(iter.value(), -1);
+            cwErrorModel* cellModel = CellErrorModels.take(cell);
+            if(cellModel != nullptr) {
+                cellModel->deleteLater();
+            }
+            iter = CellErrors.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    auto shift = [=](const CellIndex& cell) {
+        if(inRows(cell) && cell.index() >= index + count) {
+            return CellIndex(cell.index() - count, cell.role());
+        }
+        return cell;
+    };
+
+    CellErrors = shiftCells(CellErrors, shift);
+    CellErrorModels = shiftCells(CellErrorModels, shift);
+
+    ErrorModel->setUnlistedCount(CellFatalCount, CellWarningCount);
 }
 
 /**
@@ -1405,14 +1629,23 @@ void cwSurveyChunk::updateCompassClinoErrors()
 }
 
 /**
- * @brief cwSurveyChunk::clearErrors
- * Clears the error list for the chunk, and goes through and updates all the errors
+ * @brief cwSurveyChunk::updateSuppressedErrors
  *
- * If the parentTrip and cave isn't set, this does nothing
+ * Called when an error is suppressed, or unsuppressed, in a cell's cwErrorModel. This copies the
+ * cell's errors back to CellErrors, so the warning count is correct.
  */
-void cwSurveyChunk::clearErrors()
+void cwSurveyChunk::updateSuppressedErrors()
 {
-    ErrorModel->errors()->clear();
+    for(auto iter = CellErrorModels.begin(); iter != CellErrorModels.end(); ++iter) {
+        if(iter.value()->errors() == sender()) {
+            QList<cwError> errors = iter.value()->errors()->toList();
+            addToCellErrorCount(CellErrors.value(iter.key()), -1);
+            addToCellErrorCount(errors, 1);
+            CellErrors.insert(iter.key(), errors);
+            ErrorModel->setUnlistedCount(CellFatalCount, CellWarningCount);
+            return;
+        }
+    }
 }
 
 ///**
@@ -1466,7 +1699,26 @@ void cwSurveyChunk::setData(DataRole role, int index, QVariant data) {
  */
 cwErrorModel* cwSurveyChunk::errorsAt(int index, cwSurveyChunk::DataRole role) const
 {
-    return CellErrorModels.value(CellIndex(index, role), nullptr);
+    CellIndex cell(index, role);
+
+    QMap<CellIndex, QList<cwError> >::const_iterator errorIter = CellErrors.constFind(cell);
+    if(errorIter == CellErrors.constEnd()) {
+        return nullptr;
+    }
+
+    cwErrorModel* cellModel = CellErrorModels.value(cell, nullptr);
+    if(cellModel == nullptr) {
+        //Create the model, now that the cell is viewed. It isn't a child model of ErrorModel,
+        //because ErrorModel already counts the cell's errors.
+        cwSurveyChunk* chunk = const_cast<cwSurveyChunk*>(this);
+        cellModel = new cwErrorModel(chunk);
+        cellModel->errors()->append(errorIter.value());
+        connect(cellModel->errors(), SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)),
+                chunk, SLOT(updateSuppressedErrors()));
+        CellErrorModels.insert(cell, cellModel);
+    }
+
+    return cellModel;
 }
 
 ///**
@@ -1497,10 +1749,138 @@ cwErrorModel* cwSurveyChunk::errorsAt(int index, cwSurveyChunk::DataRole role) c
   */
 void cwSurveyChunk::remove(int stationIndex, int shotIndex) {
     Stations.removeAt(stationIndex);
-    emit stationsRemoved(stationIndex, stationIndex);
+    removeCellErrorRows(true, stationIndex, 1);
+    notifyStationsRemoved(stationIndex, stationIndex);
 
     Shots.removeAt(shotIndex);
-    emit shotsRemoved(shotIndex, shotIndex);
+    removeCellErrorRows(false, shotIndex, 1);
+    notifyShotsRemoved(shotIndex, shotIndex);
+}
+
+/**
+ * @brief cwSurveyChunk::beginBulkEdit
+ *
+ * Starts collecting changes to the chunk, instead of notifying them one at a time. Until the
+ * matching endBulkEdit(), stationsAdded(), shotsAdded(), stationsRemoved(), shotsRemoved() and
+ * dataChanged() aren't emitted and errors aren't checked. Calls can be nested.
+ *
+ * Use this when adding many shots, like when importing. Only changes to the chunk are batched,
+ * so cwTrip::beginBulkEdit() should be used when chunks are also being added.
+ */
+void cwSurveyChunk::beginBulkEdit()
+{
+    if(Bulk.Depth == 0) {
+        Bulk.StationCount = Stations.size();
+        Bulk.ShotCount = Shots.size();
+        Bulk.Reset = false;
+    }
+    Bulk.Depth++;
+}
+
+/**
+ * @brief cwSurveyChunk::endBulkEdit
+ *
+ * Ends a bulk edit started with beginBulkEdit(). When the outer most bulk edit ends, the changes
+ * are notified together. If stations and shots were only appended, stationsAdded() and
+ * shotsAdded() are emitted once, for all the new rows. If rows that existed before the bulk edit
+ * were changed, all the rows are removed and added again, like setData(). Then the changed rows
+ * are checked for errors and bulkEditFinished() is emitted.
+ */
+void cwSurveyChunk::endBulkEdit()
+{
+    Q_ASSERT(Bulk.Depth > 0);
+    Bulk.Depth--;
+    if(Bulk.Depth > 0) {
+        return;
+    }
+
+    if(Bulk.Reset) {
+        if(Bulk.StationCount > 0) {
+            emit stationsRemoved(0, Bulk.StationCount - 1);
+        }
+
+        if(Bulk.ShotCount > 0) {
+            emit shotsRemoved(0, Bulk.ShotCount - 1);
+        }
+
+        if(!Shots.isEmpty()) {
+            emit shotsAdded(0, Shots.size() - 1);
+        }
+
+        if(!Stations.isEmpty()) {
+            emit stationsAdded(0, Stations.size() - 1);
+        }
+
+        clearCellErrors();
+        StationsAndShotsEmpty = isStationAndShotsEmpty();
+        checkForErrors(0, Stations.size() - 1, 0, Shots.size() - 1);
+    } else {
+        if(Shots.size() > Bulk.ShotCount) {
+            emit shotsAdded(Bulk.ShotCount, Shots.size() - 1);
+        }
+
+        if(Stations.size() > Bulk.StationCount) {
+            emit stationsAdded(Bulk.StationCount, Stations.size() - 1);
+        }
+
+        //The previous last station and shot may have new neighbors
+        checkForErrors(Bulk.StationCount - 1, Stations.size() - 1, Bulk.ShotCount - 1, Shots.size() - 1);
+    }
+
+    emit bulkEditFinished();
+}
+
+/**
+ * @brief cwSurveyChunk::notifyStationsAdded
+ *
+ * Emits stationsAdded(), or if the chunk is being bulk edited, records the change for
+ * endBulkEdit(). Rows at or past Bulk.StationCount were added during the bulk edit, so changes to
+ * them are covered by the single stationsAdded() in endBulkEdit().
+ */
+void cwSurveyChunk::notifyStationsAdded(int beginIndex, int endIndex)
+{
+    if(isBulkEditing()) {
+        Bulk.Reset |= beginIndex < Bulk.StationCount;
+        return;
+    }
+    emit stationsAdded(beginIndex, endIndex);
+}
+
+void cwSurveyChunk::notifyShotsAdded(int beginIndex, int endIndex)
+{
+    if(isBulkEditing()) {
+        Bulk.Reset |= beginIndex < Bulk.ShotCount;
+        return;
+    }
+    emit shotsAdded(beginIndex, endIndex);
+}
+
+void cwSurveyChunk::notifyStationsRemoved(int beginIndex, int endIndex)
+{
+    if(isBulkEditing()) {
+        Bulk.Reset |= beginIndex < Bulk.StationCount;
+        return;
+    }
+    emit stationsRemoved(beginIndex, endIndex);
+}
+
+void cwSurveyChunk::notifyShotsRemoved(int beginIndex, int endIndex)
+{
+    if(isBulkEditing()) {
+        Bulk.Reset |= beginIndex < Bulk.ShotCount;
+        return;
+    }
+    emit shotsRemoved(beginIndex, endIndex);
+}
+
+void cwSurveyChunk::notifyDataChanged(cwSurveyChunk::DataRole role, int index)
+{
+    if(isBulkEditing()) {
+        int existingCount = isStationRole(role) ? Bulk.StationCount : Bulk.ShotCount;
+        Bulk.Reset |= index < existingCount;
+        return;
+    }
+    emit dataChanged(role, index);
 }
 
 /**
@@ -1549,15 +1929,18 @@ int cwSurveyChunk::index(int index, Direction direction) {
   \brief Returns true if the survey chunk has a station
   */
 bool cwSurveyChunk::hasStation(QString stationName) const {
+    int id = cwStationNameTable::instance()->find(stationName);
+    if(id < 0) {
+        return false;
+    }
 
-    //Linear search...
-    foreach(cwStation station, Stations) {
-        if(station.name().compare(stationName, Qt::CaseInsensitive) == 0) {
+    //Linear search, on the name ids
+    for(int i = 0; i < Stations.size(); i++) {
+        if(Stations.nameId(i) == id) {
             return true;
         }
     }
     return false;
-
 }
 
 /**
@@ -1595,8 +1978,13 @@ QSet<cwStation> cwSurveyChunk::neighboringStations(QString stationName) const {
   */
 QList<int> cwSurveyChunk::indicesOfStation(QString stationName) const {
     QList<int> indices;
+    int id = cwStationNameTable::instance()->find(stationName);
+    if(id < 0) {
+        return indices;
+    }
+
     for(int i = 0; i < Stations.size(); i++) {
-        if(Stations[i].name().compare(stationName, Qt::CaseInsensitive) == 0) {
+        if(Stations.nameId(i) == id) {
             indices.append(i);
         }
     }
@@ -12,6 +12,7 @@
 //#include "cwStationReference.h"
 #include "cwStation.h"
 #include "cwShot.h"
+#include "cwSurveyChunkData.h"
 #include "cwError.h"
 #include "cwGlobals.h"
 class cwErrorModel;
@@ -62,6 +63,9 @@ public:
     cwSurveyChunk(QObject *parent = 0);
     cwSurveyChunk(const cwSurveyChunk& chunk);
 
+    cwSurveyChunkData data() const;
+    void setData(const cwSurveyChunkData& data);
+
     bool isValid() const;
     bool canAddShot(const cwStation& fromStation, const cwStation& toStation);
 
@@ -74,6 +78,9 @@ public:
     QList<cwStation> stations() const;
     QList<cwShot> shots() const;
 
+    const cwStationColumns& stationColumns() const;
+    const cwShotColumns& shotColumns() const;
+
     bool hasStation(QString stationName) const;
     QSet<cwStation> neighboringStations(QString stationName) const;
 
@@ -92,6 +99,10 @@ public:
 
     cwErrorModel* errorModel() const;
 
+    void beginBulkEdit();
+    void endBulkEdit();
+    bool isBulkEditing() const;
+
 signals:
     void parentTripChanged();
 
@@ -109,6 +120,8 @@ signals:
 
     void errorsChanged(cwSurveyChunk::DataRole mainRole, int index);
 
+    void bulkEditFinished();
+
 public slots:
     int stationCount() const;
     cwStation station(int index) const;
@@ -157,16 +170,35 @@ private:
             return Index < other.Index;
         }
 
+        int index() const { return Index; }
+        int role() const { return Role; }
+
     private:
         int Index;
         int Role;
     };
 
-    QList<cwStation> Stations;
-    QList<cwShot> Shots;
+    //The state of a bulk edit, see beginBulkEdit()
+    class BulkEdit {
+    public:
+        BulkEdit() : Depth(0), StationCount(0), ShotCount(0), Reset(false) {}
+
+        int Depth; //!< Number of nested beginBulkEdit() calls
+        int StationCount; //!< Number of stations when the bulk edit began
+        int ShotCount; //!< Number of shots when the bulk edit began
+        bool Reset; //!< True if stations or shots that existed before the bulk edit have changed
+    };
+
+    cwStationColumns Stations;
+    cwShotColumns Shots;
+    BulkEdit Bulk;
 
     cwErrorModel* ErrorModel;
-    QMap<CellIndex, cwErrorModel*> CellErrorModels;
+    QMap<CellIndex, QList<cwError> > CellErrors; //!< Only the cells that have errors
+    mutable QMap<CellIndex, cwErrorModel*> CellErrorModels; //!< Created by errorsAt(), when the cell is viewed
+    int CellFatalCount; //!< Number of fatal errors in CellErrors
+    int CellWarningCount; //!< Number of unsuppressed warnings in CellErrors
+    bool StationsAndShotsEmpty; //!< Cached isStationAndShotsEmpty(), station name errors depend on it
 
 
     cwTrip* ParentTrip;
@@ -177,6 +209,12 @@ private:
     bool stationIndexCheck(int index) const { return index >= 0 && index < Stations.count(); }
 
     void remove(int stationIndex, int shotIndex);
+
+    void notifyStationsAdded(int beginIndex, int endIndex);
+    void notifyShotsAdded(int beginIndex, int endIndex);
+    void notifyStationsRemoved(int beginIndex, int endIndex);
+    void notifyShotsRemoved(int beginIndex, int endIndex);
+    void notifyDataChanged(DataRole role, int index);
     int index(int index, Direction direction);
 
     void updateStationsCave(cwStationReference station);
@@ -191,16 +229,22 @@ private:
 
     void checkForErrorOnDataChanged(DataRole role, int index);
     void checkForError(DataRole role, int index);
+    void checkForErrors(int firstStation, int lastStation, int firstShot, int lastShot);
     void checkForStationError(int index);
     void checkForShotError(int index);
+    void checkForEmptyChanged();
     QList<cwError> checkLRUDError(cwSurveyChunk::DataRole role, int index) const;
     QList<cwError> checkDataError(cwSurveyChunk::DataRole role, int index) const;
     QList<cwError> checkWithTolerance(cwSurveyChunk::DataRole frontSightRole, cwSurveyChunk::DataRole backSightRole, int index, double tolerance = 2.0, QString units = "°") const;
     QList<cwError> checkClinoMixingType(cwSurveyChunk::DataRole role, int index) const;
     bool isShotDataEmpty(int index) const;
     bool isStationDataEmpty(int index) const;
-    void clearErrors();
-    void updateErrors();
+
+    void setCellErrors(const CellIndex& cell, const QList<cwError>& errors);
+    void addToCellErrorCount(const QList<cwError>& errors, int sign);
+    void clearCellErrors();
+    void insertCellErrorRows(bool stationRows, int index, int count);
+    void removeCellErrorRows(bool stationRows, int index, int count);
     bool isClinoDownOrUp(cwSurveyChunk::DataRole role, int index) const;
     bool isClinoDownOrUpHelper(cwSurveyChunk::DataRole role, int index) const;
 
@@ -208,6 +252,7 @@ private slots:
     void updateCompassErrors();
     void updateClinoErrors();
     void updateCompassClinoErrors();
+    void updateSuppressedErrors();
 
 //    int errorCount(cwSurveyChunkError::ErrorType type) const;
 
@@ -225,18 +270,36 @@ inline cwTrip* cwSurveyChunk::parentTrip() const {
 /**
   \brief Gets all the stations
 
-  You shouldn't modify the station data from this list
+  This copies every station out of the columns, use stationColumns() to scan the stations
   */
 inline QList<cwStation> cwSurveyChunk::stations() const {
-    return Stations;
+    return Stations.toList();
 }
 
 /**
   \brief Gets all the shot date
 
-  You shouldn't modify the shot data from this list
+  This copies every shot out of the columns, use shotColumns() to scan the shots
   */
 inline QList<cwShot> cwSurveyChunk::shots() const {
+    return Shots.toList();
+}
+
+/**
+  \brief Gets the stations stored as columns
+
+  This doesn't copy, and is the fastest way to read the stations
+  */
+inline const cwStationColumns& cwSurveyChunk::stationColumns() const {
+    return Stations;
+}
+
+/**
+  \brief Gets the shots stored as columns
+
+  This doesn't copy, and is the fastest way to read the shots
+  */
+inline const cwShotColumns& cwSurveyChunk::shotColumns() const {
     return Shots;
 }
 
@@ -258,4 +321,12 @@ inline cwErrorModel* cwSurveyChunk::errorModel() const {
     return ErrorModel;
 }
 
+/**
+* @brief cwSurveyChunk::isBulkEditing
+* @return True if beginBulkEdit() has been called without a matching endBulkEdit()
+*/
+inline bool cwSurveyChunk::isBulkEditing() const {
+    return Bulk.Depth > 0;
+}
+
 #endif // CWSurveyChunk_H
@@ -0,0 +1,27 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWSURVEYCHUNKDATA_H
+#define CWSURVEYCHUNKDATA_H
+
+//Our includes
+#include "cwStationColumns.h"
+#include "cwShotColumns.h"
+
+/**
+ * @brief The cwSurveyChunkData class
+ *
+ * The stations and shots of a cwSurveyChunk. Both columns are implicitly shared with the chunk,
+ * so this is cheap to create, and is only detached when the chunk is edited.
+ */
+class cwSurveyChunkData {
+public:
+    cwStationColumns Stations;
+    cwShotColumns Shots;
+};
+
+#endif // CWSURVEYCHUNKDATA_H
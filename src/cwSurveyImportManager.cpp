@@ -103,6 +103,7 @@ void cwSurveyImportManager::compassImporterFinished()
     Q_ASSERT(CompassImporter->isReady());
 
     UndoStack->beginMacro("Compass Import");
+    CavingRegion->beginBulkEdit(); //So the caves are only processed once
 
     //Add new caves
     foreach(cwCave cave, CompassImporter->caves()) {
@@ -110,6 +111,7 @@ void cwSurveyImportManager::compassImporterFinished()
         CavingRegion->addCave(newCave);
     }
 
+    CavingRegion->endBulkEdit();
     UndoStack->endMacro();
 
     if(!QueuedCompassFile.isEmpty()) {
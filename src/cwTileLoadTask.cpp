@@ -0,0 +1,254 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwTileLoadTask.h"
+#include "cwImageProvider.h"
+#include "cwDxt1Encoder.h"
+#include "cwDebug.h"
+
+//Qt includes
+#include <QDebug>
+
+//Std includes
+#include <algorithm>
+#include <cstring>
+
+cwTileLoadTask::cwTileLoadTask(QObject *parent) :
+    cwTask(parent),
+    ScaleTexCoords(1.0, 1.0),
+    CachedLevelId(-1)
+{
+}
+
+/**
+ * @brief cwTileLoadTask::runTask
+ *
+ * Loads the requested tiles, a level at a time. Tiles that are interrupted by stop() are in
+ * neither tiles() or failedTiles().
+ */
+void cwTileLoadTask::runTask()
+{
+    Tiles.clear();
+    FailedTiles.clear();
+
+    cwImageProvider imageProvider;
+    imageProvider.setProjectPath(ProjectFilename);
+
+    if(LevelSizes.isEmpty()) {
+        foreach(int mipmapId, Image.mipmaps()) {
+            LevelSizes.append(imageProvider.data(mipmapId, true).size());
+        }
+        ScaleTexCoords = imageProvider.scaleTexCoords(Image);
+    }
+
+    //Sort by level, so each level is only read once
+    QList<Tile> requestedTiles = RequestedTiles;
+    std::stable_sort(requestedTiles.begin(), requestedTiles.end(),
+                     [](const Tile& left, const Tile& right) { return left.Level < right.Level; });
+
+    //Only keep the cached level, if this run needs it
+    bool needsCachedLevel = std::any_of(requestedTiles.begin(), requestedTiles.end(), [this](const Tile& tile) {
+        return tile.Level >= 0 && tile.Level < Image.mipmaps().size() && Image.mipmaps().at(tile.Level) == CachedLevelId;
+    });
+    if(!needsCachedLevel) {
+        releaseLevel();
+    }
+
+    foreach(Tile tile, requestedTiles) {
+        if(!isRunning()) { break; }
+        if(tile.Level < 0 || tile.Level >= LevelSizes.size()) {
+            FailedTiles.append(tile);
+            continue;
+        }
+
+        QSize levelSize = LevelSizes.at(tile.Level);
+        QRect rect = tileRect(levelSize, tile.Index);
+        if(rect.isEmpty()) {
+            FailedTiles.append(tile);
+            continue;
+        }
+
+        int mipmapId = Image.mipmaps().at(tile.Level);
+
+        //Only the tile's row is read, if the level is tiled
+        QByteArray data = imageProvider.tile(mipmapId, tile.Index);
+        if(!data.isEmpty()) {
+            if(data.size() != cwDxt1Encoder::storageSize(rect.size())) {
+                qDebug() << "Tile" << tile.Index << "of mipmap" << mipmapId << "is the wrong size" << data.size() << LOCATION;
+                FailedTiles.append(tile);
+                continue;
+            }
+        } else {
+            //The level is stored whole
+            if(mipmapId != CachedLevelId) {
+                //The previous level is freed first, so only one level is in memory
+                releaseLevel();
+                CachedLevelData = imageProvider.data(mipmapId).data();
+                CachedLevelId = mipmapId;
+            }
+
+            if(CachedLevelData.size() < cwDxt1Encoder::storageSize(levelSize)) {
+                qDebug() << "Mipmap" << mipmapId << "is too small for its size" << levelSize << LOCATION;
+                FailedTiles.append(tile);
+                continue;
+            }
+
+            data = copyTile(CachedLevelData, levelSize, rect);
+        }
+
+        TileData tileData;
+        tileData.Key = tile;
+        tileData.ValidSize = rect.size();
+        tileData.Size = QSize((rect.width() + 3) / 4 * 4, (rect.height() + 3) / 4 * 4);
+        tileData.Data = data;
+        Tiles.append(tileData);
+    }
+
+    done();
+}
+
+/**
+ * @brief cwTileLoadTask::tiles
+ * @return The tiles that were loaded by the last run
+ */
+QList<cwTileLoadTask::TileData> cwTileLoadTask::tiles() const
+{
+    if(isReady()) {
+        return Tiles;
+    }
+
+    qDebug() << "Tiles aren't ready" << status() << LOCATION;
+    return QList<TileData>();
+}
+
+/**
+ * @brief cwTileLoadTask::failedTiles
+ * @return The tiles from the last run that aren't in the image, or whose level is corrupt. Loading
+ * them again won't work.
+ */
+QList<cwTileLoadTask::Tile> cwTileLoadTask::failedTiles() const
+{
+    if(isReady()) {
+        return FailedTiles;
+    }
+
+    qDebug() << "Failed tiles aren't ready" << status() << LOCATION;
+    return QList<Tile>();
+}
+
+/**
+ * @brief cwTileLoadTask::levelSizes
+ * @return The size of each mipmap level in pixels, this is empty until the task has run once
+ */
+QList<QSize> cwTileLoadTask::levelSizes() const
+{
+    if(isReady()) {
+        return LevelSizes;
+    }
+
+    qDebug() << "Level sizes aren't ready" << status() << LOCATION;
+    return QList<QSize>();
+}
+
+/**
+ * @brief cwTileLoadTask::scaleTexCoords
+ * @return The area of the mipmaps that's covered by the original image, see cwImageProvider::scaleTexCoords()
+ */
+QVector2D cwTileLoadTask::scaleTexCoords() const
+{
+    if(isReady()) {
+        return ScaleTexCoords;
+    }
+
+    qDebug() << "ScaleTexCoords aren't ready" << status() << LOCATION;
+    return QVector2D(1.0, 1.0);
+}
+
+/**
+ * @brief cwTileLoadTask::tileRect
+ * @param levelSize - The size of the mipmap level
+ * @param index - The tile's column and row
+ * @return The pixels in the level that are covered by the tile. The tiles on the right and top
+ * edges of the level are smaller than TileSize. If the tile isn't in the level, this returns an
+ * empty rectangle.
+ */
+QRect cwTileLoadTask::tileRect(QSize levelSize, QPoint index)
+{
+    QRect levelRect(QPoint(), levelSize);
+    QRect rect(index * TileSize, QSize(TileSize, TileSize));
+    return levelRect.intersected(rect);
+}
+
+/**
+ * @brief cwTileLoadTask::tileGridSize
+ * @param levelSize - The size of the mipmap level
+ * @return The number of tile columns and rows that cover the level
+ */
+QSize cwTileLoadTask::tileGridSize(QSize levelSize)
+{
+    return QSize((levelSize.width() + TileSize - 1) / TileSize,
+                 (levelSize.height() + TileSize - 1) / TileSize);
+}
+
+/**
+ * @brief cwTileLoadTask::copyTile
+ * @param levelData - The DXT1 blocks of the whole level
+ * @param levelSize - The level's size in pixels
+ * @param tileRect - The tile's pixels, x and y must be multiples of 4
+ * @return The DXT1 blocks of the tile
+ */
+QByteArray cwTileLoadTask::copyTile(const QByteArray &levelData, QSize levelSize, QRect tileRect)
+{
+    Q_ASSERT(tileRect.x() % 4 == 0 && tileRect.y() % 4 == 0);
+
+    const int bytesPerBlock = 8;
+    int levelBlocksPerRow = (levelSize.width() + 3) / 4;
+    int tileBlocksPerRow = (tileRect.width() + 3) / 4;
+    int tileBlockRows = (tileRect.height() + 3) / 4;
+    int rowBytes = tileBlocksPerRow * bytesPerBlock;
+
+    QByteArray tile;
+    tile.resize(rowBytes * tileBlockRows);
+
+    for(int row = 0; row < tileBlockRows; row++) {
+        int levelBlock = (tileRect.y() / 4 + row) * levelBlocksPerRow + tileRect.x() / 4;
+        memcpy(tile.data() + row * rowBytes,
+               levelData.constData() + levelBlock * bytesPerBlock,
+               rowBytes);
+    }
+
+    return tile;
+}
+
+/**
+ * @brief cwTileLoadTask::pasteTile
+ * @param levelData - The DXT1 blocks of the whole level, this must be cwDxt1Encoder::storageSize() of levelSize
+ * @param levelSize - The level's size in pixels
+ * @param tileRect - The tile's pixels, x and y must be multiples of 4
+ * @param tileData - The DXT1 blocks of the tile, from copyTile()
+ *
+ * Copies the tile's blocks back into the level, this is the opposite of copyTile()
+ */
+void cwTileLoadTask::pasteTile(QByteArray *levelData, QSize levelSize, QRect tileRect, const QByteArray &tileData)
+{
+    Q_ASSERT(tileRect.x() % 4 == 0 && tileRect.y() % 4 == 0);
+    Q_ASSERT(tileData.size() == cwDxt1Encoder::storageSize(tileRect.size()));
+
+    const int bytesPerBlock = 8;
+    int levelBlocksPerRow = (levelSize.width() + 3) / 4;
+    int tileBlocksPerRow = (tileRect.width() + 3) / 4;
+    int tileBlockRows = (tileRect.height() + 3) / 4;
+    int rowBytes = tileBlocksPerRow * bytesPerBlock;
+
+    for(int row = 0; row < tileBlockRows; row++) {
+        int levelBlock = (tileRect.y() / 4 + row) * levelBlocksPerRow + tileRect.x() / 4;
+        memcpy(levelData->data() + levelBlock * bytesPerBlock,
+               tileData.constData() + row * rowBytes,
+               rowBytes);
+    }
+}
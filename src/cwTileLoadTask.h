@@ -0,0 +1,156 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWTILELOADTASK_H
+#define CWTILELOADTASK_H
+
+//Our includes
+#include "cwTask.h"
+#include "cwImage.h"
+#include "cwGlobals.h"
+
+//Qt includes
+#include <QList>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+#include <QVector2D>
+#include <QByteArray>
+#include <QHash>
+
+/**
+ * @brief The cwTileLoadTask class
+ *
+ * Loads square DXT1 tiles from an image's mipmaps. Together the tiles of all the levels make a
+ * tiled pyramid of the image.
+ *
+ * cwAddImageTask stores each mipmap level as separate tiles, see cwProject::addTiledImage(), so
+ * a tile is read and uncompressed on its own. Older projects store each level as one blob of DXT1
+ * blocks in row order. For those, the tile is copied out of its level a row of blocks at a time,
+ * without recompressing it. The level is read and uncompressed once for all of the run's tiles in
+ * that level. The last level that was read is kept, while the following runs keep asking for
+ * tiles in it, so panning doesn't uncompress the level for every tile. It's dropped by the first
+ * run that doesn't need it, or by releaseLevel().
+ *
+ * The first run after setImage() also loads the size of every level.
+ */
+class CAVEWHERE_LIB_EXPORT cwTileLoadTask : public cwTask
+{
+    Q_OBJECT
+public:
+    static const int TileSize = 256;
+
+    class Tile {
+    public:
+        Tile() : Level(-1) {}
+        Tile(int level, QPoint index) : Level(level), Index(index) {}
+
+        bool operator==(const Tile& other) const {
+            return Level == other.Level && Index == other.Index;
+        }
+
+        int Level; //!< The mipmap level, 0 is the full resolution
+        QPoint Index; //!< The tile's column and row in the level
+    };
+
+    class TileData {
+    public:
+        Tile Key;
+        QSize Size; //!< The tile's size in pixels, rounded up to whole DXT1 blocks
+        QSize ValidSize; //!< The part of the tile that's covered by the level
+        QByteArray Data; //!< DXT1 blocks
+    };
+
+    explicit cwTileLoadTask(QObject *parent = 0);
+
+    //Inputs
+    void setImage(cwImage image);
+    void setProjectFilename(QString filename);
+    void setTiles(QList<Tile> tiles);
+    void releaseLevel();
+
+    //Outputs
+    QList<TileData> tiles() const;
+    QList<Tile> failedTiles() const;
+    QList<QSize> levelSizes() const;
+    QVector2D scaleTexCoords() const;
+
+    static QRect tileRect(QSize levelSize, QPoint index);
+    static QSize tileGridSize(QSize levelSize);
+    static QByteArray copyTile(const QByteArray& levelData, QSize levelSize, QRect tileRect);
+    static void pasteTile(QByteArray* levelData, QSize levelSize, QRect tileRect, const QByteArray& tileData);
+
+protected:
+    void runTask();
+
+private:
+    cwImage Image;
+    QString ProjectFilename;
+    QList<Tile> RequestedTiles;
+
+    QList<TileData> Tiles;
+    QList<Tile> FailedTiles;
+    QList<QSize> LevelSizes;
+    QVector2D ScaleTexCoords;
+
+    //The last level that was read
+    int CachedLevelId;
+    QByteArray CachedLevelData;
+};
+
+inline uint qHash(const cwTileLoadTask::Tile& tile) {
+    return qHash(tile.Level) ^ qHash(tile.Index.x() << 16 | tile.Index.y());
+}
+
+/**
+ * @brief cwTileLoadTask::setImage
+ * @param image - The image that the tiles are loaded from
+ */
+inline void cwTileLoadTask::setImage(cwImage image)
+{
+    if(Image != image) {
+        Image = image;
+        LevelSizes.clear();
+        releaseLevel();
+    }
+}
+
+/**
+ * @brief cwTileLoadTask::setProjectFilename
+ * @param filename - The project file that has the image
+ */
+inline void cwTileLoadTask::setProjectFilename(QString filename)
+{
+    if(ProjectFilename != filename) {
+        ProjectFilename = filename;
+        LevelSizes.clear();
+        releaseLevel();
+    }
+}
+
+/**
+ * @brief cwTileLoadTask::setTiles
+ * @param tiles - The tiles that the next run loads
+ */
+inline void cwTileLoadTask::setTiles(QList<cwTileLoadTask::Tile> tiles)
+{
+    RequestedTiles = tiles;
+}
+
+/**
+ * @brief cwTileLoadTask::releaseLevel
+ *
+ * Frees the level that's kept from the last run. This should only be called while the task isn't
+ * running, for example when all the tiles that are in view have been loaded.
+ */
+inline void cwTileLoadTask::releaseLevel()
+{
+    CachedLevelId = -1;
+    CachedLevelData.clear();
+}
+
+#endif // CWTILELOADTASK_H
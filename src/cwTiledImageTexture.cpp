@@ -0,0 +1,440 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Our includes
+#include "cwTiledImageTexture.h"
+#include "cwDebug.h"
+
+//Qt includes
+#include <QThread>
+#include <QPair>
+
+//Std includes
+#include <algorithm>
+#include <cmath>
+
+QThread* cwTiledImageTexture::TileLoadingThread = nullptr;
+
+cwTiledImageTexture::cwTiledImageTexture(QObject *parent) :
+    QObject(parent),
+    Reset(false),
+    Generation(0),
+    LevelsLoaded(false),
+    ScaleTexCoords(1.0, 1.0),
+    BaseLevel(-1),
+    Frame(0),
+    MemoryBudget(64 * 1024 * 1024),
+    MemoryUsed(0),
+    LoadTask(nullptr),
+    LoadTaskStarted(false),
+    LoadTaskGeneration(-1)
+{
+    if(TileLoadingThread == nullptr) {
+        TileLoadingThread = new QThread();
+        TileLoadingThread->start(QThread::LowPriority);
+    }
+}
+
+/**
+ * @brief cwTiledImageTexture::~cwTiledImageTexture
+ *
+ * The deconstructor assumes that the current opengl context has
+ * been set, and this object is being destroyed in the correct thread
+ */
+cwTiledImageTexture::~cwTiledImageTexture()
+{
+    resetTiles();
+
+    if(LoadTask != nullptr) {
+        LoadTask->stop();
+        LoadTask->deleteLater();
+    }
+}
+
+/**
+  This initilizes the opengl functions, this must be called with a current context
+  */
+void cwTiledImageTexture::initialize()
+{
+    initializeOpenGLFunctions();
+}
+
+/**
+Sets image
+*/
+void cwTiledImageTexture::setImage(cwImage image)
+{
+    if(Image != image) {
+        Image = image;
+        Reset = true;
+        emit imageChanged();
+    }
+}
+
+/**
+Sets project
+*/
+void cwTiledImageTexture::setProject(QString project)
+{
+    if(ProjectFilename != project) {
+        ProjectFilename = project;
+        Reset = true;
+        emit projectChanged();
+    }
+}
+
+/**
+ * @brief cwTiledImageTexture::updateData
+ *
+ * Uploads the tiles that have finished loading, evicts tiles if the memory budget is exceeded,
+ * and starts loading the tiles that were requested by visibleTiles()
+ */
+void cwTiledImageTexture::updateData()
+{
+    if(Reset) {
+        resetTiles();
+    }
+
+    uploadTiles();
+    startLoading();
+}
+
+/**
+ * @brief cwTiledImageTexture::visibleTiles
+ * @param noteArea - The area of the note that's in view, in normalized note coordinates
+ * @param noteScreenSize - The size of the whole note on the screen, in pixels
+ * @return The uploaded tiles that cover noteArea, in the order they should be drawn
+ *
+ * The tiles that are missing are loaded, and tilesLoaded() is emitted when they are ready to be
+ * uploaded by updateData().
+ */
+QList<cwTiledImageTexture::DrawTile> cwTiledImageTexture::visibleTiles(QRectF noteArea, QSizeF noteScreenSize)
+{
+    QList<DrawTile> drawTiles;
+    if(BaseLevel < 0) {
+        return drawTiles;
+    }
+
+    Frame++;
+
+    QList<Tile> tiles;
+    QSet<Tile> drawn;
+    QList<Tile> missing;
+
+    //The base tile covers the whole note, it's drawn under everything else
+    Tile baseTile(BaseLevel, QPoint(0, 0));
+    if(!drawIfResident(baseTile, &tiles, &drawn)) {
+        missing.append(baseTile);
+    }
+
+    int viewLevel = level(noteScreenSize);
+    QSize levelSize = LevelSizes.at(viewLevel);
+    QSizeF notePixels(levelSize.width() * ScaleTexCoords.x(), levelSize.height() * ScaleTexCoords.y());
+    QRectF pixelArea(noteArea.x() * notePixels.width(),
+                     noteArea.y() * notePixels.height(),
+                     noteArea.width() * notePixels.width(),
+                     noteArea.height() * notePixels.height());
+    pixelArea = pixelArea.intersected(QRectF(QPointF(), QSizeF(levelSize)));
+
+    if(viewLevel < BaseLevel && !pixelArea.isEmpty()) {
+        const int tileSize = cwTileLoadTask::TileSize;
+        int firstColumn = static_cast<int>(pixelArea.left()) / tileSize;
+        int lastColumn = static_cast<int>(std::ceil(pixelArea.right())) / tileSize;
+        int firstRow = static_cast<int>(pixelArea.top()) / tileSize;
+        int lastRow = static_cast<int>(std::ceil(pixelArea.bottom())) / tileSize;
+
+        for(int row = firstRow; row <= lastRow; row++) {
+            for(int column = firstColumn; column <= lastColumn; column++) {
+                Tile tile(viewLevel, QPoint(column, row));
+                if(cwTileLoadTask::tileRect(levelSize, tile.Index).isEmpty()) { continue; }
+                if(drawIfResident(tile, &tiles, &drawn)) { continue; }
+
+                missing.append(tile);
+
+                //Draw the nearest coarser tile, until this one is loaded
+                for(int coarserLevel = viewLevel + 1; coarserLevel < BaseLevel; coarserLevel++) {
+                    int shift = coarserLevel - viewLevel;
+                    Tile coarserTile(coarserLevel, QPoint(column >> shift, row >> shift));
+                    if(drawIfResident(coarserTile, &tiles, &drawn)) { break; }
+                }
+            }
+        }
+    }
+
+    //Only tiles that are in view are loaded, tiles that went out of view aren't loaded anymore
+    Pending.clear();
+    foreach(Tile tile, missing) {
+        if(!Loading.contains(tile) && !Failed.contains(tile)) {
+            Pending.append(tile);
+        }
+    }
+
+    //Coarse tiles are drawn first, so finer tiles are drawn on top of them
+    std::stable_sort(tiles.begin(), tiles.end(),
+                     [](const Tile& left, const Tile& right) { return left.Level > right.Level; });
+
+    QRectF unitArea(0.0, 0.0, 1.0, 1.0);
+    foreach(Tile tile, tiles) {
+        const ResidentTile& resident = Resident[tile];
+        QSize tileLevelSize = LevelSizes.at(tile.Level);
+
+        DrawTile drawTile;
+        drawTile.TextureId = resident.TextureId;
+        drawTile.Area = this->noteArea(tile).intersected(unitArea);
+        drawTile.TexCoordScale = QVector2D(
+                    drawTile.Area.width() * tileLevelSize.width() * ScaleTexCoords.x() / resident.Size.width(),
+                    drawTile.Area.height() * tileLevelSize.height() * ScaleTexCoords.y() / resident.Size.height());
+        drawTiles.append(drawTile);
+    }
+
+    return drawTiles;
+}
+
+/**
+ * @brief cwTiledImageTexture::resetTiles
+ *
+ * Deletes all the uploaded tiles, and stops loading the tiles of the old image
+ */
+void cwTiledImageTexture::resetTiles()
+{
+    foreach(const ResidentTile& tile, Resident) {
+        glDeleteTextures(1, &tile.TextureId);
+    }
+
+    if(LoadTask != nullptr && LoadTaskStarted) {
+        LoadTask->stop();
+    }
+
+    Resident.clear();
+    Loading.clear();
+    Failed.clear();
+    Pending.clear();
+    LevelSizes.clear();
+    LevelsLoaded = false;
+    BaseLevel = -1;
+    MemoryUsed = 0;
+    Generation++;
+    Reset = false;
+}
+
+/**
+ * @brief cwTiledImageTexture::uploadTiles
+ *
+ * Uploads the tiles from LoadTask, if it's finished or was stopped. The tiles that LoadTask didn't
+ * get to are unloaded again, so they're loaded by a later run, if they're still in view.
+ */
+void cwTiledImageTexture::uploadTiles()
+{
+    if(LoadTask == nullptr || !LoadTaskStarted || !LoadTask->isReady()) {
+        return;
+    }
+
+    LoadTaskStarted = false;
+
+    if(LoadTaskGeneration != Generation) {
+        //The tiles are from the previous image
+        return;
+    }
+
+    if(!LevelsLoaded) {
+        LevelsLoaded = true;
+        LevelSizes = LoadTask->levelSizes();
+        ScaleTexCoords = LoadTask->scaleTexCoords();
+
+        BaseLevel = LevelSizes.size() - 1;
+        for(int i = 0; i < LevelSizes.size(); i++) {
+            QSize size = LevelSizes.at(i);
+            if(size.width() <= cwTileLoadTask::TileSize && size.height() <= cwTileLoadTask::TileSize) {
+                BaseLevel = i;
+                break;
+            }
+        }
+
+        if(BaseLevel >= 0) {
+            Pending.prepend(Tile(BaseLevel, QPoint(0, 0)));
+        }
+    }
+
+    Tile baseTile(BaseLevel, QPoint(0, 0));
+    bool hadBaseTile = Resident.contains(baseTile);
+
+    foreach(const cwTileLoadTask::TileData& tile, LoadTask->tiles()) {
+        uploadTile(tile);
+    }
+
+    foreach(Tile tile, LoadTask->failedTiles()) {
+        Failed.insert(tile);
+    }
+
+    //Only one run is loading at a time, so everything else in Loading was interrupted
+    Loading.clear();
+
+    evictTiles();
+
+    if(!hadBaseTile && Resident.contains(baseTile)) {
+        emit textureUploaded();
+    }
+}
+
+/**
+ * @brief cwTiledImageTexture::uploadTile
+ * @param tile - The tile that's uploaded into its own texture
+ */
+void cwTiledImageTexture::uploadTile(const cwTileLoadTask::TileData &tile)
+{
+    if(Resident.contains(tile.Key)) {
+        return;
+    }
+
+    ResidentTile resident;
+    resident.Size = tile.Size;
+    resident.Bytes = tile.Data.size();
+    resident.LastDrawn = Frame;
+
+    glGenTextures(1, &resident.TextureId);
+    glBindTexture(GL_TEXTURE_2D, resident.TextureId);
+
+    //The tile's level is chosen to match the screen, so it doesn't need mipmaps
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                           tile.Size.width(), tile.Size.height(), 0,
+                           tile.Data.size(), tile.Data.constData());
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    Resident.insert(tile.Key, resident);
+    MemoryUsed += resident.Bytes;
+}
+
+/**
+ * @brief cwTiledImageTexture::evictTiles
+ *
+ * Deletes the least recently drawn tiles, until the memory used is under the memory budget.
+ * The base tile, and the tiles that were drawn in the last frame, aren't deleted.
+ */
+void cwTiledImageTexture::evictTiles()
+{
+    if(MemoryUsed <= MemoryBudget) {
+        return;
+    }
+
+    QList< QPair<quint64, Tile> > candidates;
+    for(auto iter = Resident.constBegin(); iter != Resident.constEnd(); ++iter) {
+        if(iter.key().Level != BaseLevel && iter.value().LastDrawn < Frame) {
+            candidates.append(qMakePair(iter.value().LastDrawn, iter.key()));
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const QPair<quint64, Tile>& left, const QPair<quint64, Tile>& right) {
+        return left.first < right.first;
+    });
+
+    for(int i = 0; i < candidates.size() && MemoryUsed > MemoryBudget; i++) {
+        ResidentTile tile = Resident.take(candidates.at(i).second);
+        glDeleteTextures(1, &tile.TextureId);
+        MemoryUsed -= tile.Bytes;
+    }
+}
+
+/**
+ * @brief cwTiledImageTexture::startLoading
+ *
+ * Starts loading the level sizes, or the pending tiles, if LoadTask isn't already running
+ */
+void cwTiledImageTexture::startLoading()
+{
+    if(!Image.isValid() || ProjectFilename.isEmpty()) { return; }
+    if(LoadTaskStarted) { return; }
+
+    if(LevelsLoaded && Pending.isEmpty()) {
+        //Everything in view is uploaded, the level that the task kept isn't needed
+        if(LoadTask != nullptr) {
+            LoadTask->releaseLevel();
+        }
+        return;
+    }
+
+    if(LoadTask == nullptr) {
+        LoadTask = new cwTileLoadTask();
+        LoadTask->setThread(TileLoadingThread);
+        connect(LoadTask, &cwTileLoadTask::finished, this, &cwTiledImageTexture::tilesLoaded);
+        connect(LoadTask, &cwTileLoadTask::stopped, this, &cwTiledImageTexture::tilesLoaded);
+    }
+
+    foreach(Tile tile, Pending) {
+        Loading.insert(tile);
+    }
+
+    LoadTask->setImage(Image);
+    LoadTask->setProjectFilename(ProjectFilename);
+    LoadTask->setTiles(Pending);
+    Pending.clear();
+
+    LoadTaskStarted = true;
+    LoadTaskGeneration = Generation;
+    LoadTask->start();
+}
+
+/**
+ * @brief cwTiledImageTexture::level
+ * @param noteScreenSize - The size of the whole note on the screen, in pixels
+ * @return The coarsest level that still has a texel for every pixel on the screen
+ */
+int cwTiledImageTexture::level(QSizeF noteScreenSize) const
+{
+    if(noteScreenSize.width() <= 0.0 || noteScreenSize.height() <= 0.0) {
+        return BaseLevel;
+    }
+
+    QSize firstLevelSize = LevelSizes.first();
+    double texelsPerPixel = qMin(firstLevelSize.width() * ScaleTexCoords.x() / noteScreenSize.width(),
+                                 firstLevelSize.height() * ScaleTexCoords.y() / noteScreenSize.height());
+
+    int level = texelsPerPixel > 1.0 ? static_cast<int>(std::floor(std::log2(texelsPerPixel))) : 0;
+    return qBound(0, level, BaseLevel);
+}
+
+/**
+ * @brief cwTiledImageTexture::noteArea
+ * @return The area that's covered by the tile, in normalized note coordinates. This isn't clipped
+ * by the note, so the tiles on the edges can extend past 1.0.
+ */
+QRectF cwTiledImageTexture::noteArea(const Tile &tile) const
+{
+    QSize levelSize = LevelSizes.at(tile.Level);
+    QRect rect = cwTileLoadTask::tileRect(levelSize, tile.Index);
+    double notePixelsWidth = levelSize.width() * ScaleTexCoords.x();
+    double notePixelsHeight = levelSize.height() * ScaleTexCoords.y();
+    return QRectF(rect.x() / notePixelsWidth,
+                  rect.y() / notePixelsHeight,
+                  rect.width() / notePixelsWidth,
+                  rect.height() / notePixelsHeight);
+}
+
+/**
+ * @brief cwTiledImageTexture::drawIfResident
+ * @return True if tile is uploaded, and adds it to tiles, if it isn't already in drawn
+ */
+bool cwTiledImageTexture::drawIfResident(const Tile &tile, QList<Tile> *tiles, QSet<Tile> *drawn)
+{
+    auto iter = Resident.find(tile);
+    if(iter == Resident.end()) {
+        return false;
+    }
+
+    iter.value().LastDrawn = Frame;
+    if(!drawn->contains(tile)) {
+        drawn->insert(tile);
+        tiles->append(tile);
+    }
+    return true;
+}
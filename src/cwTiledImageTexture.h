@@ -0,0 +1,165 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWTILEDIMAGETEXTURE_H
+#define CWTILEDIMAGETEXTURE_H
+
+//Our includes
+#include "cwImage.h"
+#include "cwTileLoadTask.h"
+
+//Qt includes
+#include <QObject>
+#include <QOpenGLFunctions>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QRectF>
+#include <QSizeF>
+#include <QVector2D>
+class QThread;
+
+/**
+ * @brief The cwTiledImageTexture class
+ *
+ * A virtual texture of an image's mipmaps. Only the tiles of the level that matches the screen's
+ * resolution, and that are in view, are loaded and uploaded. While a tile is loading, the
+ * nearest coarser tile that's already uploaded is drawn in its place. The tile of the finest
+ * level that fits in a single tile is always kept, so there's always something to draw.
+ *
+ * Uploaded tiles are evicted, least recently drawn first, when the texture memory is over the
+ * memory budget.
+ *
+ * This is only used by cwImageItem. cwGLScraps still uploads each note's whole mipmap chain with
+ * cwImageTexture, cwImageProvider::data() puts the tiled levels back together for it.
+ *
+ * Except for setImage() and setProject(), this should only be used by the rendering thread,
+ * while the gui thread is blocked.
+ */
+class cwTiledImageTexture : public QObject, private QOpenGLFunctions
+{
+    Q_OBJECT
+public:
+    class DrawTile {
+    public:
+        GLuint TextureId;
+        QRectF Area; //!< The area that's covered by the tile, in normalized note coordinates
+        QVector2D TexCoordScale; //!< The part of the tile's texture that covers Area
+    };
+
+    explicit cwTiledImageTexture(QObject *parent = 0);
+    ~cwTiledImageTexture();
+
+    void initialize();
+
+    cwImage image() const;
+    void setImage(cwImage image);
+
+    QString project() const;
+    void setProject(QString project);
+
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const;
+    qint64 memoryUsed() const;
+
+    QList<DrawTile> visibleTiles(QRectF noteArea, QSizeF noteScreenSize);
+
+signals:
+    void projectChanged();
+    void imageChanged();
+    void textureUploaded();
+    void tilesLoaded();
+
+public slots:
+    void updateData();
+
+private:
+    typedef cwTileLoadTask::Tile Tile;
+
+    class ResidentTile {
+    public:
+        GLuint TextureId;
+        QSize Size;
+        int Bytes;
+        quint64 LastDrawn;
+    };
+
+    QString ProjectFilename;
+    cwImage Image;
+    bool Reset; //!< True when the image or project has changed, and the tiles need to be deleted
+    int Generation; //!< Incremented on every reset, so tiles of the old image are ignored
+
+    bool LevelsLoaded;
+    QList<QSize> LevelSizes;
+    QVector2D ScaleTexCoords;
+    int BaseLevel; //!< The finest level that fits in one tile
+
+    QHash<Tile, ResidentTile> Resident;
+    QSet<Tile> Loading; //!< Tiles that are being loaded by LoadTask
+    QSet<Tile> Failed; //!< Tiles that LoadTask couldn't load, they aren't loaded again
+    QList<Tile> Pending; //!< Tiles that are loaded on LoadTask's next run
+    quint64 Frame;
+
+    qint64 MemoryBudget;
+    qint64 MemoryUsed;
+
+    static QThread* TileLoadingThread;
+    cwTileLoadTask* LoadTask;
+    bool LoadTaskStarted;
+    int LoadTaskGeneration;
+
+    void resetTiles();
+    void uploadTiles();
+    void uploadTile(const cwTileLoadTask::TileData& tile);
+    void evictTiles();
+    void startLoading();
+
+    int level(QSizeF noteScreenSize) const;
+    QRectF noteArea(const Tile& tile) const;
+    bool drawIfResident(const Tile& tile, QList<Tile>* tiles, QSet<Tile>* drawn);
+};
+
+/**
+Gets project
+*/
+inline QString cwTiledImageTexture::project() const {
+    return ProjectFilename;
+}
+
+/**
+  Gets image
+  */
+inline cwImage cwTiledImageTexture::image() const {
+    return Image;
+}
+
+/**
+ * @brief cwTiledImageTexture::setMemoryBudget
+ * @param bytes - The most texture memory that the tiles should use, by default this is 64MB. The
+ * tiles that are in view are never evicted, so this can be exceeded for very large windows.
+ */
+inline void cwTiledImageTexture::setMemoryBudget(qint64 bytes) {
+    MemoryBudget = bytes;
+}
+
+/**
+ * @brief cwTiledImageTexture::memoryBudget
+ * @return The most texture memory that the tiles should use
+ */
+inline qint64 cwTiledImageTexture::memoryBudget() const {
+    return MemoryBudget;
+}
+
+/**
+ * @brief cwTiledImageTexture::memoryUsed
+ * @return The texture memory that's used by the uploaded tiles
+ */
+inline qint64 cwTiledImageTexture::memoryUsed() const {
+    return MemoryUsed;
+}
+
+#endif // CWTILEDIMAGETEXTURE_H
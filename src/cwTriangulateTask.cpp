@@ -16,14 +16,26 @@
 
 //Qt includes
 #include <QDebug>
+#include <QtConcurrentMap>
+
+//Std includes
+#include <math.h>
+#include <algorithm>
+
+namespace {
+
+//The grid spacing of the full detail mesh, and each coarser level of detail, in meters in the cave
+const double GridSpacings[] = {5.0, 20.0, 80.0};
+const int NumberOfGridSpacings = sizeof(GridSpacings) / sizeof(GridSpacings[0]);
+
+//A level of detail is only kept if it has this fraction of the triangles of the finer level
+const double MinimumReduction = 0.75;
+
+}
 
 cwTriangulateTask::cwTriangulateTask(QObject *parent) :
-    cwTask(parent),
-    CropTask(new cwCropImageTask(this))
+    cwTask(parent)
 {
-    CropTask->setParentTask(this);
-    CropTask->setMipmapOnly(true);
-
 }
 
 void cwTriangulateTask::setScrapData(QList<cwTriangulateInData> scraps) {
@@ -34,15 +46,6 @@ void cwTriangulateTask::setScrapData(QList<cwTriangulateInData> scraps) {
     }
 }
 
-void cwTriangulateTask::setProjectFilename(QString filename)
-{
-    if(isReady()) {
-        ProjectFilename = filename;
-    } else {
-        qDebug() << "Can't set project filename while the task is still running" << LOCATION;
-    }
-}
-
 QList<cwTriangulatedData> cwTriangulateTask::triangulatedScrapData() const {
     if(isReady()) {
         return TriangulatedScraps;
@@ -52,100 +55,157 @@ QList<cwTriangulatedData> cwTriangulateTask::triangulatedScrapData() const {
     return QList<cwTriangulatedData>();
 }
 
+/**
+ * @brief The TriangulateScrapKernal class
+ *
+ * Triangulates a single scrap on the thread pool. Each scrap writes its result into its own
+ * slot, so the results don't depend on the order the scraps finish in.
+ */
+class TriangulateScrapKernal {
+public:
+    TriangulateScrapKernal(cwTriangulateTask* task, cwTriangulatedData* results) {
+        Task = task;
+        Results = results;
+    }
+
+    cwTriangulateTask* Task;
+    cwTriangulatedData* Results;
+
+    void operator()(int index) {
+        if(!Task->isRunning()) { return; }
+
+        Results[index] = Task->triangulateScrap(Task->Scraps.at(index));
+        Task->setProgress(Task->StepsDone.fetchAndAddRelaxed(1) + 1);
+    }
+};
+
 /**
   \brief Does the triangulation
+
+  Scraps are independent of each other, so they're triangulated on the global thread pool.
+  The scraps don't get their own images, each scrap's texture is a crop rectangle of its
+  note's image, see cwTriangulatedData::cropRect().
   */
 void cwTriangulateTask::runTask() {
     TriangulatedScraps.clear();
-    TriangulatedScraps.reserve(Scraps.size());
+    StepsDone = 0;
 
-    setNumberOfSteps(Scraps.size() * 2);
+    setNumberOfSteps(Scraps.size());
 
-    //Crop all the scrap data
-    cropScraps();
+    QVector<int> scrapIndexes;
+    scrapIndexes.reserve(Scraps.size());
+    for(int i = 0; i < Scraps.size(); i++) {
+        scrapIndexes.append(i);
+    }
+
+    QVector<cwTriangulatedData> results(Scraps.size());
 
     //Triangulate scraps
-    triangulateScraps();
+    QtConcurrent::blockingMap(scrapIndexes, TriangulateScrapKernal(this, results.data()));
+
+    if(isRunning()) {
+        TriangulatedScraps.reserve(Scraps.size());
+        foreach(const cwTriangulatedData& data, results) {
+            TriangulatedScraps.append(data);
+        }
+
+        setProgress(numberOfSteps());
+    }
 
     done();
 }
 
 /**
-    This runs the cropping task on all the scraps
+    \brief triangulate the scrap data
+
+    This is called from multiple threads at the same time, so it must not modify the task.
   */
-void cwTriangulateTask::cropScraps() {
-    for(int i = 0; i < Scraps.size() && isRunning(); i++) {
-        const cwTriangulateInData& data = Scraps.at(i);
+cwTriangulatedData cwTriangulateTask::triangulateScrap(const cwTriangulateInData& scrapData) {
+    QRectF bounds = scrapData.outline().boundingRect();
 
-        QRectF cropArea = data.outline().boundingRect();
-        CropTask->setOriginal(data.noteImage());
-        CropTask->setRectF(cropArea);
-        CropTask->setDatabaseFilename(ProjectFilename);
-        CropTask->start();
+    //The size of the note image that the scrap covers, in pixels
+    QSize croppedImageSize = cwCropImageTask::mapNormalizedToIndex(bounds, scrapData.noteImage().origianlSize()).size();
 
-        cwTriangulatedData triangulatedData;
-        triangulatedData.setCroppedImage(CropTask->croppedImage());
-        TriangulatedScraps.append(triangulatedData);
+    //Create the matrix that converts the normalized note coords to normalized scrap coords
+    QMatrix4x4 toLocal = mapToScrapCoordinates(bounds);
 
-        setProgress(i + 1);
-    }
-}
+    //The full detail mesh
+    cwTriangulatedData::LevelOfDetail full = triangulateGrid(bounds, scrapData, GridSpacings[0], toLocal, croppedImageSize);
 
-/**
-  \brief triangulate the scrap data
-  */
-void cwTriangulateTask::triangulateScraps() {
-    //For each scrap
-    for(int i = 0; i < Scraps.size() && isRunning(); i++) {
-        triangulateScrap(i);
-        setProgress((i + 1) * 2);
+    //Coarser meshes for when the scrap is far away. Every level has the scrap's whole outline,
+    //so levels are skipped if the outline, instead of the grid, has most of the triangles
+    QList<cwTriangulatedData::LevelOfDetail> levels;
+    int finerIndexCount = full.Indices.size();
+    for(int i = 1; i < NumberOfGridSpacings; i++) {
+        cwTriangulatedData::LevelOfDetail level = triangulateGrid(bounds, scrapData, GridSpacings[i], toLocal, croppedImageSize);
+        if(level.Indices.isEmpty() || level.Indices.size() > finerIndexCount * MinimumReduction) {
+            continue;
+        }
+        finerIndexCount = level.Indices.size();
+        levels.append(level);
     }
+
+    //Morph the lead points for the scrap
+    QVector<QVector3D> leadPoints = morphPoints(leadPositionToVector3D(scrapData.leads()),
+                                                scrapData,
+                                                toLocal,
+                                                croppedImageSize);
+
+    cwTriangulatedData outScrapData;
+    outScrapData.setCroppedImage(scrapData.noteImage());
+    outScrapData.setCropRect(bounds);
+    outScrapData.setIndices(full.Indices);
+    outScrapData.setPoints(full.Points);
+    outScrapData.setTexCoords(full.TexCoords);
+    outScrapData.setLevelsOfDetail(levels);
+    outScrapData.setLeadPoints(leadPoints);
+    return outScrapData;
 }
 
 /**
-    \brief triangulate the scrap data
-  */
-void cwTriangulateTask::triangulateScrap(int index) {
-    cwTriangulateInData& scrapData = Scraps[index];
-    QRectF bounds = scrapData.outline().boundingRect();
-    cwImage croppedImage = TriangulatedScraps[index].croppedImage();
-
+ * @brief cwTriangulateTask::triangulateGrid
+ * @param bounds - The scrap's bounds in normalized note coordinates
+ * @param scrapData - The scrap
+ * @param gridSpacing - The distance between the grid's points, in meters in the cave
+ * @param toLocal - Converts normalized note coordinates into normalized scrap coordinates
+ * @param croppedImageSize - The size of the note image that the scrap covers, in pixels
+ * @return The scrap's morphed mesh, for a grid with gridSpacing
+ *
+ * The quads on the scrap's outline are cut by the outline, so meshes of every grid spacing
+ * have the same outline.
+ */
+cwTriangulatedData::LevelOfDetail cwTriangulateTask::triangulateGrid(QRectF bounds,
+                                                                     const cwTriangulateInData& scrapData,
+                                                                     double gridSpacing,
+                                                                     const QMatrix4x4& toLocal,
+                                                                     QSize croppedImageSize)
+{
     //Create the regualar mesh that covers the croppedImage
-    PointGrid pointGrid = createPointGrid(bounds, scrapData);
+    PointGrid pointGrid = createPointGrid(bounds, scrapData, gridSpacing);
+
+    //Classify the regualar mesh's points and quads against the scrap's polygon
+    GridClassification classification = classifyGrid(pointGrid, scrapData.outline());
 
     //Find all the points in the regualar mesh that are in the scrap's polygon
-    QSet<int> gridPointsInScrap = pointsInPolygon(pointGrid, scrapData.outline());
+    QSet<int> gridPointsInScrap = pointsInPolygon(classification);
 
     //Creates list of quads that are on the edges or in the scrap
-    QuadDatabase quads = createQuads(pointGrid, scrapData.outline());
+    QuadDatabase quads = createQuads(pointGrid, classification);
 
     //Triangulate the quads (this will update the outputs data)
     cwTriangulatedData triangleData = createTriangles(pointGrid, gridPointsInScrap, quads, scrapData);
 
-    //Create the matrix that converts the normalized note coords to normalized scrap coords
-    QMatrix4x4 toLocal = mapToScrapCoordinates(bounds);
-
-    //Convert the normalized points to local note points
-    QVector<QVector3D> localNotePoints = mapToLocalNoteCoordinates(toLocal, triangleData.points());
+    cwTriangulatedData::LevelOfDetail level;
+    level.GridSpacing = gridSpacing;
+    level.Indices = triangleData.indices();
 
-    //Create the texture coordinates
-    QVector<QVector2D> texCoords = mapTexCoordinates(localNotePoints);
+    //Create the texture coordinates, these index into the note's image
+    level.TexCoords = mapTexCoordinates(triangleData.points());
 
     //Morph the points for the scrap
-    QVector<QVector3D> points = morphPoints(triangleData.points(), scrapData, toLocal, croppedImage);
+    level.Points = morphPoints(triangleData.points(), scrapData, toLocal, croppedImageSize);
 
-    //Morph the lead points for the scrap
-    QVector<QVector3D> leadPoints = morphPoints(leadPositionToVector3D(scrapData.leads()),
-                                                scrapData,
-                                                toLocal,
-                                                croppedImage);
-
-    //For testing
-    cwTriangulatedData& outScrapData = TriangulatedScraps[index];
-    outScrapData.setIndices(triangleData.indices());
-    outScrapData.setPoints(points);
-    outScrapData.setTexCoords(texCoords);
-    outScrapData.setLeadPoints(leadPoints);
+    return level;
 }
 
 /**
@@ -155,10 +215,11 @@ void cwTriangulateTask::triangulateScrap(int index) {
 
     \param PointGridSize is the size in normalize note coordinates of the grid.
     \param scrapImage is used to get the original size and dotPerMeter
+    \param gridSpacing is the distance between points in meters in the cave
 
     This returns a regualar grid.
 */
-cwTriangulateTask::PointGrid cwTriangulateTask::createPointGrid(QRectF bounds, const cwTriangulateInData& scrapData) const {
+cwTriangulateTask::PointGrid cwTriangulateTask::createPointGrid(QRectF bounds, const cwTriangulateInData& scrapData, double gridSpacing) const {
     PointGrid grid;
 
     cwNoteTranformation noteTransform = scrapData.noteTransform();
@@ -167,9 +228,7 @@ cwTriangulateTask::PointGrid cwTriangulateTask::createPointGrid(QRectF bounds, c
     double sizeOnPaperX = scrapImageSize.width() / scrapData.noteImageResolution(); //in meters
     double sizeOnPaperY = scrapImageSize.height() / scrapData.noteImageResolution(); //in meters
 
-    //TODO: Make distance between points an option that can be adjusted
-    double distanceBetweenPoints = 5.0; //In meters
-    double pointsPerMeter = 1.0 / distanceBetweenPoints; //Grid resolution
+    double pointsPerMeter = 1.0 / gridSpacing; //Grid resolution
     double scale = noteTransform.scale(); //scale for the notes
 
     double sizeInCaveX = sizeOnPaperX / scale; //in meters in cave
@@ -223,6 +282,191 @@ int cwTriangulateTask::PointGrid::index(QPointF point) const
 }
 
 
+/**
+  \brief Classifies the grid's points and quads against polygon
+
+  This only makes a couple of passes over polygon's edges, instead of testing every point and
+  quad against every edge.
+  */
+cwTriangulateTask::GridClassification cwTriangulateTask::classifyGrid(const cwTriangulateTask::PointGrid &grid,
+                                                                      const QPolygonF &polygon) const
+{
+    GridClassification classification;
+
+    //Polygon is implicitly closed, like QPolygonF::containsPoint()
+    if(polygon.size() >= 2) {
+        classification.OutlineEdges.reserve(polygon.size());
+        for(int i = 0; i < polygon.size() - 1; i++) {
+            classification.OutlineEdges.append(QLineF(polygon.at(i), polygon.at(i + 1)));
+        }
+
+        if(polygon.last() != polygon.first()) {
+            classification.OutlineEdges.append(QLineF(polygon.last(), polygon.first()));
+        }
+    }
+
+    classification.PointsInside = pointsInsideByScanline(grid, classification.OutlineEdges);
+    classification.QuadEdges = bucketEdgesByQuad(grid, classification.OutlineEdges);
+
+    return classification;
+}
+
+/**
+  \brief Finds the grid points that are inside of the polygon made of edges
+
+  This gives the same results as QPolygonF::containsPoint() with Qt::OddEvenFill. Each edge adds
+  its crossing to the rows that it spans. Then each row is swept from left to right, counting
+  the crossings.
+  */
+QVector<bool> cwTriangulateTask::pointsInsideByScanline(const cwTriangulateTask::PointGrid &grid,
+                                                        const QVector<QLineF> &edges) const
+{
+    int width = grid.GridSize.width();
+    int height = grid.GridSize.height();
+
+    QVector<bool> pointsInside(grid.Points.size(), false);
+    if(grid.Points.isEmpty() || edges.isEmpty()) {
+        return pointsInside;
+    }
+
+    double originY = grid.y(0);
+    double deltaY = grid.GridDeltaSize.height();
+
+    //Find the x crossings of each row
+    QVector<QVector<double> > rowCrossings(height);
+    foreach(const QLineF& edge, edges) {
+        double x1 = edge.x1();
+        double y1 = edge.y1();
+        double x2 = edge.x2();
+        double y2 = edge.y2();
+
+        //Ignore horizontal lines according to scan conversion rule
+        if(qFuzzyCompare(y1, y2)) {
+            continue;
+        }
+
+        if(y2 < y1) {
+            qSwap(x1, x2);
+            qSwap(y1, y2);
+        }
+
+        //The rows the edge may span, the exact test is below
+        int firstRow = 0;
+        int lastRow = height - 1;
+        if(deltaY > 0.0) {
+            firstRow = qMax(firstRow, (int)floor((y1 - originY) / deltaY) - 1);
+            lastRow = qMin(lastRow, (int)ceil((y2 - originY) / deltaY) + 1);
+        }
+
+        for(int row = firstRow; row <= lastRow; row++) {
+            double y = grid.y(row);
+            if(y >= y1 && y < y2) {
+                double x = x1 + ((x2 - x1) / (y2 - y1)) * (y - y1);
+                rowCrossings[row].append(x);
+            }
+        }
+    }
+
+    //Sweep each row, a point is inside if an odd number of crossings are at or to the left of it
+    for(int row = 0; row < height; row++) {
+        QVector<double>& crossings = rowCrossings[row];
+        if(crossings.isEmpty()) {
+            continue;
+        }
+
+        std::sort(crossings.begin(), crossings.end());
+
+        int crossingIndex = 0;
+        for(int column = 0; column < width; column++) {
+            int index = grid.index(column, row);
+            double x = grid.Points.at(index).x();
+            while(crossingIndex < crossings.size() && crossings.at(crossingIndex) <= x) {
+                crossingIndex++;
+            }
+            pointsInside[index] = crossingIndex % 2 != 0;
+        }
+    }
+
+    return pointsInside;
+}
+
+/**
+  \brief Finds the edges that may cross each quad
+
+  Each edge is walked through the rows of quads it spans, and added to the quads it passes
+  over. The quads are padded by one on each side, so the edge lists are conservative. Quads that
+  no edge passes over aren't in the returned hash.
+  */
+QHash<int, QVector<int> > cwTriangulateTask::bucketEdgesByQuad(const cwTriangulateTask::PointGrid &grid,
+                                                              const QVector<QLineF> &edges) const
+{
+    QHash<int, QVector<int> > quadEdges;
+
+    //The quads, crop out the last band of points
+    int quadWidth = grid.GridSize.width() - 1;
+    int quadHeight = grid.GridSize.height() - 1;
+    if(quadWidth <= 0 || quadHeight <= 0) {
+        return quadEdges;
+    }
+
+    double originX = grid.x(0);
+    double originY = grid.y(0);
+    double deltaX = grid.GridDeltaSize.width();
+    double deltaY = grid.GridDeltaSize.height();
+
+    auto cellIndex = [](double value, double origin, double delta, int count)->int {
+        int index = (int)floor((value - origin) / delta);
+        return qBound(0, index, count - 1);
+    };
+
+    for(int edgeIndex = 0; edgeIndex < edges.size(); edgeIndex++) {
+        const QLineF& edge = edges.at(edgeIndex);
+
+        //Degenerate grid, test every quad
+        if(deltaX <= 0.0 || deltaY <= 0.0) {
+            for(int i = 0; i < quadWidth * quadHeight; i++) {
+                quadEdges[grid.index(i % quadWidth, i / quadWidth)].append(edgeIndex);
+            }
+            continue;
+        }
+
+        double minY = qMin(edge.y1(), edge.y2());
+        double maxY = qMax(edge.y1(), edge.y2());
+        int firstRow = qMax(0, cellIndex(minY, originY, deltaY, quadHeight) - 1);
+        int lastRow = qMin(quadHeight - 1, cellIndex(maxY, originY, deltaY, quadHeight) + 1);
+
+        for(int row = firstRow; row <= lastRow; row++) {
+            //Clip the edge to the row
+            double minX;
+            double maxX;
+            if(edge.dy() == 0.0) {
+                minX = qMin(edge.x1(), edge.x2());
+                maxX = qMax(edge.x1(), edge.x2());
+            } else {
+                double rowTop = originY + row * deltaY;
+                double rowBottom = rowTop + deltaY;
+                double t1 = qBound(0.0, (rowTop - edge.y1()) / edge.dy(), 1.0);
+                double t2 = qBound(0.0, (rowBottom - edge.y1()) / edge.dy(), 1.0);
+                double clipX1 = edge.x1() + edge.dx() * t1;
+                double clipX2 = edge.x1() + edge.dx() * t2;
+                minX = qMin(clipX1, clipX2);
+                maxX = qMax(clipX1, clipX2);
+            }
+
+            int firstColumn = qMax(0, cellIndex(minX, originX, deltaX, quadWidth) - 1);
+            int lastColumn = qMin(quadWidth - 1, cellIndex(maxX, originX, deltaX, quadWidth) + 1);
+            for(int column = firstColumn; column <= lastColumn; column++) {
+                QVector<int>& edgeIndexes = quadEdges[grid.index(column, row)];
+                if(edgeIndexes.isEmpty() || edgeIndexes.last() != edgeIndex) {
+                    edgeIndexes.append(edgeIndex);
+                }
+            }
+        }
+    }
+
+    return quadEdges;
+}
+
 /**
   \brief This creates a database of points that are in the polygon.
 
@@ -231,15 +475,12 @@ int cwTriangulateTask::PointGrid::index(QPointF point) const
 
     This returns a set of indices that are within the polygon.
 */
-QSet<int> cwTriangulateTask::pointsInPolygon(const cwTriangulateTask::PointGrid &grid, const QPolygonF &polygon) const {
+QSet<int> cwTriangulateTask::pointsInPolygon(const cwTriangulateTask::GridClassification &classification) const {
     QSet<int> inPolygon;
 
     //Go through all the grid points
-    for(int i = 0; i < grid.Points.size(); i++) {
-        const QPointF& point = grid.Points[i];
-
-        //See if the grid point containts point
-        if(polygon.containsPoint(point, Qt::OddEvenFill)) {
+    for(int i = 0; i < classification.PointsInside.size(); i++) {
+        if(classification.PointsInside.at(i)) {
             inPolygon.insert(i);
         }
     }
@@ -254,25 +495,29 @@ QSet<int> cwTriangulateTask::pointsInPolygon(const cwTriangulateTask::PointGrid
   The quads that are complete in the scrap, and quads that are on the edge of the scrap.
 
   Quads that are outside of the scrap's outline aren't stored in the database, and simply discarded.
+
+  Only the quads that the classification found edges for, are tested for intersections, and only
+  against those edges.
   */
 cwTriangulateTask::QuadDatabase cwTriangulateTask::createQuads(const cwTriangulateTask::PointGrid &grid,
-                                                               //                                                               const QSet<int> &pointsInScrap,
-                                                               const QPolygonF& polygon) {
+                                                               const cwTriangulateTask::GridClassification &classification) {
     //The valid grid size, crop out the last band of points
     int width = grid.GridSize.width() - 1;
     int height = grid.GridSize.height() - 1;
 
     QuadDatabase quadDatabase;
 
-    //TODO: Optimization - this loop can be replace by iterating over the pointsInScrap
     for(int y = 0; y < height; y++) {
         for(int x = 0; x < width; x++) {
             int index = grid.index(x, y);
             Quad quad = grid.quad(index);
 
-            if(grid.intersects(quad, polygon)) {
+            QHash<int, QVector<int> >::const_iterator edgeIter = classification.QuadEdges.constFind(index);
+            bool hasEdges = edgeIter != classification.QuadEdges.constEnd();
+
+            if(hasEdges && grid.intersects(quad, classification.OutlineEdges, edgeIter.value())) {
                 quadDatabase.PartialQuads.append(quad);
-            } else if(grid.quadContainInsideOfPolygon(quad, polygon)) {
+            } else if(grid.quadContainInsideOfPolygon(quad, classification.PointsInside)) {
                 quadDatabase.FullQuads.append(quad);
             }
         }
@@ -307,12 +552,12 @@ cwTriangulatedData cwTriangulateTask::createTriangles(const cwTriangulateTask::P
         current++;
     }
 
-    //Do triangulation
-    QVector<uint> fullTriangleIndices = createTrianglesFull(database, mapGridToOutputIndices);
-    QVector<QPointF> partialTriangles = createTrianglesPartial(grid, database, inScrapData.outline());
+    //Do triangulation, the partial triangles are welded into the same points as the full triangles
+    static const float PointTolerance = 0.000001f;
+    PointWelder welder(&points, PointTolerance);
 
-    //Get the final triangle set
-    mergeFullAndPartialTriangles(points, fullTriangleIndices, partialTriangles);
+    QVector<uint> fullTriangleIndices = createTrianglesFull(database, mapGridToOutputIndices);
+    createTrianglesPartial(grid, database, inScrapData.outline(), welder, fullTriangleIndices);
 
     //Optimize triangle indices for graphics card triangle cache preformance
     QVector<uint> optimizedIndices;
@@ -381,12 +626,15 @@ bool distanceLessThan(const QPair<QPointF, double> &d1, const QPair<QPointF, dou
 
   This function will create a small polygon that's the intersection between the full outline
   and partial quad.
-  */
-QVector<QPointF> cwTriangulateTask::createTrianglesPartial(const cwTriangulateTask::PointGrid& grid,
-                                                           const cwTriangulateTask::QuadDatabase &database,
-                                                           const QPolygonF& scrapOutline) {
 
-    QVector<QPointF> allTriangles;
+  The triangles' points are welded into welder's points, and their indices are appended to
+  indices.
+  */
+void cwTriangulateTask::createTrianglesPartial(const cwTriangulateTask::PointGrid& grid,
+                                               const cwTriangulateTask::QuadDatabase &database,
+                                               const QPolygonF& scrapOutline,
+                                               PointWelder& welder,
+                                               QVector<uint>& indices) {
 
     foreach(const Quad& quad, database.PartialQuads) {
         QPointF topLeft = grid.Points[quad.topLeft()];
@@ -436,11 +684,11 @@ QVector<QPointF> cwTriangulateTask::createTrianglesPartial(const cwTriangulateTa
                 qDebug() << "-------------------------------";
             }
 
-            allTriangles += triangles;
+            foreach(QPointF point, triangles) {
+                indices.append(welder.weld(point));
+            }
         }
     }
-
-    return allTriangles;
 }
 
 /**
@@ -561,47 +809,87 @@ QList<QPolygonF> cwTriangulateTask::createSimplePolygons(QPolygonF polygon) cons
     return simplePolygons;
 }
 /**
-    This function will add the unAddTriangles into indices.  It will also add triangle's points into
-    points.  This function will attemp to reuse points such all of pointSet's points are unique.
-
-    This function assumes that the points in pointSet are already unique before calling this functions.
+  Creates a welder that welds points into points. All the points already in points must be
+  unique. Points within tolerance, in x and y, of each other are welded together.
   */
-void cwTriangulateTask::mergeFullAndPartialTriangles(QVector<QVector3D> &pointSet,
-                                                     QVector<uint> &indices,
-                                                     const QVector<QPointF>& unAddedTriangles)
+cwTriangulateTask::PointWelder::PointWelder(QVector<QVector3D> *points, float tolerance) :
+    Points(points),
+    Tolerance(tolerance),
+    CellSize(tolerance * 2.0)
 {
-    static const float PointTolerance = 0.000001f;
+    Cells.reserve(Points->size());
+    for(int i = 0; i < Points->size(); i++) {
+        insert((uint)i);
+    }
+}
 
-    foreach(QPointF unAddedPoint, unAddedTriangles) {
+/**
+  Returns the index of the point in the vertex buffer. If no point is within the tolerance of
+  point, point is added to the buffer.
 
-        bool foundExistIndex = false;
-        uint index;
+  If multiple points are within the tolerance, the first one that was added is used.
+  */
+uint cwTriangulateTask::PointWelder::weld(QPointF point)
+{
+    qint64 cellX = cellIndex(point.x());
+    qint64 cellY = cellIndex(point.y());
+
+    //The tolerance is smaller than a cell, so only the neighbouring cells need to be searched
+    bool found = false;
+    uint foundIndex = 0;
+    for(qint64 y = cellY - 1; y <= cellY + 1; y++) {
+        for(qint64 x = cellX - 1; x <= cellX + 1; x++) {
+            QHash<qint64, QVector<uint> >::const_iterator iter = Cells.constFind(cellKey(x, y));
+            if(iter == Cells.constEnd()) {
+                continue;
+            }
 
-        //Search for the point in the point set
-        //This is a slow linear search, could be replace with a kd-tree of the pointSet
-        //Good enough for now...
-        for(int i = 0; i < pointSet.size(); i++) {
-            const QVector3D& point = pointSet[i];
-            float xDelta = fabs((float)unAddedPoint.x() - point.x());
-            float yDelta = fabs((float)unAddedPoint.y() - point.y());
+            foreach(uint index, iter.value()) {
+                const QVector3D& existingPoint = Points->at(index);
+                float xDelta = fabs((float)point.x() - existingPoint.x());
+                float yDelta = fabs((float)point.y() - existingPoint.y());
 
-            if(xDelta <= PointTolerance && yDelta <= PointTolerance) {
-                //Hey we found the point
-                index = (uint)i;
-                foundExistIndex = true;
-                break;
+                if(xDelta <= Tolerance && yDelta <= Tolerance && (!found || index < foundIndex)) {
+                    foundIndex = index;
+                    found = true;
+                }
             }
         }
+    }
 
-        //If we didn't find the index this is a new point, so add it to the pointSet
-        if(!foundExistIndex) {
-            index = (uint)pointSet.size(); //The last index
-            pointSet.append(QVector3D(unAddedPoint));
-        }
-
-        //The next index for the triangles
-        indices.append(index);
+    if(found) {
+        return foundIndex;
     }
+
+    uint index = (uint)Points->size();
+    Points->append(QVector3D(point));
+    insert(index);
+    return index;
+}
+
+/**
+  Combines the cell's x and y index into a hash key
+  */
+qint64 cwTriangulateTask::PointWelder::cellKey(qint64 x, qint64 y) const
+{
+    return (x << 32) ^ (y & 0xFFFFFFFF);
+}
+
+/**
+  Returns the cell index of value along one axis
+  */
+qint64 cwTriangulateTask::PointWelder::cellIndex(double value) const
+{
+    return (qint64)floor(value / CellSize);
+}
+
+/**
+  Adds the point at index in Points to its cell
+  */
+void cwTriangulateTask::PointWelder::insert(uint index)
+{
+    const QVector3D& point = Points->at(index);
+    Cells[cellKey(cellIndex(point.x()), cellIndex(point.y()))].append(index);
 }
 
 /**
@@ -621,32 +909,20 @@ QMatrix4x4 cwTriangulateTask::mapToScrapCoordinates(const QRectF &bounds) const
     return matrix;
 }
 
-QVector<QVector3D> cwTriangulateTask::mapToLocalNoteCoordinates(QMatrix4x4 toLocal, const QVector<QVector3D> &normalizeNoteCoords) const {
-    QVector<QVector3D> mappedCoords;
-    mappedCoords.reserve(normalizeNoteCoords.size());
-    mappedCoords.resize(normalizeNoteCoords.size());
-
-    for(int i = 0; i < normalizeNoteCoords.size(); i++) {
-        mappedCoords[i] = toLocal.map(normalizeNoteCoords[i]);
-    }
-
-    return mappedCoords;
-}
-
 /**
-    This takes the bounds of the cropped scrap and the point list of normalized cooridates of the original image.
+    This takes the point list of normalized cooridates of the original image.
 
-    This will tranform the normalized coordinates into local normalized coordinates such that
-    the cropped image can be textured in opengl
+    The scrap is textured with the note's image, so the normalized note coordinates are
+    the texture coordinates.
 
     This function will produces texcoordinates
   */
-QVector<QVector2D> cwTriangulateTask::mapTexCoordinates(const QVector<QVector3D> &localNoteCoords) const {
+QVector<QVector2D> cwTriangulateTask::mapTexCoordinates(const QVector<QVector3D> &normalizeNoteCoords) const {
 
     QVector<QVector2D> texCoords;
-    texCoords.reserve(localNoteCoords.size());
+    texCoords.reserve(normalizeNoteCoords.size());
 
-    foreach(QVector3D coord, localNoteCoords) {
+    foreach(QVector3D coord, normalizeNoteCoords) {
         QVector2D texCoord = coord.toVector2D();
         texCoords.append(texCoord);
     }
@@ -660,7 +936,7 @@ QVector<QVector2D> cwTriangulateTask::mapTexCoordinates(const QVector<QVector3D>
 QVector<QVector3D> cwTriangulateTask::morphPoints(const QVector<QVector3D>& notePoints,
                                                   const cwTriangulateInData& scrapData,
                                                   const QMatrix4x4& toLocal,
-                                                  const cwImage& croppedImage) {
+                                                  QSize croppedImageSize) {
 
     /**
       This sorts scrapData stations if the scrap is in running profile mode.
@@ -686,60 +962,6 @@ QVector<QVector3D> cwTriangulateTask::morphPoints(const QVector<QVector3D>& note
         return stations;
     };
 
-    /**
-     * Given a list of stations this finds the stations to use as control points in the morphing.
-     *
-     * If scrapData is running profile this will use two stations that notePoint.x() falls between.
-     * Those two stations are returned. The notePoint.x() will be rotated to the northUp().
-     *
-     * If scrapData is plan this will simply return stations.
-     */
-    auto findStationsToUseForMorphing = [&scrapData](QList<cwTriangulateStation> stations, QVector3D notePoint)->QList<cwTriangulateStation>
-    {
-        if(scrapData.type() == cwScrap::RunningProfile) {
-
-            //Need to have a least two stations
-            if(stations.size() < 2) {
-                return QList<cwTriangulateStation>();
-            }
-
-            //Look for the section for the notePoint, returns the stations we want to warp between
-            auto compare = [&scrapData](const cwTriangulateStation& station, const QVector3D& point)->bool {
-                QMatrix4x4 rotation = scrapData.noteTransform().matrix();
-
-                QPointF left = rotation.map(station.notePosition());
-                QVector3D right = rotation.map(point);
-
-                return left.x() < right.x();
-            };
-
-            auto foundStation = std::lower_bound(stations.begin(), stations.end(), notePoint, compare);
-
-            if(stations.size() >= 2) {
-                if(foundStation == stations.end()) {
-                    foundStation = foundStation - 1; //To from the end
-                } else if(foundStation == stations.begin()) {
-                    foundStation = foundStation + 1;
-                }
-            } else {
-                foundStation = stations.begin();
-            }
-
-            QList<cwTriangulateStation> profileStations;
-            profileStations.append(*(foundStation - 1));
-            profileStations.append(*(foundStation));
-            return profileStations;
-        }
-
-//        //Figure out which stations are visible to this point
-//        stations = stationsVisibleToPoint(notePoints[i],
-//                                          scrapData.stations(),
-//                                          scrapData.outline());
-
-
-        return stations;
-    };
-
     /**
       When the scrapData is a plan type, this function returns a identity matrix
 
@@ -774,7 +996,7 @@ QVector<QVector3D> cwTriangulateTask::morphPoints(const QVector<QVector3D>& note
     };
 
 
-    QSize imageSize = croppedImage.origianlSize();
+    QSize imageSize = croppedImageSize;
     double metersPerDot = 1.0 / (double)scrapData.noteImageResolution();
 
     //For right now try to map
@@ -790,226 +1012,131 @@ QVector<QVector3D> cwTriangulateTask::morphPoints(const QVector<QVector3D>& note
 
     QList<cwTriangulateStation> stations = sortScrapStations();
 
+    //Precompute the stations and transforms used to morph the points. In running profile, the
+    //points are morphed between the two stations that the point falls between
+    QVector<MorphStations> morphStations;
+    QVector<double> profileStationXs;
+    QMatrix4x4 profileRotation = scrapData.noteTransform().matrix();
+    if(scrapData.type() == cwScrap::RunningProfile) {
+        if(stations.size() >= 2) {
+            profileStationXs.reserve(stations.size());
+            foreach(const cwTriangulateStation& station, stations) {
+                profileStationXs.append(profileRotation.map(station.notePosition()).x());
+            }
+
+            morphStations.reserve(stations.size() - 1);
+            for(int i = 1; i < stations.size(); i++) {
+                QList<cwTriangulateStation> profileStations;
+                profileStations.append(stations.at(i - 1));
+                profileStations.append(stations.at(i));
+                morphStations.append(createMorphStations(profileStations, toWorldCoords, calculateViewMatrix(profileStations)));
+            }
+        }
+    } else {
+        morphStations.append(createMorphStations(stations, toWorldCoords, QMatrix4x4()));
+    }
+
     QVector<QVector3D> points;
-    points.reserve(notePoints.size());
     points.resize(notePoints.size());
-    for(int i = 0; i < notePoints.size(); i++) {
 
-        //Find the stations we want to use the morph the current note point
-        QList<cwTriangulateStation> stationsUsedToMorph = findStationsToUseForMorphing(stations, notePoints[i]);
+    if(morphStations.isEmpty()) {
+        //Need to have a least two stations to morph a running profile
+        return points;
+    }
 
-        //Find the view that we want to use for the morphing
-        QMatrix4x4 viewMatrix = calculateViewMatrix(stationsUsedToMorph);
+    for(int i = 0; i < notePoints.size(); i++) {
+        int morphIndex = 0;
+        if(scrapData.type() == cwScrap::RunningProfile) {
+            //Look for the section for the notePoint, returns the stations we want to warp between
+            double x = profileRotation.map(notePoints.at(i)).x();
+            int foundIndex = std::lower_bound(profileStationXs.begin(), profileStationXs.end(), x) - profileStationXs.begin();
+            foundIndex = qBound(1, foundIndex, profileStationXs.size() - 1);
+            morphIndex = foundIndex - 1;
+        }
 
-        //Based on the visible stations morph point into the scene coords
-        points[i] = morphPoint(stationsUsedToMorph, toWorldCoords, viewMatrix, notePoints[i]);
+        //Based on the stations morph point into the scene coords
+        points[i] = morphPoint(morphStations.at(morphIndex), toWorldCoords, notePoints.at(i));
     }
 
     return points;
 }
 
 /**
-  \brief Get's a list of station that are visible to the point.
+  \brief Precomputes the morph transform of each station
 
-  This shot a ray between point and each station.  If the ray interects any of the
-  polygon's lines, then the station isn't added to the list visble points
+  \param stations - The stations that points will be morphed between
+  \param toWorldCoords - The matrix that can translate a note coordinate into a world coordinate (this doesn't include offset)
+  \param viewMatrix - The view that the point will be warped in. You can think of this as the projection.
+  In plan view this should be an identitidy matrix. In running profile, this is a a rotation matrix to align the view
+  to be perpindicular to the shot's compass bearing.
 
-  The point should be in normalize note cooridanets.  This isn't local note coordinates
+  The note to scene transform for each station only differs from toWorldCoords by a translation,
+  so only that translation is stored.
   */
-QList<cwTriangulateStation> cwTriangulateTask::stationsVisibleToPoint(const QVector3D &point,
-                                                                      const QList<cwTriangulateStation> &stations,
-                                                                      const QPolygonF &scrapOutline) const{
-
-    QList<QLineF> polygonLines;
-    //For all the lines it the polygon
-    int isClosed = (int)(!scrapOutline.isClosed());
-    int numPoints = scrapOutline.size() + isClosed;
-    for(int i = 0; i < numPoints - 1; i++) {
-        int p1Index = i % scrapOutline.size();
-        int p2Index = (i + 1) % scrapOutline.size();
-
-        QLineF line(scrapOutline[p1Index], scrapOutline[p2Index]);
-        polygonLines.append(line);
-    }
-
-    QList<cwTriangulateStation> visibleStations;
-
-    QPointF point2D = point.toPointF();
-    double errorTolerance = 1.0e-6;
-
-    //For each station
-    foreach(cwTriangulateStation station, stations) {
-
-        //Create a line between the point and the station
-        QLineF ray(point2D,station.notePosition());
-
-        //The flag if the station should be added
-        bool shouldAdd = true;
-
-        //Do all the intersections
-        QPointF intersectionPoint;
-        foreach(QLineF line, polygonLines) {
-            if(ray.intersect(line, &intersectionPoint) == QLineF::BoundedIntersection) {
-                double percentX = fabs(intersectionPoint.x() - point2D.x()) / point2D.x();
-                double percentY = fabs(intersectionPoint.y() - point2D.y()) / point2D.y();
-
-                if(percentX >= errorTolerance || percentY >= errorTolerance) {
-                    shouldAdd = false;
-                    break;
-                }
-            }
-        }
-
-        if(shouldAdd) {
-            visibleStations.append(station);
-        }
-    }
-
-    //If the point has no visibleStation, we need to figure out which station are
-    //closest and uses those,  Uses the shot intersection?
-    if(visibleStations.size() < 2 && !stations.isEmpty()) {
-
-        //For debugging for now, this should be really obvious that this code is
-        //wrong
-
-        visibleStations.clear();
-
-        //The two closest stations
-        cwTriangulateStation station1;
-        cwTriangulateStation station2;
-        double distance1 = std::numeric_limits<double>::max();
-        double distance2 = distance1;
-
-        foreach(cwTriangulateStation station, stations) {
-            double length = QLineF(point2D, station1.notePosition()).length();
-
-            //Heristic
-            if(station1.name().isEmpty()) {
-                distance1 = length;
-                station1 = station;
-                continue;
-            }
-
-            if(length < distance1) {
-                //Push distance1 to distance2
-                distance2 = distance1;
-                station2 = station1;
-
-                distance1 = length;
-                station1 = station;
-                continue;
-            }
-
-            if(station2.name().isEmpty()) {
-                distance2 = length;
-                station2 = station;
-                continue;
-            }
+cwTriangulateTask::MorphStations cwTriangulateTask::createMorphStations(const QList<cwTriangulateStation> &stations,
+                                                                        const QMatrix4x4 &toWorldCoords,
+                                                                        const QMatrix4x4 &viewMatrix) const
+{
+    MorphStations morphStations;
+    morphStations.NotePositions.reserve(stations.size());
+    morphStations.Positions.reserve(stations.size());
+    morphStations.Offsets.reserve(stations.size());
+    morphStations.InverseViewMatrix = viewMatrix.inverted();
 
-            if(length < distance2) {
-                distance2 = length;
-                station2 = station;
-            }
-        }
+    foreach(const cwTriangulateStation& station, stations) {
+        QVector3D stationOnNote = toWorldCoords * QVector3D(station.notePosition()); //In view coordinates
+        QVector3D stationPos = viewMatrix * station.position(); //In view coordianets
 
-        visibleStations.append(station1);
-        visibleStations.append(station1);
+        morphStations.NotePositions.append(station.notePosition());
+        morphStations.Positions.append(station.position());
+        morphStations.Offsets.append(stationPos - stationOnNote);
     }
 
-    return visibleStations;
+    return morphStations;
 }
 
 /**
   \brief This morphs a single point based on the stations
-  that are visible to it.
 
   This preforms a weighted average based on distance.
 
-  \param visibleStations - The visible stations that the point can see
+  \param stations - The stations, with their precomputed transforms, that the point is morphed between
   \param toWorldCoords - The matrix that can translate a note coordinate into a world coordinate (this doesn't include offset)
-  \param viewMatrix - The view that the point will be warped in. You can think of this as the projection.
-  In plan view this should be an identitidy matrix. In running profile, this is a a rotation matrix to align the view
-  to be perpindicular to the shot's compass bearing.
   \param point - The point that's going to be morphed, this is in original note coordinates
   */
-QVector3D cwTriangulateTask::morphPoint(const QList<cwTriangulateStation> &visibleStations,
+QVector3D cwTriangulateTask::morphPoint(const MorphStations& stations,
                                         const QMatrix4x4& toWorldCoords,
-                                        const QMatrix4x4& viewMatrix,
-                                        const QVector3D &point)
+                                        const QVector3D &point) const
 {
-
-    //Calculate all distances the from the visibleStations, to point in note coordinates
-    QVector<double> distances;
-    distances.reserve(visibleStations.size());
-    int onTopOfStationIndex = -1;
-    for(int i = 0; i < visibleStations.size(); i++) {
-        double distance = QLineF(visibleStations[i].notePosition(), point.toPointF()).length();
-        if(distance != 0.0) {
-
-            //The inverse distance is give a high weight for points near stations
-            double inverseDistance = 1.0 / (distance * distance);  //This is the function that allows the weight to be calculated correctly
-            distances.append(inverseDistance);
-        } else {
-            //This is a special case where the point is on station
-            onTopOfStationIndex = i;
-            break;
-        }
+    if(stations.NotePositions.isEmpty()) {
+        return QVector3D();
     }
 
-    //Special case, where point is on station
-    if(onTopOfStationIndex > -1) {
-        //Just return the station's position in world coordinates
-        return visibleStations[onTopOfStationIndex].position();
-    }
+    QPointF point2D = point.toPointF();
 
-    //Calculate the sum the distances
+    //Weights the offset of each station, by the inverse distance from the station to point in
+    //note coordinates
     double sum = 0.0;
-    foreach(double distance, distances) {
-        sum += distance;
-    }
-
-    //Calculate the weights for each station
-    QVector<double> weights;
-    weights.reserve(distances.size());
-    weights.resize(distances.size());
-    for(int i = 0; i < distances.size(); i++) {
-        weights[i] = distances[i] / sum;
-    }
-
-    //Get the point's position in respect to each station
-    QVector<QVector3D> pointInRespectToStations;
-    pointInRespectToStations.reserve(visibleStations.size());
-    foreach(cwTriangulateStation station, visibleStations) {
-
-        //Setup the transformation
-        QVector3D stationOnNote = toWorldCoords * QVector3D(station.notePosition()); //In view coordinates
-        QVector3D stationPos = viewMatrix * station.position(); //In view coordianets
-
-        QMatrix4x4 offsetToFirstStation;
-        offsetToFirstStation.translate(-stationOnNote);
-        offsetToFirstStation.translate(stationPos);
-
-        QMatrix4x4 noteToScene = offsetToFirstStation * toWorldCoords; //outputs in world coordinates
-
-        //Do the transformation
-        QVector3D pointInRespectToCurrentStation = noteToScene.map(point);
+    QVector3D weightedOffset;
+    for(int i = 0; i < stations.NotePositions.size(); i++) {
+        double distance = QLineF(stations.NotePositions.at(i), point2D).length();
+        if(distance == 0.0) {
+            //This is a special case where the point is on station
+            //Just return the station's position in world coordinates
+            return stations.Positions.at(i);
+        }
 
-        //Add to point list
-        pointInRespectToStations.append(pointInRespectToCurrentStation);
+        //The inverse distance is give a high weight for points near stations
+        double inverseDistance = 1.0 / (distance * distance);  //This is the function that allows the weight to be calculated correctly
+        sum += inverseDistance;
+        weightedOffset += inverseDistance * stations.Offsets.at(i);
     }
 
-    Q_ASSERT(pointInRespectToStations.size() == weights.size());
-
-    //Use the weights to find the final position
-    QVector3D weightPosition;
-    for(int i = 0; i < pointInRespectToStations.size(); i++) {
-        weightPosition += weights[i] * pointInRespectToStations[i];
-    }
+    //Every station's transform is toWorldCoords followed by the station's offset
+    QVector3D weightPosition = toWorldCoords.map(point) + weightedOffset / sum;
 
     //Put the weighted position in world coordinates
-    weightPosition = viewMatrix.inverted() * weightPosition;
-
-    return weightPosition;
+    return stations.InverseViewMatrix.map(weightPosition);
 }
 
 /**
@@ -1056,52 +1183,45 @@ cwTriangulateTask::Quad cwTriangulateTask::PointGrid::quad(int origin) const {
 
 /**
  * @brief cwTriangulateTask::PointGrid::intersects
- * @param polygon
- * @return True if the edges of the quad intersects with the edges of the polygon
+ * @param edges - The polygon's edges
+ * @param edgeIndexes - The indexes into edges to test
+ * @return True if the edges of the quad intersects with the edges
  */
-bool cwTriangulateTask::PointGrid::intersects(const cwTriangulateTask::Quad& quad, const QPolygonF &polygon) const
+bool cwTriangulateTask::PointGrid::intersects(const cwTriangulateTask::Quad& quad,
+                                              const QVector<QLineF>& edges,
+                                              const QVector<int>& edgeIndexes) const
 {
-    if(polygon.size() < 2) { return false; }
-
-    QVector<QLineF> edges;
-    edges.reserve(4);
-    edges.append(QLineF(Points.at(quad.topLeft()), Points.at(quad.topRight())));
-    edges.append(QLineF(Points.at(quad.topRight()), Points.at(quad.bottomRight())));
-    edges.append(QLineF(Points.at(quad.bottomRight()), Points.at(quad.bottomLeft())));
-    edges.append(QLineF(Points.at(quad.bottomLeft()), Points.at(quad.topLeft())));
+    QLineF quadEdges[4] = {
+        QLineF(Points.at(quad.topLeft()), Points.at(quad.topRight())),
+        QLineF(Points.at(quad.topRight()), Points.at(quad.bottomRight())),
+        QLineF(Points.at(quad.bottomRight()), Points.at(quad.bottomLeft())),
+        QLineF(Points.at(quad.bottomLeft()), Points.at(quad.topLeft()))
+    };
 
     QPointF intersectionPoint;
 
-    for(int i = 0; i < polygon.size() - 1; i++) {
-        QLineF polygonEdge(polygon.at(i), polygon.at(i + 1));
-        foreach(QLineF edge, edges) {
-            if(polygonEdge.intersect(edge, &intersectionPoint) == QLineF::BoundedIntersection) {
+    foreach(int edgeIndex, edgeIndexes) {
+        const QLineF& polygonEdge = edges.at(edgeIndex);
+        for(int i = 0; i < 4; i++) {
+            if(polygonEdge.intersect(quadEdges[i], &intersectionPoint) == QLineF::BoundedIntersection) {
                 return true;
             }
         }
     }
 
-    if(!polygon.isClosed()) {
-        QLineF polygonEdge(polygon.first(), polygon.last());
-        foreach(QLineF edge, edges) {
-            if(polygonEdge.intersect(edge, &intersectionPoint) == QLineF::BoundedIntersection) {
-                return true;
-            }
-        }
-    }
     return false;
 }
 
 /**
  * @brief cwTriangulateTask::PointGrid::containInsideOf
- * @param polygon
+ * @param pointsInside - The grid points that are inside of the polygon
  * @return True if the quad is completely inside of the polygon
  */
-bool cwTriangulateTask::PointGrid::quadContainInsideOfPolygon(const cwTriangulateTask::Quad& quad, const QPolygonF &polygon) const
+bool cwTriangulateTask::PointGrid::quadContainInsideOfPolygon(const cwTriangulateTask::Quad& quad, const QVector<bool>& pointsInside) const
 {
-    return polygon.containsPoint(Points.at(quad.topLeft()), Qt::OddEvenFill) &&
-            polygon.containsPoint(Points.at(quad.topRight()), Qt::OddEvenFill) &&
-            polygon.containsPoint(Points.at(quad.bottomLeft()), Qt::OddEvenFill) &&
-            polygon.containsPoint(Points.at(quad.bottomRight()), Qt::OddEvenFill);
+    return pointsInside.at(quad.topLeft()) &&
+            pointsInside.at(quad.topRight()) &&
+            pointsInside.at(quad.bottomLeft()) &&
+            pointsInside.at(quad.bottomRight());
 }
 
@@ -14,7 +14,7 @@
 #include "cwTriangulatedData.h"
 #include "cwImage.h"
 #include "cwNoteTranformation.h"
-class cwCropImageTask;
+class TriangulateScrapKernal;
 
 //Qt include
 #include <QPolygonF>
@@ -22,16 +22,21 @@ class cwCropImageTask;
 #include <QVector3D>
 #include <QSet>
 #include <QPoint>
+#include <QAtomicInt>
+#include <QHash>
+#include <QLineF>
 
 class cwTriangulateTask : public cwTask
 {
+    friend class TriangulateScrapKernal;
+    friend class TriangulateTaskTester; //For testcases
+
     Q_OBJECT
 public:
     explicit cwTriangulateTask(QObject *parent = 0);
     
     //Input so the triangle task
     void setScrapData(QList<cwTriangulateInData> scraps);
-    void setProjectFilename(QString filename);
 
     //Outputs of the task
     QList<cwTriangulatedData> triangulatedScrapData() const;
@@ -84,8 +89,11 @@ private:
         QVector<QPointF> Points;
         QSizeF GridDeltaSize; //In PointsPerMeter
 
-        bool intersects(const Quad& quad, const QPolygonF &polygon) const;
-        bool quadContainInsideOfPolygon(const Quad& quad, const QPolygonF& polygon) const;
+        bool intersects(const Quad& quad, const QVector<QLineF>& edges, const QVector<int>& edgeIndexes) const;
+        bool quadContainInsideOfPolygon(const Quad& quad, const QVector<bool>& pointsInside) const;
+
+        double x(int column) const;
+        double y(int row) const;
 
         Quad quad(int origin) const;
         int index(int x, int y) const;
@@ -120,42 +128,97 @@ private:
         QList<Quad> PartialQuads;
     };
 
+    /**
+      The grid's points and quads classified against the scrap's outline.
+
+      PointsInside is found by scanline, the crossings of each row are found by only visiting the
+      rows that each outline edge spans. QuadEdges is found by walking each outline edge through
+      the quads it passes over. Quads that aren't in QuadEdges are either completely inside or
+      outside of the outline.
+      */
+    class GridClassification {
+    public:
+        QVector<QLineF> OutlineEdges;
+        QVector<bool> PointsInside; //Indexed by grid index, uses the Qt::OddEvenFill rule
+        QHash<int, QVector<int> > QuadEdges; //Quad origin to the OutlineEdges that may cross the quad
+    };
+
+    /**
+      Welds points into a vertex buffer, so points that are within the tolerance of each other
+      share the same index.
+
+      The points are bucketed into a spatial hash, with cells that are at least the tolerance
+      in size. Finding a point only searches the point's cell and its neighbours.
+      */
+    class PointWelder {
+    public:
+        PointWelder(QVector<QVector3D>* points, float tolerance);
+
+        uint weld(QPointF point);
+
+    private:
+        QVector<QVector3D>* Points;
+        float Tolerance;
+        double CellSize;
+        QHash<qint64, QVector<uint> > Cells; //Cell key to indices in Points
+
+        qint64 cellKey(qint64 x, qint64 y) const;
+        qint64 cellIndex(double value) const;
+        void insert(uint index);
+    };
+
+    /**
+      The stations that a note point is morphed between, with their transforms precomputed.
+
+      In plan, there's one MorphStations for all the scrap's stations. In running profile, there's
+      one for each pair of neighbouring stations.
+      */
+    class MorphStations {
+    public:
+        QVector<QPointF> NotePositions;
+        QVector<QVector3D> Positions; //In world coordinates
+        QVector<QVector3D> Offsets; //From the note's coordinates to the station's, in view coordinates
+        QMatrix4x4 InverseViewMatrix;
+    };
+
     //Inputs
     QList<cwTriangulateInData> Scraps;
-    QString ProjectFilename;
 
     //Outputs
     QList<cwTriangulatedData> TriangulatedScraps;
 
-    //Sub tasks
-    cwCropImageTask* CropTask;
-
-    void cropScraps();
-
-    void triangulateScraps();
-    void triangulateScrap(int index);
-    PointGrid createPointGrid(QRectF bounds, const cwTriangulateInData& scrapData) const;
-    QSet<int> pointsInPolygon(const PointGrid& grid, const QPolygonF& polygon) const;
-    QuadDatabase createQuads(const PointGrid& grid, const QPolygonF& polygon);
+    //The number of triangulations that have finished, used for progress
+    QAtomicInt StepsDone;
+
+    cwTriangulatedData triangulateScrap(const cwTriangulateInData& scrapData);
+    cwTriangulatedData::LevelOfDetail triangulateGrid(QRectF bounds,
+                                                      const cwTriangulateInData& scrapData,
+                                                      double gridSpacing,
+                                                      const QMatrix4x4& toLocal,
+                                                      QSize croppedImageSize);
+    PointGrid createPointGrid(QRectF bounds, const cwTriangulateInData& scrapData, double gridSpacing) const;
+    GridClassification classifyGrid(const PointGrid& grid, const QPolygonF& polygon) const;
+    QVector<bool> pointsInsideByScanline(const PointGrid& grid, const QVector<QLineF>& edges) const;
+    QHash<int, QVector<int> > bucketEdgesByQuad(const PointGrid& grid, const QVector<QLineF>& edges) const;
+    QSet<int> pointsInPolygon(const GridClassification& classification) const;
+    QuadDatabase createQuads(const PointGrid& grid, const GridClassification& classification);
 
     //For triangulation
     cwTriangulatedData createTriangles(const PointGrid& grid, const QSet<int> pointsInOutline, const QuadDatabase& database, const cwTriangulateInData& inScrapData);
     QVector<uint> createTrianglesFull(const QuadDatabase& database, const QHash<int, int>& mapGridToOut);
-    QVector<QPointF> createTrianglesPartial(const PointGrid& grid, const QuadDatabase &database, const QPolygonF& scrapOutline);
+    void createTrianglesPartial(const PointGrid& grid, const QuadDatabase &database, const QPolygonF& scrapOutline, PointWelder& welder, QVector<uint>& indices);
     QPolygonF addPointsOnOverlapingEdges(QPolygonF polygon) const;
     QList<QPolygonF> createSimplePolygons(QPolygonF polygon) const;
-    void mergeFullAndPartialTriangles(QVector<QVector3D>& pointSet, QVector<uint>& indices, const QVector<QPointF>& unAddedTriangles);
 
     //For transformation from note coords to local note coords
     QMatrix4x4 mapToScrapCoordinates(const QRectF& bounds) const;
-    QVector<QVector3D> mapToLocalNoteCoordinates(QMatrix4x4 toLocal, const QVector<QVector3D>& normalizeNoteCoords) const;
     QVector<QVector2D> mapTexCoordinates(const QVector<QVector3D>& normalizeNoteCoords) const;
     QVector<QVector2D> scaleTexCoordinates(const cwImage& image, QVector<QVector2D> texCoords) const;
 
     //For morphing
-    QVector<QVector3D> morphPoints(const QVector<QVector3D> &notePoints, const cwTriangulateInData &scrapData, const QMatrix4x4& toLocal, const cwImage& croppedImage);
-    QList<cwTriangulateStation> stationsVisibleToPoint(const QVector3D& point, const QList<cwTriangulateStation>& stations, const QPolygonF& scrapOutline) const;
-    QVector3D morphPoint(const QList<cwTriangulateStation>& visibleStations, const QMatrix4x4 &toWorldCoords, const QMatrix4x4 &viewMatrix, const QVector3D &point);
+    QVector<QVector3D> morphPoints(const QVector<QVector3D> &notePoints, const cwTriangulateInData &scrapData, const QMatrix4x4& toLocal, QSize croppedImageSize);
+    MorphStations createMorphStations(const QList<cwTriangulateStation>& stations, const QMatrix4x4& toWorldCoords, const QMatrix4x4& viewMatrix) const;
+    QVector3D morphPoint(const MorphStations& stations, const QMatrix4x4 &toWorldCoords, const QVector3D &point) const;
 
     //For lead handling
     QVector<QVector3D> leadPositionToVector3D(const QList<cwLead>& leads) const;
@@ -179,6 +242,20 @@ inline QPoint cwTriangulateTask::PointGrid::xyIndices(int index) const {
 }
 
 
+/**
+  \brief Gets the x coordinate of the grid's column
+  */
+inline double cwTriangulateTask::PointGrid::x(int column) const {
+    return Points.at(column).x();
+}
+
+/**
+  \brief Gets the y coordinate of the grid's row
+  */
+inline double cwTriangulateTask::PointGrid::y(int row) const {
+    return Points.at(index(0, row)).y();
+}
+
 /**
   Retruns true if the index is in the point grid and false if it's not.
   */
@@ -16,15 +16,37 @@
 #include <QVector>
 #include <QVector3D>
 #include <QVector2D>
+#include <QRectF>
+#include <QList>
 
 class cwTriangulatedData
 {
 public:
+    /**
+     * A coarser mesh of the scrap, for when the scrap is far away. It's triangulated from a
+     * coarser grid, so it has the same outline, and indexes into the same texture.
+     */
+    class LevelOfDetail {
+    public:
+        LevelOfDetail() :
+            GridSpacing(0.0)
+        {}
+
+        double GridSpacing; //!< The distance between the grid's points, in meters in the cave
+        QVector<QVector3D> Points;
+        QVector<QVector2D> TexCoords;
+        QVector<uint> Indices;
+    };
+
     cwTriangulatedData();
 
     cwImage croppedImage() const;
     void setCroppedImage(cwImage croppedImage);
 
+    QRectF cropRect() const;
+    void setCropRect(QRectF cropRect);
+    bool isCropReference() const;
+
     QVector<QVector3D> points() const;
     void setPoints(QVector<QVector3D> points);
 
@@ -37,10 +59,14 @@ public:
     QVector<QVector3D> leadPoints() const;
     void setLeadPoints(QVector<QVector3D> points);
 
+    QList<LevelOfDetail> levelsOfDetail() const;
+    void setLevelsOfDetail(QList<LevelOfDetail> levels);
+
     bool isStale() const;
     void setStale(bool isStale);
 
     bool isNull() const;
+    bool isSharedWith(const cwTriangulatedData& other) const;
 
 private:
     class PrivateData : public QSharedData {
@@ -50,10 +76,12 @@ private:
         {}
 
         cwImage croppedImage;
+        QRectF cropRect;
         QVector<QVector3D> points;
         QVector<QVector2D> texCoords;
         QVector<uint> indices;
         QVector<QVector3D> leadPoints;
+        QList<LevelOfDetail> levelsOfDetail;
         bool Stale;
     };
 
@@ -74,6 +102,38 @@ inline void cwTriangulatedData::setCroppedImage(cwImage croppedImage) {
     Data->croppedImage = croppedImage;
 }
 
+/**
+ * @brief cwTriangulatedData::cropRect
+ * @return The scrap's bounds in the note's normalized image coordinates
+ *
+ * This is null for scraps that were triangulated into a standalone cropped image.
+ */
+inline QRectF cwTriangulatedData::cropRect() const {
+    return Data->cropRect;
+}
+
+/**
+ * @brief cwTriangulatedData::setCropRect
+ * @param cropRect - The scrap's bounds in the note's normalized image coordinates
+ */
+inline void cwTriangulatedData::setCropRect(QRectF cropRect) {
+    Data->cropRect = cropRect;
+}
+
+/**
+ * @brief cwTriangulatedData::isCropReference
+ * @return True if croppedImage() is the note's image, instead of an image that only holds the
+ * scrap.
+ *
+ * A crop reference is a view of the note's existing mipmaps, and the texCoords() are in the
+ * note's normalized coordinates. The images of a crop reference belong to the note, so they
+ * must not be removed with the scrap. Projects saved before crop references have standalone
+ * cropped images, with texCoords() that are normalized to the cropRect().
+ */
+inline bool cwTriangulatedData::isCropReference() const {
+    return Data->cropRect.isValid();
+}
+
 /**
   Get variableName
   */
@@ -136,6 +196,28 @@ inline void cwTriangulatedData::setLeadPoints(QVector<QVector3D> points)
     Data->leadPoints = points;
 }
 
+/**
+ * @brief cwTriangulatedData::levelsOfDetail
+ * @return The coarser meshes of the scrap, from finest to coarsest. The full detail mesh is
+ * points(), texCoords() and indices().
+ *
+ * This is empty for projects that were saved before scraps had levels of detail.
+ */
+inline QList<cwTriangulatedData::LevelOfDetail> cwTriangulatedData::levelsOfDetail() const
+{
+    return Data->levelsOfDetail;
+}
+
+/**
+ * @brief cwTriangulatedData::setLevelsOfDetail
+ * @param levels - The coarser meshes of the scrap, from finest to coarsest
+ *
+ * This should only be set by the cwTriangulateTask
+ */
+inline void cwTriangulatedData::setLevelsOfDetail(QList<cwTriangulatedData::LevelOfDetail> levels)
+{
+    Data->levelsOfDetail = levels;
+}
 
 /**
  * @brief cwTriangulatedData::stale
@@ -159,4 +241,14 @@ inline void cwTriangulatedData::setStale(bool isStale)
 {
     Data->Stale = isStale;
 }
+/**
+ * @brief cwTriangulatedData::isSharedWith
+ * @return True if this and other share the same implicitly shared data. If they're shared, then
+ * they're the same, without having to compare the points.
+ */
+inline bool cwTriangulatedData::isSharedWith(const cwTriangulatedData &other) const
+{
+    return Data.constData() == other.Data.constData();
+}
+
 #endif // CWTRIANGULATEDATA_H
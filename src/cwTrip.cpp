@@ -13,13 +13,20 @@
 #include "cwTripCalibration.h"
 #include "cwSurveyNoteModel.h"
 #include "cwErrorModel.h"
+#include "cwNote.h"
+#include "cwStationOccurrenceIndex.h"
+#include "cwRegionObjectId.h"
 
 //Qt includes
 #include <QMap>
 
 cwTrip::cwTrip(QObject *parent) :
     QObject(parent),
-    ParentCave(nullptr)
+    ParentCave(nullptr),
+    BulkEditDepth(0),
+    BulkInsertBegin(-1),
+    BulkInsertEnd(-1),
+    Id(cwRegionObjectId::next())
 {
 //    DistanceUnit = cwUnits::Meters;
     Team = new cwTeam(this);
@@ -54,6 +61,13 @@ void cwTrip::Copy(const cwTrip& object)
     ErrorModel = new cwErrorModel(this);
 
     //Remove all the originals
+    if(isBulkEditing()) {
+        flushInsertedChunks();
+        foreach(cwSurveyChunk* chunk, Chunks) {
+            chunk->endBulkEdit();
+        }
+    }
+
     int lastChunkIndex = Chunks.size() - 1;
     Chunks.clear();
     emit chunksRemoved(0, lastChunkIndex);
@@ -66,9 +80,12 @@ void cwTrip::Copy(const cwTrip& object)
         newChunk->setParent(this);
         newChunk->setParentTrip(this);
         newChunk->errorModel()->setParentModel(ErrorModel);
+        if(isBulkEditing()) {
+            newChunk->beginBulkEdit();
+        }
         Chunks.append(newChunk);
     }
-    emit chunksInserted(0, object.Chunks.size() - 1);
+    notifyChunksInserted(0, object.Chunks.size() - 1);
 
 }
 
@@ -76,7 +93,11 @@ void cwTrip::Copy(const cwTrip& object)
   \brief Copy constructor
   */
 cwTrip::cwTrip(const cwTrip& object)
-    : QObject(nullptr), cwUndoer()
+    : QObject(nullptr), cwUndoer(),
+      BulkEditDepth(0),
+      BulkInsertBegin(-1),
+      BulkInsertEnd(-1),
+      Id(cwRegionObjectId::next())
 {
     Copy(object);
 }
@@ -94,6 +115,91 @@ cwTrip::~cwTrip()
 {
 }
 
+/**
+ * @brief cwTrip::data
+ * @return A value snapshot of the trip, its team, calibration, chunks and notes
+ */
+cwTripData cwTrip::data() const
+{
+    cwTripData data;
+    data.Id = Id;
+    data.Name = Name;
+    data.Date = Date;
+    data.Team = Team->teamMembers();
+    data.Calibration = Calibration->data();
+
+    data.Chunks.reserve(Chunks.size());
+    foreach(cwSurveyChunk* chunk, Chunks) {
+        data.Chunks.append(chunk->data());
+    }
+
+    data.Notes.reserve(Notes->rowCount());
+    foreach(cwNote* note, Notes->notes()) {
+        data.Notes.append(note->data());
+    }
+
+    return data;
+}
+
+/**
+ * @brief cwTrip::id
+ * @return The trip's id, see cwRegionObjectId. Copies of the trip get a new id
+ */
+qint64 cwTrip::id() const
+{
+    return Id;
+}
+
+/**
+ * @brief cwTrip::setId
+ * @param id - The id that was loaded with the trip
+ */
+void cwTrip::setId(qint64 id)
+{
+    cwRegionObjectId::reserve(id);
+    Id = id;
+}
+
+/**
+ * @brief cwTrip::setData
+ * @param data - Replaces all the data in the trip
+ */
+void cwTrip::setData(const cwTripData &data)
+{
+    if(data.Id != 0) {
+        setId(data.Id);
+    }
+    setName(data.Name);
+    setDate(data.Date);
+    Team->setTeamMembers(data.Team);
+    Calibration->setData(data.Calibration);
+
+    //Replace the notes
+    while(Notes->rowCount() > 0) {
+        Notes->removeNote(Notes->rowCount() - 1);
+    }
+
+    QList<cwNote*> notes;
+    notes.reserve(data.Notes.size());
+    foreach(const cwNoteData& noteData, data.Notes) {
+        cwNote* note = new cwNote();
+        note->setData(noteData);
+        notes.append(note);
+    }
+    Notes->addNotes(notes);
+
+    //Replace the chunks
+    QList<cwSurveyChunk*> chunks;
+    chunks.reserve(data.Chunks.size());
+    foreach(const cwSurveyChunkData& chunkData, data.Chunks) {
+        cwSurveyChunk* chunk = new cwSurveyChunk(this);
+        chunk->setData(chunkData);
+        chunk->errorModel()->setParentModel(ErrorModel);
+        chunks.append(chunk);
+    }
+    setChucks(chunks);
+}
+
 /**
   \brief Set's the name of the survey trip
   */
@@ -195,6 +301,14 @@ void cwTrip::removeChunks(int begin, int end) {
     begin = qMax(0, begin);
     end = qMin(end, numberOfChunks());
 
+    if(isBulkEditing()) {
+        //Listeners need to know about the chunks before they're removed
+        flushInsertedChunks();
+        for(int i = begin; i <= end; i++) {
+            Chunks.at(i)->endBulkEdit();
+        }
+    }
+
     emit chunksAboutToBeRemoved(begin, end);
 
     for(int i = end; i >= begin; i--) {
@@ -219,10 +333,12 @@ void cwTrip::insertChunk(int row, cwSurveyChunk* chunk) {
     //Make this own the chunk
     chunk->setParentTrip(this);
     chunk->errorModel()->setParentModel(errorModel());
+    if(isBulkEditing()) {
+        chunk->beginBulkEdit();
+    }
     Chunks.insert(row, chunk);
 
-    emit chunksInserted(row, row);
-    emit numberOfChunksChanged();
+    notifyChunksInserted(row, row);
 }
 
 /**
@@ -276,9 +392,109 @@ void cwTrip::setChucks(QList<cwSurveyChunk*> chunks) {
 
     foreach(cwSurveyChunk* chunk, Chunks) {
         chunk->setParentTrip(this);
+        if(isBulkEditing()) {
+            chunk->beginBulkEdit();
+        }
     }
 
-    emit chunksInserted(0, numberOfChunks() - 1);
+    notifyChunksInserted(0, numberOfChunks() - 1);
+}
+
+/**
+ * @brief cwTrip::beginBulkEdit
+ *
+ * Starts a bulk edit on the trip and all of its chunks, see cwSurveyChunk::beginBulkEdit().
+ * Chunks that are added during the bulk edit are also bulk edited, and chunksInserted() is
+ * emitted once for chunks that are inserted next to each other. Calls can be nested.
+ *
+ * Use this when adding many shots with addShotToLastChunk(), like when importing.
+ */
+void cwTrip::beginBulkEdit()
+{
+    BulkEditDepth++;
+    if(BulkEditDepth == 1) {
+        foreach(cwSurveyChunk* chunk, Chunks) {
+            chunk->beginBulkEdit();
+        }
+    }
+}
+
+/**
+ * @brief cwTrip::endBulkEdit
+ *
+ * Ends a bulk edit started with beginBulkEdit(). When the outer most bulk edit ends, all the
+ * chunks end their bulk edits, chunksInserted() is emitted for the new chunks, and then
+ * bulkEditFinished() is emitted.
+ */
+void cwTrip::endBulkEdit()
+{
+    Q_ASSERT(BulkEditDepth > 0);
+    if(BulkEditDepth > 1) {
+        BulkEditDepth--;
+        return;
+    }
+
+    //The chunks notify while the trip is still in the bulk edit, so listeners can wait for
+    //bulkEditFinished()
+    foreach(cwSurveyChunk* chunk, Chunks) {
+        chunk->endBulkEdit();
+    }
+    flushInsertedChunks();
+
+    BulkEditDepth = 0;
+    emit bulkEditFinished();
+}
+
+/**
+ * @brief cwTrip::notifyChunksInserted
+ * @param begin - The index of the first inserted chunk
+ * @param end - The index of the last inserted chunk
+ *
+ * Emits chunksInserted(), or if the trip is being bulk edited, merges the chunks into the
+ * inserted range that hasn't been emitted yet. If the chunks aren't next to that range, the range
+ * is emitted first.
+ */
+void cwTrip::notifyChunksInserted(int begin, int end)
+{
+    if(end < begin) {
+        return;
+    }
+
+    if(!isBulkEditing()) {
+        emit chunksInserted(begin, end);
+        emit numberOfChunksChanged();
+        return;
+    }
+
+    if(BulkInsertBegin >= 0 && begin >= BulkInsertBegin && begin <= BulkInsertEnd + 1) {
+        BulkInsertEnd += end - begin + 1;
+        return;
+    }
+
+    flushInsertedChunks();
+    BulkInsertBegin = begin;
+    BulkInsertEnd = end;
+}
+
+/**
+ * @brief cwTrip::flushInsertedChunks
+ *
+ * Emits chunksInserted() for the chunks that were inserted during the bulk edit, that haven't
+ * been emitted yet
+ */
+void cwTrip::flushInsertedChunks()
+{
+    if(BulkInsertBegin < 0) {
+        return;
+    }
+
+    int begin = BulkInsertBegin;
+    int end = BulkInsertEnd;
+    BulkInsertBegin = -1;
+    BulkInsertEnd = -1;
+
+    emit chunksInserted(begin, end);
+    emit numberOfChunksChanged();
 }
 
 /**
@@ -315,6 +531,10 @@ int cwTrip::numberOfStations() const {
   \brief Returns true if this trip has a station with stationName, else returns fales
   */
 bool cwTrip::hasStation(QString stationName) const {
+    if(isIndexedByParentCave()) {
+        return ParentCave->stationOccurrenceIndex()->hasStation(stationName, this);
+    }
+
     foreach(cwSurveyChunk* chunk, Chunks) {
         if(chunk->hasStation(stationName)) {
             return true;
@@ -331,6 +551,10 @@ bool cwTrip::hasStation(QString stationName) const {
   in the trip it will have neighboring stations, if there's at least one shot.
   */
 QSet<cwStation> cwTrip::neighboringStations(QString stationName) const {
+    if(isIndexedByParentCave()) {
+        return ParentCave->stationOccurrenceIndex()->neighboringStations(stationName, this);
+    }
+
     QSet<cwStation> neighbors;
     foreach(cwSurveyChunk* chunk, Chunks) {
         QSet<cwStation> chunkNeighbors = chunk->neighboringStations(stationName);
@@ -339,6 +563,16 @@ QSet<cwStation> cwTrip::neighboringStations(QString stationName) const {
     return neighbors;
 }
 
+/**
+ * @brief cwTrip::isIndexedByParentCave
+ * @return True if the trip is in the parent cave, and the cave's station occurrence index can
+ * be used to look up stations
+ */
+bool cwTrip::isIndexedByParentCave() const
+{
+    return ParentCave != nullptr && ParentCave->indexOf(const_cast<cwTrip*>(this)) >= 0;
+}
+
 /**
  * @brief cwTrip::stationPositionModelUpdated
  *
@@ -359,10 +593,10 @@ void cwTrip::stationPositionModelUpdated()
 QList< cwStation > cwTrip::uniqueStations() const {
     QMap<QString, cwStation> lookup;
     foreach(cwSurveyChunk* chunk, Chunks) {
-        for(int i = 0; i < chunk->stationCount(); i++) {
-            cwStation station = chunk->station(i);
-            if(!station.name().isEmpty()) {
-                lookup[station.name()] = station;
+        const cwStationColumns& stations = chunk->stationColumns();
+        for(int i = 0; i < stations.size(); i++) {
+            if(stations.nameId(i) >= 0) {
+                lookup[stations.name(i)] = stations.at(i);
             }
         }
     }
@@ -14,6 +14,7 @@
 #include "cwError.h"
 #include "cwGlobals.h"
 #include "cwUndoer.h"
+#include "cwTripData.h"
 class cwSurveyChunk;
 class cwCave;
 class cwTeam;
@@ -50,6 +51,12 @@ public:
     cwTrip& operator=(const cwTrip& object);
     ~cwTrip();
 
+    cwTripData data() const;
+    void setData(const cwTripData& data);
+
+    qint64 id() const;
+    void setId(qint64 id);
+
     QString name() const;
     void setName(QString name);
 
@@ -89,6 +96,11 @@ public:
     void stationPositionModelUpdated();
 
     cwErrorModel* errorModel() const;
+
+    void beginBulkEdit();
+    void endBulkEdit();
+    bool isBulkEditing() const;
+
 signals:
     void nameChanged();
     void dateChanged(QDate date);
@@ -100,6 +112,7 @@ signals:
     void notesChanged();
     void numberOfChunksChanged();
     void parentCaveChanged();
+    void bulkEditFinished();
 
 public slots:
     void setChucks(QList<cwSurveyChunk*> chunks);
@@ -120,7 +133,17 @@ protected:
 
     virtual void setUndoStackForChildren();
 private:
+    int BulkEditDepth; //!< Number of nested beginBulkEdit() calls
+    int BulkInsertBegin; //!< First chunk inserted during the bulk edit, that hasn't been notified, -1 if none
+    int BulkInsertEnd; //!< Last chunk inserted during the bulk edit, that hasn't been notified
+
+    qint64 Id; //!< The trip's row in the project file, see cwRegionObjectId
+
     void Copy(const cwTrip& object);
+    bool isIndexedByParentCave() const;
+
+    void notifyChunksInserted(int begin, int end);
+    void flushInsertedChunks();
 
     class NameCommand : public QUndoCommand {
     public:
@@ -149,6 +172,14 @@ private:
 
 Q_DECLARE_METATYPE(cwTrip*)
 
+/**
+ * @brief cwTrip::isBulkEditing
+ * @return True if beginBulkEdit() has been called without a matching endBulkEdit()
+ */
+inline bool cwTrip::isBulkEditing() const {
+    return BulkEditDepth > 0;
+}
+
 /**
 Gets numberOfChunks
 */
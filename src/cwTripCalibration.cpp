@@ -63,6 +63,51 @@ cwTripCalibration& cwTripCalibration::copy(const cwTripCalibration& object) {
     return *this;
 }
 
+/**
+ * @brief cwTripCalibration::data
+ * @return A value copy of all the calibrations
+ */
+cwTripCalibrationData cwTripCalibration::data() const
+{
+    cwTripCalibrationData data;
+    data.CorrectedCompassBacksight = CorrectedCompassBacksight;
+    data.CorrectedClinoBacksight = CorrectedClinoBacksight;
+    data.CorrectedCompassFrontsight = CorrectedCompassFrontsight;
+    data.CorrectedClinoFrontsight = CorrectedClinoFrontsight;
+    data.TapeCalibration = TapeCalibration;
+    data.FrontCompassCalibration = FrontCompassCalibration;
+    data.FrontClinoCalibration = FrontClinoCalibration;
+    data.BackCompassCalibration = BackCompasssCalibration;
+    data.BackClinoCalibration = BackClinoCalibration;
+    data.Declination = Declination;
+    data.DistanceUnit = DistanceUnit;
+    data.FrontSights = FrontSights;
+    data.BackSights = BackSights;
+    return data;
+}
+
+/**
+ * @brief cwTripCalibration::setData
+ * @param data - Sets all the calibrations, this emits the signals for the calibrations that
+ * have changed
+ */
+void cwTripCalibration::setData(const cwTripCalibrationData &data)
+{
+    setCorrectedCompassBacksight(data.CorrectedCompassBacksight);
+    setCorrectedClinoBacksight(data.CorrectedClinoBacksight);
+    setCorrectedCompassFrontsight(data.CorrectedCompassFrontsight);
+    setCorrectedClinoFrontsight(data.CorrectedClinoFrontsight);
+    setTapeCalibration(data.TapeCalibration);
+    setFrontCompassCalibration(data.FrontCompassCalibration);
+    setFrontClinoCalibration(data.FrontClinoCalibration);
+    setBackCompassCalibration(data.BackCompassCalibration);
+    setBackClinoCalibration(data.BackClinoCalibration);
+    setDeclination(data.Declination);
+    setDistanceUnit(data.DistanceUnit);
+    setFrontSights(data.FrontSights);
+    setBackSights(data.BackSights);
+}
+
 void cwTripCalibration::setCorrectedCompassBacksight(bool isCorrected) {
     if(isCorrected != CorrectedCompassBacksight) {
         CorrectedCompassBacksight = isCorrected;
@@ -15,6 +15,7 @@
 
 //Our includes
 #include "cwUnits.h"
+#include "cwTripCalibrationData.h"
 
 class CAVEWHERE_LIB_EXPORT cwTripCalibration : public QObject
 {
@@ -40,6 +41,9 @@ public:
     cwTripCalibration(const cwTripCalibration& object);
     cwTripCalibration& operator =(const cwTripCalibration& object);
 
+    cwTripCalibrationData data() const;
+    void setData(const cwTripCalibrationData& data);
+
     void setCorrectedCompassBacksight(bool isCorrected);
     bool hasCorrectedCompassBacksight() const;
 
@@ -0,0 +1,71 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWTRIPCALIBRATIONDATA_H
+#define CWTRIPCALIBRATIONDATA_H
+
+//Our includes
+#include "cwUnits.h"
+
+/**
+ * @brief The cwTripCalibrationData class
+ *
+ * A plain value copy of cwTripCalibration. This is part of a cwCavingRegionData snapshot.
+ */
+class cwTripCalibrationData {
+public:
+    cwTripCalibrationData() :
+        CorrectedCompassBacksight(false),
+        CorrectedClinoBacksight(false),
+        CorrectedCompassFrontsight(false),
+        CorrectedClinoFrontsight(false),
+        TapeCalibration(0.0),
+        FrontCompassCalibration(0.0),
+        FrontClinoCalibration(0.0),
+        BackCompassCalibration(0.0),
+        BackClinoCalibration(0.0),
+        Declination(0.0),
+        DistanceUnit(cwUnits::Meters),
+        FrontSights(true),
+        BackSights(true)
+    {}
+
+    bool CorrectedCompassBacksight;
+    bool CorrectedClinoBacksight;
+    bool CorrectedCompassFrontsight;
+    bool CorrectedClinoFrontsight;
+    double TapeCalibration;
+    double FrontCompassCalibration;
+    double FrontClinoCalibration;
+    double BackCompassCalibration;
+    double BackClinoCalibration;
+    double Declination;
+    cwUnits::LengthUnit DistanceUnit;
+    bool FrontSights;
+    bool BackSights;
+
+    bool operator==(const cwTripCalibrationData& other) const;
+    bool operator!=(const cwTripCalibrationData& other) const { return !operator==(other); }
+};
+
+inline bool cwTripCalibrationData::operator==(const cwTripCalibrationData& other) const {
+    return CorrectedCompassBacksight == other.CorrectedCompassBacksight &&
+            CorrectedClinoBacksight == other.CorrectedClinoBacksight &&
+            CorrectedCompassFrontsight == other.CorrectedCompassFrontsight &&
+            CorrectedClinoFrontsight == other.CorrectedClinoFrontsight &&
+            TapeCalibration == other.TapeCalibration &&
+            FrontCompassCalibration == other.FrontCompassCalibration &&
+            FrontClinoCalibration == other.FrontClinoCalibration &&
+            BackCompassCalibration == other.BackCompassCalibration &&
+            BackClinoCalibration == other.BackClinoCalibration &&
+            Declination == other.Declination &&
+            DistanceUnit == other.DistanceUnit &&
+            FrontSights == other.FrontSights &&
+            BackSights == other.BackSights;
+}
+
+#endif // CWTRIPCALIBRATIONDATA_H
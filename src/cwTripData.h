@@ -0,0 +1,43 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+#ifndef CWTRIPDATA_H
+#define CWTRIPDATA_H
+
+//Our includes
+#include "cwTripCalibrationData.h"
+#include "cwSurveyChunkData.h"
+#include "cwNoteData.h"
+#include "cwTeamMember.h"
+
+//Qt includes
+#include <QString>
+#include <QDate>
+#include <QList>
+
+/**
+ * @brief The cwTripData class
+ *
+ * A value copy of cwTrip, its team, calibration, survey chunks and notes. This is part of a
+ * cwCavingRegionData snapshot.
+ */
+class cwTripData {
+public:
+    cwTripData() :
+        Id(0)
+    {}
+
+    qint64 Id; //!< See cwRegionObjectId, 0 if the trip doesn't have an id
+    QString Name;
+    QDate Date;
+    QList<cwTeamMember> Team;
+    cwTripCalibrationData Calibration;
+    QList<cwSurveyChunkData> Chunks;
+    QList<cwNoteData> Notes;
+};
+
+#endif // CWTRIPDATA_H
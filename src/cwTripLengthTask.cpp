@@ -34,6 +34,7 @@ void cwTripLengthTask::setTrip(cwTrip *trip) {
         if(Trip != nullptr) {
             connect(Trip, SIGNAL(destroyed()), SLOT(disconnectTrip()));
             connect(Trip, SIGNAL(chunksInserted(int,int)), SLOT(chunkAdded(int,int)));
+            connect(Trip, SIGNAL(bulkEditFinished()), SLOT(restart()));
             connect(Trip->calibrations(), SIGNAL(tapeCalibrationChanged(double)), SLOT(restart()));
             connectChunks();
 
@@ -53,9 +54,9 @@ void cwTripLengthTask::connectChunks()
 
 void cwTripLengthTask::connectChunk(cwSurveyChunk *chunk)
 {
-    connect(chunk, SIGNAL(shotsAdded(int,int)), SLOT(restart()));
-    connect(chunk, SIGNAL(shotsRemoved(int,int)), SLOT(restart()));
-    connect(chunk, SIGNAL(dataChanged(cwSurveyChunk::DataRole,int)), SLOT(restart()));
+    connect(chunk, SIGNAL(shotsAdded(int,int)), SLOT(chunkChanged()));
+    connect(chunk, SIGNAL(shotsRemoved(int,int)), SLOT(chunkChanged()));
+    connect(chunk, SIGNAL(dataChanged(cwSurveyChunk::DataRole,int)), SLOT(chunkChanged()));
 }
 
 void cwTripLengthTask::disconnectChunks()
@@ -79,10 +80,11 @@ QPair<double, int> cwTripLengthTask::distanceOfChunk(const cwSurveyChunk *chunk)
 {
     double distance = 0.0;
     int numberOfShots = 0;
-    foreach(cwShot shot, chunk->shots()) {
-        if(shot.distanceState() == cwDistanceStates::Valid &&
-                shot.isDistanceIncluded()) {
-            distance += shot.distance();
+    const cwShotColumns& shots = chunk->shotColumns();
+    for(int i = 0; i < shots.size(); i++) {
+        if(shots.distanceState(i) == cwDistanceStates::Valid &&
+                shots.isDistanceIncluded(i)) {
+            distance += shots.distance(i);
             numberOfShots++;
         }
     }
@@ -98,6 +100,18 @@ void cwTripLengthTask::chunkAdded(int begin, int end)
     }
 }
 
+/**
+  Restarts the task when a chunk has changed. If the trip is being bulk edited, the task is
+  restarted once, when the trip's bulk edit is finished.
+  */
+void cwTripLengthTask::chunkChanged()
+{
+    if(!Trip.isNull() && Trip->isBulkEditing()) {
+        return;
+    }
+    restart();
+}
+
 /**
   Disconnects the trip from the task
   */
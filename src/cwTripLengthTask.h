@@ -46,6 +46,7 @@ signals:
 
 private slots:
    void chunkAdded(int begin, int end);
+   void chunkChanged();
 
    void disconnectTrip();
 
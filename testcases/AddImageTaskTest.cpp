@@ -0,0 +1,142 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Our includes
+#include "cwAddImageTask.h"
+
+//Qt includes
+#include <QImage>
+#include <QColor>
+
+class AddImageTaskTester {
+public:
+    static int numberOfMipmapLevels(QSize size) {
+        cwAddImageTask task;
+        return task.numberOfMipmapLevels(size);
+    }
+
+    static QList<QImage> createMipmapLevels(const QImage& firstLevel, QByteArray* levelBuffer) {
+        cwAddImageTask task;
+        return task.createMipmapLevels(firstLevel, task.numberOfMipmapLevels(firstLevel.size()), levelBuffer);
+    }
+};
+
+/**
+ * Halves source one pixel at a time, the way HalfImageKernal is documented to
+ */
+static QImage serialHalfImage(const QImage& source) {
+    QImage destination(qMax(source.width() / 2, 1), qMax(source.height() / 2, 1), QImage::Format_RGBA8888);
+    int lastRow = source.height() - 1;
+    int lastColumn = source.width() - 1;
+
+    for(int y = 0; y < destination.height(); y++) {
+        for(int x = 0; x < destination.width(); x++) {
+            QRgb pixels[4] = {
+                source.pixel(qMin(2 * x, lastColumn), qMin(2 * y, lastRow)),
+                source.pixel(qMin(2 * x + 1, lastColumn), qMin(2 * y, lastRow)),
+                source.pixel(qMin(2 * x, lastColumn), qMin(2 * y + 1, lastRow)),
+                source.pixel(qMin(2 * x + 1, lastColumn), qMin(2 * y + 1, lastRow))
+            };
+
+            int red = 0, green = 0, blue = 0, alpha = 0;
+            for(int i = 0; i < 4; i++) {
+                red += qRed(pixels[i]);
+                green += qGreen(pixels[i]);
+                blue += qBlue(pixels[i]);
+                alpha += qAlpha(pixels[i]);
+            }
+
+            destination.setPixel(x, y, qRgba((red + 2) / 4, (green + 2) / 4, (blue + 2) / 4, (alpha + 2) / 4));
+        }
+    }
+
+    return destination;
+}
+
+static QImage testImage(QSize size) {
+    QImage image(size, QImage::Format_RGBA8888);
+    quint32 random = 1;
+    for(int y = 0; y < image.height(); y++) {
+        for(int x = 0; x < image.width(); x++) {
+            random = random * 1664525u + 1013904223u;
+            image.setPixel(x, y, qRgba(random >> 24, (random >> 16) & 0xFF, (x * 13 + y * 7) % 256, 128 + (x % 128)));
+        }
+    }
+    return image;
+}
+
+TEST_CASE("Mipmap levels are halved with a box filter", "[AddImageTask]") {
+
+    SECTION("Level count and sizes") {
+        CHECK(AddImageTaskTester::numberOfMipmapLevels(QSize(256, 128)) == 9);
+        CHECK(AddImageTaskTester::numberOfMipmapLevels(QSize(13, 7)) == 4);
+        CHECK(AddImageTaskTester::numberOfMipmapLevels(QSize(1, 1)) == 1);
+
+        QByteArray levelBuffer;
+        QList<QImage> levels = AddImageTaskTester::createMipmapLevels(testImage(QSize(256, 128)), &levelBuffer);
+        REQUIRE(levels.size() == 9);
+
+        int bufferSize = 0;
+        QSize size(256, 128);
+        for(int i = 0; i < levels.size(); i++) {
+            CHECK(levels.at(i).size() == size);
+            CHECK(levels.at(i).format() == QImage::Format_RGBA8888);
+            if(i > 0) {
+                bufferSize += size.width() * size.height() * 4;
+            }
+            size = QSize(qMax(size.width() / 2, 1), qMax(size.height() / 2, 1));
+        }
+        CHECK(levels.last().size() == QSize(1, 1));
+        CHECK(levelBuffer.size() == bufferSize);
+    }
+
+    SECTION("Odd sizes") {
+        QByteArray levelBuffer;
+        QList<QImage> levels = AddImageTaskTester::createMipmapLevels(testImage(QSize(13, 7)), &levelBuffer);
+
+        QList<QSize> sizes = {QSize(13, 7), QSize(6, 3), QSize(3, 1), QSize(1, 1)};
+        REQUIRE(levels.size() == sizes.size());
+        for(int i = 0; i < levels.size(); i++) {
+            CHECK(levels.at(i).size() == sizes.at(i));
+        }
+    }
+
+    SECTION("Pixels are the average of the serial box filter") {
+        QList<QSize> sizes = {QSize(64, 32), QSize(13, 7), QSize(1, 9), QSize(17, 1)};
+        foreach(QSize size, sizes) {
+            INFO("Size:" << size.width() << "x" << size.height());
+
+            QImage image = testImage(size);
+            QByteArray levelBuffer;
+            QList<QImage> levels = AddImageTaskTester::createMipmapLevels(image, &levelBuffer);
+            REQUIRE(levels.size() == AddImageTaskTester::numberOfMipmapLevels(size));
+            CHECK(levels.first() == image);
+
+            QImage serialLevel = image;
+            for(int i = 1; i < levels.size(); i++) {
+                serialLevel = serialHalfImage(serialLevel);
+                INFO("Level:" << i);
+                CHECK(levels.at(i) == serialLevel);
+            }
+        }
+
+        //A 2x2 block averages to one pixel, rounded to the nearest value
+        QImage block(2, 2, QImage::Format_RGBA8888);
+        block.setPixel(0, 0, qRgba(0, 10, 255, 255));
+        block.setPixel(1, 0, qRgba(1, 20, 255, 255));
+        block.setPixel(0, 1, qRgba(1, 30, 0, 255));
+        block.setPixel(1, 1, qRgba(1, 40, 0, 255));
+
+        QByteArray levelBuffer;
+        QList<QImage> levels = AddImageTaskTester::createMipmapLevels(block, &levelBuffer);
+        REQUIRE(levels.size() == 2);
+        CHECK(levels.at(1).pixel(0, 0) == qRgba(1, 25, 128, 255));
+    }
+}
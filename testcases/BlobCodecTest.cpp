@@ -0,0 +1,81 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Our includes
+#include "cwBlobCodec.h"
+#include "cwImageProvider.h"
+
+//Qt includes
+#include <QtEndian>
+
+//Std includes
+#include <limits>
+
+TEST_CASE("Blob codecs round trip data", "[BlobCodec]") {
+
+    QByteArray data;
+    for(int i = 0; i < 100000; i++) {
+        //Repeating runs, with a little noise, like DXT1 blocks of a scanned page
+        data.append(static_cast<char>((i / 64) % 7 == 0 ? (i * 31) % 251 : i % 16));
+    }
+
+    QList<cwBlobCodec::Codec> codecs = {cwBlobCodec::Stored, cwBlobCodec::FastLZ, cwBlobCodec::Zlib};
+    foreach(cwBlobCodec::Codec codec, codecs) {
+        QByteArray compressed = cwBlobCodec::compress(data, codec);
+        CHECK(cwBlobCodec::uncompress(compressed, codec) == data);
+
+        QByteArray type = cwImageProvider::dxt1Format(codec);
+        CHECK(cwImageProvider::isDxt1Format(type));
+        CHECK(cwBlobCodec::codec(type) == codec);
+        CHECK(cwBlobCodec::baseType(type) == cwImageProvider::Dxt1_Extension);
+    }
+
+    CHECK(cwBlobCodec::compress(data, cwBlobCodec::FastLZ).size() < data.size() / 2);
+
+    SECTION("Small and empty blobs") {
+        QList<QByteArray> smallData = {QByteArray(), QByteArray("a"), QByteArray("abcabcabcabcabcabc")};
+        foreach(QByteArray small, smallData) {
+            CHECK(cwBlobCodec::uncompress(cwBlobCodec::compress(small, cwBlobCodec::FastLZ), cwBlobCodec::FastLZ) == small);
+        }
+    }
+
+    SECTION("Corrupt blobs don't decompress") {
+        QByteArray compressed = cwBlobCodec::compress(data, cwBlobCodec::FastLZ);
+        CHECK(cwBlobCodec::uncompress(compressed.left(compressed.size() / 2), cwBlobCodec::FastLZ).isEmpty());
+    }
+
+    SECTION("Large blobs") {
+        //Highly compressible, close to the 255 to 1 limit of the LZ format
+        QByteArray zeros(64 * 1024 * 1024, '\0');
+        QByteArray compressedZeros = cwBlobCodec::compress(zeros, cwBlobCodec::FastLZ);
+        CHECK(compressedZeros.size() < zeros.size() / 200);
+        CHECK(cwBlobCodec::uncompress(compressedZeros, cwBlobCodec::FastLZ) == zeros);
+
+        //Compresses to a little more than 16MB, where the compressed size times 255 doesn't fit in
+        //32 bits, and wraps around to less than the uncompressed size
+        QByteArray noise(16800000, '\0');
+        quint32 random = 1;
+        for(int i = 0; i < noise.size(); i++) {
+            random = random * 1664525u + 1013904223u;
+            noise[i] = static_cast<char>(random >> 24);
+        }
+        QByteArray compressedNoise = cwBlobCodec::compress(noise, cwBlobCodec::FastLZ);
+        REQUIRE(static_cast<quint64>(compressedNoise.size()) * 255u > std::numeric_limits<quint32>::max());
+        REQUIRE(static_cast<quint32>(compressedNoise.size()) * 255u < static_cast<quint32>(noise.size()));
+        CHECK(cwBlobCodec::uncompress(compressedNoise, cwBlobCodec::FastLZ) == noise);
+
+        //A corrupt size, that QByteArray can't hold
+        QByteArray badSize = compressedNoise;
+        qToBigEndian(std::numeric_limits<quint32>::max(), reinterpret_cast<uchar*>(badSize.data()));
+        CHECK(cwBlobCodec::uncompress(badSize, cwBlobCodec::FastLZ).isEmpty());
+    }
+
+    CHECK(cwImageProvider::dxt1Format(cwBlobCodec::Zlib) == cwImageProvider::Dxt1_GZ_Extension);
+}
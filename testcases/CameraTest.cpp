@@ -0,0 +1,75 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Our includes
+#include "cwCamera.h"
+#include "cwProjection.h"
+
+//Std includes
+#include <limits>
+
+TEST_CASE("Camera finds the pixels per meter of a box", "[Camera]") {
+
+    cwCamera camera;
+    camera.setViewport(QRect(0, 0, 800, 800));
+
+    SECTION("Ortho") {
+        //100 meters across 800 pixels
+        cwProjection projection;
+        projection.setOrtho(-50, 50, -50, 50, -1000, 1000);
+        camera.setProjection(projection);
+
+        CHECK(camera.pixelsPerMeter(QBox3D(QVector3D(-1, -1, -1), QVector3D(1, 1, 1))) == Approx(8.0));
+        CHECK(camera.pixelsPerMeter(QBox3D(QVector3D(10, 20, -500), QVector3D(11, 21, -400))) == Approx(8.0));
+        CHECK(camera.pixelsPerMeter(QBox3D(QVector3D(-1, -1, -1), QVector3D(1, 1, 1))) == Approx(camera.pixelsPerMeter()));
+
+        //Moving the camera doesn't change the scale
+        QMatrix4x4 view;
+        view.translate(0, 0, -300);
+        camera.setViewMatrix(view);
+        CHECK(camera.pixelsPerMeter(QBox3D(QVector3D(-1, -1, -1), QVector3D(1, 1, 1))) == Approx(8.0));
+    }
+
+    SECTION("Perspective") {
+        //A 90 degree field of view, so the viewport is 2 meters across, one meter away
+        cwProjection projection;
+        projection.setPerspective(90.0, 1.0, 1.0, 1000.0);
+        camera.setProjection(projection);
+
+        //The camera looks down -z, and the nearest corner sets the scale
+        double near = camera.pixelsPerMeter(QBox3D(QVector3D(-1, -1, -10), QVector3D(1, 1, -9)));
+        double far = camera.pixelsPerMeter(QBox3D(QVector3D(-1, -1, -100), QVector3D(1, 1, -90)));
+        CHECK(near == Approx(800.0 / (2.0 * 9.0)));
+        CHECK(far == Approx(800.0 / (2.0 * 90.0)));
+        CHECK(near / far == Approx(10.0));
+
+        //Off to the side, it's the depth that matters
+        CHECK(camera.pixelsPerMeter(QBox3D(QVector3D(5, 5, -10), QVector3D(6, 6, -9))) == Approx(near));
+
+        //Moving the camera back
+        QMatrix4x4 view;
+        view.translate(0, 0, -81);
+        camera.setViewMatrix(view);
+        CHECK(camera.pixelsPerMeter(QBox3D(QVector3D(-1, -1, -10), QVector3D(1, 1, -9))) == Approx(far));
+
+        //The camera is in the box, or the box is behind the camera
+        camera.setViewMatrix(QMatrix4x4());
+        CHECK(camera.pixelsPerMeter(QBox3D(QVector3D(-1, -1, -1), QVector3D(1, 1, 1))) == std::numeric_limits<double>::infinity());
+        CHECK(camera.pixelsPerMeter(QBox3D(QVector3D(-1, -1, 9), QVector3D(1, 1, 10))) == std::numeric_limits<double>::infinity());
+    }
+
+    SECTION("Null box") {
+        cwProjection projection;
+        projection.setPerspective(90.0, 1.0, 1.0, 1000.0);
+        camera.setProjection(projection);
+
+        CHECK(camera.pixelsPerMeter(QBox3D()) == 0.0);
+    }
+}
@@ -0,0 +1,79 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Our includes
+#include "cwCullingHierarchy.h"
+#include "cwFrustum.h"
+
+TEST_CASE("Frustum classifies boxes", "[Culling]") {
+
+    QMatrix4x4 projection;
+    projection.ortho(-10, 10, -10, 10, -100, 100);
+
+    cwFrustum frustum(projection);
+
+    CHECK(frustum.contains(QBox3D(QVector3D(-1, -1, -1), QVector3D(1, 1, 1))) == cwFrustum::Inside);
+    CHECK(frustum.contains(QBox3D(QVector3D(9, 9, 0), QVector3D(11, 11, 1))) == cwFrustum::Intersecting);
+    CHECK(frustum.contains(QBox3D(QVector3D(20, 0, 0), QVector3D(21, 1, 1))) == cwFrustum::Outside);
+    CHECK(frustum.contains(QBox3D(QVector3D(0, 0, 200), QVector3D(1, 1, 201))) == cwFrustum::Outside);
+    CHECK(frustum.contains(QBox3D()) == cwFrustum::Outside);
+
+    QMatrix4x4 perspective;
+    perspective.perspective(90.0f, 1.0f, 1.0f, 100.0f);
+    cwFrustum perspectiveFrustum(perspective);
+
+    //The camera looks down -z
+    CHECK(perspectiveFrustum.contains(QBox3D(QVector3D(-1, -1, -11), QVector3D(1, 1, -10))) == cwFrustum::Inside);
+    CHECK(perspectiveFrustum.contains(QBox3D(QVector3D(-1, -1, 10), QVector3D(1, 1, 11))) == cwFrustum::Outside);
+    CHECK(perspectiveFrustum.contains(QBox3D(QVector3D(30, -1, -11), QVector3D(31, 1, -10))) == cwFrustum::Outside);
+}
+
+TEST_CASE("Culling hierarchy finds the visible parts", "[Culling]") {
+
+    //A row of unit boxes along x
+    QVector<QBox3D> bounds;
+    for(int i = 0; i < 100; i++) {
+        bounds.append(QBox3D(QVector3D(i, 0, 0), QVector3D(i + 0.5, 0.5, 0.5)));
+    }
+    bounds.append(QBox3D()); //Never visible
+
+    cwCullingHierarchy culling;
+    culling.setBounds(bounds);
+
+    QMatrix4x4 projection;
+    projection.ortho(-10, 10, -10, 10, -100, 100);
+
+    QMatrix4x4 view;
+    view.translate(-20, 0, 0);
+
+    CHECK(culling.cull(projection * view));
+
+    //Boxes from x = 10 to x = 30 are in view
+    QVector<int> expected;
+    for(int i = 10; i <= 30; i++) {
+        expected.append(i);
+    }
+    CHECK(culling.visible() == expected);
+
+    //Cached while the camera is still
+    CHECK(!culling.cull(projection * view));
+    CHECK(culling.visible() == expected);
+
+    //Everything
+    QMatrix4x4 wide;
+    wide.ortho(-1000, 1000, -1000, 1000, -100, 100);
+    CHECK(culling.cull(wide));
+    CHECK(culling.visible().size() == 100);
+
+    //New bounds invalidate the cache
+    culling.setBounds(bounds.mid(0, 5));
+    CHECK(culling.cull(wide));
+    CHECK(culling.visible().size() == 5);
+}
@@ -0,0 +1,282 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Our includes
+#include "cwGLLinePlot.h"
+#include "cwCamera.h"
+#include "cwProjection.h"
+
+//Qt includes
+#include <QSet>
+#include <QtMath>
+
+//Std includes
+#include <limits>
+
+class GLLinePlotTester {
+public:
+    GLLinePlotTester(const QVector<QVector3D>& points, const QVector<unsigned int>& indexes) {
+        Plot.setPoints(points);
+        Plot.setIndexes(indexes);
+    }
+
+    QVector<unsigned int> simplifyLines(double tolerance) const {
+        return Plot.simplifyLines(tolerance);
+    }
+
+    void setTolerances(const QList<double>& tolerances) {
+        Plot.Levels.clear();
+        foreach(double tolerance, tolerances) {
+            cwGLLinePlot::Level level;
+            level.Tolerance = tolerance;
+            Plot.Levels.append(level);
+        }
+    }
+
+    int levelOfDetail(double pixelsPerMeter, int currentLevel) const {
+        return Plot.levelOfDetail(pixelsPerMeter, currentLevel);
+    }
+
+    QVector<unsigned int> updateLevels() { return Plot.updateLevels(); }
+    bool updateVisibleCells(cwCamera* camera) { return Plot.updateVisibleCells(camera); }
+
+    QVector<QPair<int, int> > drawRanges() {
+        Plot.updateDrawRanges();
+        return Plot.DrawRanges;
+    }
+
+    QVector<cwGLLinePlot::Level> levels() const { return Plot.Levels; }
+    QBox3D bounds() const { return Plot.Bounds; }
+    int numberOfCells() const { return Plot.CellCodes.size(); }
+    QBox3D cellBounds(int cell) const { return Plot.CellBounds.at(cell); }
+    int cellLevel(int cell) const { return Plot.CellLevels.at(cell); }
+    QVector<int> visibleCells() const { return Plot.Culling.visible(); }
+
+private:
+    cwGLLinePlot Plot;
+};
+
+/**
+ * The line segments in indexes, each with the smaller index first, so the order doesn't matter
+ */
+static QSet<QPair<unsigned int, unsigned int> > segments(const QVector<unsigned int>& indexes) {
+    QSet<QPair<unsigned int, unsigned int> > segments;
+    for(int i = 0; i + 1 < indexes.size(); i += 2) {
+        segments.insert(qMakePair(qMin(indexes.at(i), indexes.at(i + 1)),
+                                  qMax(indexes.at(i), indexes.at(i + 1))));
+    }
+    return segments;
+}
+
+static QPair<unsigned int, unsigned int> segment(unsigned int first, unsigned int second) {
+    return qMakePair(first, second);
+}
+
+TEST_CASE("Line plot simplifies chains", "[GLLinePlot]") {
+
+    //A small zigzag along x, with a spike at station 5
+    QVector<QVector3D> points;
+    QVector<unsigned int> indexes;
+    for(int i = 0; i <= 10; i++) {
+        float y = i == 5 ? 3.0f : (i % 2 == 0 ? 0.1f : -0.1f);
+        points.append(QVector3D(i * 2.0f, y, 0.0f));
+        if(i > 0) {
+            indexes.append(i - 1);
+            indexes.append(i);
+        }
+    }
+
+    GLLinePlotTester tester(points, indexes);
+
+    SECTION("A tiny tolerance keeps every station") {
+        CHECK(segments(tester.simplifyLines(0.01)) == segments(indexes));
+    }
+
+    SECTION("The zigzag is removed, the spike, its base, and the ends are kept") {
+        QSet<QPair<unsigned int, unsigned int> > expected;
+        expected.insert(segment(0, 4));
+        expected.insert(segment(4, 5));
+        expected.insert(segment(5, 6));
+        expected.insert(segment(6, 10));
+        CHECK(segments(tester.simplifyLines(1.0)) == expected);
+    }
+
+    SECTION("A large tolerance keeps the ends") {
+        QSet<QPair<unsigned int, unsigned int> > expected;
+        expected.insert(segment(0, 10));
+        CHECK(segments(tester.simplifyLines(10.0)) == expected);
+    }
+}
+
+TEST_CASE("Line plot simplification keeps junctions", "[GLLinePlot]") {
+
+    //A passage along x, with a side passage from station 2 along y
+    QVector<QVector3D> points;
+    for(int i = 0; i < 5; i++) {
+        points.append(QVector3D(i, 0.0f, 0.0f));
+    }
+    for(int i = 1; i <= 3; i++) {
+        points.append(QVector3D(2.0f, i, 0.0f));
+    }
+
+    QVector<unsigned int> indexes;
+    indexes << 0 << 1 << 1 << 2 << 2 << 3 << 3 << 4;
+    indexes << 2 << 5 << 5 << 6 << 6 << 7;
+
+    GLLinePlotTester tester(points, indexes);
+
+    QSet<QPair<unsigned int, unsigned int> > expected;
+    expected.insert(segment(0, 2));
+    expected.insert(segment(2, 4));
+    expected.insert(segment(2, 7));
+    CHECK(segments(tester.simplifyLines(1.0)) == expected);
+}
+
+TEST_CASE("Line plot simplification keeps loops closed", "[GLLinePlot]") {
+
+    //A square loop, with stations at the corners and the middle of the sides, without a junction
+    QVector<QVector3D> points;
+    points << QVector3D(0, 0, 0) << QVector3D(1, 0, 0) << QVector3D(2, 0, 0) << QVector3D(2, 1, 0)
+           << QVector3D(2, 2, 0) << QVector3D(1, 2, 0) << QVector3D(0, 2, 0) << QVector3D(0, 1, 0);
+
+    QVector<unsigned int> indexes;
+    for(int i = 0; i < points.size(); i++) {
+        indexes.append(i);
+        indexes.append((i + 1) % points.size());
+    }
+
+    GLLinePlotTester tester(points, indexes);
+
+    QSet<QPair<unsigned int, unsigned int> > expected;
+    expected.insert(segment(0, 2));
+    expected.insert(segment(2, 4));
+    expected.insert(segment(4, 6));
+    expected.insert(segment(0, 6));
+    CHECK(segments(tester.simplifyLines(0.1)) == expected);
+}
+
+TEST_CASE("Line plot level of detail has hysteresis", "[GLLinePlot]") {
+    GLLinePlotTester tester(QVector<QVector3D>(), QVector<unsigned int>());
+    tester.setTolerances(QList<double>() << 0.0 << 1.0 << 4.0 << 16.0);
+
+    //Level 1's error is a pixel, neither level changes
+    CHECK(tester.levelOfDetail(1.0, 0) == 0);
+    CHECK(tester.levelOfDetail(1.0, 1) == 1);
+
+    //Inside the band, between 1/1.5 and 1.5 pixels
+    CHECK(tester.levelOfDetail(1.4, 1) == 1);
+    CHECK(tester.levelOfDetail(0.7, 0) == 0);
+
+    //Outside the band
+    CHECK(tester.levelOfDetail(1.6, 1) == 0);
+    CHECK(tester.levelOfDetail(0.6, 0) == 1);
+
+    //Far and near
+    CHECK(tester.levelOfDetail(0.01, 0) == 3);
+    CHECK(tester.levelOfDetail(10.0, 3) == 0);
+    CHECK(tester.levelOfDetail(std::numeric_limits<double>::infinity(), 2) == 0);
+    CHECK(tester.levelOfDetail(0.0, 0) == 3);
+}
+
+TEST_CASE("Line plot picks the level of detail for each cell", "[GLLinePlot]") {
+
+    //A long passage along x, that winds in y and z, with a small zigzag
+    QVector<QVector3D> points;
+    QVector<unsigned int> indexes;
+    for(int i = 0; i <= 4000; i++) {
+        float x = i * 2.5f;
+        float zigzag = i % 2 == 0 ? 0.3f : -0.3f;
+        points.append(QVector3D(x, 10.0f * qSin(x / 50.0f) + zigzag, 10.0f * qCos(x / 70.0f)));
+        if(i > 0) {
+            indexes.append(i - 1);
+            indexes.append(i);
+        }
+    }
+
+    GLLinePlotTester tester(points, indexes);
+
+    QVector<unsigned int> allIndexes = tester.updateLevels();
+    auto levels = tester.levels();
+
+    REQUIRE(levels.size() > 1);
+    REQUIRE(tester.numberOfCells() > 1);
+    CHECK(levels.first().NumberOfIndexes == indexes.size());
+
+    int numberOfIndexes = 0;
+    foreach(const auto& level, levels) {
+        CHECK(level.IndexOffset == numberOfIndexes);
+        REQUIRE(level.CellOffsets.size() == tester.numberOfCells() + 1);
+        CHECK(level.CellOffsets.first() == 0);
+        CHECK(level.CellOffsets.last() == level.NumberOfIndexes);
+        for(int i = 1; i < level.CellOffsets.size(); i++) {
+            CHECK(level.CellOffsets.at(i - 1) <= level.CellOffsets.at(i));
+        }
+        CHECK(segments(allIndexes.mid(level.IndexOffset, level.NumberOfIndexes)) ==
+              segments(level.Tolerance == 0.0 ? indexes : tester.simplifyLines(level.Tolerance)));
+        numberOfIndexes += level.NumberOfIndexes;
+    }
+    CHECK(numberOfIndexes == allIndexes.size());
+
+    //The camera is in the middle of the passage, looking down it
+    cwCamera camera;
+    camera.setViewport(QRect(0, 0, 1000, 1000));
+
+    cwProjection projection;
+    projection.setPerspective(60.0, 1.0, 1.0, 20000.0);
+    camera.setProjection(projection);
+
+    QMatrix4x4 view;
+    view.lookAt(QVector3D(5000.0f, 0.0f, 0.0f), QVector3D(6000.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f));
+    camera.setViewMatrix(view);
+
+    //The camera is inside the line plot, so one level for the whole plot would be the full plot
+    CHECK(camera.pixelsPerMeter(tester.bounds()) == std::numeric_limits<double>::infinity());
+
+    CHECK(tester.updateVisibleCells(&camera));
+
+    QVector<int> visibleCells = tester.visibleCells();
+    REQUIRE(!visibleCells.isEmpty());
+
+    //The cells behind the camera aren't drawn
+    CHECK(visibleCells.size() < tester.numberOfCells());
+
+    //The nearest cell is detailed, and the farthest is coarse
+    int nearCell = visibleCells.first();
+    int farCell = visibleCells.first();
+    foreach(int cell, visibleCells) {
+        if(camera.pixelsPerMeter(tester.cellBounds(cell)) > camera.pixelsPerMeter(tester.cellBounds(nearCell))) {
+            nearCell = cell;
+        }
+        if(camera.pixelsPerMeter(tester.cellBounds(cell)) < camera.pixelsPerMeter(tester.cellBounds(farCell))) {
+            farCell = cell;
+        }
+    }
+
+    CHECK(tester.cellLevel(nearCell) == 0);
+    CHECK(camera.pixelsPerMeter(tester.cellBounds(farCell)) < 1.0 / 1.5);
+    CHECK(tester.cellLevel(farCell) > 0);
+
+    //Each visible cell is drawn from its own level
+    int expectedCount = 0;
+    foreach(int cell, visibleCells) {
+        const auto& level = levels.at(tester.cellLevel(cell));
+        expectedCount += level.CellOffsets.at(cell + 1) - level.CellOffsets.at(cell);
+    }
+
+    int drawCount = 0;
+    typedef QPair<int, int> DrawRange;
+    foreach(const DrawRange& range, tester.drawRanges()) {
+        drawCount += range.second;
+    }
+    CHECK(drawCount == expectedCount);
+
+    //Nothing changes while the camera is still
+    CHECK(!tester.updateVisibleCells(&camera));
+}
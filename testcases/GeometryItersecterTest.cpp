@@ -0,0 +1,50 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Our includes
+#include "cwGeometryItersecter.h"
+
+//Qt includes
+#include <QtNumeric>
+
+TEST_CASE("Geometry intersecter finds the closest triangle", "[GeometryItersecter]") {
+
+    //Two squares, one at z = 0 and one at z = 5
+    QVector<QVector3D> points = {
+        QVector3D(0, 0, 0), QVector3D(10, 0, 0), QVector3D(10, 10, 0), QVector3D(0, 10, 0),
+        QVector3D(0, 0, 5), QVector3D(10, 0, 5), QVector3D(10, 10, 5), QVector3D(0, 10, 5)
+    };
+    QVector<uint> indexes = {0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7};
+
+    cwGeometryItersecter intersecter;
+    intersecter.addObject(cwGeometryItersecter::Object(nullptr, 1, points, indexes, cwGeometryItersecter::Triangles));
+
+    QRay3D downRay(QVector3D(2, 3, 20), QVector3D(0, 0, -1));
+    CHECK(intersecter.intersects(downRay) == Approx(15.0));
+
+    SECTION("Replacing an object") {
+        intersecter.addObject(cwGeometryItersecter::Object(nullptr, 1, points, indexes.mid(0, 6), cwGeometryItersecter::Triangles));
+        CHECK(intersecter.intersects(downRay) == Approx(20.0));
+    }
+
+    SECTION("Missing uses the nearest line") {
+        QVector<QVector3D> linePoints = {QVector3D(20, 0, 0), QVector3D(20, 10, 0)};
+        QVector<uint> lineIndexes = {0, 1};
+        intersecter.addObject(cwGeometryItersecter::Object(nullptr, 2, linePoints, lineIndexes, cwGeometryItersecter::Lines));
+        intersecter.removeObject(nullptr, 1);
+
+        //Misses the line by 1 unit
+        QRay3D ray(QVector3D(21, 5, 21), QVector3D(0, 0, -1));
+        CHECK(intersecter.intersects(ray) == Approx(21.0));
+
+        intersecter.clear();
+        CHECK(qIsNaN(intersecter.intersects(ray)));
+    }
+}
@@ -0,0 +1,148 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Our includes
+#include "cwGlyphAtlas.h"
+
+//Qt includes
+#include <QList>
+#include <QPair>
+
+namespace {
+
+const QString Characters = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789.-";
+
+/**
+ * The fonts used by the tests, each size has its own glyphs
+ */
+QList<QFont> fonts(int first, int last) {
+    QList<QFont> fonts;
+    for(int size = first; size <= last; size += 4) {
+        QFont font;
+        font.setPixelSize(size);
+        fonts.append(font);
+    }
+    return fonts;
+}
+
+typedef QPair<QFont, QChar> GlyphId;
+
+/**
+ * Adds Characters in every font to atlas
+ */
+QList<GlyphId> addGlyphs(cwGlyphAtlas* atlas, const QList<QFont>& fonts) {
+    QList<GlyphId> glyphs;
+    foreach(const QFont& font, fonts) {
+        atlas->addText(Characters, font);
+        foreach(QChar character, Characters) {
+            glyphs.append(GlyphId(font, character));
+        }
+    }
+    return glyphs;
+}
+
+}
+
+TEST_CASE("Glyph atlas packs glyphs without overlapping", "[GlyphAtlas]") {
+    cwGlyphAtlas atlas;
+    QList<GlyphId> glyphs = addGlyphs(&atlas, fonts(10, 30));
+
+    QRect imageRect = atlas.image().rect();
+    QList<QRect> rects;
+    foreach(const GlyphId& id, glyphs) {
+        cwGlyphAtlas::Glyph glyph = atlas.glyph(id.second, id.first);
+        INFO("Character:" << id.second.toLatin1() << " pixel size:" << id.first.pixelSize());
+        REQUIRE(!glyph.Rect.isEmpty());
+        CHECK(imageRect.contains(glyph.Rect));
+        CHECK(glyph.Advance > 0.0);
+
+        foreach(const QRect& rect, rects) {
+            CHECK(!rect.intersects(glyph.Rect));
+        }
+        rects.append(glyph.Rect);
+    }
+
+    SECTION("Glyphs wrap into rows") {
+        QRect first = rects.first();
+        int wrapped = 0;
+        for(int i = 1; i < rects.size(); i++) {
+            if(rects.at(i).x() < rects.at(i - 1).x()) {
+                //A new row starts at the left, below the previous row
+                CHECK(rects.at(i).x() == first.x());
+                CHECK(rects.at(i).top() > rects.at(i - 1).top());
+                wrapped++;
+            } else {
+                CHECK(rects.at(i).top() == rects.at(i - 1).top());
+            }
+        }
+        CHECK(wrapped > 0);
+    }
+
+    SECTION("Adding a glyph again doesn't change the atlas") {
+        QImage image = atlas.image();
+        CHECK(!atlas.addText(Characters, glyphs.first().first));
+        CHECK(atlas.image() == image);
+        CHECK(atlas.glyph(glyphs.first().second, glyphs.first().first).Rect == rects.first());
+    }
+}
+
+TEST_CASE("Glyph atlas keeps glyphs in place when it grows", "[GlyphAtlas]") {
+    cwGlyphAtlas atlas;
+    QList<GlyphId> glyphs = addGlyphs(&atlas, fonts(10, 14));
+
+    QImage image = atlas.image();
+    QList<QRect> rects;
+    foreach(const GlyphId& id, glyphs) {
+        rects.append(atlas.glyph(id.second, id.first).Rect);
+    }
+
+    //Big glyphs make the atlas taller
+    QList<GlyphId> bigGlyphs = addGlyphs(&atlas, fonts(40, 60));
+    CHECK(atlas.image().width() == image.width());
+    REQUIRE(atlas.image().height() > image.height());
+
+    for(int i = 0; i < glyphs.size(); i++) {
+        cwGlyphAtlas::Glyph glyph = atlas.glyph(glyphs.at(i).second, glyphs.at(i).first);
+        INFO("Character:" << glyphs.at(i).second.toLatin1() << " pixel size:" << glyphs.at(i).first.pixelSize());
+        CHECK(glyph.Rect == rects.at(i));
+        CHECK(atlas.image().copy(glyph.Rect) == image.copy(rects.at(i)));
+    }
+
+    //The new glyphs don't cover the old ones
+    foreach(const GlyphId& id, bigGlyphs) {
+        QRect rect = atlas.glyph(id.second, id.first).Rect;
+        foreach(const QRect& oldRect, rects) {
+            CHECK(!rect.intersects(oldRect));
+        }
+    }
+}
+
+TEST_CASE("Glyph atlas doesn't draw whitespace", "[GlyphAtlas]") {
+    cwGlyphAtlas atlas;
+    QFont font;
+    font.setPixelSize(20);
+
+    QImage image = atlas.image();
+    CHECK(atlas.addText(" ", font));
+    CHECK(atlas.image() == image);
+
+    cwGlyphAtlas::Glyph space = atlas.glyph(' ', font);
+    CHECK(space.Rect.isEmpty());
+    CHECK(space.Advance > 0.0);
+
+    //The next glyph goes where the space would have been
+    CHECK(atlas.addText("A A", font));
+    CHECK(atlas.glyph('A', font).Rect.topLeft() == QPoint(1, 1));
+    CHECK(!atlas.glyph('A', font).Rect.isEmpty());
+
+    //Glyphs that haven't been added are empty
+    CHECK(atlas.glyph('B', font).Rect.isEmpty());
+    CHECK(atlas.glyph('B', font).Advance == 0.0);
+}
@@ -0,0 +1,130 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Cavewhere includes
+#include "cwImageProvider.h"
+
+//Qt includes
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QtConcurrent>
+
+static void createImageDatabase(const QString& filename, const QByteArray& imageData) {
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "ImageProviderTest");
+        database.setDatabaseName(filename);
+        REQUIRE(database.open());
+
+        QSqlQuery query(database);
+        REQUIRE(query.exec("CREATE TABLE Images (id INTEGER PRIMARY KEY AUTOINCREMENT, type STRING, "
+                           "shouldDelete BOOL, width INTEGER, height INTEGER, dotsPerMeter INTEGER, imageData BLOB)"));
+        REQUIRE(query.prepare("INSERT INTO Images (type, shouldDelete, width, height, dotsPerMeter, imageData) "
+                              "VALUES ('png', 0, 1, 1, 1000, ?)"));
+        query.addBindValue(imageData);
+        REQUIRE(query.exec());
+    }
+    QSqlDatabase::removeDatabase("ImageProviderTest");
+}
+
+/**
+ * Returns the number of file descriptors that this process has open to filename, or -1 if the
+ * platform can't list them
+ */
+static int openHandles(const QString& filename) {
+#ifdef Q_OS_LINUX
+    QString canonicalFilename = QFileInfo(filename).canonicalFilePath();
+    int count = 0;
+    QDirIterator iter("/proc/self/fd", QDir::System);
+    while(iter.hasNext()) {
+        iter.next();
+        if(iter.fileInfo().symLinkTarget() == canonicalFilename) {
+            count++;
+        }
+    }
+    return count;
+#else
+    Q_UNUSED(filename);
+    return -1;
+#endif
+}
+
+TEST_CASE("Image provider releases connections before a project is removed", "[ImageProvider]") {
+    QString filename = QString("%1/ImageProviderTest-%2.cw")
+            .arg(QDir::tempPath())
+            .arg(QDateTime::currentMSecsSinceEpoch(), 0, 16);
+    QFile::remove(filename);
+
+    createImageDatabase(filename, "first");
+
+    cwImageProvider provider;
+    provider.setProjectPath(filename);
+
+    //A thread pool thread closes its connection after each request
+    QFuture<QByteArray> future = QtConcurrent::run([&provider]() {
+        return provider.data(1).data();
+    });
+    CHECK(future.result() == QByteArray("first"));
+
+    if(openHandles(filename) != -1) {
+        CHECK(openHandles(filename) == 0);
+    }
+
+    //The GUI thread keeps its connection open
+    CHECK(provider.data(1).data() == QByteArray("first"));
+    CHECK(provider.data(1, true).size() == QSize(1, 1));
+
+    if(openHandles(filename) != -1) {
+        CHECK(openHandles(filename) == 1);
+    }
+
+    //Many requests from the thread pool, while the GUI thread's connection is open
+    QList<QFuture<QByteArray> > futures;
+    for(int i = 0; i < 16; i++) {
+        futures.append(QtConcurrent::run([&provider]() {
+            return provider.data(1).data();
+        }));
+    }
+    foreach(QFuture<QByteArray> request, futures) {
+        CHECK(request.result() == QByteArray("first"));
+    }
+
+    if(openHandles(filename) != -1) {
+        CHECK(openHandles(filename) == 1);
+    }
+
+    cwImageProvider::closeConnections(filename);
+
+    if(openHandles(filename) != -1) {
+        CHECK(openHandles(filename) == 0);
+    }
+
+    //Replace the project, the GUI thread reopens its connection with the new file
+    REQUIRE(QFile::remove(filename));
+    createImageDatabase(filename, "second");
+
+    CHECK(provider.data(1).data() == QByteArray("second"));
+    future = QtConcurrent::run([&provider]() {
+        return provider.data(1).data();
+    });
+    CHECK(future.result() == QByteArray("second"));
+
+    //Changing the project releases the old project's connections
+    provider.setProjectPath(QString());
+    if(openHandles(filename) != -1) {
+        CHECK(openHandles(filename) == 0);
+    }
+
+    CHECK(QFile::remove(filename));
+}
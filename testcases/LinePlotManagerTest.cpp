@@ -26,6 +26,7 @@
 //Qt includes
 #include <QThread>
 #include <QApplication>
+#include <QSignalSpy>
 
 TEST_CASE("Survey network are returned", "[LinePlotManager]") {
     cwProject* project = fileToProject(":/datasets/network.cw");
@@ -118,6 +119,23 @@ TEST_CASE("Changing data, adding and removing caves, trips, survey chunks should
             CHECK(cave->stationPositionLookup().position("a2") == QVector3D(0.0, 20.0, 0.0));
         }
 
+        SECTION("A burst of edits runs the line plot once") {
+            QSignalSpy completedSpy(plotManager, SIGNAL(completedGenerationChanged()));
+
+            chunk->setData(cwSurveyChunk::ShotDistanceRole, 0, 11.0);
+            chunk->setData(cwSurveyChunk::ShotDistanceRole, 0, 12.0);
+            chunk->setData(cwSurveyChunk::ShotDistanceRole, 0, 13.0);
+
+            CHECK(plotManager->isStale() == true);
+
+            plotManager->waitToFinish();
+
+            CHECK(completedSpy.size() == 1);
+            CHECK(plotManager->isStale() == false);
+            CHECK(plotManager->completedGeneration() == plotManager->requestedGeneration());
+            CHECK(cave->length()->value() == 13.0);
+        }
+
         SECTION("Setting compass data should re-run line plot") {
             chunk->setData(cwSurveyChunk::ShotCompassRole, 0, 90.0);
 
@@ -0,0 +1,124 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Cavewhere includes
+#include "cwLinePlotTask.h"
+#include "cwCavingRegion.h"
+#include "cwCave.h"
+#include "cwTrip.h"
+#include "cwSurveyChunk.h"
+
+/**
+ * Gives the testcases access to cwLinePlotTask's local copy of the region
+ */
+class LinePlotTaskTester {
+public:
+    static cwCavingRegion* region(const cwLinePlotTask& task) { return task.Region; }
+};
+
+/**
+ * Adds a cave with one shot, from a1 to a2, that's distance long and heads north
+ */
+static cwCave* addCave(cwCavingRegion* region, QString name, double distance) {
+    cwCave* cave = new cwCave();
+    cave->setName(name);
+    region->addCave(cave);
+
+    cwTrip* trip = new cwTrip();
+    trip->setName("Trip 1");
+    cave->addTrip(trip);
+
+    cwSurveyChunk* chunk = new cwSurveyChunk();
+    trip->addChunk(chunk);
+
+    cwShot shot;
+    shot.setDistance(QString::number(distance));
+    shot.setCompass("0.0");
+    shot.setClino("0.0");
+    chunk->appendShot(cwStation("a1"), cwStation("a2"), shot);
+
+    return cave;
+}
+
+/**
+ * Runs the task on region, and updates the region's station positions, like cwLinePlotManager
+ */
+static void runLinePlot(cwLinePlotTask* task, cwCavingRegion* region) {
+    task->setData(*region);
+    task->start();
+    REQUIRE(task->isReady());
+
+    cwLinePlotTask::LinePlotResultData results = task->linePlotData();
+    foreach(cwCave* cave, region->caves()) {
+        if(results.caveData().contains(cave) && results.caveData().value(cave).hasStationPositionsChanged()) {
+            cave->setStationPositionLookup(results.caveData().value(cave).stationPositions());
+        }
+    }
+}
+
+TEST_CASE("Line plot task only rebuilds the caves that have changed", "[LinePlotTask]") {
+    cwCavingRegion region;
+    addCave(&region, "Cave 1", 10.0);
+    cwCave* cave2 = addCave(&region, "Cave 2", 20.0);
+
+    cwLinePlotTask task;
+    runLinePlot(&task, &region);
+
+    cwCavingRegion* localRegion = LinePlotTaskTester::region(task);
+    REQUIRE(localRegion != nullptr);
+    REQUIRE(localRegion->caveCount() == 2);
+    cwTrip* localTrip1 = localRegion->cave(0)->trip(0);
+    cwTrip* localTrip2 = localRegion->cave(1)->trip(0);
+
+    CHECK(region.cave(0)->stationPositionLookup().position("a2") == QVector3D(0.0, 10.0, 0.0));
+    CHECK(cave2->stationPositionLookup().position("a2") == QVector3D(0.0, 20.0, 0.0));
+
+    SECTION("Running again without changes keeps every cave") {
+        runLinePlot(&task, &region);
+
+        REQUIRE(localRegion->caveCount() == 2);
+        CHECK(localRegion->cave(0)->trip(0) == localTrip1);
+        CHECK(localRegion->cave(1)->trip(0) == localTrip2);
+        CHECK(task.linePlotData().trips().isEmpty());
+    }
+
+    SECTION("Editing a cave only rebuilds that cave") {
+        cave2->trip(0)->chunk(0)->setData(cwSurveyChunk::ShotDistanceRole, 0, 30.0);
+        runLinePlot(&task, &region);
+
+        REQUIRE(localRegion->caveCount() == 2);
+        CHECK(localRegion->cave(0)->trip(0) == localTrip1);
+        CHECK(localRegion->cave(1)->trip(0) != localTrip2);
+
+        CHECK(region.cave(0)->stationPositionLookup().position("a2") == QVector3D(0.0, 10.0, 0.0));
+        CHECK(cave2->stationPositionLookup().position("a2") == QVector3D(0.0, 30.0, 0.0));
+        CHECK(task.linePlotData().trips() == QSet<cwTrip*>() << cave2->trip(0));
+    }
+
+    SECTION("Resetting the station positions of a cave is picked up") {
+        cave2->setStationPositionLookup(cwStationPositionLookup());
+        runLinePlot(&task, &region);
+
+        CHECK(localRegion->cave(1)->trip(0) == localTrip2);
+        CHECK(cave2->stationPositionLookup().position("a2") == QVector3D(0.0, 20.0, 0.0));
+        CHECK(task.linePlotData().caveData().contains(cave2));
+        CHECK(!task.linePlotData().caveData().value(region.cave(0)).hasStationPositionsChanged());
+    }
+
+    SECTION("Adding and removing caves") {
+        region.removeCave(0);
+        cwCave* cave3 = addCave(&region, "Cave 3", 40.0);
+        runLinePlot(&task, &region);
+
+        REQUIRE(localRegion->caveCount() == 2);
+        CHECK(cave2->stationPositionLookup().position("a2") == QVector3D(0.0, 20.0, 0.0));
+        CHECK(cave3->stationPositionLookup().position("a2") == QVector3D(0.0, 40.0, 0.0));
+    }
+}
@@ -0,0 +1,151 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Cavewhere includes
+#include "cwLoopCloser.h"
+#include "cwLoopCloserTask.h"
+#include "cwShot.h"
+#include "cwTripCalibration.h"
+
+//Our includes
+#include "TestHelper.h"
+
+//Std includes
+#include <math.h>
+
+TEST_CASE("Loop closer distributes misclosure in a loop", "[LoopCloser]") {
+    cwLoopCloser loopCloser;
+    loopCloser.fixStation("a1", cwLoopCloser::Vector());
+    loopCloser.addShot("a1", "a2", cwLoopCloser::Vector(0.0, 10.0, 0.0), 1.0);
+    loopCloser.addShot("a2", "a3", cwLoopCloser::Vector(10.0, 0.0, 0.0), 1.0);
+    loopCloser.addShot("a3", "a4", cwLoopCloser::Vector(0.0, -10.0, 0.0), 1.0);
+    loopCloser.addShot("A4", "A1", cwLoopCloser::Vector(-10.0, 0.4, 0.0), 1.0);
+    loopCloser.solve();
+
+    CHECK(loopCloser.stationCount() == 4);
+    CHECK(loopCloser.position("a1").Y == Approx(0.0));
+    CHECK(loopCloser.position("a2").Y == Approx(9.9));
+    CHECK(loopCloser.position("a3").X == Approx(10.0));
+    CHECK(loopCloser.position("a3").Y == Approx(9.8));
+    CHECK(loopCloser.position("a4").Y == Approx(-0.3));
+
+    cwStationPositionLookup lookup = loopCloser.positions();
+    CHECK(lookup.position("a2") == QVector3D(0.0, 9.9, 0.0));
+    CHECK(lookup.position("a4") == QVector3D(10.0, -0.3, 0.0));
+}
+
+TEST_CASE("Loop closer weights junctions by variance", "[LoopCloser]") {
+    cwLoopCloser loopCloser;
+    loopCloser.fixStation("a", cwLoopCloser::Vector(1.0, 2.0, 3.0));
+    loopCloser.addShot("a", "b", cwLoopCloser::Vector(0.0, 10.0, 0.0), 1.0);
+    loopCloser.addShot("a", "c", cwLoopCloser::Vector(0.0, 4.0, 0.0), 1.0);
+    loopCloser.addShot("c", "b", cwLoopCloser::Vector(0.0, 5.0, 0.0), 1.0);
+    loopCloser.addShot("b", "e", cwLoopCloser::Vector(1.0, 0.0, 0.0), 1.0);
+    loopCloser.solve();
+
+    CHECK(loopCloser.position("a").X == Approx(1.0));
+    CHECK(loopCloser.position("b").Y == Approx(2.0 + 14.5 / 1.5));
+    CHECK(loopCloser.position("c").Y == Approx(2.0 + 4.0 + (14.5 / 1.5 - 9.0) * 0.5));
+    CHECK(loopCloser.position("e").X == Approx(2.0));
+    CHECK(loopCloser.position("e").Z == Approx(3.0));
+}
+
+TEST_CASE("Loop closer only re-solves the changed parts of the network", "[LoopCloser]") {
+    auto addShots = [](cwLoopCloser& loopCloser, double tweak) {
+        loopCloser.fixStation("a", cwLoopCloser::Vector());
+        loopCloser.addShot("a", "b", cwLoopCloser::Vector(0.0, 10.0, 0.0), 1.0);
+        loopCloser.addShot("b", "c", cwLoopCloser::Vector(10.0, 0.0, 0.0), 1.0);
+        loopCloser.addShot("c", "d", cwLoopCloser::Vector(0.0, -10.0, 0.0), 1.0);
+        loopCloser.addShot("d", "a", cwLoopCloser::Vector(-10.0, 0.4, 0.0), 1.0);
+        loopCloser.addShot("d", "e", cwLoopCloser::Vector(5.0, 0.0, 0.0), 1.0);
+        loopCloser.addShot("e", "f", cwLoopCloser::Vector(0.0, 5.0, 0.0), 1.0);
+        loopCloser.addShot("f", "g", cwLoopCloser::Vector(5.0, 0.0, 0.0), 1.0);
+        loopCloser.addShot("g", "e", cwLoopCloser::Vector(-5.0, -5.2 + tweak, 0.0), 1.0);
+    };
+
+    cwLoopCloser loopCloser;
+    addShots(loopCloser, 0.0);
+    loopCloser.solve();
+    CHECK(!loopCloser.wasIncremental());
+    CHECK(loopCloser.changedStations().size() == 7);
+
+    loopCloser.clearShots();
+    addShots(loopCloser, 0.3);
+    loopCloser.solve();
+    CHECK(loopCloser.wasIncremental());
+
+    QStringList changedStations = loopCloser.changedStations();
+    CHECK(changedStations.size() == 2);
+    CHECK(changedStations.contains("f"));
+    CHECK(changedStations.contains("g"));
+
+    cwLoopCloser fullLoopCloser;
+    addShots(fullLoopCloser, 0.3);
+    fullLoopCloser.solve();
+
+    foreach(QString station, QStringList() << "a" << "b" << "c" << "d" << "e" << "f" << "g") {
+        INFO("Station:" << station.toStdString());
+        CHECK(loopCloser.positions().position(station) == fullLoopCloser.positions().position(station));
+    }
+
+    SECTION("Removing a station solves the whole network") {
+        loopCloser.clearShots();
+        addShots(loopCloser, 0.3);
+        loopCloser.addShot("g", "h", cwLoopCloser::Vector(1.0, 0.0, 0.0), 1.0);
+        loopCloser.solve();
+        CHECK(!loopCloser.wasIncremental());
+        CHECK(loopCloser.changedStations() == QStringList() << "h");
+
+        loopCloser.clearShots();
+        addShots(loopCloser, 0.3);
+        loopCloser.solve();
+        CHECK(!loopCloser.positions().hasPosition("h"));
+        CHECK(loopCloser.changedStations() == QStringList() << "h");
+    }
+}
+
+TEST_CASE("Loop closer reduces shots like cavern", "[LoopCloser]") {
+    cwTripCalibration calibration;
+
+    cwShot shot;
+    shot.setDistance("10.0");
+    shot.setCompass("0.0");
+    shot.setBackCompass("90.0");
+    shot.setClino("0.0");
+    shot.setBackClino("45.0");
+
+    cwLoopCloser::Vector delta;
+    double variance;
+    REQUIRE(cwLoopCloserTask::shotVector(shot, &calibration, &delta, &variance));
+
+    double horizontal = 10.0 * cos(22.5 * cwGlobals::DegreesToRadians);
+    CHECK(delta.X == Approx(-horizontal * sin(45.0 * cwGlobals::DegreesToRadians)));
+    CHECK(delta.Y == Approx(horizontal * cos(45.0 * cwGlobals::DegreesToRadians)));
+    CHECK(delta.Z == Approx(-10.0 * sin(22.5 * cwGlobals::DegreesToRadians)));
+    CHECK(variance > 0.0);
+
+    SECTION("Vertical shots don't need a compass") {
+        cwShot verticalShot;
+        verticalShot.setDistance("5.0");
+        verticalShot.setClino("Down");
+
+        REQUIRE(cwLoopCloserTask::shotVector(verticalShot, &calibration, &delta, &variance));
+        CHECK(delta.X == Approx(0.0));
+        CHECK(delta.Y == Approx(0.0));
+        CHECK(delta.Z == Approx(-5.0));
+    }
+
+    SECTION("Shots without a compass aren't reduced") {
+        cwShot badShot;
+        badShot.setDistance("5.0");
+        badShot.setClino("10.0");
+        CHECK(!cwLoopCloserTask::shotVector(badShot, &calibration, &delta, &variance));
+    }
+}
@@ -0,0 +1,181 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Cavewhere includes
+#include "cwProject.h"
+#include "cwCave.h"
+#include "cwTrip.h"
+#include "cwNote.h"
+#include "cwScrap.h"
+#include "cwSurveyNoteModel.h"
+#include "cwCavingRegion.h"
+#include "cwTriangulatedData.h"
+
+//Our includes
+#include "TestHelper.h"
+
+//Qt includes
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+
+static int countRows(const QString& filename, const QString& queryStr) {
+    int count = -1;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "ProjectTest");
+        database.setDatabaseName(filename);
+        REQUIRE(database.open());
+
+        QSqlQuery query(database);
+        REQUIRE(query.exec(queryStr));
+        if(query.next()) {
+            count = query.value(0).toInt();
+        }
+    }
+    QSqlDatabase::removeDatabase("ProjectTest");
+    return count;
+}
+
+static void execQueries(const QString& filename, const QStringList& queries) {
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "ProjectTest");
+        database.setDatabaseName(filename);
+        REQUIRE(database.open());
+
+        QSqlQuery query(database);
+        foreach(const QString& queryStr, queries) {
+            REQUIRE(query.exec(queryStr));
+        }
+    }
+    QSqlDatabase::removeDatabase("ProjectTest");
+}
+
+/**
+ * Logs every insert and delete on RegionObjects into the WriteLog table, and clears the log
+ */
+static void logRegionObjectWrites(const QString& filename) {
+    execQueries(filename, QStringList()
+                << "CREATE TABLE IF NOT EXISTS WriteLog (kind TEXT)"
+                << "DELETE FROM WriteLog"
+                << "CREATE TRIGGER IF NOT EXISTS LogInsert AFTER INSERT ON RegionObjects BEGIN INSERT INTO WriteLog VALUES ('insert'); END"
+                << "CREATE TRIGGER IF NOT EXISTS LogDelete AFTER DELETE ON RegionObjects BEGIN INSERT INTO WriteLog VALUES ('delete'); END");
+}
+
+/**
+ * Returns the number of RegionObjects rows with kind, "insert" or "delete", since logRegionObjectWrites()
+ */
+static int regionObjectWrites(const QString& filename, const QString& kind) {
+    return countRows(filename, QString("SELECT count(*) FROM WriteLog WHERE kind = '%1'").arg(kind));
+}
+
+static void saveProject(cwProject* project) {
+    project->save();
+    project->waitSaveToFinish();
+}
+
+TEST_CASE("Projects migrate to a row per region object when saved", "[Project]") {
+    cwProject* project = fileToProject(":/datasets/scrapAutoCalculate/runningProfile.cw");
+    REQUIRE(project->cavingRegion()->caveCount() == 1);
+
+    cwCave* cave = project->cavingRegion()->cave(0);
+    REQUIRE(cave->tripCount() == 1);
+    REQUIRE(cave->trip(0)->notes()->notes().size() == 1);
+
+    cwScrap* scrap = cave->trip(0)->notes()->notes().first()->scrap(0);
+    cwTriangulatedData triangulatedData = scrap->triangulationData();
+
+    project->save();
+    project->waitSaveToFinish();
+
+    QString filename = project->filename();
+    CHECK(countRows(filename, "SELECT count(*) FROM ObjectData WHERE id = 1") == 0);
+
+    //Region, cave, trip, note, and the scrap's geometry
+    CHECK(countRows(filename, "SELECT count(*) FROM RegionObjects") == 5);
+    CHECK(countRows(filename, QString("SELECT count(*) FROM RegionObjects WHERE id = %1").arg(scrap->id())) == 1);
+
+    cwProject loadedProject;
+    loadedProject.loadFile(filename);
+    loadedProject.waitLoadToFinish();
+
+    REQUIRE(loadedProject.cavingRegion()->caveCount() == 1);
+    cwCave* loadedCave = loadedProject.cavingRegion()->cave(0);
+    CHECK(loadedCave->id() == cave->id());
+    CHECK(loadedCave->name() == cave->name());
+    REQUIRE(loadedCave->tripCount() == 1);
+    CHECK(loadedCave->trip(0)->numberOfChunks() == cave->trip(0)->numberOfChunks());
+    REQUIRE(loadedCave->trip(0)->notes()->notes().size() == 1);
+
+    cwScrap* loadedScrap = loadedCave->trip(0)->notes()->notes().first()->scrap(0);
+    CHECK(loadedScrap->id() == scrap->id());
+    CHECK(loadedScrap->points() == scrap->points());
+    CHECK(loadedScrap->triangulationData().points() == triangulatedData.points());
+    CHECK(loadedScrap->triangulationData().indices() == triangulatedData.indices());
+
+    delete project;
+}
+
+TEST_CASE("Saving only writes the region objects that changed", "[Project]") {
+    cwProject* project = fileToProject(":/datasets/scrapAutoCalculate/runningProfile.cw");
+    REQUIRE(project->cavingRegion()->caveCount() == 1);
+    cwCave* cave = project->cavingRegion()->cave(0);
+
+    saveProject(project);
+
+    QString filename = project->filename();
+    REQUIRE(countRows(filename, "SELECT count(*) FROM RegionObjects") == 5);
+
+    SECTION("An unchanged region writes nothing") {
+        logRegionObjectWrites(filename);
+        saveProject(project);
+        CHECK(regionObjectWrites(filename, "insert") == 0);
+        CHECK(regionObjectWrites(filename, "delete") == 0);
+    }
+
+    SECTION("Editing a cave only writes the cave's row") {
+        logRegionObjectWrites(filename);
+        cave->setName("Renamed cave");
+        saveProject(project);
+        CHECK(regionObjectWrites(filename, "insert") == 1);
+        CHECK(regionObjectWrites(filename, "delete") == 0);
+    }
+
+    SECTION("Inserting and removing a cave doesn't rewrite its siblings") {
+        logRegionObjectWrites(filename);
+
+        cwCave* newCave = new cwCave();
+        newCave->setName("New cave");
+        project->cavingRegion()->insertCave(0, newCave);
+        REQUIRE(project->cavingRegion()->cave(1) == cave);
+
+        //The region's row, for the cave ids, and the new cave's row
+        saveProject(project);
+        CHECK(regionObjectWrites(filename, "insert") == 2);
+        CHECK(regionObjectWrites(filename, "delete") == 0);
+
+        logRegionObjectWrites(filename);
+        project->cavingRegion()->removeCave(0);
+        saveProject(project);
+
+        //The region's row, and the removed cave's row
+        CHECK(regionObjectWrites(filename, "insert") == 1);
+        CHECK(regionObjectWrites(filename, "delete") == 1);
+
+        cwProject loadedProject;
+        loadedProject.loadFile(filename);
+        loadedProject.waitLoadToFinish();
+
+        REQUIRE(loadedProject.cavingRegion()->caveCount() == 1);
+        CHECK(loadedProject.cavingRegion()->cave(0)->id() == cave->id());
+        CHECK(loadedProject.cavingRegion()->cave(0)->name() == cave->name());
+    }
+
+    delete project;
+}
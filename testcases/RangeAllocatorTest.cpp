@@ -0,0 +1,54 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Our includes
+#include "cwRangeAllocator.h"
+
+TEST_CASE("Range allocator reuses and merges freed ranges", "[RangeAllocator]") {
+
+    cwRangeAllocator allocator;
+
+    int a = allocator.allocate(10);
+    int b = allocator.allocate(20);
+    int c = allocator.allocate(10);
+
+    CHECK(a == 0);
+    CHECK(b == 10);
+    CHECK(c == 30);
+    CHECK(allocator.capacity() >= 40);
+    CHECK(allocator.allocatedSize() == 40);
+    CHECK(allocator.size(b) == 20);
+
+    //Fits in b's range without growing
+    int capacity = allocator.capacity();
+    allocator.free(b);
+    CHECK(allocator.size(b) == 0);
+    int d = allocator.allocate(15);
+    CHECK(d == b);
+    CHECK(allocator.capacity() == capacity);
+
+    //Freeing a and d merges them, so 25 fits at the start
+    allocator.free(a);
+    allocator.free(d);
+    int e = allocator.allocate(25);
+    CHECK(e == 0);
+    CHECK(allocator.capacity() == capacity);
+
+    //Growing at least doubles the capacity
+    int f = allocator.allocate(capacity);
+    CHECK(f >= 30);
+    CHECK(allocator.capacity() >= capacity * 2);
+    CHECK(allocator.allocatedSize() == 25 + 10 + capacity);
+
+    allocator.clear();
+    CHECK(allocator.capacity() == 0);
+    CHECK(allocator.allocatedSize() == 0);
+    CHECK(allocator.allocate(5) == 0);
+}
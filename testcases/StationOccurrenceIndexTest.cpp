@@ -0,0 +1,73 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Our includes
+#include "cwStationOccurrenceIndex.h"
+#include "cwCave.h"
+#include "cwTrip.h"
+#include "cwStation.h"
+#include "cwShot.h"
+#include "cwSurveyChunk.h"
+
+TEST_CASE("Station occurrence index follows the cave's chunks", "[StationOccurrenceIndex]") {
+
+    cwCave* cave = new cwCave();
+    cwTrip* trip1 = new cwTrip();
+    cwTrip* trip2 = new cwTrip();
+    cave->addTrip(trip1);
+    cave->addTrip(trip2);
+
+    cwShot shot;
+    shot.setDistance("10");
+    shot.setCompass("0");
+    shot.setClino("0");
+
+    cwSurveyChunk* chunk1 = new cwSurveyChunk();
+    trip1->addChunk(chunk1);
+    chunk1->appendShot(cwStation("a1"), cwStation("a2"), shot);
+    chunk1->appendShot(cwStation("a2"), cwStation("a3"), shot);
+
+    cwSurveyChunk* chunk2 = new cwSurveyChunk();
+    trip2->addChunk(chunk2);
+    chunk2->appendShot(cwStation("a3"), cwStation("b1"), shot);
+
+    cwStationOccurrenceIndex* index = cave->stationOccurrenceIndex();
+
+    CHECK(index->hasStation("A2") == true);
+    CHECK(index->hasStation("a2", trip2) == false);
+    CHECK(index->trips("a3").size() == 2);
+    CHECK(index->neighboringStations("a3").size() == 2);
+    CHECK(index->neighboringStations("a3", trip2).size() == 1);
+    CHECK(trip1->hasStation("A1") == true);
+    CHECK(trip2->hasStation("a1") == false);
+
+    SECTION("Renaming a station updates the index") {
+        chunk2->setStation(cwStation("c1"), 1);
+        CHECK(index->hasStation("b1") == false);
+        CHECK(index->hasStation("c1", trip2) == true);
+        CHECK(index->neighboringStations("a3", trip2).contains(cwStation("c1")));
+    }
+
+    SECTION("Adding a chunk updates the index") {
+        cwSurveyChunk* chunk3 = new cwSurveyChunk();
+        trip2->addChunk(chunk3);
+        chunk3->appendShot(cwStation("b1"), cwStation("b2"), shot);
+        CHECK(index->hasStation("b2", trip2) == true);
+        CHECK(index->stationNames().size() == 5);
+    }
+
+    SECTION("Removing a trip updates the index") {
+        cave->removeTrip(0);
+        CHECK(index->hasStation("a1") == false);
+        CHECK(index->trips("a3").size() == 1);
+    }
+
+    delete cave;
+}
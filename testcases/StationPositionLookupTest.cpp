@@ -0,0 +1,90 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Cavewhere includes
+#include "cwStationPositionLookup.h"
+#include "cwStationNameTable.h"
+
+//Our includes
+#include "TestHelper.h"
+
+TEST_CASE("Station names are interned case insensitively", "[StationPositionLookup]") {
+    cwStationNameTable* table = cwStationNameTable::instance();
+
+    int id = table->intern("InternTest1");
+    CHECK(id >= 0);
+    CHECK(table->intern("interntest1") == id);
+    CHECK(table->find("INTERNTEST1") == id);
+    CHECK(table->name(id) == QString("interntest1"));
+    CHECK(table->find("InternTest2") == -1);
+    CHECK(table->intern(QString()) == -1);
+}
+
+TEST_CASE("Station position lookup works with names and ids", "[StationPositionLookup]") {
+    cwStationPositionLookup lookup;
+    lookup.setPosition("A1", QVector3D(1.0, 2.0, 3.0));
+    lookup.setPosition("a2", QVector3D(4.0, 5.0, 6.0));
+
+    int a1 = cwStationNameTable::instance()->find("a1");
+    CHECK(lookup.count() == 2);
+    CHECK(lookup.hasPosition(a1));
+    CHECK(lookup.position(a1) == QVector3D(1.0, 2.0, 3.0));
+    CHECK(lookup.position("A2") == QVector3D(4.0, 5.0, 6.0));
+    CHECK(!lookup.hasPosition("a3"));
+    CHECK(lookup.position("a3") == QVector3D());
+
+    QMap<QString, QVector3D> positions = lookup.positions();
+    CHECK(positions.size() == 2);
+    CHECK(positions.value("a1") == QVector3D(1.0, 2.0, 3.0));
+
+    cwStationPositionLookup copy = lookup;
+    CHECK(copy.isSharedWith(lookup));
+
+    copy.removePosition("a1");
+    CHECK(!copy.isSharedWith(lookup));
+    CHECK(!copy.hasPosition("a1"));
+    CHECK(copy.count() == 1);
+    CHECK(lookup.hasPosition("a1"));
+}
+
+TEST_CASE("Station position lookup stays dense after removing", "[StationPositionLookup]") {
+    cwStationNameTable* table = cwStationNameTable::instance();
+
+    //Intern lots of names, the lookup shouldn't care how many there are
+    for(int i = 0; i < 1000; i++) {
+        table->intern(QString("DenseFiller%1").arg(i));
+    }
+
+    int b1 = table->intern("DenseB1");
+    int b2 = table->intern("DenseB2");
+    int b3 = table->intern("DenseB3");
+
+    cwStationPositionLookup lookup;
+    lookup.setPosition(b3, QVector3D(3.0, 0.0, 0.0));
+    lookup.setPosition(b1, QVector3D(1.0, 0.0, 0.0));
+    lookup.setPosition(b2, QVector3D(2.0, 0.0, 0.0));
+    lookup.setPosition(b1, QVector3D(1.5, 0.0, 0.0));
+
+    CHECK(lookup.count() == 3);
+    CHECK(lookup.stationIds() == QVector<int>({b1, b2, b3}));
+    CHECK(lookup.position(b1) == QVector3D(1.5, 0.0, 0.0));
+
+    lookup.removePosition(b3);
+    lookup.removePosition(b3);
+    CHECK(lookup.count() == 2);
+    CHECK(!lookup.hasPosition(b3));
+    CHECK(lookup.position(b1) == QVector3D(1.5, 0.0, 0.0));
+    CHECK(lookup.position(b2) == QVector3D(2.0, 0.0, 0.0));
+    CHECK(lookup.stationIds() == QVector<int>({b1, b2}));
+
+    lookup.clearStations();
+    CHECK(lookup.count() == 0);
+    CHECK(!lookup.hasPosition(b1));
+}
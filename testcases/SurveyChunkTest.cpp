@@ -17,9 +17,13 @@
 #include "cwTrip.h"
 #include "cwSurveyChunk.h"
 #include "cwTripCalibration.h"
+#include "cwStationNameTable.h"
 
 #include "TestHelper.h"
 
+//Qt includes
+#include <QSignalSpy>
+
 void printErrorForChunk(const cwSurveyChunk* chunk) {
     foreach(cwErrorModel* model, chunk->errorModel()->childModels()) {
         foreach(cwError error, model->errors()->toList()) {
@@ -566,3 +570,172 @@ TEST_CASE("Checks cwSurveyChunk errors")
     }
 }
 
+
+TEST_CASE("Cave data can be copied into a new cave", "[SurveyChunk]") {
+    cwCave cave;
+    cave.setName("Test Cave");
+
+    cwTrip* trip = new cwTrip();
+    trip->setName("Trip 1");
+    trip->calibrations()->setDeclination(10.5);
+    cave.addTrip(trip);
+
+    cwSurveyChunk* chunk = new cwSurveyChunk();
+    chunk->appendNewShot();
+    chunk->setData(cwSurveyChunk::StationNameRole, 0, "a1");
+    chunk->setData(cwSurveyChunk::StationNameRole, 1, "a2");
+    chunk->setData(cwSurveyChunk::ShotDistanceRole, 0, "10.0");
+    trip->addChunk(chunk);
+
+    cwCaveData data = cave.data();
+
+    //Editing the cave doesn't change the snapshot
+    chunk->setData(cwSurveyChunk::StationNameRole, 1, "a3");
+    CHECK(data.Trips.first().Chunks.first().Stations.at(1).name() == QString("a2"));
+
+    cwCave copy;
+    copy.setData(data);
+
+    CHECK(copy.name() == QString("Test Cave"));
+    REQUIRE(copy.tripCount() == 1);
+    CHECK(copy.trip(0)->name() == QString("Trip 1"));
+    CHECK(copy.trip(0)->calibrations()->declination() == 10.5);
+    REQUIRE(copy.trip(0)->numberOfChunks() == 1);
+
+    cwSurveyChunk* copyChunk = copy.trip(0)->chunk(0);
+    CHECK(copyChunk->stationCount() == 2);
+    CHECK(copyChunk->station(1).name() == QString("a2"));
+    CHECK(copyChunk->shot(0).distance() == 10.0);
+    CHECK(copyChunk->parentTrip() == copy.trip(0));
+}
+
+TEST_CASE("Survey chunk columns keep the shot and station readings", "[SurveyChunk]") {
+    cwSurveyChunk chunk;
+    chunk.appendNewShot();
+    chunk.setData(cwSurveyChunk::StationNameRole, 0, "A1");
+    chunk.setData(cwSurveyChunk::StationNameRole, 1, "a2");
+    chunk.setData(cwSurveyChunk::StationLeftRole, 0, "1.5");
+    chunk.setData(cwSurveyChunk::ShotDistanceRole, 0, "10.0");
+    chunk.setData(cwSurveyChunk::ShotBackCompassRole, 0, "180");
+    chunk.setData(cwSurveyChunk::ShotClinoRole, 0, "down");
+    chunk.setData(cwSurveyChunk::ShotDistanceIncludedRole, 0, false);
+
+    const cwStationColumns& stations = chunk.stationColumns();
+    CHECK(stations.name(0) == QString("A1"));
+    CHECK(stations.nameId(0) == cwStationNameTable::instance()->find("a1"));
+    CHECK(stations.leftState(0) == cwDistanceStates::Valid);
+    CHECK(stations.left(0) == 1.5);
+    CHECK(stations.rightState(0) == cwDistanceStates::Empty);
+    CHECK(chunk.hasStation("a1"));
+    CHECK(chunk.indicesOfStation("A2") == QList<int>() << 1);
+
+    const cwShotColumns& shots = chunk.shotColumns();
+    CHECK(shots.distanceState(0) == cwDistanceStates::Valid);
+    CHECK(shots.distance(0) == 10.0);
+    CHECK(shots.compassState(0) == cwCompassStates::Empty);
+    CHECK(shots.backCompassState(0) == cwCompassStates::Valid);
+    CHECK(shots.clinoState(0) == cwClinoStates::Down);
+    CHECK(shots.backClinoState(0) == cwClinoStates::Empty);
+    CHECK(shots.isDistanceIncluded(0) == false);
+
+    cwShot shot = chunk.shot(0);
+    CHECK(shot.backCompass() == 180.0);
+    CHECK(shot.clinoState() == cwClinoStates::Down);
+    CHECK(shot.isDistanceIncluded() == false);
+
+    CHECK(chunk.data(cwSurveyChunk::ShotClinoRole, 0).toString() == QString("Down"));
+    CHECK(chunk.isStationAndShotsEmpty() == false);
+}
+
+TEST_CASE("Survey chunk cell errors move with their rows", "[SurveyChunk]") {
+    cwShot shot;
+    shot.setDistance("10");
+    shot.setCompass("0");
+    shot.setBackCompass("180");
+    shot.setClino("0");
+    shot.setBackClino("0");
+
+    cwSurveyChunk chunk;
+    chunk.appendShot(cwStation("a1"), cwStation("a2"), shot);
+    chunk.appendShot(cwStation("a2"), cwStation("a3"), shot);
+    chunk.appendShot(cwStation("a3"), cwStation("a4"), shot);
+    REQUIRE(chunk.errorModel()->fatalCount() == 0);
+
+    chunk.setData(cwSurveyChunk::StationNameRole, 3, "");
+    CHECK(chunk.errorModel()->fatalCount() == 1);
+    CHECK(chunk.errorsAt(0, cwSurveyChunk::StationNameRole) == nullptr);
+
+    chunk.removeStation(1, cwSurveyChunk::Below);
+    CHECK(chunk.errorModel()->fatalCount() == 1);
+
+    cwErrorModel* errorModel = chunk.errorsAt(2, cwSurveyChunk::StationNameRole);
+    REQUIRE(errorModel != nullptr);
+    REQUIRE(errorModel->errors()->size() == 1);
+    CHECK(errorModel->errors()->first().type() == cwError::Fatal);
+
+    chunk.setData(cwSurveyChunk::StationNameRole, 2, "a4");
+    CHECK(chunk.errorModel()->fatalCount() == 0);
+    CHECK(chunk.errorsAt(2, cwSurveyChunk::StationNameRole) == nullptr);
+}
+
+TEST_CASE("Bulk edits notify the changes once", "[SurveyChunk]") {
+    cwShot shot;
+    shot.setDistance("10");
+    shot.setCompass("0");
+    shot.setBackCompass("180");
+    shot.setClino("0");
+    shot.setBackClino("0");
+
+    cwTrip trip;
+    trip.addShotToLastChunk(cwStation("a1"), cwStation("a2"), shot);
+    cwSurveyChunk* chunk = trip.chunk(0);
+
+    QSignalSpy stationsAddedSpy(chunk, SIGNAL(stationsAdded(int,int)));
+    QSignalSpy stationsRemovedSpy(chunk, SIGNAL(stationsRemoved(int,int)));
+    QSignalSpy shotsAddedSpy(chunk, SIGNAL(shotsAdded(int,int)));
+    QSignalSpy chunksInsertedSpy(&trip, SIGNAL(chunksInserted(int,int)));
+    QSignalSpy tripFinishedSpy(&trip, SIGNAL(bulkEditFinished()));
+
+    trip.beginBulkEdit();
+    trip.addShotToLastChunk(cwStation("a2"), cwStation("a3"), shot);
+    trip.addShotToLastChunk(cwStation("a3"), cwStation("a4"), shot);
+    trip.addShotToLastChunk(cwStation("b1"), cwStation("b2"), shot);
+    trip.addShotToLastChunk(cwStation("b2"), cwStation("b3"), shot);
+
+    CHECK(chunk->isBulkEditing());
+    CHECK(stationsAddedSpy.isEmpty());
+    CHECK(shotsAddedSpy.isEmpty());
+    CHECK(chunksInsertedSpy.isEmpty());
+
+    SECTION("Appending") {
+        trip.endBulkEdit();
+
+        REQUIRE(stationsAddedSpy.size() == 1);
+        CHECK(stationsAddedSpy.first().at(0).toInt() == 2);
+        CHECK(stationsAddedSpy.first().at(1).toInt() == 3);
+        REQUIRE(shotsAddedSpy.size() == 1);
+        CHECK(shotsAddedSpy.first().at(0).toInt() == 1);
+        CHECK(shotsAddedSpy.first().at(1).toInt() == 2);
+        CHECK(stationsRemovedSpy.isEmpty());
+    }
+
+    SECTION("Changing a station that existed before the bulk edit") {
+        chunk->setData(cwSurveyChunk::StationNameRole, 1, "");
+        trip.endBulkEdit();
+
+        REQUIRE(stationsRemovedSpy.size() == 1);
+        CHECK(stationsRemovedSpy.first().at(1).toInt() == 1);
+        REQUIRE(stationsAddedSpy.size() == 1);
+        CHECK(stationsAddedSpy.first().at(0).toInt() == 0);
+        CHECK(stationsAddedSpy.first().at(1).toInt() == 3);
+        CHECK(chunk->errorModel()->fatalCount() == 1);
+    }
+
+    CHECK(chunk->isBulkEditing() == false);
+    CHECK(tripFinishedSpy.size() == 1);
+    REQUIRE(chunksInsertedSpy.size() == 1);
+    CHECK(chunksInsertedSpy.first().at(0).toInt() == 1);
+    CHECK(chunksInsertedSpy.first().at(1).toInt() == 1);
+    REQUIRE(trip.numberOfChunks() == 2);
+    CHECK(trip.chunk(1)->stationCount() == 3);
+}
@@ -0,0 +1,246 @@
+/**************************************************************************
+**
+**    Copyright (C) 2016 by Philip Schuchardt
+**    www.cavewhere.com
+**
+**************************************************************************/
+
+//Catch includes
+#include "catch.hpp"
+
+//Our includes
+#include "cwTileLoadTask.h"
+#include "cwDxt1Encoder.h"
+#include "cwImageProvider.h"
+#include "cwProject.h"
+
+//Qt includes
+#include <QImage>
+#include <QColor>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QDir>
+#include <QFile>
+#include <QDateTime>
+
+/**
+ * Creates a project with an Images table, that has a DXT1 row for each level. The ids of the rows
+ * start at 1.
+ */
+static void createLevelDatabase(const QString& filename, const QList<QSize>& sizes, const QList<QByteArray>& levels) {
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "TileLoadTaskTest");
+        database.setDatabaseName(filename);
+        REQUIRE(database.open());
+
+        QSqlQuery query(database);
+        REQUIRE(query.exec("CREATE TABLE Images (id INTEGER PRIMARY KEY AUTOINCREMENT, type STRING, "
+                           "shouldDelete BOOL, width INTEGER, height INTEGER, dotsPerMeter INTEGER, imageData BLOB)"));
+        for(int i = 0; i < levels.size(); i++) {
+            REQUIRE(query.prepare("INSERT INTO Images (type, shouldDelete, width, height, dotsPerMeter, imageData) "
+                                  "VALUES ('dxt1', 0, ?, ?, 1000, ?)"));
+            query.addBindValue(sizes.at(i).width());
+            query.addBindValue(sizes.at(i).height());
+            query.addBindValue(levels.at(i));
+            REQUIRE(query.exec());
+        }
+    }
+    QSqlDatabase::removeDatabase("TileLoadTaskTest");
+}
+
+TEST_CASE("Tiles are copied out of a DXT1 level", "[TileLoadTask]") {
+
+    //A level that's bigger than one tile, and isn't a multiple of the tile size
+    QSize levelSize(cwTileLoadTask::TileSize + 100, cwTileLoadTask::TileSize * 2 + 36);
+    QImage image(levelSize, QImage::Format_RGBA8888);
+    for(int y = 0; y < image.height(); y++) {
+        for(int x = 0; x < image.width(); x++) {
+            image.setPixel(x, y, qRgb((x * 7) % 256, (y * 3) % 256, (x + y) % 256));
+        }
+    }
+
+    cwDxt1Encoder encoder;
+    encoder.setQuality(cwDxt1Encoder::Fast);
+    QByteArray levelData = encoder.compress(image);
+
+    CHECK(cwTileLoadTask::tileRect(levelSize, QPoint(0, 0)) == QRect(0, 0, 256, 256));
+    CHECK(cwTileLoadTask::tileRect(levelSize, QPoint(1, 2)) == QRect(256, 512, 100, 36));
+    CHECK(cwTileLoadTask::tileRect(levelSize, QPoint(2, 0)).isEmpty());
+
+    //Blocks are compressed independently, so the tile's blocks are the same as compressing the tile's pixels
+    for(int row = 0; row < 3; row++) {
+        for(int column = 0; column < 2; column++) {
+            QRect rect = cwTileLoadTask::tileRect(levelSize, QPoint(column, row));
+            QByteArray tile = cwTileLoadTask::copyTile(levelData, levelSize, rect);
+            CHECK(tile.size() == cwDxt1Encoder::storageSize(rect.size()));
+            CHECK(tile == encoder.compress(image.copy(rect)));
+        }
+    }
+}
+
+TEST_CASE("Tile load task loads tiles from a project, and reports tiles that can't load", "[TileLoadTask]") {
+    QSize levelSize(cwTileLoadTask::TileSize + 100, cwTileLoadTask::TileSize);
+    QImage image(levelSize, QImage::Format_RGBA8888);
+    for(int y = 0; y < image.height(); y++) {
+        for(int x = 0; x < image.width(); x++) {
+            image.setPixel(x, y, qRgb((x * 5) % 256, (y * 11) % 256, (x * y) % 256));
+        }
+    }
+
+    cwDxt1Encoder encoder;
+    encoder.setQuality(cwDxt1Encoder::Fast);
+    QByteArray levelData = encoder.compress(image);
+
+    //The second level is too small for its size, like a corrupt mipmap
+    QSize corruptSize(levelSize / 2);
+    QByteArray corruptData(16, '\0');
+
+    QString filename = QString("%1/TileLoadTaskTest-%2.cw")
+            .arg(QDir::tempPath())
+            .arg(QDateTime::currentMSecsSinceEpoch(), 0, 16);
+    QFile::remove(filename);
+    createLevelDatabase(filename, {levelSize, corruptSize}, {levelData, corruptData});
+
+    cwImage cwimage;
+    cwimage.setOriginal(1);
+    cwimage.setMipmaps({1, 2});
+
+    cwTileLoadTask task;
+    task.setProjectFilename(filename);
+    task.setImage(cwimage);
+
+    typedef cwTileLoadTask::Tile Tile;
+    Tile first(0, QPoint(0, 0));
+    Tile second(0, QPoint(1, 0));
+    Tile corrupt(1, QPoint(0, 0));
+    Tile outside(0, QPoint(5, 5));
+    task.setTiles({corrupt, second, outside, first});
+
+    task.start();
+    task.waitToFinish();
+
+    CHECK(task.levelSizes() == QList<QSize>({levelSize, corruptSize}));
+
+    QList<cwTileLoadTask::TileData> tiles = task.tiles();
+    REQUIRE(tiles.size() == 2);
+    foreach(const cwTileLoadTask::TileData& tile, tiles) {
+        QRect rect = cwTileLoadTask::tileRect(levelSize, tile.Key.Index);
+        CHECK(tile.Key.Level == 0);
+        CHECK(tile.ValidSize == rect.size());
+        CHECK(tile.Data == encoder.compress(image.copy(rect)));
+    }
+
+    QList<Tile> failedTiles = task.failedTiles();
+    CHECK(failedTiles.size() == 2);
+    CHECK(failedTiles.contains(corrupt));
+    CHECK(failedTiles.contains(outside));
+
+    //Loading again, after the level was released, reads the level again
+    task.releaseLevel();
+    task.setTiles({second});
+    task.start();
+    task.waitToFinish();
+
+    REQUIRE(task.tiles().size() == 1);
+    CHECK(task.tiles().first().Data == encoder.compress(image.copy(cwTileLoadTask::tileRect(levelSize, second.Index))));
+    CHECK(task.failedTiles().isEmpty());
+
+    cwImageProvider::closeConnections(filename);
+    CHECK(QFile::remove(filename));
+}
+
+TEST_CASE("Tile load task reads single tiles from tiled mipmaps", "[TileLoadTask]") {
+    QSize levelSize(cwTileLoadTask::TileSize * 2 + 60, cwTileLoadTask::TileSize + 20);
+    QImage image(levelSize, QImage::Format_RGBA8888);
+    for(int y = 0; y < image.height(); y++) {
+        for(int x = 0; x < image.width(); x++) {
+            image.setPixel(x, y, qRgb((x * 3) % 256, (y * 7) % 256, (x ^ y) % 256));
+        }
+    }
+
+    cwDxt1Encoder encoder;
+    encoder.setQuality(cwDxt1Encoder::Fast);
+    QByteArray levelData = encoder.compress(image);
+
+    QString filename = QString("%1/TileLoadTaskTest-tiled-%2.cw")
+            .arg(QDir::tempPath())
+            .arg(QDateTime::currentMSecsSinceEpoch(), 0, 16);
+    QFile::remove(filename);
+    createLevelDatabase(filename, QList<QSize>(), QList<QByteArray>());
+
+    int mipmapId = -1;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "TileLoadTaskTest");
+        database.setDatabaseName(filename);
+        REQUIRE(database.open());
+
+        cwImageData level(levelSize, 0, cwImageProvider::dxt1Format(cwBlobCodec::Stored), levelData);
+        mipmapId = cwProject::addTiledImage(database, level, cwBlobCodec::FastLZ);
+        REQUIRE(mipmapId > 0);
+
+        //Each tile is its own row, and the level doesn't have a blob
+        QSqlQuery query(database);
+        REQUIRE(query.exec("SELECT count(*) FROM ImageTiles"));
+        REQUIRE(query.next());
+        CHECK(query.value(0).toInt() == 6);
+        query.finish();
+
+        REQUIRE(query.exec(QString("SELECT length(imageData) FROM Images WHERE id=%1").arg(mipmapId)));
+        REQUIRE(query.next());
+        CHECK(query.value(0).toInt() == 0);
+    }
+    QSqlDatabase::removeDatabase("TileLoadTaskTest");
+
+    SECTION("The image provider puts the tiles back together") {
+        cwImageProvider provider;
+        provider.setProjectPath(filename);
+        cwImageData data = provider.data(mipmapId);
+        CHECK(data.size() == levelSize);
+        CHECK(data.format() == cwImageProvider::dxt1Format(cwBlobCodec::FastLZ));
+        CHECK(data.data() == levelData);
+
+        QRect rect = cwTileLoadTask::tileRect(levelSize, QPoint(2, 1));
+        CHECK(provider.tile(mipmapId, QPoint(2, 1)) == encoder.compress(image.copy(rect)));
+        CHECK(provider.tile(mipmapId, QPoint(3, 1)).isEmpty());
+    }
+
+    SECTION("Only the requested tiles are read") {
+        //Without this tile, the whole level can't be put back together
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "TileLoadTaskTest");
+            database.setDatabaseName(filename);
+            REQUIRE(database.open());
+            QSqlQuery query(database);
+            REQUIRE(query.exec("DELETE FROM ImageTiles WHERE tileColumn=0 AND tileRow=0"));
+        }
+        QSqlDatabase::removeDatabase("TileLoadTaskTest");
+
+        cwImage cwimage;
+        cwimage.setOriginal(mipmapId);
+        cwimage.setMipmaps({mipmapId});
+
+        cwTileLoadTask task;
+        task.setProjectFilename(filename);
+        task.setImage(cwimage);
+
+        typedef cwTileLoadTask::Tile Tile;
+        Tile missing(0, QPoint(0, 0));
+        task.setTiles({Tile(0, QPoint(1, 0)), Tile(0, QPoint(2, 1)), missing});
+        task.start();
+        task.waitToFinish();
+
+        CHECK(task.levelSizes() == QList<QSize>({levelSize}));
+
+        QList<cwTileLoadTask::TileData> tiles = task.tiles();
+        REQUIRE(tiles.size() == 2);
+        foreach(const cwTileLoadTask::TileData& tile, tiles) {
+            QRect rect = cwTileLoadTask::tileRect(levelSize, tile.Key.Index);
+            CHECK(tile.ValidSize == rect.size());
+            CHECK(tile.Data == encoder.compress(image.copy(rect)));
+        }
+        CHECK(task.failedTiles() == QList<Tile>({missing}));
+    }
+
+    cwImageProvider::closeConnections(filename);
+    CHECK(QFile::remove(filename));
+}
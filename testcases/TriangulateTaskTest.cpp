@@ -12,8 +12,767 @@
 
 //Cavewhere includes
 #include "cwTriangulateTask.h"
+#include "cwTriangulateInData.h"
+#include "cwTriangulatedData.h"
 
 //Our includes
 #include "TestHelper.h"
 
+//Qt includes
+#include <QPolygonF>
+#include <QtMath>
 
+//Std includes
+#include <algorithm>
+#include <limits>
+
+
+
+TEST_CASE("Triangulated scraps reference their note's image", "[TriangulateTask]") {
+    cwImage noteImage;
+    noteImage.setOriginal(1);
+    noteImage.setMipmaps(QList<int>() << 2 << 3 << 4);
+    noteImage.setOriginalSize(QSize(1024, 1024));
+
+    QRectF bounds(0.25, 0.5, 0.5, 0.25);
+
+    cwTriangulateInData scrap;
+    scrap.setNoteImage(noteImage);
+    scrap.setNoteImageResolution(1024.0 / 0.2); //The note is 20cm wide
+    scrap.setOutline(QPolygonF(bounds));
+
+    cwTriangulateTask task;
+    task.setScrapData(QList<cwTriangulateInData>() << scrap);
+    task.start();
+
+    REQUIRE(task.triangulatedScrapData().size() == 1);
+    cwTriangulatedData data = task.triangulatedScrapData().first();
+
+    CHECK(data.isCropReference() == true);
+    CHECK(data.croppedImage().mipmaps() == noteImage.mipmaps());
+    CHECK(data.cropRect() == bounds);
+
+    //The texture coordinates are in the note's coordinates, inside of the scrap's bounds
+    REQUIRE(data.texCoords().isEmpty() == false);
+    foreach(QVector2D texCoord, data.texCoords()) {
+        CHECK(texCoord.x() >= bounds.left() - 0.001);
+        CHECK(texCoord.x() <= bounds.right() + 0.001);
+        CHECK(texCoord.y() >= bounds.top() - 0.001);
+        CHECK(texCoord.y() <= bounds.bottom() + 0.001);
+    }
+}
+
+TEST_CASE("Triangulated scraps have coarser levels of detail", "[TriangulateTask]") {
+    cwImage noteImage;
+    noteImage.setOriginal(1);
+    noteImage.setMipmaps(QList<int>() << 2 << 3 << 4);
+    noteImage.setOriginalSize(QSize(1024, 1024));
+
+    QRectF bounds(0.25, 0.25, 0.5, 0.5);
+
+    cwNoteTranformation noteTransform;
+    noteTransform.setScale(1.0 / 2500.0); //The note is 500m wide in the cave
+
+    cwTriangulateInData scrap;
+    scrap.setNoteImage(noteImage);
+    scrap.setNoteImageResolution(1024.0 / 0.2); //The note is 20cm wide
+    scrap.setNoteTransform(noteTransform);
+    scrap.setOutline(QPolygonF(bounds));
+
+    cwTriangulateTask task;
+    task.setScrapData(QList<cwTriangulateInData>() << scrap);
+    task.start();
+
+    REQUIRE(task.triangulatedScrapData().size() == 1);
+    cwTriangulatedData data = task.triangulatedScrapData().first();
+
+    QList<cwTriangulatedData::LevelOfDetail> levels = data.levelsOfDetail();
+    REQUIRE(levels.isEmpty() == false);
+
+    int finerIndexCount = data.indices().size();
+    double finerGridSpacing = 0.0;
+    foreach(const cwTriangulatedData::LevelOfDetail& level, levels) {
+        CHECK(level.GridSpacing > finerGridSpacing);
+        CHECK(level.Indices.size() < finerIndexCount);
+        CHECK(level.Points.size() == level.TexCoords.size());
+
+        foreach(uint index, level.Indices) {
+            CHECK((int)index < level.Points.size());
+        }
+
+        //Same outline, so the texture coordinates cover the same bounds
+        foreach(QVector2D texCoord, level.TexCoords) {
+            CHECK(texCoord.x() >= bounds.left() - 0.001);
+            CHECK(texCoord.x() <= bounds.right() + 0.001);
+            CHECK(texCoord.y() >= bounds.top() - 0.001);
+            CHECK(texCoord.y() <= bounds.bottom() + 0.001);
+        }
+
+        finerIndexCount = level.Indices.size();
+        finerGridSpacing = level.GridSpacing;
+    }
+}
+
+/**
+ * A scrap on a 20cm wide note, with outline in normalized note coordinates
+ */
+static cwTriangulateInData testScrap(const QPolygonF& outline) {
+    cwImage noteImage;
+    noteImage.setOriginal(1);
+    noteImage.setMipmaps(QList<int>() << 2 << 3 << 4);
+    noteImage.setOriginalSize(QSize(1024, 1024));
+
+    cwNoteTranformation noteTransform;
+    noteTransform.setScale(1.0 / 500.0);
+
+    cwTriangulateInData scrap;
+    scrap.setNoteImage(noteImage);
+    scrap.setNoteImageResolution(1024.0 / 0.2);
+    scrap.setNoteTransform(noteTransform);
+    scrap.setOutline(outline);
+    return scrap;
+}
+
+/**
+ * Runs the task on scraps, on the current thread
+ */
+static QList<cwTriangulatedData> triangulate(const QList<cwTriangulateInData>& scraps) {
+    cwTriangulateTask task;
+    task.setScrapData(scraps);
+    task.start();
+    return task.triangulatedScrapData();
+}
+
+static void checkSameTriangulation(const cwTriangulatedData& data, const cwTriangulatedData& expected) {
+    CHECK(data.cropRect() == expected.cropRect());
+    CHECK(data.indices() == expected.indices());
+    CHECK(data.points() == expected.points());
+    CHECK(data.texCoords() == expected.texCoords());
+
+    REQUIRE(data.levelsOfDetail().size() == expected.levelsOfDetail().size());
+    for(int i = 0; i < data.levelsOfDetail().size(); i++) {
+        CHECK(data.levelsOfDetail().at(i).GridSpacing == expected.levelsOfDetail().at(i).GridSpacing);
+        CHECK(data.levelsOfDetail().at(i).Indices == expected.levelsOfDetail().at(i).Indices);
+        CHECK(data.levelsOfDetail().at(i).Points == expected.levelsOfDetail().at(i).Points);
+    }
+}
+
+TEST_CASE("Scraps are triangulated in parallel, in the order they're given", "[TriangulateTask]") {
+    QList<cwTriangulateInData> scraps;
+    scraps.append(testScrap(QPolygonF(QRectF(0.1, 0.1, 0.3, 0.2))));
+    scraps.append(testScrap(QPolygonF() << QPointF(0.5, 0.5) << QPointF(0.9, 0.55) << QPointF(0.6, 0.95)));
+    scraps.append(testScrap(QPolygonF(QRectF(0.05, 0.6, 0.1, 0.3))));
+    scraps.append(testScrap(QPolygonF() << QPointF(0.2, 0.4) << QPointF(0.45, 0.4) << QPointF(0.45, 0.45)
+                            << QPointF(0.3, 0.45) << QPointF(0.3, 0.7) << QPointF(0.2, 0.7)));
+    scraps.append(testScrap(QPolygonF(QRectF(0.6, 0.05, 0.35, 0.35))));
+
+    QList<cwTriangulatedData> results = triangulate(scraps);
+    REQUIRE(results.size() == scraps.size());
+
+    for(int i = 0; i < scraps.size(); i++) {
+        INFO("Scrap " << i);
+        CHECK(results.at(i).cropRect() == scraps.at(i).outline().boundingRect());
+        CHECK(!results.at(i).indices().isEmpty());
+
+        //The same as triangulating the scrap by itself
+        QList<cwTriangulatedData> single = triangulate(QList<cwTriangulateInData>() << scraps.at(i));
+        REQUIRE(single.size() == 1);
+        checkSameTriangulation(results.at(i), single.first());
+    }
+}
+
+TEST_CASE("Stopping the triangulation doesn't give partial results", "[TriangulateTask]") {
+    QList<cwTriangulateInData> scraps;
+    for(int i = 0; i < 64; i++) {
+        double x = (i % 8) / 8.0;
+        double y = (i / 8) / 8.0;
+        scraps.append(testScrap(QPolygonF(QRectF(x + 0.01, y + 0.01, 0.1, 0.1))));
+    }
+
+    cwTriangulateTask task;
+
+    //A full run, so there are old results to clear
+    task.setScrapData(scraps);
+    task.start();
+    REQUIRE(task.triangulatedScrapData().size() == scraps.size());
+
+    //Stop after the first scrap is done, this is called from the thread pool
+    QAtomicInt stopped(0);
+    QObject::connect(&task, &cwTask::progressChanged, [&task, &stopped]() {
+        if(stopped.testAndSetOrdered(0, 1)) {
+            task.stop();
+        }
+    });
+
+    task.start();
+
+    CHECK(stopped.load() == 1);
+    CHECK(task.isReady());
+    CHECK(task.progress() < scraps.size());
+    CHECK(task.triangulatedScrapData().isEmpty());
+}
+
+/**
+ * Gives the testcases access to cwTriangulateTask's grid classification
+ */
+class TriangulateTaskTester {
+public:
+    TriangulateTaskTester(int columns, int rows, double spacing) :
+        Spacing(spacing)
+    {
+        Grid.GridSize = QSize(columns, rows);
+        Grid.GridDeltaSize = QSizeF(spacing, spacing);
+        for(int y = 0; y < rows; y++) {
+            for(int x = 0; x < columns; x++) {
+                Grid.Points.append(QPointF(x * spacing, y * spacing));
+            }
+        }
+    }
+
+    void classify(const QPolygonF& polygon) {
+        cwTriangulateTask task;
+        cwTriangulateTask::GridClassification classification = task.classifyGrid(Grid, polygon);
+        Edges = classification.OutlineEdges;
+        PointsInside = classification.PointsInside;
+        QuadEdges = classification.QuadEdges;
+    }
+
+    int quadColumns() const { return Grid.GridSize.width() - 1; }
+    int quadRows() const { return Grid.GridSize.height() - 1; }
+    int index(int column, int row) const { return Grid.index(column, row); }
+    QRectF quadRect(int column, int row) const { return QRectF(column * Spacing, row * Spacing, Spacing, Spacing); }
+    QVector<QPointF> points() const { return Grid.Points; }
+
+    /**
+     * The triangles of an outline, before they're optimized. Points starts with the grid points
+     * that are inside of the outline.
+     */
+    class Triangles {
+    public:
+        QVector<QVector3D> Points;
+        int NumberOfGridPoints;
+        QVector<uint> FullIndices;
+        QVector<uint> PartialIndices;
+    };
+
+    /**
+     * Triangulates outline on the grid, the partial quads' triangles are welded with tolerance.
+     * A negative tolerance never welds, so the partial quads' points are appended in order.
+     */
+    Triangles triangulate(const QPolygonF& outline, float tolerance) const {
+        cwTriangulateTask task;
+        cwTriangulateTask::GridClassification classification = task.classifyGrid(Grid, outline);
+        QSet<int> pointsInside = task.pointsInPolygon(classification);
+        cwTriangulateTask::QuadDatabase quads = task.createQuads(Grid, classification);
+
+        Triangles triangles;
+        QHash<int, int> gridToPoints;
+        foreach(int gridIndex, pointsInside) {
+            gridToPoints.insert(gridIndex, triangles.Points.size());
+            triangles.Points.append(QVector3D(Grid.Points.at(gridIndex)));
+        }
+        triangles.NumberOfGridPoints = triangles.Points.size();
+
+        triangles.FullIndices = task.createTrianglesFull(quads, gridToPoints);
+
+        cwTriangulateTask::PointWelder welder(&triangles.Points, tolerance);
+        task.createTrianglesPartial(Grid, quads, outline, welder, triangles.PartialIndices);
+        return triangles;
+    }
+
+    /**
+     * The number of points in the vertex buffer that the task creates for outline
+     */
+    int numberOfTrianglePoints(const QPolygonF& outline) const {
+        cwTriangulateTask task;
+        cwTriangulateTask::GridClassification classification = task.classifyGrid(Grid, outline);
+        cwTriangulateInData scrap;
+        scrap.setOutline(outline);
+        cwTriangulatedData data = task.createTriangles(Grid,
+                                                       task.pointsInPolygon(classification),
+                                                       task.createQuads(Grid, classification),
+                                                       scrap);
+        return data.points().size();
+    }
+
+    /**
+     * Welds newPoints into points with cwTriangulateTask's welder, and returns their indices
+     */
+    static QVector<uint> weld(QVector<QVector3D>* points, const QVector<QPointF>& newPoints, float tolerance) {
+        cwTriangulateTask::PointWelder welder(points, tolerance);
+        QVector<uint> indices;
+        foreach(QPointF point, newPoints) {
+            indices.append(welder.weld(point));
+        }
+        return indices;
+    }
+
+    /**
+     * Morphs notePoints with cwTriangulateTask's precomputed station transforms
+     */
+    static QVector<QVector3D> morphPoints(const QVector<QVector3D>& notePoints,
+                                          const cwTriangulateInData& scrapData,
+                                          const QMatrix4x4& toLocal,
+                                          QSize croppedImageSize) {
+        cwTriangulateTask task;
+        return task.morphPoints(notePoints, scrapData, toLocal, croppedImageSize);
+    }
+
+    QVector<QLineF> Edges;
+    QVector<bool> PointsInside;
+    QHash<int, QVector<int> > QuadEdges;
+
+private:
+    cwTriangulateTask::PointGrid Grid;
+    double Spacing;
+};
+
+/**
+ * Returns true if the edge touches rect, including its boundary
+ */
+static bool edgeTouchesRect(const QLineF& edge, const QRectF& rect) {
+    QRectF closedRect = rect.adjusted(-1.0e-9, -1.0e-9, 1.0e-9, 1.0e-9);
+    if(closedRect.contains(edge.p1()) || closedRect.contains(edge.p2())) {
+        return true;
+    }
+
+    QLineF rectEdges[4] = {
+        QLineF(rect.topLeft(), rect.topRight()),
+        QLineF(rect.topRight(), rect.bottomRight()),
+        QLineF(rect.bottomRight(), rect.bottomLeft()),
+        QLineF(rect.bottomLeft(), rect.topLeft())
+    };
+
+    for(int i = 0; i < 4; i++) {
+        QPointF intersection;
+        if(edge.intersect(rectEdges[i], &intersection) == QLineF::BoundedIntersection) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST_CASE("Scanline classification matches QPolygonF::containsPoint", "[TriangulateTask]") {
+
+    QList<QPolygonF> outlines;
+
+    //An L, the grid points land on its edges and vertices
+    outlines.append(QPolygonF() << QPointF(1, 1) << QPointF(6, 1) << QPointF(6, 3)
+                    << QPointF(3, 3) << QPointF(3, 8) << QPointF(1, 8));
+
+    //A U, with a notch that comes down from the top, explicitly closed
+    outlines.append(QPolygonF() << QPointF(0, 0) << QPointF(2, 0) << QPointF(2, 6)
+                    << QPointF(5, 6) << QPointF(5, 0) << QPointF(7, 0) << QPointF(7, 9)
+                    << QPointF(0, 9) << QPointF(0, 0));
+
+    //A saw tooth, its peaks and valleys are vertices on grid rows
+    outlines.append(QPolygonF() << QPointF(0, 9) << QPointF(0, 2) << QPointF(2, 5)
+                    << QPointF(4, 1) << QPointF(6, 5) << QPointF(8, 0) << QPointF(9, 9));
+
+    //A star that doesn't line up with the grid
+    QPolygonF star;
+    for(int i = 0; i < 10; i++) {
+        double radius = i % 2 == 0 ? 4.3 : 1.7;
+        double angle = i * M_PI / 5.0 + 0.1;
+        star << QPointF(4.9 + radius * cos(angle), 5.1 + radius * sin(angle));
+    }
+    outlines.append(star);
+
+    foreach(const QPolygonF& outline, outlines) {
+        TriangulateTaskTester tester(11, 11, 1.0);
+        tester.classify(outline);
+
+        QVector<QPointF> points = tester.points();
+        REQUIRE(tester.PointsInside.size() == points.size());
+
+        int numberInside = 0;
+        for(int i = 0; i < points.size(); i++) {
+            INFO("Point " << points.at(i).x() << " " << points.at(i).y());
+            CHECK(tester.PointsInside.at(i) == outline.containsPoint(points.at(i), Qt::OddEvenFill));
+            numberInside += tester.PointsInside.at(i) ? 1 : 0;
+        }
+        CHECK(numberInside > 0);
+
+        //Every edge that touches a quad must be bucketed into that quad
+        for(int row = 0; row < tester.quadRows(); row++) {
+            for(int column = 0; column < tester.quadColumns(); column++) {
+                QRectF rect = tester.quadRect(column, row);
+                QVector<int> edgeIndexes = tester.QuadEdges.value(tester.index(column, row));
+                for(int e = 0; e < tester.Edges.size(); e++) {
+                    if(edgeTouchesRect(tester.Edges.at(e), rect)) {
+                        INFO("Quad " << column << " " << row << " edge " << e);
+                        CHECK(edgeIndexes.contains(e));
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * The linear search that the welder replaced, the first point within tolerance is used
+ */
+static QVector<uint> linearWeld(QVector<QVector3D>* points, const QVector<QPointF>& newPoints, float tolerance) {
+    QVector<uint> indices;
+    foreach(QPointF newPoint, newPoints) {
+        int found = -1;
+        for(int i = 0; i < points->size(); i++) {
+            float xDelta = fabs((float)newPoint.x() - points->at(i).x());
+            float yDelta = fabs((float)newPoint.y() - points->at(i).y());
+            if(xDelta <= tolerance && yDelta <= tolerance) {
+                found = i;
+                break;
+            }
+        }
+
+        if(found == -1) {
+            found = points->size();
+            points->append(QVector3D(newPoint));
+        }
+        indices.append((uint)found);
+    }
+    return indices;
+}
+
+TEST_CASE("Point welder welds points across cells", "[TriangulateTask]") {
+
+    SECTION("Cell boundaries") {
+        //The cells are a unit wide
+        QVector<QVector3D> points;
+        points << QVector3D(0.999f, 0.0f, 0.0f) << QVector3D(1.0f, 1.0f, 0.0f) << QVector3D(0.2f, -3.0f, 0.0f);
+
+        QVector<QPointF> newPoints;
+        newPoints << QPointF(1.001, 0.0) //Neighbouring cell
+                  << QPointF(1.0, 1.0) //Exactly on a boundary
+                  << QPointF(1.5, 1.5) //Exactly the tolerance away, on the next boundary
+                  << QPointF(0.5, 0.5) //Within the tolerance of two points, the first is used
+                  << QPointF(1.51, 1.0) //Just outside of the tolerance, added
+                  << QPointF(-0.2, -3.0) //Neighbouring cell, across zero
+                  << QPointF(1.52, 1.0); //Welded to the point that was just added
+
+        QVector<QVector3D> expectedPoints = points;
+        QVector<uint> expected = linearWeld(&expectedPoints, newPoints, 0.5f);
+        CHECK(expected == (QVector<uint>() << 0 << 1 << 1 << 0 << 3 << 2 << 3));
+
+        CHECK(TriangulateTaskTester::weld(&points, newPoints, 0.5f) == expected);
+        CHECK(points == expectedPoints);
+    }
+
+    SECTION("Matches the linear search near cell boundaries") {
+        //The triangulation's tolerance. The points are doubles, the buffer is floats, and the
+        //points are jittered around the cell boundaries
+        const float tolerance = 0.000001f;
+        const double cellSize = tolerance * 2.0;
+
+        quint32 seed = 12345;
+        auto random = [&seed]()->double {
+            seed = seed * 1664525u + 1013904223u;
+            return (seed >> 8) / double(1 << 24);
+        };
+
+        QVector<QVector3D> points;
+        for(int i = 0; i < 200; i++) {
+            points.append(QVector3D(0.3f + i * 0.0001f, 0.7f, 0.0f));
+        }
+
+        QVector<QPointF> newPoints;
+        for(int i = 0; i < 2000; i++) {
+            QPointF base(0.3 + (i % 200) * 0.0001, 0.7);
+            double boundaryX = floor(base.x() / cellSize) * cellSize;
+            double boundaryY = floor(base.y() / cellSize) * cellSize;
+            QPointF jitter((random() - 0.5) * 3.0 * tolerance, (random() - 0.5) * 3.0 * tolerance);
+
+            switch(i % 4) {
+            case 0:
+                newPoints.append(base + jitter);
+                break;
+            case 1:
+                newPoints.append(QPointF(boundaryX, boundaryY) + jitter);
+                break;
+            case 2:
+                newPoints.append(QPointF(boundaryX, base.y()));
+                break;
+            default:
+                newPoints.append(base + QPointF(tolerance, -tolerance) * random());
+                break;
+            }
+        }
+
+        QVector<QVector3D> expectedPoints = points;
+        QVector<uint> expected = linearWeld(&expectedPoints, newPoints, tolerance);
+        CHECK(expectedPoints.size() > points.size());
+
+        CHECK(TriangulateTaskTester::weld(&points, newPoints, tolerance) == expected);
+        CHECK(points == expectedPoints);
+    }
+}
+
+TEST_CASE("Partial quads share the full quads' vertices", "[TriangulateTask]") {
+    const float tolerance = 0.000001f;
+
+    QList<QPolygonF> outlines;
+
+    //An L that doesn't line up with the grid
+    outlines.append(QPolygonF() << QPointF(1.5, 1.5) << QPointF(7.3, 1.5) << QPointF(7.3, 3.6)
+                    << QPointF(3.4, 3.6) << QPointF(3.4, 8.2) << QPointF(1.5, 8.2));
+
+    //A star, with edges that cross the grid's points and lines at many angles
+    QPolygonF star;
+    for(int i = 0; i < 10; i++) {
+        double radius = i % 2 == 0 ? 4.3 : 1.7;
+        double angle = i * M_PI / 5.0 + 0.1;
+        star << QPointF(4.9 + radius * cos(angle), 5.1 + radius * sin(angle));
+    }
+    outlines.append(star);
+
+    //An outline with edges along the grid lines, so the partial quads have points on grid points
+    outlines.append(QPolygonF() << QPointF(1, 1) << QPointF(6, 1) << QPointF(6, 3)
+                    << QPointF(3, 3.5) << QPointF(3, 8) << QPointF(1, 8));
+
+    foreach(const QPolygonF& outline, outlines) {
+        TriangulateTaskTester tester(11, 11, 1.0);
+
+        TriangulateTaskTester::Triangles triangles = tester.triangulate(outline, tolerance);
+        REQUIRE(!triangles.FullIndices.isEmpty());
+        REQUIRE(!triangles.PartialIndices.isEmpty());
+
+        //Partial quad points that are on a grid point use the full quads' index
+        QSet<uint> fullIndices = QSet<uint>::fromList(triangles.FullIndices.toList());
+        QSet<uint> partialIndices = QSet<uint>::fromList(triangles.PartialIndices.toList());
+        CHECK(fullIndices.intersects(partialIndices));
+
+        foreach(uint index, partialIndices) {
+            if((int)index < triangles.NumberOfGridPoints) {
+                continue;
+            }
+
+            QVector3D point = triangles.Points.at(index);
+            for(int i = 0; i < triangles.NumberOfGridPoints; i++) {
+                QVector3D gridPoint = triangles.Points.at(i);
+                INFO("Point " << point.x() << " " << point.y() << " grid point " << gridPoint.x() << " " << gridPoint.y());
+                CHECK(!(fabs(point.x() - gridPoint.x()) <= tolerance && fabs(point.y() - gridPoint.y()) <= tolerance));
+            }
+        }
+
+        //The same vertex buffer and indices as the linear search
+        TriangulateTaskTester::Triangles unwelded = tester.triangulate(outline, -1.0f);
+        REQUIRE(unwelded.PartialIndices.size() == triangles.PartialIndices.size());
+
+        QVector<QPointF> partialPoints;
+        foreach(uint index, unwelded.PartialIndices) {
+            partialPoints.append(unwelded.Points.at(index).toPointF());
+        }
+
+        QVector<QVector3D> expectedPoints = unwelded.Points.mid(0, unwelded.NumberOfGridPoints);
+        QVector<uint> expectedIndices = linearWeld(&expectedPoints, partialPoints, tolerance);
+
+        CHECK(triangles.FullIndices == unwelded.FullIndices);
+        CHECK(triangles.PartialIndices == expectedIndices);
+        CHECK(triangles.Points == expectedPoints);
+        CHECK(tester.numberOfTrianglePoints(outline) == expectedPoints.size());
+    }
+}
+
+/**
+ * Morphs point between stations, with a matrix for each station, the way the task did before
+ * the station transforms were precomputed
+ */
+static QVector3D referenceMorphPoint(const QList<cwTriangulateStation>& stations,
+                                     const QMatrix4x4& toWorldCoords,
+                                     const QMatrix4x4& viewMatrix,
+                                     const QVector3D& point) {
+    double sum = 0.0;
+    QVector<double> inverseDistances;
+    foreach(const cwTriangulateStation& station, stations) {
+        double distance = QLineF(station.notePosition(), point.toPointF()).length();
+        if(distance == 0.0) {
+            return station.position();
+        }
+        inverseDistances.append(1.0 / (distance * distance));
+        sum += inverseDistances.last();
+    }
+
+    QVector3D weightPosition;
+    for(int i = 0; i < stations.size(); i++) {
+        QVector3D stationOnNote = toWorldCoords * QVector3D(stations.at(i).notePosition());
+        QVector3D stationPos = viewMatrix * stations.at(i).position();
+
+        QMatrix4x4 offsetToFirstStation;
+        offsetToFirstStation.translate(-stationOnNote);
+        offsetToFirstStation.translate(stationPos);
+
+        QMatrix4x4 noteToScene = offsetToFirstStation * toWorldCoords;
+        weightPosition += (inverseDistances.at(i) / sum) * noteToScene.map(point);
+    }
+
+    return viewMatrix.inverted() * weightPosition;
+}
+
+/**
+ * Morphs notePoints the way the task did before the station transforms were precomputed. In
+ * running profile, each point is morphed between the two stations it falls between.
+ */
+static QVector<QVector3D> referenceMorphPoints(const QVector<QVector3D>& notePoints,
+                                               const cwTriangulateInData& scrapData,
+                                               const QMatrix4x4& toLocal,
+                                               QSize croppedImageSize) {
+    QMatrix4x4 rotation = scrapData.noteTransform().matrix();
+    double metersPerDot = 1.0 / scrapData.noteImageResolution();
+
+    QMatrix4x4 toPixels;
+    toPixels.scale(croppedImageSize.width(), croppedImageSize.height(), 1.0);
+
+    QMatrix4x4 toMetersOnPaper;
+    toMetersOnPaper.scale(metersPerDot, metersPerDot, 1.0);
+
+    QMatrix4x4 toWorldCoords = rotation * toMetersOnPaper * toPixels * toLocal;
+
+    QList<cwTriangulateStation> stations = scrapData.stations();
+    if(scrapData.type() == cwScrap::RunningProfile) {
+        std::sort(stations.begin(), stations.end(),
+                  [&rotation](const cwTriangulateStation& left, const cwTriangulateStation& right) {
+            return rotation.map(left.notePosition()).x() < rotation.map(right.notePosition()).x();
+        });
+    }
+
+    QVector<QVector3D> points;
+    foreach(const QVector3D& notePoint, notePoints) {
+        if(scrapData.type() != cwScrap::RunningProfile) {
+            points.append(referenceMorphPoint(stations, toWorldCoords, QMatrix4x4(), notePoint));
+            continue;
+        }
+
+        auto found = std::lower_bound(stations.begin(), stations.end(), notePoint,
+                                      [&rotation](const cwTriangulateStation& station, const QVector3D& point) {
+            return rotation.map(station.notePosition()).x() < rotation.map(point).x();
+        });
+        if(found == stations.end()) {
+            found = found - 1;
+        } else if(found == stations.begin()) {
+            found = found + 1;
+        }
+
+        QList<cwTriangulateStation> profileStations;
+        profileStations << *(found - 1) << *found;
+
+        QVector3D from = profileStations.first().position();
+        QMatrix4x4 translateForward;
+        translateForward.translate(from);
+        QMatrix4x4 translateBackward;
+        translateBackward.translate(-from);
+        QMatrix4x4 viewMatrix = translateForward *
+                cwScrap::toProfileRotation(from, profileStations.last().position()) *
+                translateBackward;
+
+        points.append(referenceMorphPoint(profileStations, toWorldCoords, viewMatrix, notePoint));
+    }
+    return points;
+}
+
+static cwTriangulateStation morphStation(QString name, QPointF notePosition, QVector3D position) {
+    cwTriangulateStation station;
+    station.setName(name);
+    station.setNotePosition(notePosition);
+    station.setPosition(position);
+    return station;
+}
+
+static void checkSameMorph(const QVector<QVector3D>& points, const QVector<QVector3D>& expected) {
+    REQUIRE(points.size() == expected.size());
+    for(int i = 0; i < points.size(); i++) {
+        INFO("Point " << i << " morphed:" << points.at(i).x() << " " << points.at(i).y() << " " << points.at(i).z()
+             << " expected:" << expected.at(i).x() << " " << expected.at(i).y() << " " << expected.at(i).z());
+        CHECK((points.at(i) - expected.at(i)).length() < 0.001);
+    }
+}
+
+TEST_CASE("Morphing points matches the per station transforms", "[TriangulateTask]") {
+    //The note is 20cm wide, and 100m in the cave
+    cwNoteTranformation noteTransform;
+    noteTransform.setScale(1.0 / 500.0);
+    noteTransform.setNorthUp(30.0);
+
+    cwTriangulateInData scrap;
+    scrap.setNoteImageResolution(1024.0 / 0.2);
+    scrap.setNoteTransform(noteTransform);
+
+    //The cropped image is the middle of the note
+    QSize croppedImageSize(512, 512);
+    QMatrix4x4 toLocal;
+    toLocal.translate(-0.25, -0.25, 0.0);
+
+    QList<cwTriangulateStation> stations;
+    stations << morphStation("a1", QPointF(0.30, 0.40), QVector3D(10.0f, 20.0f, -5.0f))
+             << morphStation("a2", QPointF(0.55, 0.35), QVector3D(38.0f, 12.0f, -8.0f))
+             << morphStation("a3", QPointF(0.45, 0.70), QVector3D(25.0f, 55.0f, -2.0f))
+             << morphStation("a4", QPointF(0.70, 0.60), QVector3D(60.0f, 41.0f, 3.0f));
+
+    QVector<QVector3D> notePoints;
+    notePoints << QVector3D(0.5f, 0.5f, 0.0f)
+               << QVector3D(0.31f, 0.42f, 0.0f)
+               << QVector3D(0.05f, 0.10f, 0.0f) //Before the first station
+               << QVector3D(0.95f, 0.90f, 0.0f) //After the last station
+               << QVector3D(0.62f, 0.48f, 0.0f);
+
+    foreach(const cwTriangulateStation& station, stations) {
+        notePoints << QVector3D(station.notePosition());
+    }
+
+    SECTION("Plan") {
+        scrap.setType(cwScrap::Plan);
+        scrap.setStations(stations);
+
+        QVector<QVector3D> points = TriangulateTaskTester::morphPoints(notePoints, scrap, toLocal, croppedImageSize);
+        checkSameMorph(points, referenceMorphPoints(notePoints, scrap, toLocal, croppedImageSize));
+
+        //Points on a station are the station
+        for(int i = 0; i < stations.size(); i++) {
+            CHECK(points.at(notePoints.size() - stations.size() + i) == stations.at(i).position());
+        }
+    }
+
+    SECTION("Running profile") {
+        scrap.setType(cwScrap::RunningProfile);
+
+        //Out of order, the task sorts them along the page
+        QList<cwTriangulateStation> profileStations = stations;
+        std::reverse(profileStations.begin(), profileStations.end());
+        scrap.setStations(profileStations);
+
+        //Make sure the points are before and after the stations along the profile
+        QMatrix4x4 rotation = noteTransform.matrix();
+        double firstX = std::numeric_limits<double>::max();
+        double lastX = -std::numeric_limits<double>::max();
+        foreach(const cwTriangulateStation& station, stations) {
+            firstX = qMin(firstX, (double)rotation.map(station.notePosition()).x());
+            lastX = qMax(lastX, (double)rotation.map(station.notePosition()).x());
+        }
+
+        QVector<QVector3D> outsidePoints;
+        foreach(const QVector3D& point, notePoints) {
+            double x = rotation.map(point).x();
+            if(x < firstX || x > lastX) {
+                outsidePoints.append(point);
+            }
+        }
+        CHECK(outsidePoints.size() >= 2);
+
+        QVector<QVector3D> points = TriangulateTaskTester::morphPoints(notePoints, scrap, toLocal, croppedImageSize);
+        checkSameMorph(points, referenceMorphPoints(notePoints, scrap, toLocal, croppedImageSize));
+
+        for(int i = 0; i < stations.size(); i++) {
+            CHECK(points.at(notePoints.size() - stations.size() + i) == stations.at(i).position());
+        }
+    }
+
+    SECTION("Running profile needs two stations") {
+        scrap.setType(cwScrap::RunningProfile);
+        scrap.setStations(QList<cwTriangulateStation>() << stations.first());
+
+        QVector<QVector3D> points = TriangulateTaskTester::morphPoints(notePoints, scrap, toLocal, croppedImageSize);
+        CHECK(points.size() == notePoints.size());
+        foreach(const QVector3D& point, points) {
+            CHECK(point == QVector3D());
+        }
+    }
+}